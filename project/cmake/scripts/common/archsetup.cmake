@@ -63,3 +63,7 @@ check_function_exists(localtime_r HAVE_LOCALTIME_R)
 if(HAVE_LOCALTIME_R)
   list(APPEND SYSTEM_DEFINES -DHAVE_LOCALTIME_R=1)
 endif()
+check_symbol_exists(inotify_init1 sys/inotify.h HAVE_INOTIFY)
+if(HAVE_INOTIFY)
+  list(APPEND SYSTEM_DEFINES -DHAVE_INOTIFY=1)
+endif()
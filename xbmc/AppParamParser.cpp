@@ -25,6 +25,7 @@
 #include "ApplicationMessenger.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/log.h"
+#include "utils/PerformanceTrace.h"
 #ifdef TARGET_WINDOWS
 #include "WIN32Util.h"
 #endif
@@ -104,6 +105,7 @@ void CAppParamParser::DisplayHelp()
   printf("  -n or --nolirc\tdo not use Lirc, i.e. no remote input.\n");
 #endif
   printf("  --debug\t\tEnable debug logging\n");
+  printf("  --trace\t\tRecord a performance trace, saved to special://temp/xbmc-trace.json on exit\n");
   printf("  --version\t\tPrint version information\n");
   printf("  --test\t\tEnable test mode. [FILE] required.\n");
   printf("  --settings=<filename>\t\tLoads specified file after advancedsettings.xml replacing any settings specified\n");
@@ -132,6 +134,8 @@ void CAppParamParser::ParseArg(const std::string &arg)
     g_application.EnablePlatformDirectories(false);
   else if (arg == "--debug")
     EnableDebugMode();
+  else if (arg == "--trace")
+    CPerformanceTrace::Start();
   else if (arg == "--legacy-res")
     g_application.SetEnableLegacyRes(true);
   else if (arg == "--test")
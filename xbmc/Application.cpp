@@ -299,12 +299,15 @@
 
 #include "storage/MediaManager.h"
 #include "utils/JobManager.h"
+#include "utils/PerformanceTrace.h"
+#include "dbwrappers/DatabaseProfiler.h"
 #include "utils/SaveFileStateJob.h"
 #include "utils/AlarmClock.h"
 #include "utils/RssReader.h"
 #include "utils/StringUtils.h"
 #include "utils/Weather.h"
 #include "DatabaseManager.h"
+#include "LibraryMonitor.h"
 
 #ifdef TARGET_POSIX
 #include "XHandle.h"
@@ -1513,6 +1516,8 @@ bool CApplication::Initialize()
   }
 
   m_slowTimer.StartZero();
+  m_jobStatisticsTimer.StartZero();
+  m_databaseStatisticsTimer.StartZero();
 
   CAddonMgr::Get().StartServices(true);
 
@@ -3457,6 +3462,8 @@ bool CApplication::Cleanup()
 
     CAddonMgr::Get().DeInit();
 
+    CDatabaseManager::Get().Deinitialize();
+
 #if defined(HAS_LIRC) || defined(HAS_IRSERVERSUITE)
     CLog::Log(LOGNOTICE, "closing down remote control service");
     g_RemoteControl.Disconnect();
@@ -3469,6 +3476,12 @@ bool CApplication::Cleanup()
     m_perfStats.DumpStats();
 #endif
 
+    if (CPerformanceTrace::IsEnabled())
+    {
+      CPerformanceTrace::Stop();
+      CPerformanceTrace::Save(CSpecialProtocol::TranslatePath("special://temp/xbmc-trace.json"));
+    }
+
     //  Shutdown as much as possible of the
     //  application, to reduce the leaks dumped
     //  to the vc output window before calling
@@ -3488,6 +3501,8 @@ bool CApplication::Cleanup()
     g_playlistPlayer.Clear();
     CSettings::Get().Uninitialize();
     g_advancedSettings.Clear();
+    // flush anything still queued for the log writer thread
+    CLog::SetAsynchronous(false);
 
 #ifdef TARGET_POSIX
     CXHandle::DumpObjectTracker();
@@ -3552,6 +3567,8 @@ void CApplication::Stop(int exitCode)
     CJobManager::GetInstance().CancelJobs();
 
     // stop scanning before we kill the network and so on
+    CLibraryMonitor::Get().Stop();
+
     if (m_musicInfoScanner->IsScanning())
       m_musicInfoScanner->Stop();
 
@@ -5125,6 +5142,21 @@ void CApplication::ProcessSlow()
     CJobManager::GetInstance().UnPauseJobs();
   }
 
+  // log the job statistics every so often if asked to
+  if (g_advancedSettings.m_jobStatisticsLogInterval > 0 &&
+      m_jobStatisticsTimer.GetElapsedSeconds() > g_advancedSettings.m_jobStatisticsLogInterval)
+  {
+    m_jobStatisticsTimer.Reset();
+    CJobManager::GetInstance().DumpStatistics();
+  }
+
+  if (CDatabaseProfiler::IsEnabled() && g_advancedSettings.m_databaseProfileLogInterval > 0 &&
+      m_databaseStatisticsTimer.GetElapsedSeconds() > g_advancedSettings.m_databaseProfileLogInterval)
+  {
+    m_databaseStatisticsTimer.Reset();
+    CDatabaseProfiler::Get().DumpStatistics();
+  }
+
   // Store our file state for use on close()
   UpdateFileState();
 
@@ -5611,6 +5643,8 @@ void CApplication::UpdateLibraries()
     CLog::Log(LOGNOTICE, "%s - Starting music library startup scan", __FUNCTION__);
     StartMusicScan("");
   }
+
+  CLibraryMonitor::Get().Start();
 }
 
 bool CApplication::IsVideoScanning() const
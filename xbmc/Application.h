@@ -395,6 +395,8 @@ protected:
   CStopWatch m_frameTime;
   CStopWatch m_navigationTimer;
   CStopWatch m_slowTimer;
+  CStopWatch m_jobStatisticsTimer;
+  CStopWatch m_databaseStatisticsTimer;
   CStopWatch m_shutdownTimer;
 
   bool m_bInhibitIdleShutdown;
@@ -70,6 +70,7 @@ void CDatabaseManager::Deinitialize()
 {
   CSingleLock lock(m_section);
   m_dbStatus.clear();
+  CDatabase::CloseIdleConnections();
 }
 
 bool CDatabaseManager::CanOpen(const std::string &name)
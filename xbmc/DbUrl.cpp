@@ -21,6 +21,7 @@
 #include <sstream>
 
 #include "DbUrl.h"
+#include "utils/SortUtils.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 
@@ -137,6 +138,36 @@ void CDbUrl::RemoveOption(const std::string &key)
   updateOptions(); 
 }
 
+void CDbUrl::TakeSorting(SortDescription &sorting)
+{
+  UrlOptions::const_iterator option = m_options.find("sortby");
+  if (option != m_options.end())
+    sorting.sortBy = (SortBy)option->second.asInteger();
+
+  option = m_options.find("sortorder");
+  if (option != m_options.end())
+    sorting.sortOrder = (SortOrder)option->second.asInteger();
+
+  option = m_options.find("ignorearticle");
+  if (option != m_options.end())
+    sorting.sortAttributes = option->second.asBoolean() ? SortAttributeIgnoreArticle : SortAttributeNone;
+
+  option = m_options.find("start");
+  if (option != m_options.end())
+    sorting.limitStart = (int)option->second.asInteger();
+
+  option = m_options.find("end");
+  if (option != m_options.end())
+    sorting.limitEnd = (int)option->second.asInteger();
+
+  const char *keys[] = { "sortby", "sortorder", "ignorearticle", "start", "end" };
+  for (unsigned int i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+  {
+    if (m_options.find(keys[i]) != m_options.end())
+      RemoveOption(keys[i]);
+  }
+}
+
 bool CDbUrl::validateOption(const std::string &key, const CVariant &value)
 {
   if (key.empty())
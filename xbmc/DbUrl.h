@@ -25,6 +25,8 @@
 #include "URL.h"
 #include "utils/UrlOptions.h"
 
+struct SortDescription;
+
 class CDbUrl : public CUrlOptions
 {
 public:
@@ -49,6 +51,13 @@ public:
   virtual void AddOptions(const std::string &options);
   virtual void RemoveOption(const std::string &key);
 
+  /*! \brief Move the sort method and the range of the items requested with the "sortby", "sortorder",
+   "ignorearticle", "start" and "end" options into a sort description. The options are removed so that
+   the paths of the listed items don't inherit them.
+   \param sorting the sort description to update with the options present.
+   */
+  void TakeSorting(SortDescription &sorting);
+
 protected:
   virtual bool parse() = 0;
   virtual bool validateOption(const std::string &key, const CVariant &value);
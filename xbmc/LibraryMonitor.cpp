@@ -0,0 +1,519 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "LibraryMonitor.h"
+#include "Application.h"
+#include "GUIInfoManager.h"
+#include "Util.h"
+#include "filesystem/Directory.h"
+#include "filesystem/SpecialProtocol.h"
+#include "music/MusicDatabase.h"
+#include "settings/AdvancedSettings.h"
+#include "settings/MediaSourceSettings.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "video/VideoDatabase.h"
+#include "video/VideoInfoScanner.h"
+
+#ifdef HAVE_INOTIFY
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+#endif
+
+using namespace std;
+using namespace XFILE;
+
+#ifdef HAVE_INOTIFY
+// changes made by other hosts are never reported for network filesystems
+static bool IsRemoteFilesystem(const std::string &path)
+{
+  struct statfs fs;
+  if (statfs(path.c_str(), &fs) != 0)
+    return false;
+
+  switch ((unsigned long)fs.f_type)
+  {
+  case 0x6969:     // nfs
+  case 0x517B:     // smbfs
+  case 0xFF534D42: // cifs
+    return true;
+  }
+  return false;
+}
+#endif
+
+CLibraryMonitor::CLibraryMonitor() : CThread("LibraryMonitor")
+{
+  m_fd = -1;
+}
+
+CLibraryMonitor::~CLibraryMonitor()
+{
+  StopThread();
+}
+
+CLibraryMonitor &CLibraryMonitor::Get()
+{
+  static CLibraryMonitor s_monitor;
+  return s_monitor;
+}
+
+void CLibraryMonitor::Start()
+{
+  Stop();
+
+  if (g_advancedSettings.m_bLibraryMonitorEnabled)
+    Create();
+}
+
+void CLibraryMonitor::Stop()
+{
+  StopThread();
+  m_sources.clear();
+  m_scans.clear();
+  m_removals.clear();
+}
+
+void CLibraryMonitor::Process()
+{
+#ifdef HAVE_INOTIFY
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0)
+    CLog::Log(LOGERROR, "%s - unable to initialize inotify (%s), polling the library sources instead", __FUNCTION__, strerror(errno));
+#endif
+
+  UpdateSources();
+
+  bool scanning[LIBRARIES] = { IsScanning(VIDEO), IsScanning(MUSIC) };
+  unsigned int polled = XbmcThreads::SystemClockMillis();
+  while (!m_bStop)
+  {
+    ReadEvents(500);
+
+    // a finished scan may have added sources to the library, or removed them
+    bool update = false;
+    for (int i = 0; i < LIBRARIES; i++)
+    {
+      bool busy = IsScanning((LIBRARY)i);
+      update |= scanning[i] && !busy;
+      scanning[i] = busy;
+    }
+    if (update)
+      UpdateSources();
+
+    if (XbmcThreads::SystemClockMillis() - polled >= (unsigned int)g_advancedSettings.m_iLibraryMonitorPollInterval * 60000)
+    {
+      // local sources that ran out of watches may be watchable again by now
+      UpdateSources();
+      Poll(false);
+      polled = XbmcThreads::SystemClockMillis();
+    }
+
+    ProcessChanges();
+  }
+
+  Unwatch();
+#ifdef HAVE_INOTIFY
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+  m_fd = -1;
+}
+
+void CLibraryMonitor::GetSources(vector<CSource> &sources)
+{
+  CVideoDatabase videodb;
+  if (videodb.Open())
+  {
+    set<string> paths;
+    videodb.GetPaths(paths);
+
+    // the set is sorted, so a source comes right before the paths below it
+    string parent;
+    for (set<string>::const_iterator it = paths.begin(); it != paths.end(); ++it)
+    {
+      if (!parent.empty() && StringUtils::StartsWith(*it, parent))
+        continue;
+      parent = *it;
+      if (!URIUtils::IsHD(*it))
+        continue;
+
+      VIDEO::SScanSettings settings;
+      bool foundDirectly = false;
+      ADDON::ScraperPtr scraper = videodb.GetScraperForPath(*it, settings, foundDirectly);
+      if (!scraper || settings.noupdate)
+        continue;
+
+      // tv shows are only followed from the source holding them
+      bool shows = scraper->Content() == CONTENT_TVSHOWS;
+      if (shows && !foundDirectly)
+        continue;
+
+      sources.push_back(CSource(VIDEO, *it, shows));
+    }
+    videodb.Close();
+  }
+
+  CMusicDatabase musicdb;
+  if (musicdb.Open())
+  {
+    set<string> paths;
+    musicdb.GetPaths(paths);
+    musicdb.Close();
+
+    // the library only knows the folders of the songs, so follow the sources they were scanned from
+    VECSOURCES *shares = CMediaSourceSettings::Get().GetSources("music");
+    for (VECSOURCES::const_iterator share = shares->begin(); share != shares->end(); ++share)
+    {
+      for (vector<string>::const_iterator it = share->vecPaths.begin(); it != share->vecPaths.end(); ++it)
+      {
+        string path(*it);
+        URIUtils::AddSlashAtEnd(path);
+        if (!URIUtils::IsHD(path))
+          continue;
+
+        set<string>::const_iterator song = paths.lower_bound(path);
+        if (song == paths.end() || !StringUtils::StartsWith(*song, path))
+          continue;
+
+        bool known = false;
+        for (vector<CSource>::const_iterator source = sources.begin(); source != sources.end() && !known; ++source)
+          known = source->library == MUSIC && StringUtils::StartsWith(path, source->path);
+        if (!known)
+          sources.push_back(CSource(MUSIC, path));
+      }
+    }
+  }
+}
+
+bool CLibraryMonitor::IsScanning(LIBRARY library)
+{
+  return library == VIDEO ? g_application.IsVideoScanning() : g_application.IsMusicScanning();
+}
+
+void CLibraryMonitor::Scan(LIBRARY library, const string &path)
+{
+  CLog::Log(LOGDEBUG, "%s - scanning %s", __FUNCTION__, path.c_str());
+  if (library == VIDEO)
+    g_application.StartVideoScan(path);
+  else
+    g_application.StartMusicScan(path);
+}
+
+void CLibraryMonitor::Remove(LIBRARY library, const string &path)
+{
+  CLog::Log(LOGDEBUG, "%s - cleaning %s", __FUNCTION__, path.c_str());
+  if (library == VIDEO)
+  {
+    CVideoDatabase videodb;
+    if (!videodb.Open())
+      return;
+
+    vector< pair<int, string> > paths;
+    videodb.GetSubPaths(path, paths);
+    set<int> ids;
+    for (vector< pair<int, string> >::const_iterator it = paths.begin(); it != paths.end(); ++it)
+      ids.insert(it->first);
+    if (!ids.empty())
+      videodb.CleanDatabase(NULL, &ids, false);
+    videodb.Close();
+  }
+  else
+  {
+    // folders that are still around get rescanned instead, which drops their missing songs
+    if (CDirectory::Exists(path))
+      return;
+
+    CMusicDatabase musicdb;
+    if (!musicdb.Open())
+      return;
+
+    MAPSONGS songs;
+    musicdb.RemoveSongsFromPath(path, songs, false);
+    musicdb.CleanupOrphanedItems();
+    musicdb.Close();
+    g_infoManager.ResetLibraryBools();
+    CUtil::DeleteMusicDatabaseDirectoryCache();
+  }
+}
+
+void CLibraryMonitor::UpdateSources()
+{
+  vector<CSource> sources;
+  GetSources(sources);
+
+  // sources that can't be watched at all are polled from the start, so the ones
+  // that fell back to polling differ from the new ones and get their watches retried
+  for (vector<CSource>::iterator it = sources.begin(); it != sources.end(); ++it)
+  {
+#ifdef HAVE_INOTIFY
+    it->polled = m_fd < 0 || IsRemoteFilesystem(CSpecialProtocol::TranslatePath(it->path));
+#else
+    it->polled = true;
+#endif
+  }
+  if (sources == m_sources)
+    return;
+
+  Unwatch();
+  m_sources = sources;
+  for (unsigned int i = 0; i < m_sources.size(); i++)
+  {
+    CSource &source = m_sources[i];
+    if (!source.polled)
+      Watch(i, source.path);
+    CLog::Log(LOGDEBUG, "%s - %s %s", __FUNCTION__, source.polled ? "polling" : "watching", source.path.c_str());
+  }
+  CLog::Log(LOGNOTICE, "%s - watching %u folders of %u library sources", __FUNCTION__, (unsigned int)m_watches.size(), (unsigned int)m_sources.size());
+}
+
+bool CLibraryMonitor::Watch(unsigned int source, const string &path)
+{
+#ifdef HAVE_INOTIFY
+  string local = CSpecialProtocol::TranslatePath(path);
+  int wd = inotify_add_watch(m_fd, local.c_str(), WATCH_EVENTS);
+  if (wd < 0)
+  {
+    if (errno == ENOENT || errno == ENOTDIR)
+      return true; // gone again already
+
+    if (errno == ENOSPC)
+      CLog::Log(LOGWARNING, "%s - out of inotify watches at %s, polling %s instead (see fs.inotify.max_user_watches)", __FUNCTION__, path.c_str(), m_sources[source].path.c_str());
+    else
+      CLog::Log(LOGERROR, "%s - unable to watch %s (%s), polling %s instead", __FUNCTION__, path.c_str(), strerror(errno), m_sources[source].path.c_str());
+    m_sources[source].polled = true;
+    return false;
+  }
+
+  // a folder may be reached twice through links
+  if (m_watches.find(wd) != m_watches.end())
+    return true;
+  m_watches[wd] = make_pair(source, path);
+
+  DIR *dir = opendir(local.c_str());
+  if (dir == NULL)
+    return true;
+
+  bool watched = true;
+  struct dirent *entry;
+  while (watched && (entry = readdir(dir)) != NULL)
+  {
+    if (entry->d_name[0] == '.')
+      continue;
+
+    bool folder = entry->d_type == DT_DIR;
+    if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN)
+    {
+      struct stat64 st;
+      folder = stat64((local + entry->d_name).c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
+    if (folder)
+      watched = Watch(source, path + entry->d_name + "/");
+  }
+  closedir(dir);
+  return watched;
+#else
+  return false;
+#endif
+}
+
+void CLibraryMonitor::Unwatch(const string &path)
+{
+  for (map<int, pair<unsigned int, string> >::iterator it = m_watches.begin(); it != m_watches.end();)
+  {
+    if (StringUtils::StartsWith(it->second.second, path))
+    {
+#ifdef HAVE_INOTIFY
+      inotify_rm_watch(m_fd, it->first);
+#endif
+      m_watches.erase(it++);
+    }
+    else
+      ++it;
+  }
+}
+
+void CLibraryMonitor::Unwatch()
+{
+#ifdef HAVE_INOTIFY
+  for (map<int, pair<unsigned int, string> >::const_iterator it = m_watches.begin(); it != m_watches.end(); ++it)
+    inotify_rm_watch(m_fd, it->first);
+#endif
+  m_watches.clear();
+}
+
+void CLibraryMonitor::ReadEvents(unsigned int timeout)
+{
+#ifdef HAVE_INOTIFY
+  if (m_fd >= 0)
+  {
+    struct pollfd fds = { m_fd, POLLIN, 0 };
+    if (poll(&fds, 1, timeout) <= 0)
+      return;
+
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+    while (!m_bStop && (length = read(m_fd, buffer, sizeof(buffer))) > 0)
+    {
+      const struct inotify_event *event;
+      for (char *ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + event->len)
+      {
+        event = (const struct inotify_event *)ptr;
+        if (event->mask & IN_Q_OVERFLOW)
+        { // changes were lost, let the hashes find them
+          CLog::Log(LOGWARNING, "%s - inotify queue overflowed, rescanning all library sources", __FUNCTION__);
+          Poll(true);
+          continue;
+        }
+
+        map<int, pair<unsigned int, string> >::iterator watch = m_watches.find(event->wd);
+        if (watch == m_watches.end())
+          continue;
+        if (event->mask & IN_IGNORED)
+        { // the folder was removed
+          m_watches.erase(watch);
+          continue;
+        }
+        if (event->len == 0 || event->name[0] == '.')
+          continue;
+
+        unsigned int source = watch->second.first;
+        string path = watch->second.second;
+        if (event->mask & IN_ISDIR)
+        {
+          string folder = path + event->name + "/";
+          if (event->mask & (IN_CREATE | IN_MOVED_TO))
+          {
+            Watch(source, folder);
+            OnChanged(source, folder, false);
+          }
+          else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+          {
+            Unwatch(folder);
+            OnChanged(source, folder, true);
+          }
+        }
+        else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+          OnChanged(source, path, false);
+        else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        { // the music scanner drops the songs of a folder before rescanning it, videos need cleaning
+          OnChanged(source, path, m_sources[source].library == VIDEO);
+        }
+      }
+    }
+    return;
+  }
+#endif
+  Sleep(timeout);
+}
+
+void CLibraryMonitor::OnChanged(unsigned int source, const string &path, bool removed)
+{
+  const CSource &changed = m_sources[source];
+  string folder(path);
+  if (changed.shows)
+  { // tv shows are scanned per show folder, files at the top of the source aren't scanned at all
+    size_t slash = folder.find('/', changed.path.size());
+    if (slash == string::npos)
+      return;
+    folder.erase(slash + 1);
+  }
+
+  Queue(removed ? m_removals : m_scans, changed.library, folder, XbmcThreads::SystemClockMillis());
+}
+
+void CLibraryMonitor::Queue(CHANGES &changes, LIBRARY library, const string &path, unsigned int time)
+{
+  if (&changes == &m_scans)
+  {
+    // scans cover the folders below, so a copy of a whole tree ends in a single scan
+    for (CHANGES::iterator it = changes.begin(); it != changes.end();)
+    {
+      if (it->second.library == library && StringUtils::StartsWith(path, it->first))
+      {
+        it->second.time = time;
+        return;
+      }
+      if (it->second.library == library && StringUtils::StartsWith(it->first, path))
+        changes.erase(it++);
+      else
+        ++it;
+    }
+  }
+
+  CHANGES::iterator it = changes.find(path);
+  if (it != changes.end())
+    it->second.time = time;
+  else
+    changes.insert(make_pair(path, CChange(library, time)));
+}
+
+void CLibraryMonitor::Poll(bool all)
+{
+  // queued as if they were quiet already
+  unsigned int time = XbmcThreads::SystemClockMillis() - g_advancedSettings.m_iLibraryMonitorSettleTime;
+  for (vector<CSource>::const_iterator it = m_sources.begin(); it != m_sources.end(); ++it)
+  {
+    if (all || it->polled)
+      Queue(m_scans, it->library, it->path, time);
+  }
+}
+
+void CLibraryMonitor::ProcessChanges()
+{
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  unsigned int settle = g_advancedSettings.m_iLibraryMonitorSettleTime;
+  bool busy[LIBRARIES] = { IsScanning(VIDEO), IsScanning(MUSIC) };
+
+  for (CHANGES::iterator it = m_removals.begin(); it != m_removals.end() && !m_bStop;)
+  {
+    if (busy[it->second.library] || now - it->second.time < settle)
+    {
+      ++it;
+      continue;
+    }
+    Remove(it->second.library, it->first);
+    m_removals.erase(it++);
+  }
+
+  // the scanners take one folder at a time, the others wait for them to finish
+  for (CHANGES::iterator it = m_scans.begin(); it != m_scans.end() && !m_bStop;)
+  {
+    if (busy[it->second.library] || now - it->second.time < settle)
+    {
+      ++it;
+      continue;
+    }
+    Scan(it->second.library, it->first);
+    busy[it->second.library] = true;
+    m_scans.erase(it++);
+  }
+}
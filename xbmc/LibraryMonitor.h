@@ -0,0 +1,124 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "threads/Thread.h"
+
+/*!
+ \ingroup library
+ \brief Keeps the video and music libraries up to date with their local sources.
+
+ Sources on local (or bind mounted) filesystems are watched with inotify where
+ it is available. Changes are collected per directory and, once a directory has
+ been quiet for a moment, handed to the scanners as a scan of just that directory,
+ or cleaned from the library when things were removed.
+
+ Sources that can't be watched, because they are on a network filesystem or the
+ inotify watch limit was reached, are rescanned periodically instead, which the
+ path hashes keep cheap.
+ */
+class CLibraryMonitor : public CThread
+{
+public:
+  enum LIBRARY { VIDEO = 0, MUSIC, LIBRARIES };
+
+  struct CSource
+  {
+    CSource(LIBRARY library, const std::string &path, bool shows = false)
+      : library(library), path(path), shows(shows), polled(false) {}
+
+    bool operator==(const CSource &right) const
+    {
+      return library == right.library && path == right.path && shows == right.shows && polled == right.polled;
+    }
+
+    LIBRARY library;
+    std::string path; ///< path of the source as known to the library, with a trailing slash
+    bool shows;       ///< the source holds tv shows, which are scanned per show folder
+    bool polled;      ///< the source can't (fully) be watched and is rescanned periodically
+  };
+
+  /*!
+   \brief The only way through which the global instance of the CLibraryMonitor should be accessed.
+   \return the global instance.
+   */
+  static CLibraryMonitor &Get();
+
+  /*! \brief Start (or restart) watching the library sources of the current profile.
+   Does nothing when disabled in advancedsettings.xml.
+   */
+  void Start();
+
+  /*! \brief Stop watching, dropping any changes not handed to the scanners yet.
+   */
+  void Stop();
+
+protected:
+  CLibraryMonitor();
+  virtual ~CLibraryMonitor();
+
+  virtual void Process();
+
+  /*! \brief Get the sources to watch, the topmost local paths of the libraries.
+   */
+  virtual void GetSources(std::vector<CSource> &sources);
+
+  virtual bool IsScanning(LIBRARY library);
+
+  /*! \brief Scan a single directory (and what's below it) into the library.
+   */
+  virtual void Scan(LIBRARY library, const std::string &path);
+
+  /*! \brief Remove what no longer exists at or below the given path from the library.
+   */
+  virtual void Remove(LIBRARY library, const std::string &path);
+
+private:
+  CLibraryMonitor(const CLibraryMonitor&);
+  CLibraryMonitor const& operator=(CLibraryMonitor const&);
+
+  struct CChange
+  {
+    CChange(LIBRARY library, unsigned int time) : library(library), time(time) {}
+    LIBRARY library;
+    unsigned int time; ///< time of the last change, a directory is handled once it's quiet
+  };
+  typedef std::map<std::string, CChange> CHANGES;
+
+  void UpdateSources();
+  bool Watch(unsigned int source, const std::string &path);
+  void Unwatch(const std::string &path);
+  void Unwatch();
+  void ReadEvents(unsigned int timeout);
+  void OnChanged(unsigned int source, const std::string &path, bool removed);
+  void Queue(CHANGES &changes, LIBRARY library, const std::string &path, unsigned int time);
+  void Poll(bool all);
+  void ProcessChanges();
+
+  int m_fd;
+  std::vector<CSource> m_sources;
+  std::map<int, std::pair<unsigned int, std::string> > m_watches; ///< watch -> source and directory
+  CHANGES m_scans;    ///< directories to scan, keyed by path
+  CHANGES m_removals; ///< directories to clean from the library, keyed by path
+};
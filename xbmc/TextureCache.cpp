@@ -40,8 +40,10 @@ CTextureCache &CTextureCache::Get()
   return s_cache;
 }
 
-CTextureCache::CTextureCache() : CJobQueue(false, 1, CJob::PRIORITY_LOW_PAUSABLE)
+CTextureCache::CTextureCache() : CJobQueue(false, 1, CJob::PRIORITY_LOW_PAUSABLE),
+                                 m_cleanupQueue(false, 1, CJob::PRIORITY_LOW_PAUSABLE)
 {
+  m_cachedCount = 0;
 }
 
 CTextureCache::~CTextureCache()
@@ -53,12 +55,29 @@ void CTextureCache::Initialize()
   CSingleLock lock(m_databaseSection);
   if (!m_database.IsOpen())
     m_database.Open();
+  lock.Leave();
+
+  CleanupCache();
 }
 
 void CTextureCache::Deinitialize()
 {
   CancelJobs();
+  m_cleanupQueue.CancelJobs();
   CSingleLock lock(m_databaseSection);
+
+  // write the uses not written by a CTextureUseCountJob yet
+  CSingleLock useCountLock(m_useCountSection);
+  if (!m_useCounts.empty() && m_database.IsOpen())
+  {
+    m_database.BeginTransaction();
+    for (std::vector<CTextureDetails>::const_iterator i = m_useCounts.begin(); i != m_useCounts.end(); ++i)
+      m_database.IncrementUseCount(*i);
+    m_database.CommitTransaction();
+  }
+  m_useCounts.clear();
+  useCountLock.Leave();
+
   m_database.Close();
 }
 
@@ -283,11 +302,34 @@ void CTextureCache::OnCachingComplete(bool success, CTextureCacheJob *job)
 
   m_completeEvent.Set();
 
+  if (success)
+  {
+    static const unsigned int cached_before_cleanup = 500;
+    CSingleLock lock(m_processingSection);
+    if (++m_cachedCount >= cached_before_cleanup)
+    {
+      m_cachedCount = 0;
+      lock.Leave();
+      CleanupCache();
+    }
+  }
+
   // TODO: call back to the UI indicating that it can update it's image...
   if (success && g_advancedSettings.m_useDDSFanart && !job->m_details.file.empty())
     AddJob(new CTextureDDSJob(GetCachedPath(job->m_details.file)));
 }
 
+void CTextureCache::CleanupCache()
+{
+  if (g_advancedSettings.m_textureCacheSize > 0)
+  {
+    // not through our own queue, which would hold up the caching meanwhile, but through
+    // one of its own, which drops the job while another cleanup is queued or running
+    uint64_t budget = (uint64_t)g_advancedSettings.m_textureCacheSize * 1024 * 1024;
+    m_cleanupQueue.AddJob(new CTextureCleanupJob(budget));
+  }
+}
+
 void CTextureCache::OnJobComplete(unsigned int jobID, bool success, CJob *job)
 {
   if (strcmp(job->GetType(), kJobTypeCacheImage) == 0)
@@ -221,6 +221,11 @@ private:
    */
   void OnCachingComplete(bool success, CTextureCacheJob *job);
 
+  /*! \brief Queue a job evicting the least used images if the cache takes more than <texturecachesize>
+   \sa CTextureCleanupJob
+   */
+  void CleanupCache();
+
   CCriticalSection m_databaseSection;
   CTextureDatabase m_database;
   std::set<std::string> m_processinglist; ///< currently processing list to avoid 2 jobs being processed at once
@@ -228,5 +233,7 @@ private:
   CEvent               m_completeEvent; ///< Set whenever a job has finished
   std::vector<CTextureDetails> m_useCounts; ///< Use count tracking
   CCriticalSection             m_useCountSection;
+  unsigned int                 m_cachedCount; ///< images cached since the last cleanup
+  CJobQueue                    m_cleanupQueue; ///< runs a single CTextureCleanupJob at a time
 };
 
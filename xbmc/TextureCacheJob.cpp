@@ -27,6 +27,7 @@
 #include "utils/log.h"
 #include "filesystem/File.h"
 #include "pictures/Picture.h"
+#include "profiles/ProfilesManager.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
 #include "URL.h"
@@ -269,3 +270,89 @@ bool CTextureUseCountJob::DoWork()
   }
   return true;
 }
+
+CTextureCleanupJob::CTextureCleanupJob(uint64_t budget)
+{
+  m_budget = budget;
+  m_size = 0;
+  m_reclaimed = 0;
+  m_evicted = 0;
+}
+
+bool CTextureCleanupJob::operator==(const CJob* job) const
+{
+  // a single cleanup at a time is plenty
+  return strcmp(job->GetType(), GetType()) == 0;
+}
+
+bool CTextureCleanupJob::DoWork()
+{
+  CTextureDatabase db;
+  if (!db.Open())
+    return false;
+
+  return Cleanup(db, CProfilesManager::Get().GetThumbnailsFolder());
+}
+
+bool CTextureCleanupJob::Cleanup(CTextureDatabase &db, const std::string &folder)
+{
+  std::vector<CTextureUsage> textures;
+  if (!db.GetTexturesByUsage(textures))
+    return false;
+
+  // the sizes aren't in the database, so stat the cached files (and their .dds versions)
+  std::vector<uint64_t> sizes(textures.size());
+  for (unsigned int i = 0; i < textures.size(); i++)
+  {
+    std::string path = URIUtils::AddFileToFolder(folder, textures[i].file);
+    struct __stat64 st;
+    if (XFILE::CFile::Stat(path, &st) == 0)
+      sizes[i] += st.st_size;
+    if (XFILE::CFile::Stat(URIUtils::ReplaceExtension(path, ".dds"), &st) == 0)
+      sizes[i] += st.st_size;
+    m_size += sizes[i];
+  }
+
+  if (m_size <= m_budget)
+    return true;
+
+  // evict the textures least worth keeping until we're comfortably below the budget,
+  // a batch at a time so that we don't hold up the database or playback for long
+  static const unsigned int batch_size = 50;
+  uint64_t target = m_budget / 10 * 9;
+  unsigned int i = 0;
+  while (i < textures.size() && m_size - m_reclaimed > target)
+  {
+    if (CJobManager::GetInstance().IsPaused())
+    {
+      CLog::Log(LOGDEBUG, "%s - stopping for playback", __FUNCTION__);
+      break;
+    }
+
+    std::vector<std::string> files;
+    db.BeginTransaction();
+    for (unsigned int end = i + batch_size; i < end && i < textures.size() && m_size - m_reclaimed > target; i++)
+    {
+      std::string file;
+      if (db.ClearCachedTexture(textures[i].id, file))
+      {
+        files.push_back(URIUtils::AddFileToFolder(folder, file));
+        m_reclaimed += sizes[i];
+        m_evicted++;
+      }
+    }
+    db.CommitTransaction();
+
+    for (std::vector<std::string>::const_iterator file = files.begin(); file != files.end(); ++file)
+    {
+      XFILE::CFile::Delete(*file);
+      std::string dds = URIUtils::ReplaceExtension(*file, ".dds");
+      if (XFILE::CFile::Exists(dds))
+        XFILE::CFile::Delete(dds);
+    }
+  }
+
+  CLog::Log(LOGNOTICE, "%s - evicted %u cached images, reclaimed %" PRIu64 " of %" PRIu64 " bytes (budget %" PRIu64 ")",
+            __FUNCTION__, m_evicted, m_reclaimed, m_size, m_budget);
+  return true;
+}
@@ -22,9 +22,11 @@
 
 #include <string>
 #include <vector>
+#include <stdint.h>
 #include "utils/Job.h"
 
 class CBaseTexture;
+class CTextureDatabase;
 
 /*!
  \ingroup textures
@@ -151,3 +153,30 @@ public:
 private:
   std::vector<CTextureDetails> m_textures;
 };
+
+/* \brief Job class for keeping the cached textures within the disk space they may take
+ Once the cached textures take more than the budget, the ones least worth keeping
+ are evicted in batches until they take no more than 90% of it. The job stops early
+ while pausable jobs are paused, ie during playback.
+ */
+class CTextureCleanupJob : public CJob
+{
+public:
+  CTextureCleanupJob(uint64_t budget);
+
+  virtual const char* GetType() const { return kJobTypeCleanupImages; };
+  virtual bool operator==(const CJob *job) const;
+  virtual bool DoWork();
+
+  /*! \brief Evict textures of the given database, whose cached files are in the given folder
+   \param db the texture database
+   \param folder the folder of the cached textures, e.g. the thumbnails folder of the profile
+   \return true if the cleanup ran, false if the textures couldn't be listed
+   */
+  bool Cleanup(CTextureDatabase &db, const std::string &folder);
+
+  uint64_t     m_budget;    ///< bytes the cached textures may take
+  uint64_t     m_size;      ///< bytes the cached textures took before the cleanup
+  uint64_t     m_reclaimed; ///< bytes freed by the cleanup
+  unsigned int m_evicted;   ///< number of textures evicted
+};
@@ -18,12 +18,19 @@
  *
  */
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 #include "TextureDatabase.h"
 #include "utils/log.h"
 #include "XBDateTime.h"
 #include "dbwrappers/dataset.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "URL.h"
 #include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
 #include "utils/Variant.h"
 
 enum TextureField
@@ -65,6 +72,140 @@ static const translateField fields[] = {
 
 static const size_t NUM_FIELDS = sizeof(fields) / sizeof(translateField);
 
+// texture tables with more textures than this aren't held in memory but queried
+#define MAX_INDEXED_TEXTURES 100000
+
+// a failed load of the index is retried after 10 seconds, twice as long after each further failure
+#define INDEX_RETRY_DELAY      10000
+#define INDEX_MAX_RETRY_DELAY  (60 * 60 * 1000)
+
+namespace
+{
+  /*! \brief Memory resident copy of the cached textures, shared by all connections
+   Image lookups are answered from here rather than from the texture table, which
+   is read once on the first lookup and kept up to date by the writes after that.
+   The table is read without holding the lock of the index, lookups are answered
+   from the table until it has been read.
+   */
+  class CTextureIndex
+  {
+  public:
+    typedef struct
+    {
+      int id;
+      std::string file;
+      std::string hash;
+      CDateTime lastHashCheck;
+      unsigned int width;
+      unsigned int height;
+    } Texture;
+
+    typedef std::map<std::string, Texture> Textures;
+
+    /*! \brief a write to the texture table, see CTextureDatabase::UpdateIndex() */
+    typedef struct
+    {
+      std::string url;
+      int id;
+      bool added;
+      CTextureDetails details;
+      bool checked;
+      CDateTime lastHashCheck;
+    } Write;
+
+    static CTextureIndex &Get()
+    {
+      static CTextureIndex sTextureIndex;
+      return sTextureIndex;
+    }
+
+    /*! \brief whether the index holds the textures of the given database
+     The index is dropped when the textures of another profile are used.
+     */
+    bool IsLoaded(const std::string &database)
+    {
+      if (m_database != database)
+      {
+        m_textures.clear();
+        m_pending.clear();
+        m_database = database;
+        m_loaded = false;
+        m_retryDelay = 0;
+      }
+      return m_loaded;
+    }
+
+    /*! \brief whether the index may be loaded now, i.e. no load is running and no failed one is to be waited for */
+    bool MayLoad() const
+    {
+      return !m_loading && (m_retryDelay == 0 || XbmcThreads::SystemClockMillis() - m_failTime >= m_retryDelay);
+    }
+
+    /*! \brief drop the index, it is loaded again after the given delay at the earliest */
+    void Drop(unsigned int retryDelay)
+    {
+      m_textures.clear();
+      m_pending.clear();
+      m_loaded = false;
+      m_failTime = XbmcThreads::SystemClockMillis();
+      m_retryDelay = retryDelay;
+    }
+
+    /*! \brief the delay before the next try after a failed load */
+    unsigned int GetRetryDelay() const
+    {
+      return m_retryDelay == 0 ? INDEX_RETRY_DELAY : std::min(2 * m_retryDelay, (unsigned int)INDEX_MAX_RETRY_DELAY);
+    }
+
+    static void Apply(Textures &textures, const Write &write)
+    {
+      if (write.url.empty())
+      { // only the id is known
+        for (Textures::iterator it = textures.begin(); it != textures.end(); ++it)
+        {
+          if (it->second.id == write.id)
+          {
+            textures.erase(it);
+            break;
+          }
+        }
+        return;
+      }
+
+      Textures::iterator it = textures.find(write.url);
+      if (write.added)
+      {
+        Texture &texture = textures[write.url];
+        texture.id = write.id;
+        texture.file = write.details.file;
+        texture.hash = write.details.hash;
+        texture.width = write.details.width;
+        texture.height = write.details.height;
+        texture.lastHashCheck = write.checked ? write.lastHashCheck : CDateTime();
+      }
+      else if (it != textures.end())
+      {
+        if (write.checked)
+          it->second.lastHashCheck = write.lastHashCheck;
+        else
+          textures.erase(it);
+      }
+    }
+
+    CCriticalSection m_section;
+    std::string m_database;       ///< the database the index (and its state) is of
+    Textures m_textures;
+    bool m_loaded;                ///< whether m_textures holds the textures of m_database
+    bool m_loading;               ///< whether a connection is reading the texture table into an index
+    std::vector<Write> m_pending; ///< writes made while loading, applied to the index loaded
+    unsigned int m_failTime;      ///< time the last load failed at
+    unsigned int m_retryDelay;    ///< time to wait after m_failTime before loading again, 0 if nothing failed
+
+  private:
+    CTextureIndex() : m_loaded(false), m_loading(false), m_failTime(0), m_retryDelay(0) { }
+  };
+}
+
 int CTextureRule::TranslateField(const char *field) const
 {
   for (unsigned int i = 0; i < NUM_FIELDS; i++)
@@ -246,19 +387,197 @@ void CTextureDatabase::UpdateTables(int version)
 
 bool CTextureDatabase::IncrementUseCount(const CTextureDetails &details)
 {
-  std::string sql = PrepareSQL("UPDATE sizes SET usecount=usecount+1, lastusetime=CURRENT_TIMESTAMP WHERE idtexture=%u AND width=%u AND height=%u", details.id, details.width, details.height);
-  return ExecuteQuery(sql);
+  return ExecuteQuery("UPDATE sizes SET usecount=usecount+1, lastusetime=CURRENT_TIMESTAMP WHERE idtexture=? AND width=? AND height=?",
+                      Parameters(details.id)(details.width)(details.height));
+}
+
+std::string CTextureDatabase::GetIndexName() const
+{
+  return URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+}
+
+bool CTextureDatabase::LoadIndex()
+{
+  if (NULL == m_pDB.get()) return false;
+  if (NULL == m_pDS.get()) return false;
+
+  CTextureIndex &index = CTextureIndex::Get();
+  std::string database = GetIndexName();
+  {
+    CSingleLock lock(index.m_section);
+    if (index.IsLoaded(database))
+      return true;
+    if (!index.MayLoad())
+      return false;
+    index.m_loading = true;
+    index.m_pending.clear();
+  }
+
+  // read the table without holding the lock, so that lookups and writes of other threads go on
+  unsigned int time = XbmcThreads::SystemClockMillis();
+  CTextureIndex::Textures textures;
+  bool loaded = false;
+  try
+  {
+    m_pDS->query_streamed("SELECT url, id, cachedurl, lasthashcheck, imagehash, width, height FROM texture JOIN sizes ON (texture.id=sizes.idtexture AND sizes.size=1)");
+    while (!m_pDS->eof() && textures.size() <= MAX_INDEXED_TEXTURES)
+    {
+      const dbiplus::sql_record* const record = m_pDS->get_sql_record();
+      CTextureIndex::Texture &texture = textures[record->at(0).get_asString()];
+      texture.id = record->at(1).get_asInt();
+      texture.file = record->at(2).get_asString();
+      texture.lastHashCheck.SetFromDBDateTime(record->at(3).get_asString());
+      texture.hash = record->at(4).get_asString();
+      texture.width = record->at(5).get_asInt();
+      texture.height = record->at(6).get_asInt();
+      m_pDS->next();
+    }
+    m_pDS->close();
+    loaded = true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+
+  CSingleLock lock(index.m_section);
+  index.m_loading = false;
+  if (index.m_database != database)
+    return false; // the textures of another profile are used by now
+
+  // the writes made in the meantime may not be in what was read
+  for (std::vector<CTextureIndex::Write>::const_iterator it = index.m_pending.begin(); it != index.m_pending.end(); ++it)
+    CTextureIndex::Apply(textures, *it);
+  index.m_pending.clear();
+
+  if (!loaded)
+  {
+    index.Drop(index.GetRetryDelay());
+    return false;
+  }
+  if (textures.size() > MAX_INDEXED_TEXTURES)
+  {
+    CLog::Log(LOGDEBUG, "%s - more than %u textures, looking them up in the database", __FUNCTION__, MAX_INDEXED_TEXTURES);
+    index.Drop(INDEX_MAX_RETRY_DELAY);
+    return false;
+  }
+
+  index.m_textures.swap(textures);
+  index.m_loaded = true;
+  index.m_retryDelay = 0;
+  CLog::Log(LOGDEBUG, "%s - loaded %u textures in %u ms", __FUNCTION__, (unsigned int)index.m_textures.size(), XbmcThreads::SystemClockMillis() - time);
+  return true;
+}
+
+void CTextureDatabase::UpdateIndex(const std::string &url, int id, const CTextureDetails *details, const CDateTime *lastHashCheck)
+{
+  if (NULL == m_pDB.get()) return;
+
+  CTextureIndex::Write write;
+  write.url = url;
+  write.id = id;
+  write.added = details != NULL;
+  if (details != NULL)
+    write.details = *details;
+  write.checked = lastHashCheck != NULL;
+  if (lastHashCheck != NULL)
+    write.lastHashCheck = *lastHashCheck;
+
+  CTextureIndex &index = CTextureIndex::Get();
+  CSingleLock lock(index.m_section);
+  if (!index.IsLoaded(GetIndexName()))
+  {
+    if (index.m_loading)
+      index.m_pending.push_back(write);
+    return;
+  }
+
+  CTextureIndex::Apply(index.m_textures, write);
+  if (index.m_textures.size() > MAX_INDEXED_TEXTURES)
+  {
+    CLog::Log(LOGDEBUG, "%s - more than %u textures, looking them up in the database", __FUNCTION__, MAX_INDEXED_TEXTURES);
+    index.Drop(INDEX_MAX_RETRY_DELAY);
+  }
+}
+
+static bool SortByScore(const CTextureUsage &left, const CTextureUsage &right)
+{
+  if (left.score != right.score)
+    return left.score < right.score;
+  return left.id < right.id;
+}
+
+bool CTextureDatabase::GetTexturesByUsage(std::vector<CTextureUsage> &textures)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    CDateTime now = CDateTime::GetCurrentDateTime();
+    m_pDS->query_streamed("SELECT id, cachedurl, usecount, lastusetime FROM texture JOIN sizes ON (texture.id=sizes.idtexture AND sizes.size=1)");
+    while (!m_pDS->eof())
+    {
+      const dbiplus::sql_record* const record = m_pDS->get_sql_record();
+      CTextureUsage texture;
+      texture.id = record->at(0).get_asInt();
+      texture.file = record->at(1).get_asString();
+
+      // textures never used count as unused for a year
+      double days = 365.0;
+      CDateTime lastUsed;
+      lastUsed.SetFromDBDateTime(record->at(3).get_asString());
+      if (lastUsed.IsValid())
+      {
+        CDateTimeSpan age = now - lastUsed;
+        days = std::max(0.0, age.GetDays() + age.GetHours() / 24.0);
+      }
+      texture.score = record->at(2).get_asInt() / (1.0 + days);
+
+      textures.push_back(texture);
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    std::sort(textures.begin(), textures.end(), SortByScore);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
 }
 
 bool CTextureDatabase::GetCachedTexture(const std::string &url, CTextureDetails &details)
 {
+  if (LoadIndex())
+  {
+    CTextureIndex &index = CTextureIndex::Get();
+    CSingleLock lock(index.m_section);
+    if (index.IsLoaded(GetIndexName()))
+    {
+      CTextureIndex::Textures::const_iterator it = index.m_textures.find(url);
+      if (it == index.m_textures.end())
+        return false;
+
+      details.id = it->second.id;
+      details.file = it->second.file;
+      if (it->second.lastHashCheck.IsValid() && it->second.lastHashCheck + CDateTimeSpan(1,0,0,0) < CDateTime::GetCurrentDateTime())
+        details.hash = it->second.hash;
+      details.width = it->second.width;
+      details.height = it->second.height;
+      return true;
+    }
+  }
+
+  // the index is being loaded by another thread, has failed to load or is too large
   try
   {
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string sql = PrepareSQL("SELECT id, cachedurl, lasthashcheck, imagehash, width, height FROM texture JOIN sizes ON (texture.id=sizes.idtexture AND sizes.size=1) WHERE url='%s'", url.c_str());
-    m_pDS->query(sql.c_str());
+    m_pDS->query("SELECT id, cachedurl, lasthashcheck, imagehash, width, height FROM texture JOIN sizes ON (texture.id=sizes.idtexture AND sizes.size=1) WHERE url=?", Parameters(url));
     if (!m_pDS->eof())
     { // have some information
       details.id = m_pDS->fv(0).get_asInt();
@@ -329,9 +648,16 @@ bool CTextureDatabase::GetTextures(CVariant &items, const Filter &filter)
 
 bool CTextureDatabase::SetCachedTextureValid(const std::string &url, bool updateable)
 {
-  std::string date = updateable ? CDateTime::GetCurrentDateTime().GetAsDBDateTime() : "";
+  CDateTime lastHashCheck;
+  if (updateable)
+    lastHashCheck = CDateTime::GetCurrentDateTime();
+  std::string date = updateable ? lastHashCheck.GetAsDBDateTime() : "";
   std::string sql = PrepareSQL("UPDATE texture SET lasthashcheck='%s' WHERE url='%s'", date.c_str(), url.c_str());
-  return ExecuteQuery(sql);
+  if (!ExecuteQuery(sql))
+    return false;
+
+  UpdateIndex(url, -1, NULL, &lastHashCheck);
+  return true;
 }
 
 bool CTextureDatabase::AddCachedTexture(const std::string &url, const CTextureDetails &details)
@@ -344,7 +670,10 @@ bool CTextureDatabase::AddCachedTexture(const std::string &url, const CTextureDe
     std::string sql = PrepareSQL("DELETE FROM texture WHERE url='%s'", url.c_str());
     m_pDS->exec(sql.c_str());
 
-    std::string date = details.updateable ? CDateTime::GetCurrentDateTime().GetAsDBDateTime() : "";
+    CDateTime lastHashCheck;
+    if (details.updateable)
+      lastHashCheck = CDateTime::GetCurrentDateTime();
+    std::string date = details.updateable ? lastHashCheck.GetAsDBDateTime() : "";
     sql = PrepareSQL("INSERT INTO texture (id, url, cachedurl, imagehash, lasthashcheck) VALUES(NULL, '%s', '%s', '%s', '%s')", url.c_str(), details.file.c_str(), details.hash.c_str(), date.c_str());
     m_pDS->exec(sql.c_str());
     int textureID = (int)m_pDS->lastinsertid();
@@ -352,9 +681,12 @@ bool CTextureDatabase::AddCachedTexture(const std::string &url, const CTextureDe
     // set the size information
     sql = PrepareSQL("INSERT INTO sizes (idtexture, size, usecount, lastusetime, width, height) VALUES(%u, 1, 1, CURRENT_TIMESTAMP, %u, %u)", textureID, details.width, details.height);
     m_pDS->exec(sql.c_str());
+
+    UpdateIndex(url, textureID, &details, &lastHashCheck);
   }
   catch (...)
   {
+    UpdateIndex(url, -1);
     CLog::Log(LOGERROR, "%s failed on url '%s'", __FUNCTION__, url.c_str());
   }
   return true;
@@ -373,16 +705,18 @@ bool CTextureDatabase::ClearCachedTexture(int id, std::string &cacheFile)
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string sql = PrepareSQL("select cachedurl from texture where id=%u", id);
+    std::string sql = PrepareSQL("select cachedurl, url from texture where id=%u", id);
     m_pDS->query(sql.c_str());
 
     if (!m_pDS->eof())
     { // have some information
       cacheFile = m_pDS->fv(0).get_asString();
+      std::string url = m_pDS->fv(1).get_asString();
       m_pDS->close();
       // remove it
       sql = PrepareSQL("delete from texture where id=%u", id);
       m_pDS->exec(sql.c_str());
+      UpdateIndex(url, id);
       return true;
     }
     m_pDS->close();
@@ -396,9 +730,14 @@ bool CTextureDatabase::ClearCachedTexture(int id, std::string &cacheFile)
 
 bool CTextureDatabase::InvalidateCachedTexture(const std::string &url)
 {
-  std::string date = (CDateTime::GetCurrentDateTime() - CDateTimeSpan(2, 0, 0, 0)).GetAsDBDateTime();
+  CDateTime lastHashCheck = CDateTime::GetCurrentDateTime() - CDateTimeSpan(2, 0, 0, 0);
+  std::string date = lastHashCheck.GetAsDBDateTime();
   std::string sql = PrepareSQL("UPDATE texture SET lasthashcheck='%s' WHERE url='%s'", date.c_str(), url.c_str());
-  return ExecuteQuery(sql);
+  if (!ExecuteQuery(sql))
+    return false;
+
+  UpdateIndex(url, -1, NULL, &lastHashCheck);
+  return true;
 }
 
 std::string CTextureDatabase::GetTextureForPath(const std::string &url, const std::string &type)
@@ -411,8 +750,7 @@ std::string CTextureDatabase::GetTextureForPath(const std::string &url, const st
     if (url.empty())
       return "";
 
-    std::string sql = PrepareSQL("select texture from path where url='%s' and type='%s'", url.c_str(), type.c_str());
-    m_pDS->query(sql.c_str());
+    m_pDS->query("select texture from path where url=? and type=?", Parameters(url)(type));
 
     if (!m_pDS->eof())
     { // have some information
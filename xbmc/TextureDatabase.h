@@ -25,6 +25,7 @@
 #include "dbwrappers/DatabaseQuery.h"
 #include "utils/DatabaseUtils.h"
 
+class CDateTime;
 class CVariant;
 
 class CTextureRule : public CDatabaseQueryRule
@@ -65,6 +66,19 @@ public:
   static std::string UnwrapImageURL(const std::string &image);
 };
 
+/*!
+ \brief How much a cached texture is used, to decide which textures to evict
+ */
+class CTextureUsage
+{
+public:
+  CTextureUsage() : id(-1), score(0.0) { }
+
+  int          id;
+  std::string  file;
+  double       score; ///< uses divided by the days since the last use
+};
+
 class CTextureDatabase : public CDatabase, public IDatabaseQueryRuleFactory
 {
 public:
@@ -79,6 +93,12 @@ public:
   bool ClearCachedTexture(int textureID, std::string &cacheFile);
   bool IncrementUseCount(const CTextureDetails &details);
 
+  /*! \brief Get the cached textures ordered by how much they are used
+   \param textures [out] the cached textures, the ones least worth keeping first
+   \return true if the textures could be retrieved, false otherwise.
+   */
+  bool GetTexturesByUsage(std::vector<CTextureUsage> &textures);
+
   /*! \brief Invalidate a previously cached texture
    Invalidates the texture hash, and sets the texture update time to the current time so that
    next texture load it will be re-cached.
@@ -127,6 +147,22 @@ protected:
    */
   unsigned int GetURLHash(const std::string &url) const;
 
+  /*! \brief fill the index of the cached textures from the texture table, if not done yet
+   The table is read without holding the lock of the index. Only one connection reads it at a
+   time, a failed load is retried after a delay and tables too large for memory aren't read.
+   \return true if the index holds the textures of this database
+   */
+  bool LoadIndex();
+
+  /*! \brief bring the index of the cached textures in line with a write to the texture table
+   \param url url of the texture written
+   \param id id of the texture written
+   \param details details of a texture added, NULL if it wasn't added
+   \param lastHashCheck time of the last check for updates of the texture, NULL if the texture was removed
+   */
+  void UpdateIndex(const std::string &url, int id, const CTextureDetails *details = NULL, const CDateTime *lastHashCheck = NULL);
+  std::string GetIndexName() const;
+
   virtual void CreateTables();
   virtual void CreateAnalytics();
   virtual void UpdateTables(int version);
@@ -125,7 +125,7 @@ static void CheckScraperError(const TiXmlElement *pxeRoot)
   throw CScraperError(sTitle, sMessage);
 }
 
-CScraper::CScraper(const cp_extension_t *ext) : CAddon(ext), m_fLoaded(false)
+CScraper::CScraper(const cp_extension_t *ext) : CAddon(ext), m_fLoaded(false), m_httpCache(true)
 {
   if (ext)
   {
@@ -134,6 +134,7 @@ CScraper::CScraper(const cp_extension_t *ext) : CAddon(ext), m_fLoaded(false)
     std::string persistence = CAddonMgr::Get().GetExtValue(ext->configuration, "@cachepersistence");
     if (!persistence.empty())
       m_persistence.SetFromTimeString(persistence);
+    m_httpCache = CAddonMgr::Get().GetExtValue(ext->configuration, "@httpcache") != "false";
   }
   switch (Type())
   {
@@ -169,6 +170,7 @@ CScraper::CScraper(const CScraper &rhs)
   m_pathContent = rhs.m_pathContent;
   m_persistence = rhs.m_persistence;
   m_requiressettings = rhs.m_requiressettings;
+  m_httpCache = rhs.m_httpCache;
   m_language = rhs.m_language;
 }
 
@@ -333,7 +335,7 @@ std::string CScraper::InternalRun(const std::string& function,
   for (i=0;i<scrURL.m_url.size();++i)
   {
     std::string strCurrHTML;
-    if (!CScraperUrl::Get(scrURL.m_url[i],m_parser.m_param[i],http,ID()) || m_parser.m_param[i].size() == 0)
+    if (!CScraperUrl::Get(scrURL.m_url[i],m_parser.m_param[i],http,ID(),m_httpCache) || m_parser.m_param[i].size() == 0)
       return "";
   }
   // put the 'extra' parameterts into the parser parameter list too
@@ -170,6 +170,7 @@ private:
   std::string m_language;
   bool m_requiressettings;
   CDateTimeSpan m_persistence;
+  bool m_httpCache; ///< whether pages are fetched through the HTTP cache, unless httpcache="false"
   CONTENT_TYPE m_pathContent;
   CScraperParser m_parser;
 };
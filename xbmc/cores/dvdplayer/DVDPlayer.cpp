@@ -67,6 +67,7 @@
 #include "settings/MediaSettings.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
+#include "utils/PerformanceTrace.h"
 #include "utils/StreamDetails.h"
 #include "pvr/PVRManager.h"
 #include "pvr/channels/PVRChannel.h"
@@ -618,6 +619,7 @@ void CDVDPlayer::OnStartup()
 
 bool CDVDPlayer::OpenInputStream()
 {
+  TRACE_FUNCTION;
   if(m_pInputStream)
     SAFE_DELETE(m_pInputStream);
 
@@ -694,6 +696,7 @@ bool CDVDPlayer::OpenInputStream()
 
 bool CDVDPlayer::OpenDemuxStream()
 {
+  TRACE_FUNCTION;
   if(m_pDemuxer)
     SAFE_DELETE(m_pDemuxer);
 
@@ -808,6 +811,7 @@ void CDVDPlayer::OpenDefaultStreams(bool reset)
 
 bool CDVDPlayer::ReadPacket(DemuxPacket*& packet, CDemuxStream*& stream)
 {
+  TRACE_FUNCTION;
 
   // check if we should read from subtitle demuxer
   if( m_pSubtitleDemuxer && m_dvdPlayerSubtitle.AcceptsData() )
@@ -1311,6 +1315,7 @@ bool CDVDPlayer::CheckIsCurrent(CCurrentStream& current, CDemuxStream* stream, D
 
 void CDVDPlayer::ProcessPacket(CDemuxStream* pStream, DemuxPacket* pPacket)
 {
+  TRACE_FUNCTION;
     /* process packet if it belongs to selected stream. for dvd's don't allow automatic opening of streams*/
 
       if (CheckIsCurrent(m_CurrentAudio, pStream, pPacket))
@@ -2806,6 +2811,7 @@ void CDVDPlayer::ToFFRW(int iSpeed)
 
 bool CDVDPlayer::OpenStream(CCurrentStream& current, int iStream, int source, bool reset)
 {
+  TRACE_FUNCTION;
   CDemuxStream* stream = NULL;
   CDVDStreamInfo hint;
 
@@ -20,6 +20,9 @@
 
 #include "Database.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "filesystem/DirectoryFingerprint.h"
 #include "filesystem/SpecialProtocol.h"
 #include "filesystem/File.h"
 #include "profiles/ProfilesManager.h"
@@ -37,11 +40,112 @@
 
 #ifdef TARGET_POSIX
 #include "linux/ConvUtils.h"
+#if defined(TARGET_DARWIN) || defined(TARGET_FREEBSD)
+#include <sys/param.h>
+#include <sys/mount.h>
+#else
+#include <sys/vfs.h>
+#endif
 #endif
 
 using namespace dbiplus;
+using XFILE::CDirectoryFingerprint;
 
 #define MAX_COMPRESS_COUNT 20
+#define MAX_IDLE_CONNECTIONS 4 // per database
+#define MAX_BATCH_DURATION 1000 // ms a batch is kept open for
+
+namespace
+{
+  CCriticalSection revisionSection;
+  // revision counters by base name of the database, the map never removes
+  // an entry so the counters may be referenced by open connections
+  std::map<std::string, long> revisions;
+
+  CCriticalSection connectionSection;
+  // unused read-only connections by full path of the database file
+  std::multimap<std::string, Database*> idleConnections;
+
+  // WAL mode needs memory shared by all connections to a database, which
+  // network file systems can't provide
+  bool IsOnNetworkFileSystem(const std::string &folder)
+  {
+#if defined(TARGET_WINDOWS)
+    if (StringUtils::StartsWith(folder, "\\\\"))
+      return true;
+    if (folder.size() >= 2 && folder[1] == ':')
+      return GetDriveTypeA((folder.substr(0, 2) + "\\").c_str()) == DRIVE_REMOTE;
+    return false;
+#elif defined(TARGET_DARWIN) || defined(TARGET_FREEBSD)
+    struct statfs fsInfo;
+    return statfs(folder.c_str(), &fsInfo) == 0 && (fsInfo.f_flags & MNT_LOCAL) == 0;
+#elif defined(TARGET_POSIX)
+    struct statfs fsInfo;
+    if (statfs(folder.c_str(), &fsInfo) != 0)
+      return false;
+
+    switch ((uint32_t)fsInfo.f_type)
+    {
+    case 0x6969:     // NFS
+    case 0x517B:     // SMB
+    case 0xFF534D42: // CIFS
+    case 0xFE534D42: // SMB2
+    case 0x73757245: // Coda
+    case 0x5346414F: // AFS
+    case 0x01021997: // 9P
+    case 0x00C36400: // Ceph
+      return true;
+    default:
+      return false;
+    }
+#else
+    return false;
+#endif
+  }
+
+  std::string GetConnectionKey(const std::string &host, const std::string &dbName)
+  {
+    return URIUtils::AddFileToFolder(host, dbName);
+  }
+
+  void ReleaseConnection(Database *db)
+  {
+    std::string key = GetConnectionKey(db->getHostName(), db->getDatabase());
+    {
+      CSingleLock lock(connectionSection);
+      if (idleConnections.count(key) < MAX_IDLE_CONNECTIONS)
+      {
+        idleConnections.insert(std::make_pair(key, db));
+        return;
+      }
+    }
+
+    db->disconnect();
+    delete db;
+  }
+
+  // splits the search into lower case words the way the full text indexes do,
+  // characters beyond ASCII are left for the index to fold
+  std::vector<std::string> GetSearchWords(const std::string &search)
+  {
+    std::vector<std::string> words;
+    std::string word;
+    for (std::string::const_iterator it = search.begin(); it != search.end(); ++it)
+    {
+      unsigned char c = *it;
+      if (c >= 0x80 || isalnum(c))
+        word += (char)tolower(c);
+      else if (!word.empty())
+      {
+        words.push_back(word);
+        word.clear();
+      }
+    }
+    if (!word.empty())
+      words.push_back(word);
+    return words;
+  }
+}
 
 void CDatabase::Filter::AppendField(const std::string &strField)
 {
@@ -105,9 +209,14 @@ void CDatabase::Filter::AppendGroup(const std::string &strGroup)
 CDatabase::CDatabase(void)
 {
   m_openCount = 0;
+  m_readOnly = false;
   m_sqlite = true;
   m_bMultiWrite = false;
   m_multipleExecute = false;
+  m_batchSize = 0;
+  m_batchCount = 0;
+  m_batchStart = 0;
+  m_batchOpen = false;
 }
 
 CDatabase::~CDatabase(void)
@@ -198,9 +307,9 @@ bool CDatabase::CommitMultipleExecute()
 {
   m_multipleExecute = false;
   BeginTransaction();
-  for (std::vector<std::string>::const_iterator i = m_multipleQueries.begin(); i != m_multipleQueries.end(); ++i)
+  for (std::vector< std::pair<std::string, sql_record> >::const_iterator i = m_multipleQueries.begin(); i != m_multipleQueries.end(); ++i)
   {
-    if (!ExecuteQuery(*i))
+    if (!(i->second.empty() ? ExecuteQuery(i->first) : ExecuteQuery(i->first, i->second)))
     {
       RollbackTransaction();
       return false;
@@ -214,7 +323,7 @@ bool CDatabase::ExecuteQuery(const std::string &strQuery)
 {
   if (m_multipleExecute)
   {
-    m_multipleQueries.push_back(strQuery);
+    m_multipleQueries.push_back(std::make_pair(strQuery, sql_record()));
     return true;
   }
 
@@ -236,6 +345,32 @@ bool CDatabase::ExecuteQuery(const std::string &strQuery)
   return bReturn;
 }
 
+bool CDatabase::ExecuteQuery(const std::string &strQuery, const sql_record &params)
+{
+  if (m_multipleExecute)
+  {
+    m_multipleQueries.push_back(std::make_pair(strQuery, params));
+    return true;
+  }
+
+  bool bReturn = false;
+
+  try
+  {
+    if (NULL == m_pDB.get()) return bReturn;
+    if (NULL == m_pDS.get()) return bReturn;
+    m_pDS->exec(strQuery, params);
+    bReturn = true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to execute query '%s'",
+        __FUNCTION__, strQuery.c_str());
+  }
+
+  return bReturn;
+}
+
 bool CDatabase::ResultQuery(const std::string &strQuery)
 {
   bool bReturn = false;
@@ -258,6 +393,26 @@ bool CDatabase::ResultQuery(const std::string &strQuery)
   return bReturn;
 }
 
+bool CDatabase::ResultQuery(const std::string &strQuery, const sql_record &params)
+{
+  bool bReturn = false;
+
+  try
+  {
+    if (NULL == m_pDB.get()) return bReturn;
+    if (NULL == m_pDS.get()) return bReturn;
+
+    bReturn = m_pDS->query(strQuery, params);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to execute query '%s'",
+        __FUNCTION__, strQuery.c_str());
+  }
+
+  return bReturn;
+}
+
 bool CDatabase::QueueInsertQuery(const std::string &strQuery)
 {
   if (strQuery.empty())
@@ -323,9 +478,45 @@ bool CDatabase::Open(const DatabaseSettings &settings)
 
   std::string dbName = dbSettings.name;
   dbName += StringUtils::Format("%d", GetSchemaVersion());
+
+  // connections to a server are not pooled
+  if (m_readOnly && !m_sqlite)
+    m_readOnly = false;
+
+  if (m_readOnly)
+    return ConnectPooled(dbName, dbSettings);
+
   return Connect(dbName, dbSettings, false);
 }
 
+bool CDatabase::OpenReadOnly()
+{
+  if (IsOpen())
+    return Open();
+
+  m_readOnly = true;
+  if (Open())
+    return true;
+
+  m_readOnly = false;
+  return false;
+}
+
+void CDatabase::CloseIdleConnections()
+{
+  std::multimap<std::string, Database*> connections;
+  {
+    CSingleLock lock(connectionSection);
+    connections.swap(idleConnections);
+  }
+
+  for (std::multimap<std::string, Database*>::iterator it = connections.begin(); it != connections.end(); ++it)
+  {
+    it->second->disconnect();
+    delete it->second;
+  }
+}
+
 void CDatabase::InitSettings(DatabaseSettings &dbSettings)
 {
   m_sqlite = true;
@@ -493,12 +684,51 @@ bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSet
       m_pDS->exec("PRAGMA cache_size=4096\n");
       m_pDS->exec("PRAGMA synchronous='NORMAL'\n");
       m_pDS->exec("PRAGMA count_changes='OFF'\n");
+
+      // let readers continue while a writer is in a transaction. The journal
+      // mode is stored in the database file, so readers don't have to set it,
+      // and it's set back for databases which shouldn't use WAL (any more).
+      if (!m_readOnly)
+      {
+        bool wal = g_advancedSettings.m_databaseWAL;
+        if (wal && IsOnNetworkFileSystem(dbSettings.host))
+        {
+          CLog::Log(LOGDEBUG, "%s not using WAL mode for %s on a network file system", __FUNCTION__, dbName.c_str());
+          wal = false;
+        }
+
+        try
+        {
+          m_pDS->exec(wal ? "PRAGMA journal_mode=WAL\n" : "PRAGMA journal_mode=DELETE\n");
+        }
+        catch (DbErrors &error)
+        {
+          // e.g. while another connection is in a transaction, next time then
+          CLog::Log(LOGWARNING, "%s unable to set the journal mode: '%s'", __FUNCTION__, error.getMsg());
+        }
+      }
+      else
+      {
+        try
+        {
+          // catch anything that would try to write through a shared connection
+          m_pDS->exec("PRAGMA query_only=ON\n");
+        }
+        catch (DbErrors &error)
+        {
+          CLog::Log(LOGWARNING, "%s unable to make the connection read-only: '%s'", __FUNCTION__, error.getMsg());
+        }
+      }
     }
+
+    // only count the changes made after the connection has been set up
+    m_pDB->setChangeCounter(GetRevisionCounter(GetBaseDBName()));
   }
   catch (DbErrors &error)
   {
     CLog::Log(LOGERROR, "%s failed with '%s'", __FUNCTION__, error.getMsg());
     m_openCount = 1; // set to open so we can execute Close()
+    m_readOnly = false; // don't hand the connection to the pool
     Close();
     return false;
   }
@@ -507,6 +737,311 @@ bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSet
   return true;
 }
 
+bool CDatabase::ConnectPooled(const std::string &dbName, const DatabaseSettings &dbSettings)
+{
+  Database *db = NULL;
+  {
+    CSingleLock lock(connectionSection);
+    std::multimap<std::string, Database*>::iterator it = idleConnections.find(GetConnectionKey(dbSettings.host, dbName));
+    if (it != idleConnections.end())
+    {
+      db = it->second;
+      idleConnections.erase(it);
+    }
+  }
+
+  if (db != NULL)
+  {
+    m_pDB.reset(db);
+    m_pDS.reset(m_pDB->CreateDataset());
+    m_pDS2.reset(m_pDB->CreateDataset());
+    m_openCount = 1;
+    return true;
+  }
+
+  return Connect(dbName, dbSettings, false);
+}
+
+long CDatabase::GetRevision(const std::string &baseDBName)
+{
+  return *GetRevisionCounter(baseDBName);
+}
+
+volatile long *CDatabase::GetRevisionCounter(const std::string &baseDBName)
+{
+  CSingleLock lock(revisionSection);
+  return &revisions[baseDBName];
+}
+
+std::string CDatabase::GetSearchCondition(const std::string &table, const std::string &idField, const std::string &field,
+                                          const std::string &id, const std::string &search) const
+{
+  std::vector<std::string> words = GetSearchWords(search);
+  if (words.empty())
+    return PrepareSQL("%s IN (SELECT %s FROM %s WHERE %s LIKE '%%%s%%')", id.c_str(), idField.c_str(), table.c_str(), field.c_str(), search.c_str());
+
+  // every word has to match as a prefix, MySQL can only be asked for the words it indexes
+  std::string match, like;
+  const SearchIndex &index = GetSearchIndex(table);
+  for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it)
+  {
+    if (index.exists && IsIndexedWord(index, *it))
+    {
+      if (!match.empty())
+        match += " ";
+      match += (m_sqlite ? "" : "+") + *it + "*";
+    }
+    else
+    {
+      if (!like.empty())
+        like += " AND ";
+      like += PrepareSQL("(%s LIKE '%s%%' OR %s LIKE '%% %s%%')", field.c_str(), it->c_str(), field.c_str(), it->c_str());
+    }
+  }
+
+  if (match.empty())
+    return PrepareSQL("%s IN (SELECT %s FROM %s WHERE ", id.c_str(), idField.c_str(), table.c_str()) + like + ")";
+
+  if (m_sqlite)
+    return PrepareSQL("%s IN (SELECT docid FROM %ssearch WHERE %ssearch MATCH '%s')", id.c_str(), table.c_str(), table.c_str(), match.c_str());
+
+  std::string condition = PrepareSQL("%s IN (SELECT %s FROM %s WHERE MATCH(%s) AGAINST('%s' IN BOOLEAN MODE)",
+                                     id.c_str(), idField.c_str(), table.c_str(), field.c_str(), match.c_str());
+  if (!like.empty())
+    condition += " AND " + like;
+  return condition + ")";
+}
+
+void CDatabase::CreateSearchIndex(const std::string &table, const std::string &idField, const std::string &field)
+{
+  m_searchIndexes.erase(table);
+
+  if (!m_sqlite)
+  {
+    try
+    {
+      m_pDS->exec(PrepareSQL("CREATE FULLTEXT INDEX ix_%s_search ON %s (%s)", table.c_str(), table.c_str(), field.c_str()));
+    }
+    catch (...)
+    {
+      CLog::Log(LOGWARNING, "%s - no full text index on %s.%s, searching it will be slow", __FUNCTION__, table.c_str(), field.c_str());
+    }
+    return;
+  }
+
+  // the unicode61 tokenizer folds diacritics but needs SQLite 3.7.13
+  const char *tokenizers[] = { "unicode61", "simple" };
+  for (unsigned int i = 0; i < sizeof(tokenizers) / sizeof(tokenizers[0]); i++)
+  {
+    try
+    {
+      m_pDS->exec(PrepareSQL("DROP TABLE IF EXISTS %ssearch", table.c_str()));
+      m_pDS->exec(PrepareSQL("CREATE VIRTUAL TABLE %ssearch USING fts4(%s, tokenize=%s)", table.c_str(), field.c_str(), tokenizers[i]));
+      break;
+    }
+    catch (...)
+    {
+      CLog::Log(LOGWARNING, "%s - the %s tokenizer isn't available for %s.%s", __FUNCTION__, tokenizers[i], table.c_str(), field.c_str());
+      if (i + 1 == sizeof(tokenizers) / sizeof(tokenizers[0]))
+        return;
+    }
+  }
+
+  m_pDS->exec(PrepareSQL("INSERT INTO %ssearch (docid, %s) SELECT %s, %s FROM %s", table.c_str(), field.c_str(), idField.c_str(), field.c_str(), table.c_str()));
+  m_pDS->exec(PrepareSQL("CREATE TRIGGER %ssearch_insert AFTER INSERT ON %s FOR EACH ROW BEGIN "
+                         "REPLACE INTO %ssearch (docid, %s) VALUES (new.%s, new.%s); "
+                         "END", table.c_str(), table.c_str(), table.c_str(), field.c_str(), idField.c_str(), field.c_str()));
+  m_pDS->exec(PrepareSQL("CREATE TRIGGER %ssearch_update AFTER UPDATE OF %s, %s ON %s FOR EACH ROW BEGIN "
+                         "DELETE FROM %ssearch WHERE docid=old.%s; "
+                         "REPLACE INTO %ssearch (docid, %s) VALUES (new.%s, new.%s); "
+                         "END", table.c_str(), idField.c_str(), field.c_str(), table.c_str(), table.c_str(), idField.c_str(),
+                         table.c_str(), field.c_str(), idField.c_str(), field.c_str()));
+  m_pDS->exec(PrepareSQL("CREATE TRIGGER %ssearch_delete AFTER DELETE ON %s FOR EACH ROW BEGIN "
+                         "DELETE FROM %ssearch WHERE docid=old.%s; "
+                         "END", table.c_str(), table.c_str(), table.c_str(), idField.c_str()));
+}
+
+const CDatabase::SearchIndex &CDatabase::GetSearchIndex(const std::string &table) const
+{
+  std::map<std::string, SearchIndex>::const_iterator it = m_searchIndexes.find(table);
+  if (it != m_searchIndexes.end())
+    return it->second;
+
+  SearchIndex &index = m_searchIndexes[table];
+  if (NULL == m_pDB.get())
+    return index;
+
+  std::string sql;
+  if (m_sqlite)
+    sql = PrepareSQL("SELECT 1 FROM sqlite_master WHERE type='table' AND name='%ssearch'", table.c_str());
+  else
+    sql = PrepareSQL("SELECT engine FROM information_schema.statistics JOIN information_schema.tables USING (table_schema, table_name) "
+                     "WHERE table_schema=DATABASE() AND table_name='%s' AND index_name='ix_%s_search'", table.c_str(), table.c_str());
+
+  try
+  {
+    std::auto_ptr<Dataset> ds(m_pDB->CreateDataset());
+    index.exists = ds->query(sql.c_str()) && ds->num_rows() > 0;
+    std::string engine = index.exists && !m_sqlite ? ds->fv(0).get_asString() : "";
+    ds->close();
+    if (engine.empty())
+      return index;
+
+    // words shorter than the minimum length and stopwords aren't in the index, MATCH() never finds
+    // rows for them. InnoDB lists its stopwords, MyISAM's built-in ones and stopword files can't be read.
+    if (StringUtils::EqualsNoCase(engine, "InnoDB"))
+    {
+      ds->query("SELECT @@innodb_ft_min_token_size, @@innodb_ft_enable_stopword, @@innodb_ft_user_stopword_table, @@innodb_ft_server_stopword_table");
+      index.minWordLength = ds->fv(0).get_asInt();
+      bool stopwords = ds->fv(1).get_asInt() != 0;
+      std::string stopwordTable = ds->fv(2).get_asString();
+      if (stopwordTable.empty())
+        stopwordTable = ds->fv(3).get_asString();
+      ds->close();
+
+      if (stopwords)
+      {
+        // the stopword tables are given as "database/table"
+        if (stopwordTable.empty())
+          sql = "SELECT value FROM information_schema.INNODB_FT_DEFAULT_STOPWORD";
+        else
+        {
+          StringUtils::Replace(stopwordTable, "/", "`.`");
+          sql = "SELECT value FROM `" + stopwordTable + "`";
+        }
+        if (ds->query(sql.c_str()))
+        {
+          for (; !ds->eof(); ds->next())
+          {
+            std::string stopword = ds->fv(0).get_asString();
+            StringUtils::ToLower(stopword);
+            index.stopwords.insert(stopword);
+          }
+        }
+        ds->close();
+      }
+    }
+    else
+    {
+      ds->query("SELECT @@ft_min_word_len, @@ft_stopword_file");
+      index.minWordLength = ds->fv(0).get_asInt();
+      index.stopwordsKnown = ds->fv(1).get_asString().empty();
+      ds->close();
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed on query '%s'", __FUNCTION__, sql.c_str());
+    index.stopwordsKnown = false;
+  }
+
+  if (!index.stopwordsKnown)
+    CLog::Log(LOGDEBUG, "%s - the stopwords of the full text index on %s are unknown, searching it with LIKE", __FUNCTION__, table.c_str());
+  return index;
+}
+
+bool CDatabase::IsIndexedWord(const SearchIndex &index, const std::string &word) const
+{
+  if (!index.stopwordsKnown)
+    return false;
+
+  // MySQL counts characters, not the bytes of their UTF-8 encoding
+  unsigned int length = 0;
+  for (std::string::const_iterator it = word.begin(); it != word.end(); ++it)
+  {
+    if ((*it & 0xC0) != 0x80)
+      length++;
+  }
+  return length >= index.minWordLength && index.stopwords.find(word) == index.stopwords.end();
+}
+
+void CDatabase::CreateFingerprintTable()
+{
+  CLog::Log(LOGINFO, "create pathfingerprint table");
+  m_pDS->exec("CREATE TABLE pathfingerprint (strPath text, iModified bigint, iEntries integer, strHash text)");
+}
+
+bool CDatabase::GetFingerprint(CDirectoryFingerprint &fingerprint)
+{
+  const std::string &root = fingerprint.GetRoot();
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    CDirectoryFingerprint::FOLDERS folders;
+    m_pDS->query("SELECT strPath, iModified, iEntries, strHash FROM pathfingerprint WHERE strPath>=? AND strPath<?",
+                 Parameters(root)(CDirectoryFingerprint::GetEndOfTree(root)));
+    while (!m_pDS->eof())
+    {
+      // the collation of the column may not be binary
+      std::string path = m_pDS->fv(0).get_asString();
+      if (StringUtils::StartsWith(path, root))
+      {
+        CDirectoryFingerprint::CFolder &folder = folders[path];
+        folder.modified = m_pDS->fv(1).get_asInt64();
+        folder.entries = m_pDS->fv(2).get_asInt();
+        folder.hash = m_pDS->fv(3).get_asString();
+      }
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (folders.find(root) == folders.end())
+      return false;
+    fingerprint.SetFolders(folders);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to get the fingerprint of %s", __FUNCTION__, root.c_str());
+  }
+  return false;
+}
+
+bool CDatabase::SetFingerprint(const CDirectoryFingerprint &fingerprint)
+{
+  BeginTransaction();
+  bool success = DeleteFingerprint(fingerprint.GetRoot());
+
+  const CDirectoryFingerprint::FOLDERS &folders = fingerprint.GetFolders();
+  for (CDirectoryFingerprint::FOLDERS::const_iterator it = folders.begin(); success && it != folders.end(); ++it)
+    success = ExecuteQuery("INSERT INTO pathfingerprint (strPath, iModified, iEntries, strHash) VALUES (?, ?, ?, ?)",
+                           Parameters(it->first)(it->second.modified)(it->second.entries)(it->second.hash));
+
+  if (success)
+    return CommitTransaction();
+  RollbackTransaction();
+  return false;
+}
+
+bool CDatabase::DeleteFingerprint(const std::string &path)
+{
+  std::string root(path);
+  URIUtils::AddSlashAtEnd(root);
+  return ExecuteQuery("DELETE FROM pathfingerprint WHERE strPath>=? AND strPath<?",
+                      Parameters(root)(CDirectoryFingerprint::GetEndOfTree(root)));
+}
+
+bool CDatabase::DeleteFingerprintsAbove(const std::string &path)
+{
+  // the trees are rooted at the path itself or at any of its parents
+  std::string folder(path);
+  URIUtils::AddSlashAtEnd(folder);
+  bool success = true;
+  while (success && !folder.empty())
+  {
+    success = ExecuteQuery("DELETE FROM pathfingerprint WHERE strPath=?", Parameters(folder));
+
+    std::string parent;
+    if (!URIUtils::GetParentPath(folder, parent) || parent == folder)
+      break;
+    URIUtils::AddSlashAtEnd(parent);
+    folder = parent;
+  }
+  return success;
+}
+
 int CDatabase::GetDBVersion()
 {
   m_pDS->query("SELECT idVersion FROM version\n");
@@ -579,8 +1114,24 @@ void CDatabase::Close()
   m_openCount = 0;
   m_multipleExecute = false;
 
+  if (m_batchSize > 0)
+    CommitBatch();
+
+  bool pooled = m_readOnly;
+  m_readOnly = false;
+  m_searchIndexes.clear();
+
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
+
+  if (pooled && m_pDB->isActive() && !m_pDB->in_transaction())
+  {
+    m_pDS.reset();
+    m_pDS2.reset();
+    ReleaseConnection(m_pDB.release());
+    return;
+  }
+
   m_pDB->disconnect();
   m_pDB.reset();
   m_pDS.reset();
@@ -632,8 +1183,22 @@ void CDatabase::BeginTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (NULL == m_pDB.get())
+      return;
+
+    if (m_batchSize == 0)
+    {
       m_pDB->start_transaction();
+      return;
+    }
+
+    if (!m_batchOpen)
+    {
+      m_pDB->start_transaction();
+      m_batchOpen = true;
+      m_batchStart = XbmcThreads::SystemClockMillis();
+    }
+    m_pDS2->exec("SAVEPOINT batch_item");
   }
   catch (...)
   {
@@ -645,14 +1210,26 @@ bool CDatabase::CommitTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (NULL == m_pDB.get())
+      return true;
+
+    if (m_batchSize == 0)
+    {
       m_pDB->commit_transaction();
+      return true;
+    }
+
+    m_pDS2->exec("RELEASE SAVEPOINT batch_item");
   }
   catch (...)
   {
     CLog::Log(LOGERROR, "database:committransaction failed");
     return false;
   }
+
+  if (++m_batchCount >= m_batchSize || XbmcThreads::SystemClockMillis() - m_batchStart >= MAX_BATCH_DURATION)
+    return FlushBatch();
+
   return true;
 }
 
@@ -660,8 +1237,18 @@ void CDatabase::RollbackTransaction()
 {
   try
   {
-    if (NULL != m_pDB.get())
+    if (NULL == m_pDB.get())
+      return;
+
+    if (m_batchSize == 0)
+    {
       m_pDB->rollback_transaction();
+      return;
+    }
+
+    // keep what the other transactions of the batch did
+    m_pDS2->exec("ROLLBACK TO SAVEPOINT batch_item");
+    m_pDS2->exec("RELEASE SAVEPOINT batch_item");
   }
   catch (...)
   {
@@ -669,6 +1256,41 @@ void CDatabase::RollbackTransaction()
   }
 }
 
+void CDatabase::BeginBatch(unsigned int batchSize)
+{
+  if (m_batchSize > 0)
+    FlushBatch();
+
+  m_batchSize = batchSize;
+}
+
+bool CDatabase::CommitBatch()
+{
+  bool bReturn = FlushBatch();
+  m_batchSize = 0;
+  return bReturn;
+}
+
+bool CDatabase::FlushBatch()
+{
+  m_batchCount = 0;
+  if (!m_batchOpen)
+    return true;
+
+  m_batchOpen = false;
+  try
+  {
+    if (NULL != m_pDB.get())
+      m_pDB->commit_transaction();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "database:commitbatch failed");
+    return false;
+  }
+  return true;
+}
+
 bool CDatabase::InTransaction()
 {
   if (NULL != m_pDB.get()) return false;
@@ -722,6 +1344,137 @@ bool CDatabase::BuildSQL(const std::string &strQuery, const Filter &filter, std:
   return true;
 }
 
+std::string CDatabase::GetTextOrder(const std::string &column, bool ignoreArticles) const
+{
+  std::string order = column;
+  if (ignoreArticles && !g_advancedSettings.m_vecTokens.empty())
+  {
+    // same as SortUtils::RemoveArticles()
+    order = "CASE";
+    for (std::vector<std::string>::const_iterator token = g_advancedSettings.m_vecTokens.begin(); token != g_advancedSettings.m_vecTokens.end(); ++token)
+    {
+      std::string lowerToken = *token;
+      StringUtils::ToLower(lowerToken);
+      order += StringUtils::Format(" WHEN length(%s) > %u AND lower(substr(%s, 1, %u)) = ", column.c_str(), (unsigned int)token->size(), column.c_str(), (unsigned int)token->size());
+      order += PrepareSQL("'%s'", lowerToken.c_str());
+      order += StringUtils::Format(" THEN substr(%s, %u)", column.c_str(), (unsigned int)token->size() + 1);
+    }
+    order += " ELSE " + column + " END";
+  }
+
+  // MySQL's default collations already ignore case
+  if (m_sqlite)
+    order += " COLLATE NOCASE";
+
+  return order;
+}
+
+bool CDatabase::BuildOrderClause(const SortDescription &sorting, const MediaType &mediaType, std::string &orderClause) const
+{
+  bool ignoreArticles = (sorting.sortAttributes & SortAttributeIgnoreArticle) == SortAttributeIgnoreArticle;
+
+  std::string id = DatabaseUtils::GetField(FieldId, mediaType, DatabaseQueryPartSelect);
+  if (id.empty())
+    return false;
+
+  // the columns the labels are made of, see DatabaseUtils::GetDatabaseResults(). Episode
+  // labels start with their season and episode numbers which are stored as text.
+  std::vector<std::string> label;
+  if (mediaType == MediaTypeMovie || mediaType == MediaTypeTvShow || mediaType == MediaTypeMusicVideo)
+    label.push_back(GetTextOrder(DatabaseUtils::GetField(FieldTitle, mediaType, DatabaseQueryPartSelect), ignoreArticles));
+  else if (mediaType == MediaTypeAlbum)
+    label.push_back(GetTextOrder(DatabaseUtils::GetField(FieldAlbum, mediaType, DatabaseQueryPartSelect), ignoreArticles));
+  else if (mediaType == MediaTypeArtist)
+    label.push_back(GetTextOrder(DatabaseUtils::GetField(FieldArtist, mediaType, DatabaseQueryPartSelect), ignoreArticles));
+  else if (mediaType == MediaTypeSong)
+  {
+    // "<track>. <title>" never starts with an article
+    label.push_back(DatabaseUtils::GetField(FieldTrackNumber, mediaType, DatabaseQueryPartSelect));
+    label.push_back(GetTextOrder(DatabaseUtils::GetField(FieldTitle, mediaType, DatabaseQueryPartSelect), false));
+  }
+
+  std::vector<std::string> terms;
+  std::string column;
+  switch (sorting.sortBy)
+  {
+    case SortByLabel:
+      terms = label;
+      break;
+
+    case SortByTitle:
+      column = DatabaseUtils::GetField(FieldTitle, mediaType, DatabaseQueryPartSelect);
+      if (!column.empty())
+        terms.push_back(GetTextOrder(column, ignoreArticles));
+      break;
+
+    case SortBySortTitle:
+      // the title is used for items without a sort title
+      if (mediaType == MediaTypeMovie || mediaType == MediaTypeTvShow)
+        terms.push_back(GetTextOrder(DatabaseUtils::GetField(FieldTitle, mediaType, DatabaseQueryPartOrderBy), ignoreArticles));
+      break;
+
+    case SortByYear:
+      if (mediaType == MediaTypeMovie || mediaType == MediaTypeAlbum)
+      {
+        terms.push_back(DatabaseUtils::GetField(FieldYear, mediaType, DatabaseQueryPartOrderBy));
+        // the album is compared without its articles whatever the attributes say
+        if (mediaType == MediaTypeAlbum)
+          terms.push_back(GetTextOrder(DatabaseUtils::GetField(FieldAlbum, mediaType, DatabaseQueryPartSelect), true));
+      }
+      break;
+
+    case SortByRating:
+      // the ratings of the other media types are stored as text
+      if (mediaType == MediaTypeMovie || mediaType == MediaTypeAlbum || mediaType == MediaTypeSong)
+        terms.push_back(DatabaseUtils::GetField(FieldRating, mediaType, DatabaseQueryPartOrderBy));
+      break;
+
+    case SortByPlaycount:
+      terms.push_back(DatabaseUtils::GetField(FieldPlaycount, mediaType, DatabaseQueryPartOrderBy));
+      break;
+
+    case SortByLastPlayed:
+      terms.push_back(DatabaseUtils::GetField(FieldLastPlayed, mediaType, DatabaseQueryPartOrderBy));
+      break;
+
+    case SortByDateAdded:
+      // followed by the id, just like SortUtils compares them
+      terms.push_back(DatabaseUtils::GetField(FieldDateAdded, mediaType, DatabaseQueryPartOrderBy));
+      break;
+
+    default:
+      break;
+  }
+
+  if (terms.empty())
+    return false;
+
+  // the values are followed by the label when SortUtils compares them
+  if (sorting.sortBy == SortByYear || sorting.sortBy == SortByRating ||
+      sorting.sortBy == SortByPlaycount || sorting.sortBy == SortByLastPlayed)
+  {
+    if (label.empty())
+      return false;
+    terms.insert(terms.end(), label.begin(), label.end());
+  }
+  terms.push_back(id);
+
+  orderClause = " ORDER BY ";
+  for (std::vector<std::string>::const_iterator term = terms.begin(); term != terms.end(); ++term)
+  {
+    if (term->empty())
+      return false;
+
+    if (term != terms.begin())
+      orderClause += ", ";
+    orderClause += *term;
+    if (sorting.sortOrder == SortOrderDescending)
+      orderClause += " DESC";
+  }
+
+  return true;
+}
+
 bool CDatabase::BuildSQL(const std::string &strBaseDir, const std::string &strQuery, Filter &filter, std::string &strSQL, CDbUrl &dbUrl)
 {
   SortDescription sorting;
@@ -25,10 +25,19 @@ namespace dbiplus {
   class Dataset;
 }
 
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "qry_dat.h"
+#include "media/MediaType.h"
+
+namespace XFILE {
+  class CDirectoryFingerprint;
+}
+
 class DatabaseSettings; // forward
 class CDbUrl;
 struct SortDescription;
@@ -57,6 +66,19 @@ public:
     std::string limit;
   };
 
+  /*!
+   * @brief Values for the '?' placeholders of a query, e.g.
+   *        ResultQuery("SELECT idFile FROM files WHERE idPath=? AND strFilename=?", Parameters(idPath)(strFileName))
+   */
+  class Parameters : public dbiplus::sql_record
+  {
+  public:
+    Parameters() {};
+    template<typename T> Parameters(const T &value) { push_back(dbiplus::field_value(value)); };
+
+    template<typename T> Parameters& operator()(const T &value) { push_back(dbiplus::field_value(value)); return *this; };
+  };
+
   CDatabase(void);
   virtual ~CDatabase(void);
   bool IsOpen();
@@ -66,13 +88,82 @@ public:
 
   bool Open(const DatabaseSettings &db);
 
+  /*! \brief Open the database for queries that don't change it.
+   SQLite connections opened this way are taken from a pool of read-only
+   connections shared by all instances and handed back to it on Close().
+   As the databases are kept in WAL mode, reading does not wait for a
+   writer (e.g. a running library scan) to finish its transaction.
+   \return true if the database was opened, false otherwise.
+   \sa Open, CloseIdleConnections
+   */
+  bool OpenReadOnly();
+
+  /*! \brief Close all read-only connections which are not in use.
+   */
+  static void CloseIdleConnections();
+
   void BeginTransaction();
   virtual bool CommitTransaction();
-  void RollbackTransaction();
+  virtual void RollbackTransaction();
   bool InTransaction();
 
+  /*!
+   * @brief Combine the following transactions into larger ones, e.g. while
+   *        adding many items. Until CommitBatch() is called, BeginTransaction()
+   *        and CommitTransaction() only set and release a savepoint within
+   *        the transaction of the batch and RollbackTransaction() only undoes
+   *        the changes made since the savepoint. The batch is committed every
+   *        batchSize transactions or after a second, whichever comes first.
+   *        As the open batch holds the database's write lock, call FlushBatch()
+   *        before anything that may take long, e.g. network I/O.
+   * @param batchSize The number of transactions to commit at once.
+   * @sa CommitBatch, FlushBatch
+   */
+  void BeginBatch(unsigned int batchSize);
+
+  /*!
+   * @brief Commit the transactions of the batch so far, the batch stays in
+   *        place for the following transactions.
+   * @return True if there was nothing to commit or committing succeeded.
+   * @sa BeginBatch
+   */
+  bool FlushBatch();
+
+  /*!
+   * @brief Commit the open batch and return to separate transactions.
+   * @return True if the batch was committed successfully, false otherwise.
+   * @sa BeginBatch
+   */
+  bool CommitBatch();
+  bool InBatch() const { return m_batchSize > 0; };
+
   std::string PrepareSQL(std::string strStmt, ...) const;
 
+  /*! \brief Get the revision of a database.
+   The revision is increased whenever a statement changes the database through
+   any connection, so results computed from the database remain valid for as
+   long as its revision stays the same.
+   \param baseDBName base name of the database (see GetBaseDBName()).
+   \return the current revision of the database.
+   */
+  static long GetRevision(const std::string &baseDBName);
+
+  /*! \brief Get the condition matching the rows of a table whose column has words starting with every word of the search.
+   The full text index created by CreateSearchIndex() is used if there is one. With SQLite matching ignores case and
+   diacritics, with MySQL it depends on the collation. Words MySQL doesn't index, those shorter than its minimum
+   word length and stopwords, are matched with LIKE within the rows found by the index. Without an index, or if
+   none of the words are indexed, the column is searched with LIKE.
+   \param table the indexed table, e.g. "song".
+   \param idField the id column of the table, e.g. "idSong".
+   \param field the indexed column of the table, e.g. "strTitle".
+   \param id the id of the rows in the query using the condition, e.g. "songview.idSong".
+   \param search the words to search for.
+   \return the condition for the WHERE clause of the query.
+   \sa CreateSearchIndex
+   */
+  std::string GetSearchCondition(const std::string &table, const std::string &idField, const std::string &field,
+                                 const std::string &id, const std::string &search) const;
+
   /*!
    * @brief Get a single value from a table.
    * @remarks The values of the strWhereClause and strOrderBy parameters have to be FormatSQL'ed when used.
@@ -110,6 +201,17 @@ public:
    */
   bool ExecuteQuery(const std::string &strQuery);
 
+  /*!
+   * @brief Execute a single statement that does not return any result with
+   *        the given values bound to its '?' placeholders. Statements are
+   *        prepared only once per connection where the backend supports it.
+   * @param strQuery The statement to execute.
+   * @param params The values of the placeholders.
+   * @return True if the query was executed successfully, false otherwise.
+   * @sa ExecuteQuery, Parameters
+   */
+  bool ExecuteQuery(const std::string &strQuery, const dbiplus::sql_record &params);
+
   /*!
    * @brief Execute a query that returns a result.
    * @remarks Call m_pDS->close(); to clean up the dataset when done.
@@ -118,6 +220,17 @@ public:
    */
   bool ResultQuery(const std::string &strQuery);
 
+  /*!
+   * @brief Execute a query that returns a result with the given values bound
+   *        to its '?' placeholders.
+   * @remarks Call m_pDS->close(); to clean up the dataset when done.
+   * @param strQuery The query to execute.
+   * @param params The values of the placeholders.
+   * @return True if the query was executed successfully, false otherwise.
+   * @sa ResultQuery, Parameters
+   */
+  bool ResultQuery(const std::string &strQuery, const dbiplus::sql_record &params);
+
   /*!
    * @brief Start a multiple execution queue. Any ExecuteQuery() function
    *        following this call will be queued rather than executed until
@@ -157,6 +270,28 @@ public:
    */
   bool CommitInsertQueries();
 
+  /*! \brief Get the stored fingerprint of a directory tree.
+   \param fingerprint the fingerprint to fill, for the tree at its root.
+   \return true if a fingerprint of the tree was stored, false otherwise.
+   \sa SetFingerprint, XFILE::CDirectoryFingerprint
+   */
+  bool GetFingerprint(XFILE::CDirectoryFingerprint &fingerprint);
+
+  /*! \brief Store the fingerprint of a directory tree, replacing whatever was stored below its root.
+   An empty fingerprint just removes the stored one.
+   \return true if the fingerprint was stored, false otherwise.
+   */
+  bool SetFingerprint(const XFILE::CDirectoryFingerprint &fingerprint);
+
+  /*! \brief Remove the stored fingerprints of a directory and everything below it, e.g. when its settings changed.
+   */
+  bool DeleteFingerprint(const std::string &path);
+
+  /*! \brief Remove the stored fingerprints of the trees a path lies in, so that their next scan doesn't skip it,
+   e.g. when an item below it was removed from the library.
+   */
+  bool DeleteFingerprintsAbove(const std::string &path);
+
   virtual bool GetFilter(CDbUrl &dbUrl, Filter &filter, SortDescription &sorting) { return true; }
   virtual bool BuildSQL(const std::string &strBaseDir, const std::string &strQuery, Filter &filter, std::string &strSQL, CDbUrl &dbUrl);
   virtual bool BuildSQL(const std::string &strBaseDir, const std::string &strQuery, Filter &filter, std::string &strSQL, CDbUrl &dbUrl, SortDescription &sorting);
@@ -190,6 +325,21 @@ protected:
    */
   virtual void UpdateTables(int version) {};
 
+  /*! \brief Create a full text index over a column of a table for GetSearchCondition().
+   SQLite keeps the words in an FTS4 table updated by triggers, MySQL uses a FULLTEXT index. If the
+   backend doesn't support either, searches fall back to LIKE. Call from CreateAnalytics().
+   \param table the table to index, e.g. "song".
+   \param idField the id column of the table, e.g. "idSong".
+   \param field the column to index, e.g. "strTitle".
+   \sa GetSearchCondition
+   */
+  void CreateSearchIndex(const std::string &table, const std::string &idField, const std::string &field);
+
+  /*! \brief Create the table of the directory fingerprints, see GetFingerprint().
+   Call from CreateTables() and from UpdateTables() of the version introducing it.
+   */
+  void CreateFingerprintTable();
+
   /* \brief The minimum schema version that we support updating from.
    */
   virtual int GetMinSchemaVersion() const { return 0; };
@@ -204,6 +354,17 @@ protected:
 
   bool BuildSQL(const std::string &strQuery, const Filter &filter, std::string &strSQL);
 
+  /*! \brief Build the ORDER BY clause sorting the rows of a view the way SortUtils sorts their items.
+   Only sort methods whose fields all map to columns of the view are supported. Text columns are compared
+   ignoring case but not naturally, so numbers within titles are ordered by their digits. The id of the rows
+   is the last order term so that the order is stable across LIMIT ranges.
+   \param sorting the sort method, order and attributes to translate.
+   \param mediaType the media type of the rows of the view.
+   \param orderClause the resulting " ORDER BY ..." clause.
+   \return true if the sort method could be translated, false if the rows have to be sorted with SortUtils.
+   */
+  bool BuildOrderClause(const SortDescription &sorting, const MediaType &mediaType, std::string &orderClause) const;
+
   bool m_sqlite; ///< \brief whether we use sqlite (defaults to true)
 
   std::auto_ptr<dbiplus::Database> m_pDB;
@@ -213,11 +374,39 @@ protected:
 private:
   void InitSettings(DatabaseSettings &dbSettings);
   bool Connect(const std::string &dbName, const DatabaseSettings &db, bool create);
+  bool ConnectPooled(const std::string &dbName, const DatabaseSettings &db);
   void UpdateVersionNumber();
+  static volatile long *GetRevisionCounter(const std::string &baseDBName);
+
+  struct SearchIndex
+  {
+    SearchIndex() : exists(false), minWordLength(0), stopwordsKnown(true) {}
+    bool exists;                     /*!< True if CreateSearchIndex() succeeded */
+    unsigned int minWordLength;      /*!< Length of the shortest words MySQL indexes */
+    std::set<std::string> stopwords; /*!< Words MySQL doesn't index */
+    bool stopwordsKnown;             /*!< False if MySQL uses stopwords which can't be listed */
+  };
+  const SearchIndex &GetSearchIndex(const std::string &table) const;
+  bool IsIndexedWord(const SearchIndex &index, const std::string &word) const;
+
+  /*! \brief Get the expression ordering the values of a text column like SortUtils does.
+   \param column the text column.
+   \param ignoreArticles whether to skip the sort tokens at the start of the values.
+   \return the expression for the ORDER BY clause.
+   */
+  std::string GetTextOrder(const std::string &column, bool ignoreArticles) const;
 
   bool m_bMultiWrite; /*!< True if there are any queries in the queue, false otherwise */
   unsigned int m_openCount;
+  bool m_readOnly; /*!< True if the connection belongs to the pool of read-only connections */
+
+  unsigned int m_batchSize;  /*!< Number of transactions per batch, 0 if there is no batch */
+  unsigned int m_batchCount; /*!< Number of transactions in the open batch */
+  unsigned int m_batchStart; /*!< Time the open batch was started */
+  bool m_batchOpen;          /*!< True if the transaction of the batch has been started */
+
+  mutable std::map<std::string, SearchIndex> m_searchIndexes; /*!< The full text indexes found, by table */
 
   bool m_multipleExecute;
-  std::vector<std::string> m_multipleQueries;
+  std::vector< std::pair<std::string, dbiplus::sql_record> > m_multipleQueries;
 };
@@ -0,0 +1,251 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <ctype.h>
+#include <algorithm>
+#include <vector>
+
+#include "DatabaseProfiler.h"
+#include "dataset.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+
+namespace
+{
+  bool IsIdentifierChar(char c)
+  {
+    return isalnum((unsigned char)c) || c == '_' || c == '.' || (unsigned char)c >= 0x80;
+  }
+
+  // replaces "(?, ?, ?)" by "(?)" so lists of any length are counted together
+  void CollapseLists(std::string &sql)
+  {
+    size_t pos = 0;
+    while ((pos = sql.find("(?", pos)) != std::string::npos)
+    {
+      size_t end = sql.find_first_not_of("?, ", pos + 1);
+      if (end != std::string::npos && sql[end] == ')')
+        sql.replace(pos, end - pos + 1, "(?)");
+      pos++;
+    }
+  }
+
+  bool CompareMax(const std::pair<std::string, int64_t> &left, const std::pair<std::string, int64_t> &right)
+  {
+    return left.second > right.second;
+  }
+}
+
+CDatabaseProfiler& CDatabaseProfiler::Get()
+{
+  static CDatabaseProfiler sDatabaseProfiler;
+  return sDatabaseProfiler;
+}
+
+bool CDatabaseProfiler::IsEnabled()
+{
+  return g_advancedSettings.m_databaseProfiling;
+}
+
+void CDatabaseProfiler::Record(dbiplus::Database &db, const std::string &sql, int64_t time, bool backslashEscapes /* = false */)
+{
+  std::string statement = Normalize(sql, backslashEscapes);
+  bool slow = time >= (int64_t)g_advancedSettings.m_databaseSlowQueryTime * 1000;
+  bool explain = false;
+
+  {
+    CSingleLock lock(m_critSection);
+    Statements::iterator it = m_statements.find(statement);
+    if (it == m_statements.end())
+    {
+      // make room by dropping the statement with the fastest slowest run, if that is faster than this one
+      if (m_statements.size() >= g_advancedSettings.m_databaseProfileStatements)
+      {
+        Statements::iterator fastest = m_statements.end();
+        for (Statements::iterator i = m_statements.begin(); i != m_statements.end(); ++i)
+        {
+          if (fastest == m_statements.end() || i->second.max < fastest->second.max)
+            fastest = i;
+        }
+        if (fastest == m_statements.end() || fastest->second.max >= time)
+          return;
+        m_statements.erase(fastest);
+      }
+
+      Statement entry;
+      entry.database = db.getDatabase();
+      entry.count = 0;
+      entry.total = 0;
+      entry.max = -1;
+      entry.explained = false;
+      it = m_statements.insert(std::make_pair(statement, entry)).first;
+    }
+
+    Statement &entry = it->second;
+    entry.count++;
+    entry.total += time;
+    if (time > entry.max)
+    {
+      entry.max = time;
+      entry.slowest = sql;
+    }
+
+    // the plan is only asked for once, it won't change without a schema update
+    explain = slow && !entry.explained;
+    entry.explained |= explain;
+  }
+
+  if (!explain)
+  {
+    if (slow)
+      CLog::Log(LOGDEBUG, "%s - slow query (%.1f ms) on %s: %s", __FUNCTION__, time / 1000.0, db.getDatabase(), sql.c_str());
+    return;
+  }
+
+  std::string plan = db.explain(sql);
+  CLog::Log(LOGWARNING, "%s - slow query (%.1f ms) on %s: %s", __FUNCTION__, time / 1000.0, db.getDatabase(), sql.c_str());
+  if (!plan.empty())
+    CLog::Log(LOGWARNING, "%s - query plan:\n%s", __FUNCTION__, plan.c_str());
+
+  CSingleLock lock(m_critSection);
+  Statements::iterator it = m_statements.find(statement);
+  if (it != m_statements.end())
+    it->second.plan = plan;
+}
+
+void CDatabaseProfiler::GetStatistics(CVariant &stats) const
+{
+  stats["enabled"] = IsEnabled();
+  stats["slowquerytime"] = g_advancedSettings.m_databaseSlowQueryTime;
+  stats["statements"] = CVariant(CVariant::VariantTypeArray);
+
+  CSingleLock lock(m_critSection);
+  std::vector< std::pair<std::string, int64_t> > order;
+  order.reserve(m_statements.size());
+  for (Statements::const_iterator it = m_statements.begin(); it != m_statements.end(); ++it)
+    order.push_back(std::make_pair(it->first, it->second.max));
+  std::sort(order.begin(), order.end(), CompareMax);
+
+  for (std::vector< std::pair<std::string, int64_t> >::const_iterator it = order.begin(); it != order.end(); ++it)
+  {
+    const Statement &entry = m_statements.find(it->first)->second;
+    CVariant statement;
+    statement["statement"] = it->first;
+    statement["database"] = entry.database;
+    statement["count"] = entry.count;
+    statement["total"] = entry.total / 1000.0;
+    statement["average"] = entry.total / 1000.0 / entry.count;
+    statement["max"] = entry.max / 1000.0;
+    statement["slowest"] = entry.slowest;
+    statement["plan"] = entry.plan;
+    stats["statements"].push_back(statement);
+  }
+}
+
+void CDatabaseProfiler::DumpStatistics() const
+{
+  CVariant stats;
+  GetStatistics(stats);
+
+  CLog::Log(LOGNOTICE, "Database statistics: %u statements kept, plans for those slower than %u ms",
+            (unsigned int)stats["statements"].size(), (unsigned int)stats["slowquerytime"].asUnsignedInteger());
+  for (CVariant::const_iterator_array statement = stats["statements"].begin_array(); statement != stats["statements"].end_array(); ++statement)
+  {
+    CLog::Log(LOGNOTICE, "  %s: run %d times, total %.2f avg %.2f max %.2f ms: %s",
+              (*statement)["database"].asString().c_str(), (int)(*statement)["count"].asInteger(),
+              (*statement)["total"].asDouble(), (*statement)["average"].asDouble(), (*statement)["max"].asDouble(),
+              (*statement)["statement"].asString().c_str());
+    if (!(*statement)["plan"].asString().empty())
+      CLog::Log(LOGNOTICE, "    query plan:\n%s", (*statement)["plan"].asString().c_str());
+  }
+}
+
+void CDatabaseProfiler::Reset()
+{
+  CSingleLock lock(m_critSection);
+  m_statements.clear();
+}
+
+std::string CDatabaseProfiler::Normalize(const std::string &sql, bool backslashEscapes /* = false */)
+{
+  std::string normalized;
+  normalized.reserve(sql.size());
+
+  for (size_t i = 0; i < sql.size(); i++)
+  {
+    char c = sql[i];
+    if (c == '\'')
+    {
+      // string literal, quotes in it are doubled (or escaped)
+      for (i++; i < sql.size(); i++)
+      {
+        if (backslashEscapes && sql[i] == '\\')
+          i++;
+        else if (sql[i] == '\'')
+        {
+          if (i + 1 < sql.size() && sql[i + 1] == '\'')
+            i++;
+          else
+            break;
+        }
+      }
+      normalized += '?';
+    }
+    else if (isdigit((unsigned char)c) && (normalized.empty() || !IsIdentifierChar(normalized[normalized.size() - 1])))
+    {
+      // numeric literal
+      while (i + 1 < sql.size() && (isdigit((unsigned char)sql[i + 1]) || sql[i + 1] == '.'))
+        i++;
+      normalized += '?';
+    }
+    else if (isspace((unsigned char)c))
+    {
+      if (!normalized.empty() && normalized[normalized.size() - 1] != ' ')
+        normalized += ' ';
+    }
+    else
+      normalized += c;
+  }
+
+  if (!normalized.empty() && normalized[normalized.size() - 1] == ' ')
+    normalized.erase(normalized.size() - 1);
+
+  CollapseLists(normalized);
+  return normalized;
+}
+
+CDatabaseQueryTimer::CDatabaseQueryTimer(dbiplus::Database *db, const std::string &sql, bool backslashEscapes /* = false */)
+  : m_db(CDatabaseProfiler::IsEnabled() ? db : NULL),
+    m_sql(sql),
+    m_backslashEscapes(backslashEscapes),
+    m_start(m_db != NULL ? CurrentHostCounter() : 0)
+{ }
+
+CDatabaseQueryTimer::~CDatabaseQueryTimer()
+{
+  if (m_db == NULL)
+    return;
+
+  int64_t time = (CurrentHostCounter() - m_start) * 1000000 / CurrentHostFrequency();
+  CDatabaseProfiler::Get().Record(*m_db, m_sql, time, m_backslashEscapes);
+}
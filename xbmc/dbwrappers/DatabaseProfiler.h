@@ -0,0 +1,113 @@
+#pragma once
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+#include "threads/CriticalSection.h"
+
+class CVariant;
+
+namespace dbiplus
+{
+  class Database;
+}
+
+/*!
+ \brief Profiler of the statements run on the databases
+
+ Profiling is off unless enabled with <databaseprofiling><enabled> in
+ advancedsettings.xml. Every statement run by a dataset is then timed and
+ counted under its normalized form, which has its literals replaced by '?'.
+ Only the statements with the longest run times are kept, as many as
+ <statements> says. The first time a statement takes longer than
+ <slowquerytime> milliseconds it is logged together with its query plan
+ (EXPLAIN QUERY PLAN with SQLite, EXPLAIN with MySQL).
+ */
+class CDatabaseProfiler
+{
+public:
+  static CDatabaseProfiler& Get();
+
+  static bool IsEnabled();
+
+  /*!
+   \brief Record a statement run on a database
+   \param db Connection the statement was run on, used to get its query plan
+   \param sql Statement as it was run
+   \param time Microseconds it took
+   \param backslashEscapes Whether the backend escapes quotes in literals with a backslash
+   */
+  void Record(dbiplus::Database &db, const std::string &sql, int64_t time, bool backslashEscapes = false);
+
+  /*!
+   \brief Get the kept statements, the slowest first
+   */
+  void GetStatistics(CVariant &stats) const;
+  void DumpStatistics() const;
+  void Reset();
+
+  /*!
+   \brief Get the form of a statement all its runs are counted under
+   \param sql Statement as it was run
+   \param backslashEscapes Whether the backend escapes quotes in literals with a backslash
+   \return Statement with its literals replaced by '?' and lists of them by a single one
+   */
+  static std::string Normalize(const std::string &sql, bool backslashEscapes = false);
+
+private:
+  CDatabaseProfiler() { }
+  CDatabaseProfiler(const CDatabaseProfiler&);
+  CDatabaseProfiler const& operator=(CDatabaseProfiler const&);
+
+  typedef struct
+  {
+    std::string database;
+    unsigned int count;
+    int64_t total;
+    int64_t max;
+    std::string slowest; // the slowest run as it was run
+    std::string plan;
+    bool explained;
+  } Statement;
+
+  typedef std::map<std::string, Statement> Statements;
+
+  mutable CCriticalSection m_critSection;
+  Statements m_statements;
+};
+
+/*!
+ \brief Records the statement run during its lifetime with the CDatabaseProfiler
+ */
+class CDatabaseQueryTimer
+{
+public:
+  CDatabaseQueryTimer(dbiplus::Database *db, const std::string &sql, bool backslashEscapes = false);
+  ~CDatabaseQueryTimer();
+
+private:
+  dbiplus::Database *m_db;
+  const std::string &m_sql;
+  bool m_backslashEscapes;
+  int64_t m_start;
+};
@@ -51,7 +51,8 @@ static const operatorField operators[] = {
   { "notinthelast",    CDatabaseQueryRule::OPERATOR_NOT_IN_THE_LAST,   21411 },
   { "true",            CDatabaseQueryRule::OPERATOR_TRUE,              20122 },
   { "false",           CDatabaseQueryRule::OPERATOR_FALSE,             20424 },
-  { "between",         CDatabaseQueryRule::OPERATOR_BETWEEN,           21456 }
+  { "between",         CDatabaseQueryRule::OPERATOR_BETWEEN,           21456 },
+  { "matches",         CDatabaseQueryRule::OPERATOR_MATCHES,           21466 }
 };
 
 static const size_t NUM_OPERATORS = sizeof(operators) / sizeof(operatorField);
@@ -287,6 +288,7 @@ std::string CDatabaseQueryRule::GetOperatorString(SEARCH_OPERATOR op) const
     switch (op)
     {
     case OPERATOR_CONTAINS:
+    case OPERATOR_MATCHES:
       operatorString = " LIKE '%%%s%%'"; break;
     case OPERATOR_DOES_NOT_CONTAIN:
       operatorString = " LIKE '%%%s%%'"; break;
@@ -368,7 +370,13 @@ std::string CDatabaseQueryRule::GetWhereClause(const CDatabase &db, const std::s
   std::string wholeQuery;
   for (vector<string>::const_iterator it = m_parameter.begin(); it != m_parameter.end(); ++it)
   {
-    std::string query = '(' + FormatWhereClause(negate, operatorString, *it, db, strType) + ')';
+    // fields without a search index match the same as with contains
+    std::string query;
+    if (op == OPERATOR_MATCHES)
+      query = GetSearchQuery(*it, db, strType);
+    if (query.empty())
+      query = FormatWhereClause(negate, operatorString, *it, db, strType);
+    query = '(' + query + ')';
 
     if (it+1 != m_parameter.end())
       query += " OR ";
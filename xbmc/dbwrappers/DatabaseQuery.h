@@ -52,6 +52,7 @@ public:
                          OPERATOR_TRUE,
                          OPERATOR_FALSE,
                          OPERATOR_BETWEEN,
+                         OPERATOR_MATCHES,
                          OPERATOR_END
                        };
 
@@ -94,6 +95,7 @@ protected:
   virtual SEARCH_OPERATOR     GetOperator(const std::string &type) const { return m_operator; };
   virtual std::string         GetOperatorString(SEARCH_OPERATOR op) const;
   virtual std::string         GetBooleanQuery(const std::string &negate, const std::string &strType) const { return ""; }
+  virtual std::string         GetSearchQuery(const std::string &param, const CDatabase &db, const std::string &strType) const { return ""; }
 
   static SEARCH_OPERATOR      TranslateOperator(const char *oper);
   static std::string          TranslateOperator(SEARCH_OPERATOR oper);
@@ -28,6 +28,7 @@
 
 #include "dataset.h"
 #include "utils/log.h"
+#include "threads/Atomics.h"
 #include <cstring>
 
 #ifndef __GNUC__
@@ -48,12 +49,18 @@ Database::Database() {
   login = "";
   passwd = "";
   sequence_table = "db_sequence";
+  change_counter = NULL;
 }
 
 Database::~Database() {
   disconnect();		// Disconnect if connected to database
 }
 
+void Database::changed(void) {
+  if (change_counter != NULL)
+    AtomicIncrement(change_counter);
+}
+
 int Database::connectFull(const char *newHost, const char *newPort, const char *newDb, const char *newLogin, const char *newPasswd,
                         const char *newKey, const char *newCert, const char *newCA, const char *newCApath, const char *newCiphers) {
   host = newHost;
@@ -198,6 +205,63 @@ void Dataset::parse_sql(string &sql) {
   } //for
 }
 
+string Dataset::bind_sql(const string &sql, const sql_record &params) {
+  string result;
+  unsigned int param = 0;
+  char quote = 0;
+  for (string::const_iterator it = sql.begin(); it != sql.end(); ++it) {
+    // placeholders in string literals and quoted names are left alone
+    if (quote != 0) {
+      if (*it == quote) quote = 0;
+    }
+    else if (*it == '\'' || *it == '"' || *it == '`')
+      quote = *it;
+    else if (*it == '?') {
+      if (param >= params.size())
+        throw DbErrors("Missing value for parameter %u of '%s'", param + 1, sql.c_str());
+
+      const field_value &value = params[param++];
+      if (value.get_isNull())
+        result += "NULL";
+      else {
+        switch (value.get_fType()) {
+        case ft_String:
+        case ft_Char:
+        case ft_WChar:
+        case ft_WideString:
+          result += db->prepare("'%s'", value.get_asString().c_str());
+          break;
+        case ft_Boolean:
+          result += value.get_asBool() ? "1" : "0";
+          break;
+        case ft_Float:
+        case ft_Double:
+          result += db->prepare("%.17g", value.get_asDouble());
+          break;
+        default:
+          result += value.get_asString();
+          break;
+        }
+      }
+      continue;
+    }
+    result += *it;
+  }
+
+  if (param != params.size())
+    throw DbErrors("Too many values for the parameters of '%s'", sql.c_str());
+
+  return result;
+}
+
+int Dataset::exec(const string &sql, const sql_record &params) {
+  return exec(bind_sql(sql, params));
+}
+
+bool Dataset::query(const string &sql, const sql_record &params) {
+  return query(bind_sql(sql, params).c_str());
+}
+
 
 void Dataset::close(void) {
   haveError  = false;
@@ -73,6 +73,7 @@ protected:
     sequence_table, //Sequence table for nextid
     default_charset, //Default character set
     key, cert, ca, capath, ciphers; //SSL - Encryption info
+  volatile long *change_counter; //Increased on every change, may be NULL
 
 public:
 /* constructor */
@@ -116,6 +117,10 @@ public:
     capath = newCApath;
     ciphers = newCiphers;
   }
+/* sets a counter to be increased whenever the database is changed */
+  void setChangeCounter(volatile long *counter) { change_counter = counter; }
+/* increases the change counter after a statement changed the database */
+  void changed(void);
 
 /* virtual methods that must be overloaded in derived classes */
 
@@ -141,6 +146,9 @@ public:
 /* \brief drop all extra analytics from database */
   virtual int drop_analytics(void) { return -1; }
 
+/* \brief query plan of a statement, a line per step, empty if unknown */
+  virtual std::string explain(const std::string &sql) { return ""; }
+
   virtual bool exists(void) { return false; }
 
 /* virtual methods for transaction */
@@ -262,6 +270,9 @@ protected:
 /* Parse Sql - replacing fields with prefixes :OLD_ and :NEW_ with current values of OLD or NEW field. */
   void parse_sql(std::string &sql);
 
+/* Bind Sql - replacing the '?' placeholders with the escaped literals of the given values. */
+  std::string bind_sql(const std::string &sql, const sql_record &params);
+
 /* Returns old field value (for :OLD) */
   virtual const field_value f_old(const char *f);
 
@@ -307,9 +318,16 @@ public:
 /* func. executes a query without results to return */
   virtual int  exec (const std::string &sql) = 0;
   virtual int  exec() = 0;
+/* as exec, but with a '?' placeholder in sql for each of the params */
+  virtual int  exec (const std::string &sql, const sql_record &params);
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const char *sql) = 0;
+/* as query, but with a '?' placeholder in sql for each of the params */
+  virtual bool query(const std::string &sql, const sql_record &params);
+/* as query, for callers that walk the rows once with next() only: backends that can
+  stream the rows don't hold the whole result in memory, the others buffer it as query() */
+  virtual bool query_streamed(const std::string &sql) { return query(sql.c_str()); }
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
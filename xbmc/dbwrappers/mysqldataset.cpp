@@ -19,6 +19,7 @@
  */
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <set>
 
@@ -26,9 +27,12 @@
 #include "system.h" // for GetLastError()
 #include "network/WakeOnAccess.h"
 #include "Util.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 
 #ifdef HAS_MYSQL
 #include "mysqldataset.h"
+#include "DatabaseProfiler.h"
 #include "mysql/errmsg.h"
 #ifdef TARGET_WINDOWS
 #pragma comment(lib, "mysqlclient.lib")
@@ -56,6 +60,7 @@ MysqlDatabase::MysqlDatabase() {
   login = "root";
   passwd = "null";
   conn = NULL;
+  streaming = NULL;
   default_charset = "";
 }
 
@@ -196,6 +201,7 @@ int MysqlDatabase::connect(bool create_new) {
 }
 
 void MysqlDatabase::disconnect(void) {
+  finish_streaming();
   if (conn != NULL)
   {
     mysql_close(conn);
@@ -292,6 +298,45 @@ int MysqlDatabase::copy(const char *backup_name) {
   return 1;
 }
 
+std::string MysqlDatabase::explain(const std::string &sql) {
+  std::string plan;
+  if ( !active || conn == NULL)
+    return plan;
+
+  // older servers explain SELECT statements only
+  size_t start = sql.find_first_not_of(" \t\r\n");
+  if (start == string::npos || !StringUtils::StartsWithNoCase(sql.c_str() + start, "select"))
+    return plan;
+
+  string qry = "EXPLAIN " + sql;
+  if (query_with_reconnect(qry.c_str()) != MYSQL_OK)
+    return plan;
+
+  MYSQL_RES* res = mysql_store_result(conn);
+  if (res)
+  {
+    const unsigned int numColumns = mysql_num_fields(res);
+    MYSQL_FIELD *fields = mysql_fetch_fields(res);
+    MYSQL_ROW row;
+    while ( (row=mysql_fetch_row(res)) != NULL )
+    {
+      if (!plan.empty())
+        plan += "\n";
+      for (unsigned int i = 0; i < numColumns; i++)
+      {
+        if (row[i] == NULL)
+          continue;
+        if (i > 0)
+          plan += " ";
+        plan += string(fields[i].name) + "=" + row[i];
+      }
+    }
+    mysql_free_result(res);
+  }
+
+  return plan;
+}
+
 int MysqlDatabase::drop_analytics(void) {
   if ( !active || conn == NULL)
     throw DbErrors("Can't clean database: no active connection...");
@@ -382,10 +427,17 @@ int MysqlDatabase::drop_analytics(void) {
   return 1;
 }
 
+void MysqlDatabase::finish_streaming() {
+  if (streaming != NULL)
+    streaming->store_stream();
+}
+
 int MysqlDatabase::query_with_reconnect(const char* query) {
   int attempts = 5;
   int result;
 
+  finish_streaming();
+
   // try to reconnect if server is gone
   while ( ((result = mysql_real_query(conn, query, strlen(query))) != MYSQL_OK) &&
           ((result = mysql_errno(conn)) == CR_SERVER_GONE_ERROR || result == CR_SERVER_LOST) &&
@@ -450,15 +502,18 @@ void MysqlDatabase::start_transaction() {
 void MysqlDatabase::commit_transaction() {
   if (active)
   {
+    finish_streaming();
     mysql_commit(conn);
     CLog::Log(LOGDEBUG,"Mysql commit transaction");
     _in_transaction = false;
+    changed();
   }
 }
 
 void MysqlDatabase::rollback_transaction() {
   if (active)
   {
+    finish_streaming();
     mysql_rollback(conn);
     CLog::Log(LOGDEBUG,"Mysql rollback transaction");
     _in_transaction = false;
@@ -468,6 +523,7 @@ void MysqlDatabase::rollback_transaction() {
 bool MysqlDatabase::exists(void) {
   bool ret = false;
 
+  finish_streaming();
   if ( conn == NULL || mysql_ping(conn) )
   {
     CLog::Log(LOGERROR, "Not connected to database, test of existence is not possible.");
@@ -1280,6 +1336,10 @@ MysqlDataset::MysqlDataset():Dataset() {
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
+  stream = NULL;
+  forward_only = false;
+  rows_read = 0;
+  stream_time = -1;
 }
 
 
@@ -1288,9 +1348,14 @@ MysqlDataset::MysqlDataset(MysqlDatabase *newDb):Dataset(newDb) {
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
+  stream = NULL;
+  forward_only = false;
+  rows_read = 0;
+  stream_time = -1;
 }
 
 MysqlDataset::~MysqlDataset() {
+   close_stream();
    if (errmsg) free(errmsg);
  }
 
@@ -1450,6 +1515,7 @@ int MysqlDataset::exec(const string &sql) {
   }
 
   CLog::Log(LOGDEBUG,"Mysql execute: %s", qry.c_str());
+  CDatabaseQueryTimer timer(db, qry, true);
 
   if (db->setErr( static_cast<MysqlDatabase *>(db)->query_with_reconnect(qry.c_str()), qry.c_str()) != MYSQL_OK)
   {
@@ -1457,6 +1523,7 @@ int MysqlDataset::exec(const string &sql) {
   }
   else
   {
+    db->changed();
     // TODO: collect results and store in exec_res
     return res;
   }
@@ -1471,7 +1538,73 @@ const void* MysqlDataset::getExecRes() {
 }
 
 
+static sql_record* make_record(MYSQL_ROW row, MYSQL_FIELD *fields, unsigned int numColumns)
+{
+  sql_record *res = new sql_record;
+  res->resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    field_value &v = res->at(i);
+    switch (fields[i].type)
+    {
+      case MYSQL_TYPE_LONGLONG:
+      case MYSQL_TYPE_DECIMAL:
+      case MYSQL_TYPE_NEWDECIMAL:
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONG:
+        if (row[i] != NULL)
+        {
+          v.set_asInt(atoi(row[i]));
+        }
+        else
+        {
+          v.set_asInt(0);
+        }
+        break;
+      case MYSQL_TYPE_FLOAT:
+      case MYSQL_TYPE_DOUBLE:
+        if (row[i] != NULL)
+        {
+          v.set_asDouble(atof(row[i]));
+        }
+        else
+        {
+          v.set_asDouble(0);
+        }
+        break;
+      case MYSQL_TYPE_STRING:
+      case MYSQL_TYPE_VAR_STRING:
+      case MYSQL_TYPE_VARCHAR:
+        if (row[i] != NULL) v.set_asString((const char *)row[i] );
+        break;
+      case MYSQL_TYPE_TINY_BLOB:
+      case MYSQL_TYPE_MEDIUM_BLOB:
+      case MYSQL_TYPE_LONG_BLOB:
+      case MYSQL_TYPE_BLOB:
+        if (row[i] != NULL) v.set_asString((const char *)row[i]);
+        break;
+      case MYSQL_TYPE_NULL:
+      default:
+        CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
+        v.set_asString("");
+        v.set_isNull();
+        break;
+    }
+  }
+  return res;
+}
+
 bool MysqlDataset::query(const char *query) {
+  return run_query(query, false);
+}
+
+bool MysqlDataset::query_streamed(const string &query) {
+  return run_query(query, true);
+}
+
+bool MysqlDataset::run_query(const string &query, bool streamed) {
   if(!handle()) throw DbErrors("No Database Connection");
   std::string qry = query;
   int fs = qry.find("select");
@@ -1487,87 +1620,107 @@ bool MysqlDataset::query(const char *query) {
   while ((loc = ci_find(qry, "as integer)")) != string::npos)
     qry = qry.insert(loc + 3, "signed ");
 
+  // a streamed query is recorded once all its rows are fetched, as the
+  // connection can't explain it before
+  std::auto_ptr<CDatabaseQueryTimer> timer;
+  int64_t start = -1;
+  if (!streamed)
+    timer.reset(new CDatabaseQueryTimer(db, qry, true));
+  else if (CDatabaseProfiler::IsEnabled())
+    start = CurrentHostCounter();
   MYSQL_RES *stmt = NULL;
 
   if ( static_cast<MysqlDatabase*>(db)->setErr(static_cast<MysqlDatabase*>(db)->query_with_reconnect(qry.c_str()), qry.c_str()) != MYSQL_OK )
     throw DbErrors(db->getErrorMsg());
 
+  // a streamed result keeps the rows on the server until they are fetched
   MYSQL* conn = handle();
-  stmt = mysql_store_result(conn);
+  stmt = streamed ? mysql_use_result(conn) : mysql_store_result(conn);
+  if (stmt == NULL)
+    throw DbErrors("%s", mysql_error(conn));
 
   // column headers
   const unsigned int numColumns = mysql_num_fields(stmt);
   MYSQL_FIELD *fields = mysql_fetch_fields(stmt);
-  MYSQL_ROW row;
   result.record_header.resize(numColumns);
   for (unsigned int i = 0; i < numColumns; i++)
     result.record_header[i].name = fields[i].name;
 
-  // returned rows
-  while ((row = mysql_fetch_row(stmt)))
-  { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
-    for (unsigned int i = 0; i < numColumns; i++)
+  active = true;
+  ds_state = dsSelect;
+
+  if (streamed)
+  {
+    stream = stmt;
+    forward_only = true;
+    if (start >= 0)
     {
-      field_value &v = res->at(i);
-      switch (fields[i].type)
-      {
-        case MYSQL_TYPE_LONGLONG:
-        case MYSQL_TYPE_DECIMAL:
-        case MYSQL_TYPE_NEWDECIMAL:
-        case MYSQL_TYPE_TINY:
-        case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_INT24:
-        case MYSQL_TYPE_LONG:
-          if (row[i] != NULL)
-          {
-            v.set_asInt(atoi(row[i]));
-          }
-          else
-          {
-            v.set_asInt(0);
-          }
-          break;
-        case MYSQL_TYPE_FLOAT:
-        case MYSQL_TYPE_DOUBLE:
-          if (row[i] != NULL)
-          {
-            v.set_asDouble(atof(row[i]));
-          }
-          else
-          {
-            v.set_asDouble(0);
-          }
-          break;
-        case MYSQL_TYPE_STRING:
-        case MYSQL_TYPE_VAR_STRING:
-        case MYSQL_TYPE_VARCHAR:
-          if (row[i] != NULL) v.set_asString((const char *)row[i] );
-          break;
-        case MYSQL_TYPE_TINY_BLOB:
-        case MYSQL_TYPE_MEDIUM_BLOB:
-        case MYSQL_TYPE_LONG_BLOB:
-        case MYSQL_TYPE_BLOB:
-          if (row[i] != NULL) v.set_asString((const char *)row[i]);
-          break;
-        case MYSQL_TYPE_NULL:
-        default:
-          CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
-          v.set_asString("");
-          v.set_isNull();
-          break;
-      }
+      stream_query = qry;
+      stream_time = CurrentHostCounter() - start;
     }
-    result.records.push_back(res);
+    static_cast<MysqlDatabase*>(db)->set_streaming(this);
+    fetch_row();
+    Dataset::first();
+    fill_fields();
+    return true;
   }
+
+  // returned rows
+  MYSQL_ROW row;
+  while ((row = mysql_fetch_row(stmt)))
+    result.records.push_back(make_record(row, fields, numColumns));
   mysql_free_result(stmt);
-  active = true;
-  ds_state = dsSelect;
   this->first();
   return true;
 }
 
+bool MysqlDataset::fetch_row() {
+  if (stream == NULL)
+    return false;
+
+  int64_t start = stream_time >= 0 ? CurrentHostCounter() : 0;
+  MYSQL_ROW row = mysql_fetch_row(stream);
+  if (stream_time >= 0)
+    stream_time += CurrentHostCounter() - start;
+  if (row == NULL)
+  {
+    // all rows are read, unless the connection failed on the way
+    std::string error;
+    if (mysql_errno(handle()) != 0)
+      error = mysql_error(handle());
+    close_stream();
+    if (!error.empty())
+      throw DbErrors("%s", error.c_str());
+    return false;
+  }
+
+  result.records.push_back(make_record(row, mysql_fetch_fields(stream), mysql_num_fields(stream)));
+  rows_read++;
+  return true;
+}
+
+void MysqlDataset::store_stream() {
+  while (fetch_row());
+}
+
+void MysqlDataset::close_stream() {
+  if (stream == NULL)
+    return;
+
+  // frees the rows that weren't fetched as well
+  mysql_free_result(stream);
+  stream = NULL;
+  static_cast<MysqlDatabase*>(db)->set_streaming(NULL);
+
+  // the connection is free for the EXPLAIN of a slow query now
+  if (stream_time >= 0)
+  {
+    int64_t time = stream_time * 1000000 / CurrentHostFrequency();
+    stream_time = -1;
+    CDatabaseProfiler::Get().Record(*db, stream_query, time, true);
+  }
+}
+
 bool MysqlDataset::query(const string &q) {
   return query(q.c_str());
 }
@@ -1589,6 +1742,9 @@ void MysqlDataset::open() {
 }
 
 void MysqlDataset::close() {
+  close_stream();
+  forward_only = false;
+  rows_read = 0;
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -1610,6 +1766,8 @@ void MysqlDataset::cancel() {
 
 
 int MysqlDataset::num_rows() {
+  if (forward_only)
+    return rows_read;
   return result.records.size();
 }
 
@@ -1625,21 +1783,49 @@ bool MysqlDataset::bof() {
 
 
 void MysqlDataset::first() {
+  // the rows passed are gone in a streamed result
+  if (forward_only && (frecno > 0 || rows_read > (int)result.records.size()))
+    throw DbErrors("Dataset is forward only");
   Dataset::first();
   this->fill_fields();
 }
 
 void MysqlDataset::last() {
+  if (forward_only)
+    throw DbErrors("Dataset is forward only");
   Dataset::last();
   fill_fields();
 }
 
 void MysqlDataset::prev(void) {
+  if (forward_only)
+    throw DbErrors("Dataset is forward only");
   Dataset::prev();
   fill_fields();
 }
 
 void MysqlDataset::next(void) {
+  if (forward_only)
+  {
+    if (ds_state != dsSelect || feof)
+      return;
+
+    // only the rows not walked yet are kept
+    free_row();
+    frecno++;
+    if (frecno >= (int)result.records.size())
+    {
+      result.records.clear();
+      frecno = 0;
+      fetch_row();
+    }
+    fbof = false;
+    feof = frecno >= (int)result.records.size();
+    if (!feof)
+      fill_fields();
+    return;
+  }
+
   Dataset::next();
   if (!eof())
       fill_fields();
@@ -1659,6 +1845,8 @@ void MysqlDataset::free_row(void)
 }
 
 bool MysqlDataset::seek(int pos) {
+  if (forward_only)
+    throw DbErrors("Dataset is forward only");
   if (ds_state == dsSelect)
   {
     Dataset::seek(pos);
@@ -26,6 +26,8 @@
 #include "mysql/mysql.h"
 
 namespace dbiplus {
+class MysqlDataset;
+
 /***************** Class MysqlDatabase definition ******************
 
        class 'MysqlDatabase' connects with MySQL-server
@@ -37,6 +39,11 @@ protected:
   MYSQL* conn;
   bool _in_transaction;
   int last_err;
+/* dataset whose streamed result is being read from the connection */
+  MysqlDataset *streaming;
+
+/* reads the remaining rows of a streamed result, nothing else can be sent to the server before */
+  void finish_streaming();
 
 
 public:
@@ -72,6 +79,9 @@ public:
 /* \brief drop all extra analytics from database */
   virtual int drop_analytics(void);
 
+/* \brief query plan of a statement */
+  virtual std::string explain(const std::string &sql);
+
   virtual long nextid(const char* seq_name);
 
 /* virtual methods for transaction */
@@ -85,6 +95,7 @@ public:
 
   bool in_transaction() {return _in_transaction;};
   int query_with_reconnect(const char* query);
+  void set_streaming(MysqlDataset *ds) { streaming = ds; }
 
 private:
 
@@ -128,6 +139,22 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* result of a streamed query, NULL once all its rows are read */
+  MYSQL_RES *stream;
+/* whether the rows can only be walked once from first to last */
+  bool forward_only;
+/* number of rows read from a streamed result so far */
+  int rows_read;
+/* streamed query being profiled, which is recorded once the stream is closed */
+  std::string stream_query;
+/* host counter ticks spent running the profiled streamed query and fetching its rows, -1 if not profiled */
+  int64_t stream_time;
+
+  bool run_query(const std::string &query, bool streamed);
+/* reads the next row of a streamed result into the records */
+  bool fetch_row();
+  void close_stream();
+
 public:
 /* constructor */
   MysqlDataset();
@@ -150,6 +177,11 @@ or insert() operations default = false) */
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+/* as query, but the rows are read from the server one at a time as the dataset moves
+  forward, num_rows() is the number of rows read so far */
+  virtual bool query_streamed(const std::string &query);
+/* reads the remaining rows of a streamed query into memory */
+  void store_stream();
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -30,6 +30,7 @@
 #include <string.h>
 
 #include "sqlitedataset.h"
+#include "DatabaseProfiler.h"
 #include "utils/log.h"
 #include "system.h" // for Sleep(), OutputDebugString() and GetLastError()
 #include "utils/URIUtils.h"
@@ -90,12 +91,57 @@ static int busy_callback(void*, int busyCount)
   return 1;
 }
 
+// number of unused prepared statements kept per connection by default
+#define STATEMENT_CACHE_SIZE 64
+
+static int bind_values(sqlite3_stmt *stmt, const sql_record &params)
+{
+  if (sqlite3_bind_parameter_count(stmt) != (int)params.size())
+    return SQLITE_RANGE;
+
+  int res = SQLITE_OK;
+  for (unsigned int i = 0; i < params.size() && res == SQLITE_OK; i++)
+  {
+    const field_value &value = params[i];
+    if (value.get_isNull())
+    {
+      res = sqlite3_bind_null(stmt, i + 1);
+      continue;
+    }
+
+    switch (value.get_fType())
+    {
+    case ft_String:
+    case ft_Char:
+    case ft_WChar:
+    case ft_WideString:
+    {
+      std::string str = value.get_asString();
+      res = sqlite3_bind_text(stmt, i + 1, str.c_str(), str.size(), SQLITE_TRANSIENT);
+      break;
+    }
+    case ft_Float:
+    case ft_Double:
+      res = sqlite3_bind_double(stmt, i + 1, value.get_asDouble());
+      break;
+    default:
+      res = sqlite3_bind_int64(stmt, i + 1, value.get_asInt64());
+      break;
+    }
+  }
+
+  return res;
+}
+
 //************* SqliteDatabase implementation ***************
 
 SqliteDatabase::SqliteDatabase() {
 
   active = false;  
   _in_transaction = false;    // for transaction
+  statement_cache_size = STATEMENT_CACHE_SIZE;
+  statement_hits = 0;
+  statement_misses = 0;
 
   error = "Unknown database error";//S_NO_CONNECTION;
   host = "localhost";
@@ -263,10 +309,62 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  clear_statements();
   sqlite3_close(conn);
   active = false;
 }
 
+int SqliteDatabase::prepare_statement(const string &sql, sqlite3_stmt **stmt) {
+  std::map<string, StatementList::iterator>::iterator it = statement_index.find(sql);
+  if (it != statement_index.end()) {
+    // the statement is handed out, so a nested use of the same sql gets its own
+    *stmt = it->second->second;
+    statements.erase(it->second);
+    statement_index.erase(it);
+    statement_hits++;
+    return SQLITE_OK;
+  }
+
+  statement_misses++;
+  return sqlite3_prepare_v2(conn, sql.c_str(), -1, stmt, NULL);
+}
+
+int SqliteDatabase::release_statement(const string &sql, sqlite3_stmt *stmt) {
+  int res = sqlite3_reset(stmt);
+  if (res != SQLITE_OK || statement_cache_size == 0 || statement_index.find(sql) != statement_index.end()) {
+    sqlite3_finalize(stmt);
+    return res;
+  }
+
+  sqlite3_clear_bindings(stmt);
+  statements.push_front(std::make_pair(sql, stmt));
+  statement_index.insert(std::make_pair(sql, statements.begin()));
+
+  while (statements.size() > statement_cache_size) {
+    sqlite3_finalize(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+
+  return res;
+}
+
+void SqliteDatabase::set_statement_cache_size(unsigned int size) {
+  statement_cache_size = size;
+  while (statements.size() > statement_cache_size) {
+    sqlite3_finalize(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+}
+
+void SqliteDatabase::clear_statements() {
+  for (StatementList::iterator it = statements.begin(); it != statements.end(); ++it)
+    sqlite3_finalize(it->second);
+  statements.clear();
+  statement_index.clear();
+}
+
 int SqliteDatabase::create() {
   return connect(true);
 }
@@ -327,7 +425,8 @@ int SqliteDatabase::drop_analytics(void) {
   result_set res;
 
   CLog::Log(LOGDEBUG, "Cleaning indexes from database %s at %s", db.c_str(), host.c_str());
-  sprintf(sqlcmd, "SELECT name FROM sqlite_master WHERE type == 'index'");
+  // indexes of constraints (e.g. of the tables behind full text indexes) have no sql and can't be dropped
+  sprintf(sqlcmd, "SELECT name FROM sqlite_master WHERE type == 'index' AND sql IS NOT NULL");
   if ((last_err = sqlite3_exec(conn, sqlcmd, &callback, &res, NULL)) != SQLITE_OK) return DB_UNEXPECTED_RESULT;
 
   for (size_t i=0; i < res.records.size(); i++) {
@@ -359,6 +458,28 @@ int SqliteDatabase::drop_analytics(void) {
   return DB_COMMAND_OK;
 }
 
+std::string SqliteDatabase::explain(const std::string &sql) {
+  std::string plan;
+  if (active == false) return plan;
+
+  sqlite3_stmt *stmt = NULL;
+  std::string query = "EXPLAIN QUERY PLAN " + sql;
+  if (sqlite3_prepare_v2(conn, query.c_str(), -1, &stmt, NULL) != SQLITE_OK)
+    return plan;
+
+  // the last column describes the step
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    const char *detail = (const char *)sqlite3_column_text(stmt, sqlite3_column_count(stmt) - 1);
+    if (!plan.empty())
+      plan += "\n";
+    plan += detail ? detail : "";
+  }
+  sqlite3_finalize(stmt);
+
+  return plan;
+}
+
 int SqliteDatabase::drop() {
   if (active == false) throw DbErrors("Can't drop database: no active connection...");
   disconnect();
@@ -407,6 +528,7 @@ void SqliteDatabase::commit_transaction() {
   if (active) {
     sqlite3_exec(conn,"commit",NULL,NULL,NULL);
     _in_transaction = false;
+    changed();
   }
 }
 
@@ -625,8 +747,12 @@ int SqliteDataset::exec(const string &sql) {
       qry = qry.substr(0, pos);
   }
 
+  CDatabaseQueryTimer timer(db, qry);
   if((res = db->setErr(sqlite3_exec(handle(),qry.c_str(),&callback,&exec_res,&errmsg),qry.c_str())) == SQLITE_OK)
+  {
+    db->changed();
     return res;
+  }
   else
     {
       throw DbErrors(db->getErrorMsg());
@@ -642,20 +768,76 @@ const void* SqliteDataset::getExecRes() {
 }
 
 
+int SqliteDataset::exec(const string &sql, const sql_record &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+  exec_res.clear();
+  CDatabaseQueryTimer timer(db, sql);
+
+  sqlite3_stmt *stmt = NULL;
+  if (db->setErr(prepare_statement(sql, params, &stmt), sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  int res = bind_values(stmt, params);
+  if (res == SQLITE_OK)
+  {
+    while ((res = sqlite3_step(stmt)) == SQLITE_ROW)
+      ;
+    if (res == SQLITE_DONE)
+      res = SQLITE_OK;
+  }
+  release_statement(sql, params, stmt);
+
+  if (db->setErr(res, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  db->changed();
+  return res;
+}
+
+
+int SqliteDataset::prepare_statement(const string &sql, const sql_record &params, sqlite3_stmt **stmt) {
+  // literal sql is rarely the same twice, only statements with bound values are kept for reuse
+  if (params.empty())
+    return sqlite3_prepare_v2(handle(), sql.c_str(), -1, stmt, NULL);
+
+  return static_cast<SqliteDatabase*>(db)->prepare_statement(sql, stmt);
+}
+
+int SqliteDataset::release_statement(const string &sql, const sql_record &params, sqlite3_stmt *stmt) {
+  if (params.empty())
+    return sqlite3_finalize(stmt);
+
+  return static_cast<SqliteDatabase*>(db)->release_statement(sql, stmt);
+}
+
 bool SqliteDataset::query(const char *query) {
+  return this->query(string(query), sql_record());
+}
+
+bool SqliteDataset::query(const string &q){
+  return query(q, sql_record());
+}
+
+bool SqliteDataset::query(const string &query, const sql_record &params) {
     if(!handle()) throw DbErrors("No Database Connection");
-    std::string qry = query;
-    int fs = qry.find("select");
-    int fS = qry.find("SELECT");
+    int fs = query.find("select");
+    int fS = query.find("SELECT");
     if (!( fs >= 0 || fS >=0))                                 
          throw DbErrors("MUST be select SQL!"); 
 
   close();
+  CDatabaseQueryTimer timer(db, query);
 
   sqlite3_stmt *stmt = NULL;
-  if (db->setErr(sqlite3_prepare_v2(handle(),query,-1,&stmt, NULL),query) != SQLITE_OK)
+  if (db->setErr(prepare_statement(query, params, &stmt),query.c_str()) != SQLITE_OK)
     throw DbErrors(db->getErrorMsg());
 
+  if (db->setErr(bind_values(stmt, params),query.c_str()) != SQLITE_OK)
+  {
+    release_statement(query, params, stmt);
+    throw DbErrors(db->getErrorMsg());
+  }
+
   // column headers
   const unsigned int numColumns = sqlite3_column_count(stmt);
   result.record_header.resize(numColumns);
@@ -693,7 +875,7 @@ bool SqliteDataset::query(const char *query) {
     }
     result.records.push_back(res);
   }
-  if (db->setErr(sqlite3_finalize(stmt),query) == SQLITE_OK)
+  if (db->setErr(release_statement(query, params, stmt),query.c_str()) == SQLITE_OK)
   {
     active = true;
     ds_state = dsSelect;
@@ -706,10 +888,6 @@ bool SqliteDataset::query(const char *query) {
   }  
 }
 
-bool SqliteDataset::query(const string &q){
-  return query(q.c_str());
-}
-
 void SqliteDataset::open(const string &sql) {
   set_select_sql(sql);
   open();
@@ -30,6 +30,8 @@
 #define _SQLITEDATASET_H
 
 #include <stdio.h>
+#include <list>
+#include <map>
 #include "dataset.h"
 #include <sqlite3.h>
 
@@ -46,6 +48,16 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* prepared statements which are not in use, most recently used first */
+  typedef std::list< std::pair<std::string, sqlite3_stmt*> > StatementList;
+  StatementList statements;
+  std::map<std::string, StatementList::iterator> statement_index;
+  unsigned int statement_cache_size;
+  unsigned int statement_hits, statement_misses;
+
+/* finalizes all cached statements */
+  void clear_statements();
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -84,6 +96,9 @@ public:
 /* \brief drop all extra analytics from database */
   virtual int drop_analytics(void);
 
+/* \brief query plan of a statement */
+  virtual std::string explain(const std::string &sql);
+
   virtual long nextid(const char* seq_name);
 
 /* virtual methods for transaction */
@@ -97,6 +112,17 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+/* func. gets a prepared statement for sql, reusing a cached one if possible */
+  int prepare_statement(const std::string &sql, sqlite3_stmt **stmt);
+/* func. resets a statement and keeps it for the next use of its sql,
+   returns the result of the last evaluation of the statement */
+  int release_statement(const std::string &sql, sqlite3_stmt *stmt);
+/* sets the number of unused prepared statements to keep, 0 disables the cache */
+  void set_statement_cache_size(unsigned int size);
+/* number of statements taken from and missing in the cache */
+  unsigned int get_statement_hits() const { return statement_hits; }
+  unsigned int get_statement_misses() const { return statement_misses; }
+
 };
 
 
@@ -128,6 +154,11 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* gets a statement for sql, statements with bound values come from the statement cache */
+  int prepare_statement(const std::string &sql, const sql_record &params, sqlite3_stmt **stmt);
+/* finalizes the statement or returns it to the cache, as it was got by prepare_statement */
+  int release_statement(const std::string &sql, const sql_record &params, sqlite3_stmt *stmt);
+
 public:
 /* constructor */
   SqliteDataset();
@@ -146,10 +177,12 @@ or insert() operations default = false) */
 /* func. executes a query without results to return */
   virtual int  exec ();
   virtual int  exec (const std::string &sql);
+  virtual int  exec (const std::string &sql, const sql_record &params);
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+  virtual bool query(const std::string &query, const sql_record &params);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
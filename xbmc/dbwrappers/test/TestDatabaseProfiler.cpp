@@ -0,0 +1,152 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/DatabaseProfiler.h"
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+#include <memory>
+
+using namespace dbiplus;
+
+class TestDatabaseProfiler : public testing::Test
+{
+protected:
+  TestDatabaseProfiler()
+    : m_profiling(g_advancedSettings.m_databaseProfiling),
+      m_slowQueryTime(g_advancedSettings.m_databaseSlowQueryTime),
+      m_statements(g_advancedSettings.m_databaseProfileStatements)
+  {
+    m_file = XBMC_CREATETEMPFILE(".db");
+    if (m_file != NULL)
+    {
+      m_file->Close();
+      m_db.setHostName(CXBMCTestUtils::Instance().TempFileDirectory(m_file).c_str());
+      m_db.setDatabase(URIUtils::GetFileName(XBMC_TEMPFILEPATH(m_file)).c_str());
+    }
+    CDatabaseProfiler::Get().Reset();
+  }
+
+  ~TestDatabaseProfiler()
+  {
+    g_advancedSettings.m_databaseProfiling = m_profiling;
+    g_advancedSettings.m_databaseSlowQueryTime = m_slowQueryTime;
+    g_advancedSettings.m_databaseProfileStatements = m_statements;
+    CDatabaseProfiler::Get().Reset();
+
+    m_ds.reset();
+    m_db.disconnect();
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_file != NULL);
+    ASSERT_EQ(DB_CONNECTION_OK, m_db.connect(true));
+    m_ds.reset(m_db.CreateDataset());
+    m_ds->exec("CREATE TABLE movie (idMovie integer primary key, c00 text, c07 text)");
+    m_ds->exec("CREATE INDEX ix_movie ON movie (c07)");
+  }
+
+  bool m_profiling;
+  unsigned int m_slowQueryTime;
+  unsigned int m_statements;
+
+  XFILE::CFile *m_file;
+  SqliteDatabase m_db;
+  std::auto_ptr<Dataset> m_ds;
+};
+
+TEST_F(TestDatabaseProfiler, Normalize)
+{
+  EXPECT_STREQ("SELECT * FROM movie WHERE c00=? AND idMovie=?",
+               CDatabaseProfiler::Normalize("SELECT * FROM movie WHERE c00='it''s' AND idMovie=42").c_str());
+  EXPECT_STREQ("SELECT * FROM movie WHERE c07>? LIMIT ?,?",
+               CDatabaseProfiler::Normalize("SELECT  *\n FROM movie\tWHERE c07>2.5 LIMIT 0,10").c_str());
+  EXPECT_STREQ("DELETE FROM movie WHERE idMovie IN (?)",
+               CDatabaseProfiler::Normalize("DELETE FROM movie WHERE idMovie IN (1, 2, 3,4)").c_str());
+  EXPECT_STREQ("SELECT * FROM movie WHERE c00=? AND c07=?",
+               CDatabaseProfiler::Normalize("SELECT * FROM movie WHERE c00='a\\'b' AND c07=1", true).c_str());
+}
+
+TEST_F(TestDatabaseProfiler, Disabled)
+{
+  g_advancedSettings.m_databaseProfiling = false;
+  m_ds->query("SELECT * FROM movie");
+  m_ds->close();
+
+  CVariant stats;
+  CDatabaseProfiler::Get().GetStatistics(stats);
+  EXPECT_FALSE(stats["enabled"].asBoolean());
+  EXPECT_EQ(0U, stats["statements"].size());
+}
+
+TEST_F(TestDatabaseProfiler, Record)
+{
+  g_advancedSettings.m_databaseProfiling = true;
+  g_advancedSettings.m_databaseSlowQueryTime = 0;
+
+  for (int i = 0; i < 5; i++)
+  {
+    m_ds->query(m_db.prepare("SELECT idMovie FROM movie WHERE c07='%i'", 2000 + i).c_str());
+    m_ds->close();
+  }
+
+  CVariant stats;
+  CDatabaseProfiler::Get().GetStatistics(stats);
+  EXPECT_TRUE(stats["enabled"].asBoolean());
+  ASSERT_EQ(1U, stats["statements"].size());
+
+  const CVariant &statement = stats["statements"][0];
+  EXPECT_STREQ("SELECT idMovie FROM movie WHERE c07=?", statement["statement"].asString().c_str());
+  EXPECT_EQ(5, statement["count"].asInteger());
+  EXPECT_LE(statement["average"].asDouble(), statement["max"].asDouble());
+  EXPECT_TRUE(StringUtils::StartsWith(statement["slowest"].asString(), "SELECT idMovie FROM movie WHERE c07='"));
+  // every run is slow with a threshold of 0 so the plan is captured
+  EXPECT_NE(std::string::npos, statement["plan"].asString().find("ix_movie"));
+}
+
+TEST_F(TestDatabaseProfiler, Limit)
+{
+  g_advancedSettings.m_databaseProfiling = true;
+  g_advancedSettings.m_databaseProfileStatements = 3;
+
+  CDatabaseProfiler &profiler = CDatabaseProfiler::Get();
+  profiler.Record(m_db, "SELECT idMovie FROM movie", 1000);
+  profiler.Record(m_db, "SELECT c00 FROM movie", 3000);
+  profiler.Record(m_db, "SELECT c07 FROM movie", 2000);
+  profiler.Record(m_db, "SELECT COUNT(*) FROM movie", 500);
+  profiler.Record(m_db, "SELECT * FROM movie", 5000);
+
+  // the fastest statements make way for slower ones
+  CVariant stats;
+  profiler.GetStatistics(stats);
+  ASSERT_EQ(3U, stats["statements"].size());
+  EXPECT_STREQ("SELECT * FROM movie", stats["statements"][0]["statement"].asString().c_str());
+  EXPECT_DOUBLE_EQ(5.0, stats["statements"][0]["max"].asDouble());
+  EXPECT_DOUBLE_EQ(3.0, stats["statements"][1]["max"].asDouble());
+  EXPECT_DOUBLE_EQ(2.0, stats["statements"][2]["max"].asDouble());
+}
@@ -0,0 +1,229 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifdef HAS_MYSQL
+#include "dbwrappers/DatabaseProfiler.h"
+#include "dbwrappers/mysqldataset.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+#include <iostream>
+#include <memory>
+#include <stdlib.h>
+
+using namespace dbiplus;
+
+namespace
+{
+  const int LibraryItems = 20000;
+
+  // the tests need a MySQL/MariaDB server, by default a local one with the
+  // usual xbmc/xbmc account, else the one given by XBMC_TEST_MYSQL_HOST
+  const char *GetEnv(const char *name, const char *defaultValue)
+  {
+    const char *value = getenv(name);
+    return value != NULL ? value : defaultValue;
+  }
+}
+
+class TestMysqlDataset : public testing::Test
+{
+protected:
+  TestMysqlDataset()
+  {
+    m_db.setHostName(GetEnv("XBMC_TEST_MYSQL_HOST", "localhost"));
+    m_db.setPort(GetEnv("XBMC_TEST_MYSQL_PORT", "3306"));
+    m_db.setLogin(GetEnv("XBMC_TEST_MYSQL_USER", "xbmc"));
+    m_db.setPasswd(GetEnv("XBMC_TEST_MYSQL_PASS", "xbmc"));
+    m_db.setDatabase("xbmc_test_dataset");
+  }
+
+  ~TestMysqlDataset()
+  {
+    if (m_ds.get() != NULL)
+      m_ds->exec("DROP TABLE IF EXISTS files");
+    m_ds2.reset();
+    m_ds.reset();
+    m_db.disconnect();
+  }
+
+  // returns false when there is no server to run the test against
+  bool Connect()
+  {
+    if (m_db.connect(true) != DB_CONNECTION_OK)
+    {
+      std::cout << "no MySQL server, skipping test" << std::endl;
+      return false;
+    }
+
+    m_ds.reset(m_db.CreateDataset());
+    m_ds2.reset(m_db.CreateDataset());
+    m_ds->exec("DROP TABLE IF EXISTS files");
+    m_ds->exec("CREATE TABLE files (idFile integer primary key, idPath integer, strFilename text)");
+
+    m_db.start_transaction();
+    for (int i = 0; i < LibraryItems; i++)
+      m_ds->exec(m_db.prepare("INSERT INTO files (idFile, idPath, strFilename) VALUES (NULL, %i, 'movie %i.mkv')", i % 100, i));
+    m_db.commit_transaction();
+    return true;
+  }
+
+  MysqlDatabase m_db;
+  std::auto_ptr<Dataset> m_ds;
+  std::auto_ptr<Dataset> m_ds2;
+};
+
+TEST_F(TestMysqlDataset, Streamed)
+{
+  if (!Connect())
+    return;
+
+  ASSERT_TRUE(m_ds->query_streamed("SELECT idFile, strFilename FROM files ORDER BY idFile"));
+  int rows = 0;
+  while (!m_ds->eof())
+  {
+    rows++;
+    EXPECT_EQ(rows, m_ds->fv(0).get_asInt());
+    EXPECT_STREQ(StringUtils::Format("movie %d.mkv", rows - 1).c_str(), m_ds->get_sql_record()->at(1).get_asString().c_str());
+    EXPECT_EQ(rows, m_ds->num_rows());
+    m_ds->next();
+  }
+  m_ds->close();
+  EXPECT_EQ(LibraryItems, rows);
+
+  // empty results end right away
+  ASSERT_TRUE(m_ds->query_streamed("SELECT idFile FROM files WHERE idPath=-1"));
+  EXPECT_TRUE(m_ds->eof());
+  EXPECT_EQ(0, m_ds->num_rows());
+  m_ds->close();
+}
+
+TEST_F(TestMysqlDataset, ForwardOnly)
+{
+  if (!Connect())
+    return;
+
+  ASSERT_TRUE(m_ds->query_streamed("SELECT idFile FROM files ORDER BY idFile"));
+  m_ds->first();
+  m_ds->next();
+  EXPECT_EQ(2, m_ds->fv(0).get_asInt());
+  EXPECT_THROW(m_ds->prev(), DbErrors);
+  EXPECT_THROW(m_ds->first(), DbErrors);
+  EXPECT_THROW(m_ds->seek(0), DbErrors);
+  m_ds->close();
+
+  // the buffered mode still goes both ways
+  ASSERT_TRUE(m_ds->query("SELECT idFile FROM files ORDER BY idFile"));
+  m_ds->next();
+  m_ds->prev();
+  EXPECT_EQ(1, m_ds->fv(0).get_asInt());
+  EXPECT_EQ(LibraryItems, m_ds->num_rows());
+  m_ds->close();
+}
+
+TEST_F(TestMysqlDataset, Interleaved)
+{
+  if (!Connect())
+    return;
+
+  // other statements on the connection read the rest of the stream first
+  ASSERT_TRUE(m_ds->query_streamed("SELECT idFile, idPath FROM files ORDER BY idFile"));
+  int rows = 0;
+  while (!m_ds->eof())
+  {
+    rows++;
+    EXPECT_EQ(rows, m_ds->fv(0).get_asInt());
+    if (rows % 5000 == 0)
+    {
+      ASSERT_TRUE(m_ds2->query(m_db.prepare("SELECT COUNT(*) FROM files WHERE idPath=%i", m_ds->fv(1).get_asInt()).c_str()));
+      EXPECT_EQ(LibraryItems / 100, m_ds2->fv(0).get_asInt());
+      m_ds2->close();
+    }
+    m_ds->next();
+  }
+  m_ds->close();
+  EXPECT_EQ(LibraryItems, rows);
+}
+
+TEST_F(TestMysqlDataset, ProfiledStream)
+{
+  if (!Connect())
+    return;
+
+  bool profiling = g_advancedSettings.m_databaseProfiling;
+  unsigned int slowQueryTime = g_advancedSettings.m_databaseSlowQueryTime;
+  g_advancedSettings.m_databaseProfiling = true;
+  g_advancedSettings.m_databaseSlowQueryTime = 0;
+  CDatabaseProfiler::Get().Reset();
+
+  // explaining the query as soon as it's run would read the whole stream
+  ASSERT_TRUE(m_ds->query_streamed("SELECT idFile FROM files ORDER BY idFile"));
+  EXPECT_EQ(1, m_ds->num_rows());
+  CVariant stats;
+  CDatabaseProfiler::Get().GetStatistics(stats);
+  EXPECT_EQ(0U, stats["statements"].size());
+
+  int rows = 0;
+  for (; !m_ds->eof(); m_ds->next())
+    rows++;
+  m_ds->close();
+  EXPECT_EQ(LibraryItems, rows);
+
+  // it's recorded with the time its rows took once they are all read
+  CDatabaseProfiler::Get().GetStatistics(stats);
+  ASSERT_EQ(1U, stats["statements"].size());
+  EXPECT_EQ(1, stats["statements"][0]["count"].asInteger());
+  EXPECT_FALSE(stats["statements"][0]["plan"].asString().empty());
+
+  CDatabaseProfiler::Get().Reset();
+  g_advancedSettings.m_databaseProfiling = profiling;
+  g_advancedSettings.m_databaseSlowQueryTime = slowQueryTime;
+}
+
+TEST_F(TestMysqlDataset, Benchmark)
+{
+  if (!Connect())
+    return;
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  ASSERT_TRUE(m_ds->query("SELECT * FROM files"));
+  unsigned int firstRow[2] = { XbmcThreads::SystemClockMillis() - start, 0 };
+  while (!m_ds->eof())
+    m_ds->next();
+  m_ds->close();
+  unsigned int buffered = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  ASSERT_TRUE(m_ds->query_streamed("SELECT * FROM files"));
+  firstRow[1] = XbmcThreads::SystemClockMillis() - start;
+  while (!m_ds->eof())
+    m_ds->next();
+  m_ds->close();
+  unsigned int streamed = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << LibraryItems << " rows read in " << buffered << " ms (first after " << firstRow[0] << " ms) buffered, "
+            << streamed << " ms (first after " << firstRow[1] << " ms) streamed" << std::endl;
+}
+#endif
@@ -0,0 +1,297 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+#include "threads/test/TestHelpers.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+using namespace dbiplus;
+
+namespace
+{
+  // size of the synthetic library used for the benchmark
+  const int LibraryItems = 50000;
+  const int LibraryPaths = 500;
+
+  // batches of items a scan commits while the library is being read
+  const int ScanBatches = 40;
+  const int ScanBatchItems = 250;
+
+  // adds items through its own connection the way a library scan does
+  class ScanWriter : public IRunnable
+  {
+  public:
+    ScanWriter(const SqliteDatabase &db) : m_done(false)
+    {
+      m_db.setHostName(db.getHostName());
+      m_db.setDatabase(db.getDatabase());
+    }
+
+    virtual void Run()
+    {
+      if (m_db.connect(false) == DB_CONNECTION_OK)
+      {
+        std::auto_ptr<Dataset> ds(m_db.CreateDataset());
+        for (int batch = 0; batch < ScanBatches; batch++)
+        {
+          m_db.start_transaction();
+          for (int i = 0; i < ScanBatchItems; i++)
+          {
+            sql_record params;
+            params.push_back(field_value(batch));
+            params.push_back(field_value(StringUtils::Format("scanned %d.mkv", i)));
+            params.push_back(field_value(0.0));
+            ds->exec("INSERT INTO files (idFile, idPath, strFilename, rating) VALUES (NULL, ?, ?, ?)", params);
+          }
+          m_db.commit_transaction();
+        }
+        ds.reset();
+        m_db.disconnect();
+      }
+      m_done = true;
+    }
+
+    volatile bool m_done;
+
+  private:
+    SqliteDatabase m_db;
+  };
+}
+
+class TestSqliteDataset : public testing::Test
+{
+protected:
+  TestSqliteDataset()
+  {
+    m_file = XBMC_CREATETEMPFILE(".db");
+    if (m_file != NULL)
+    {
+      m_file->Close();
+      m_db.setHostName(CXBMCTestUtils::Instance().TempFileDirectory(m_file).c_str());
+      m_db.setDatabase(URIUtils::GetFileName(XBMC_TEMPFILEPATH(m_file)).c_str());
+    }
+  }
+
+  ~TestSqliteDataset()
+  {
+    m_ds.reset();
+    m_db.disconnect();
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_file != NULL);
+    ASSERT_EQ(DB_CONNECTION_OK, m_db.connect(true));
+    m_ds.reset(m_db.CreateDataset());
+    m_ds->exec("CREATE TABLE files (idFile integer primary key, idPath integer, strFilename text, rating double)");
+    m_ds->exec("CREATE UNIQUE INDEX ix_files ON files (idPath, strFilename)");
+  }
+
+  void CreateLibrary()
+  {
+    m_db.start_transaction();
+    for (int i = 0; i < LibraryItems; i++)
+    {
+      sql_record params;
+      params.push_back(field_value(i % LibraryPaths));
+      params.push_back(field_value(StringUtils::Format("movie %d.mkv", i)));
+      params.push_back(field_value(i / 10.0));
+      m_ds->exec("INSERT INTO files (idFile, idPath, strFilename, rating) VALUES (NULL, ?, ?, ?)", params);
+    }
+    m_db.commit_transaction();
+  }
+
+  // looks up every item of the library by path and file name
+  unsigned int LookupLibrary(bool bind)
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (int i = 0; i < LibraryItems; i++)
+    {
+      std::string file = StringUtils::Format("movie %d.mkv", i);
+      if (bind)
+      {
+        sql_record params;
+        params.push_back(field_value(i % LibraryPaths));
+        params.push_back(field_value(file));
+        m_ds->query("SELECT idFile FROM files WHERE idPath=? AND strFilename=?", params);
+      }
+      else
+        m_ds->query(m_db.prepare("SELECT idFile FROM files WHERE idPath=%i AND strFilename='%s'", i % LibraryPaths, file.c_str()).c_str());
+
+      EXPECT_EQ(i + 1, m_ds->fv(0).get_asInt());
+      m_ds->close();
+    }
+    return std::max(XbmcThreads::SystemClockMillis() - start, 1U);
+  }
+
+  // reads the library while a scan adds items, returns the number of reads
+  unsigned int ReadDuringScan(unsigned int &slowest)
+  {
+    unsigned int reads = 0;
+    slowest = 0;
+
+    ScanWriter writer(m_db);
+    thread scan(writer);
+    while (!writer.m_done)
+    {
+      unsigned int start = XbmcThreads::SystemClockMillis();
+      sql_record params;
+      params.push_back(field_value(reads % ScanBatches));
+      EXPECT_TRUE(m_ds->query("SELECT COUNT(*) FROM files WHERE idPath=?", params));
+      m_ds->close();
+      slowest = std::max(slowest, XbmcThreads::SystemClockMillis() - start);
+      reads++;
+    }
+    scan.join();
+
+    return reads;
+  }
+
+  XFILE::CFile *m_file;
+  SqliteDatabase m_db;
+  std::auto_ptr<Dataset> m_ds;
+};
+
+TEST_F(TestSqliteDataset, BoundValues)
+{
+  sql_record params;
+  params.push_back(field_value(7));
+  params.push_back(field_value("it's a \"quoted\" name?"));
+  params.push_back(field_value(2.5));
+  EXPECT_EQ(SQLITE_OK, m_ds->exec("INSERT INTO files (idFile, idPath, strFilename, rating) VALUES (NULL, ?, ?, ?)", params));
+
+  field_value null;
+  null.set_isNull();
+  params.clear();
+  params.push_back(field_value(8));
+  params.push_back(null);
+  params.push_back(null);
+  EXPECT_EQ(SQLITE_OK, m_ds->exec("INSERT INTO files (idFile, idPath, strFilename, rating) VALUES (NULL, ?, ?, ?)", params));
+
+  params.clear();
+  params.push_back(field_value(std::string("it's a \"quoted\" name?")));
+  ASSERT_TRUE(m_ds->query("SELECT idPath, rating FROM files WHERE strFilename=?", params));
+  ASSERT_EQ(1, m_ds->num_rows());
+  EXPECT_EQ(7, m_ds->fv(0).get_asInt());
+  EXPECT_EQ(2.5, m_ds->fv(1).get_asDouble());
+  m_ds->close();
+
+  // placeholders in string literals are not bound
+  params.clear();
+  params.push_back(field_value(8));
+  ASSERT_TRUE(m_ds->query("SELECT '?', strFilename FROM files WHERE idPath=?", params));
+  ASSERT_EQ(1, m_ds->num_rows());
+  EXPECT_STREQ("?", m_ds->fv(0).get_asString().c_str());
+  EXPECT_TRUE(m_ds->fv(1).get_isNull());
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, MissingValues)
+{
+  sql_record params;
+  params.push_back(field_value(1));
+  EXPECT_THROW(m_ds->query("SELECT idFile FROM files WHERE idPath=? AND strFilename=?", params), DbErrors);
+  EXPECT_THROW(m_ds->exec("DELETE FROM files WHERE idPath=? AND strFilename=?", params), DbErrors);
+
+  // the statement is usable again afterwards
+  params.push_back(field_value("file"));
+  EXPECT_TRUE(m_ds->query("SELECT idFile FROM files WHERE idPath=? AND strFilename=?", params));
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, StatementCache)
+{
+  sql_record params;
+  params.push_back(field_value(1));
+
+  unsigned int hits = m_db.get_statement_hits();
+  unsigned int misses = m_db.get_statement_misses();
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_TRUE(m_ds->query("SELECT idFile FROM files WHERE idPath=?", params));
+    m_ds->close();
+  }
+  EXPECT_EQ(hits + 9, m_db.get_statement_hits());
+  EXPECT_EQ(misses + 1, m_db.get_statement_misses());
+
+  // literal sql is prepared and finalized every time, without going through the cache
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_TRUE(m_ds->query(StringUtils::Format("SELECT idFile FROM files WHERE idPath=%i", i).c_str()));
+    m_ds->close();
+    EXPECT_EQ(SQLITE_OK, m_ds->exec(StringUtils::Format("DELETE FROM files WHERE idPath=%i", i + 100)));
+  }
+  EXPECT_EQ(hits + 9, m_db.get_statement_hits());
+  EXPECT_EQ(misses + 1, m_db.get_statement_misses());
+
+  m_db.set_statement_cache_size(0);
+  hits = m_db.get_statement_hits();
+  ASSERT_TRUE(m_ds->query("SELECT idFile FROM files WHERE idPath=?", params));
+  m_ds->close();
+  ASSERT_TRUE(m_ds->query("SELECT idFile FROM files WHERE idPath=?", params));
+  m_ds->close();
+  EXPECT_EQ(hits, m_db.get_statement_hits());
+}
+
+TEST_F(TestSqliteDataset, Benchmark)
+{
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CreateLibrary();
+  unsigned int created = XbmcThreads::SystemClockMillis() - start;
+
+  unsigned int literal = LookupLibrary(false);
+  unsigned int bound = LookupLibrary(true);
+
+  std::cout << LibraryItems << " items inserted in " << created << " ms, looked up in "
+            << literal << " ms with literal values and " << bound << " ms with bound values" << std::endl;
+}
+
+TEST_F(TestSqliteDataset, ReadsDuringScan)
+{
+  unsigned int slowest[2];
+  unsigned int reads[2];
+
+  // readers and the writer lock each other out with a rollback journal
+  m_ds->exec("PRAGMA journal_mode=DELETE");
+  reads[0] = ReadDuringScan(slowest[0]);
+
+  m_ds->exec("DELETE FROM files");
+  m_ds->exec("PRAGMA journal_mode=WAL");
+  reads[1] = ReadDuringScan(slowest[1]);
+
+  ASSERT_TRUE(m_ds->query("SELECT COUNT(*) FROM files"));
+  EXPECT_EQ(ScanBatches * ScanBatchItems, m_ds->fv(0).get_asInt());
+  m_ds->close();
+  EXPECT_LT(0U, reads[1]);
+
+  std::cout << "reads during a scan of " << ScanBatches * ScanBatchItems << " items: "
+            << reads[0] << " (slowest " << slowest[0] << " ms) with a rollback journal, "
+            << reads[1] << " (slowest " << slowest[1] << " ms) in WAL mode" << std::endl;
+}
@@ -419,6 +419,7 @@ void CGUIDialogSmartPlaylistRule::UpdateButtons()
     labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_DOES_NOT_CONTAIN));
     labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_STARTS_WITH));
     labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_ENDS_WITH));
+    labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_MATCHES));
     break;
 
   case CDatabaseQueryRule::NUMERIC_FIELD:
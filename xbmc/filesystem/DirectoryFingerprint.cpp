@@ -0,0 +1,176 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DirectoryFingerprint.h"
+#include "Directory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "Util.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace XFILE;
+
+CDirectoryFingerprint::CDirectoryFingerprint(const std::string &root, const vector<string> &excludes)
+  : m_root(root), m_excludes(StringUtils::Join(excludes, "|")), m_regexps(excludes)
+{
+  URIUtils::AddSlashAtEnd(m_root);
+}
+
+std::string CDirectoryFingerprint::GetHash() const
+{
+  FOLDERS::const_iterator it = m_folders.find(m_root);
+  if (it == m_folders.end())
+    return "";
+  return it->second.hash;
+}
+
+bool CDirectoryFingerprint::Update()
+{
+  FOLDERS stored;
+  stored.swap(m_folders);
+
+  if (!Update(m_root, stored, PropagatesTimes(m_root)))
+  {
+    CLog::Log(LOGDEBUG, "%s - unable to fingerprint '%s'", __FUNCTION__, CURL::GetRedacted(m_root).c_str());
+    m_folders.clear();
+    return true;
+  }
+
+  FOLDERS::const_iterator it = stored.find(m_root);
+  return it == stored.end() || it->second.hash != GetHash();
+}
+
+std::string CDirectoryFingerprint::GetEndOfTree(const std::string &path)
+{
+  std::string end(path);
+  if (!end.empty())
+    end[end.size() - 1]++;
+  return end;
+}
+
+bool CDirectoryFingerprint::PropagatesTimes(const std::string &path)
+{
+  const vector<string> &paths = g_advancedSettings.m_propagatedMTimePaths;
+  for (vector<string>::const_iterator it = paths.begin(); it != paths.end(); ++it)
+  {
+    if (StringUtils::StartsWith(path, *it))
+      return true;
+  }
+  return false;
+}
+
+bool CDirectoryFingerprint::Update(const std::string &path, const FOLDERS &stored, bool propagated)
+{
+  CFolder folder;
+  struct __stat64 buffer;
+  if (CFile::Stat(path, &buffer) == 0)
+    folder.modified = buffer.st_mtime ? buffer.st_mtime : buffer.st_ctime;
+  if (!folder.modified)
+    return false;
+
+  vector<string> subFolders;
+  FOLDERS::const_iterator it = stored.find(path);
+  if (it != stored.end() && it->second.modified == folder.modified && IsValid(stored, it))
+  {
+    if (propagated)
+    { // nothing below it can have changed either
+      m_folders.insert(it, stored.lower_bound(GetEndOfTree(path)));
+      return true;
+    }
+    // the folder itself is unchanged, but its subfolders need checking all the same
+    folder.entries = it->second.entries;
+    GetSubFolders(stored, path, subFolders);
+  }
+  else
+  {
+    CFileItemList items;
+    if (!CDirectory::GetDirectory(path, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO | DIR_FLAG_BYPASS_CACHE))
+      return false;
+
+    folder.entries = items.Size();
+    for (int i = 0; i < items.Size(); ++i)
+    {
+      const CFileItemPtr item = items[i];
+      if (item->m_bIsFolder && !item->IsParentFolder() && !CUtil::ExcludeFileOrFolder(item->GetPath(), m_regexps))
+      {
+        std::string subFolder = item->GetPath();
+        URIUtils::AddSlashAtEnd(subFolder);
+        subFolders.push_back(subFolder);
+      }
+    }
+    sort(subFolders.begin(), subFolders.end());
+  }
+
+  for (vector<string>::const_iterator subFolder = subFolders.begin(); subFolder != subFolders.end(); ++subFolder)
+  {
+    if (!Update(*subFolder, stored, propagated))
+      return false;
+  }
+
+  folder.hash = GetHash(folder, m_folders, subFolders);
+  m_folders[path] = folder;
+  return true;
+}
+
+bool CDirectoryFingerprint::IsValid(const FOLDERS &stored, FOLDERS::const_iterator folder) const
+{
+  // a folder is only reused if it was fingerprinted with the same excludes, and all of its subfolders were
+  vector<string> subFolders;
+  GetSubFolders(stored, folder->first, subFolders);
+  return !folder->second.hash.empty() && GetHash(folder->second, stored, subFolders) == folder->second.hash;
+}
+
+void CDirectoryFingerprint::GetSubFolders(const FOLDERS &folders, const std::string &path, vector<string> &subFolders) const
+{
+  // skip over the trees of the subfolders, leaving just their roots
+  FOLDERS::const_iterator end = folders.lower_bound(GetEndOfTree(path));
+  FOLDERS::const_iterator it = folders.upper_bound(path);
+  while (it != end)
+  {
+    if (!CUtil::ExcludeFileOrFolder(it->first, m_regexps))
+      subFolders.push_back(it->first);
+    it = folders.lower_bound(GetEndOfTree(it->first));
+  }
+}
+
+std::string CDirectoryFingerprint::GetHash(const CFolder &folder, const FOLDERS &folders, const vector<string> &subFolders) const
+{
+  XBMC::XBMC_MD5 md5state;
+  md5state.append(m_excludes);
+  md5state.append((unsigned char *)&folder.modified, sizeof(folder.modified));
+  md5state.append((unsigned char *)&folder.entries, sizeof(folder.entries));
+  for (vector<string>::const_iterator subFolder = subFolders.begin(); subFolder != subFolders.end(); ++subFolder)
+  {
+    FOLDERS::const_iterator it = folders.find(*subFolder);
+    if (it == folders.end())
+      return "";
+    md5state.append(*subFolder);
+    md5state.append(it->second.hash);
+  }
+  return md5state.getDigest();
+}
@@ -0,0 +1,96 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace XFILE
+{
+  /*!
+   \ingroup filesystem
+   \brief Fingerprint of the folders of a directory tree, used to tell cheaply whether anything below it changed.
+
+   Each folder is recorded with its mtime, its number of entries and a hash over those and the
+   hashes of its subfolders, so the hash of the root changes whenever a folder anywhere below it
+   is modified. The fingerprint is kept in the library databases and refreshed with Update(), which
+   only lists the folders whose mtime changed and otherwise just stats each folder.
+
+   On paths configured as propagating mtimes (a change anywhere below a folder updates the
+   folder's own mtime) a folder with an unchanged mtime is taken as unchanged as a whole, so an
+   untouched tree costs a single stat.
+   */
+  class CDirectoryFingerprint
+  {
+  public:
+    struct CFolder
+    {
+      CFolder() : modified(0), entries(0) {}
+      int64_t modified; ///< mtime of the folder (ctime where there's no mtime)
+      int entries;      ///< number of files and folders in it
+      std::string hash; ///< hash over the above and the hashes of the (non excluded) subfolders
+    };
+    typedef std::map<std::string, CFolder> FOLDERS;
+
+    /*! \brief Fingerprint of the tree at the given path, leaving out subfolders matching the excludes.
+     */
+    CDirectoryFingerprint(const std::string &root, const std::vector<std::string> &excludes);
+
+    const std::string &GetRoot() const { return m_root; };
+
+    /*! \brief The folders of the tree keyed by path, the root included, or empty if there is no fingerprint.
+     */
+    const FOLDERS &GetFolders() const { return m_folders; };
+    void SetFolders(const FOLDERS &folders) { m_folders = folders; };
+
+    /*! \brief Hash of the whole tree, empty if there is no fingerprint.
+     */
+    std::string GetHash() const;
+
+    /*! \brief Bring the fingerprint up to date with the filesystem.
+     If the tree can't be fingerprinted (no mtimes, or a folder that can't be read) the fingerprint
+     is cleared, and callers should fall back to looking at the tree itself.
+     \return true if anything changed since the fingerprint was taken (or there was none), false otherwise.
+     */
+    bool Update();
+
+    /*! \brief Whether folder mtimes propagate up on the given path, as configured in advancedsettings.xml.
+     */
+    static bool PropagatesTimes(const std::string &path);
+
+    /*! \brief The first path sorting after those of the folder and everything below it, for range queries.
+     */
+    static std::string GetEndOfTree(const std::string &path);
+
+  private:
+    bool Update(const std::string &path, const FOLDERS &stored, bool propagated);
+    bool IsValid(const FOLDERS &stored, FOLDERS::const_iterator folder) const;
+    void GetSubFolders(const FOLDERS &folders, const std::string &path, std::vector<std::string> &subFolders) const;
+    std::string GetHash(const CFolder &folder, const FOLDERS &folders, const std::vector<std::string> &subFolders) const;
+
+    std::string m_root;
+    std::string m_excludes; ///< the exclude expressions, part of every hash
+    std::vector<std::string> m_regexps;
+    FOLDERS m_folders;
+  };
+}
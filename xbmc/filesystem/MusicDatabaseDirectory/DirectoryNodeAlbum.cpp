@@ -40,7 +40,7 @@ std::string CDirectoryNodeAlbum::GetLocalizedName() const
   if (GetID() == -1)
     return g_localizeStrings.Get(15102); // All Albums
   CMusicDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
     return db.GetAlbumById(GetID());
   return "";
 }
@@ -48,7 +48,7 @@ std::string CDirectoryNodeAlbum::GetLocalizedName() const
 bool CDirectoryNodeAlbum::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
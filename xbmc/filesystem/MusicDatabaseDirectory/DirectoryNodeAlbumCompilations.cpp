@@ -43,7 +43,7 @@ std::string CDirectoryNodeAlbumCompilations::GetLocalizedName() const
   if (GetID() == -1)
     return g_localizeStrings.Get(15102); // All Albums
   CMusicDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
     return db.GetAlbumById(GetID());
   return "";
 }
@@ -51,7 +51,7 @@ std::string CDirectoryNodeAlbumCompilations::GetLocalizedName() const
 bool CDirectoryNodeAlbumCompilations::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
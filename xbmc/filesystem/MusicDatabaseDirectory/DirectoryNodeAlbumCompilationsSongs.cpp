@@ -34,7 +34,7 @@ CDirectoryNodeAlbumCompilationsSongs::CDirectoryNodeAlbumCompilationsSongs(const
 bool CDirectoryNodeAlbumCompilationsSongs::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -44,7 +44,7 @@ std::string CDirectoryNodeAlbumRecentlyAdded::GetLocalizedName() const
   if (GetID() == -1)
     return g_localizeStrings.Get(15102); // All Albums
   CMusicDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
     return db.GetAlbumById(GetID());
   return "";
 }
@@ -52,7 +52,7 @@ std::string CDirectoryNodeAlbumRecentlyAdded::GetLocalizedName() const
 bool CDirectoryNodeAlbumRecentlyAdded::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   VECALBUMS albums;
@@ -42,7 +42,7 @@ NODE_TYPE CDirectoryNodeAlbumTop100::GetChildType() const
 std::string CDirectoryNodeAlbumTop100::GetLocalizedName() const
 {
   CMusicDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
     return db.GetAlbumById(GetID());
   return "";
 }
@@ -50,7 +50,7 @@ std::string CDirectoryNodeAlbumTop100::GetLocalizedName() const
 bool CDirectoryNodeAlbumTop100::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   VECALBUMS albums;
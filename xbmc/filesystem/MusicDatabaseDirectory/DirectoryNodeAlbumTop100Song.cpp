@@ -32,7 +32,7 @@ CDirectoryNodeAlbumTop100Song::CDirectoryNodeAlbumTop100Song(const std::string&
 bool CDirectoryNodeAlbumTop100Song::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   std::string strBaseDir=BuildPath();
@@ -43,7 +43,7 @@ std::string CDirectoryNodeAudiobooks::GetLocalizedName() const
 bool CDirectoryNodeAudiobooks::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   bool bSuccess=musicdatabase.GetAudioBooks(items);
@@ -39,7 +39,7 @@ NODE_TYPE CDirectoryNodeGrouped::GetChildType() const
 std::string CDirectoryNodeGrouped::GetLocalizedName() const
 {
   CMusicDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
     return db.GetItemById(GetContentType(), GetID());
   return "";
 }
@@ -47,7 +47,7 @@ std::string CDirectoryNodeGrouped::GetLocalizedName() const
 bool CDirectoryNodeGrouped::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   return musicdatabase.GetItems(BuildPath(), GetContentType(), items);
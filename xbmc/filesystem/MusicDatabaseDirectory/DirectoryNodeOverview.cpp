@@ -73,7 +73,7 @@ bool CDirectoryNodeOverview::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicDatabase;
   bool showSingles = false;
-  if (musicDatabase.Open())
+  if (musicDatabase.OpenReadOnly())
   {
     CDatabase::Filter filter("songview.idAlbum IN (SELECT idAlbum FROM album WHERE strAlbum = '')");
     if (musicDatabase.GetSongsCount(filter) > 0)
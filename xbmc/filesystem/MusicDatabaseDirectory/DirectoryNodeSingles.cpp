@@ -33,7 +33,7 @@ CDirectoryNodeSingles::CDirectoryNodeSingles(const std::string& strName, CDirect
 bool CDirectoryNodeSingles::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   bool bSuccess=musicdatabase.GetSongsByWhere(BuildPath(), CDatabase::Filter(), items);
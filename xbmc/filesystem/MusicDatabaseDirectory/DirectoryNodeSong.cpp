@@ -33,7 +33,7 @@ CDirectoryNodeSong::CDirectoryNodeSong(const std::string& strName, CDirectoryNod
 bool CDirectoryNodeSong::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
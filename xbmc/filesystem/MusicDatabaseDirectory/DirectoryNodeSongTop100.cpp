@@ -32,7 +32,7 @@ CDirectoryNodeSongTop100::CDirectoryNodeSongTop100(const std::string& strName, C
 bool CDirectoryNodeSongTop100::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   std::string strBaseDir=BuildPath();
@@ -33,7 +33,7 @@ CDirectoryNodeYearSong::CDirectoryNodeYearSong(const std::string& strName, CDire
 bool CDirectoryNodeYearSong::GetContent(CFileItemList& items) const
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
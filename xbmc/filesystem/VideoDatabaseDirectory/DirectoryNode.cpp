@@ -328,7 +328,7 @@ void CDirectoryNode::AddQueuingFolder(CFileItemList& items) const
         pItem->GetVideoInfoTag()->m_iEpisode = watched + unwatched;
         pItem->GetVideoInfoTag()->m_playCount = (unwatched == 0) ? 1 : 0;
         CVideoDatabase db;
-        if (db.Open())
+        if (db.OpenReadOnly())
         {
           pItem->GetVideoInfoTag()->m_iDbId = db.GetSeasonId(pItem->GetVideoInfoTag()->m_iIdShow, -1);
           db.Close();
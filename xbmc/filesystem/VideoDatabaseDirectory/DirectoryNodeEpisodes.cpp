@@ -33,7 +33,7 @@ CDirectoryNodeEpisodes::CDirectoryNodeEpisodes(const std::string& strName, CDire
 bool CDirectoryNodeEpisodes::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
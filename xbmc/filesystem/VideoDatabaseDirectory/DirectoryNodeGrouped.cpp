@@ -50,7 +50,7 @@ NODE_TYPE CDirectoryNodeGrouped::GetChildType() const
 std::string CDirectoryNodeGrouped::GetLocalizedName() const
 {
   CVideoDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
     return db.GetItemById(GetContentType(), GetID());
 
   return "";
@@ -59,7 +59,7 @@ std::string CDirectoryNodeGrouped::GetLocalizedName() const
 bool CDirectoryNodeGrouped::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
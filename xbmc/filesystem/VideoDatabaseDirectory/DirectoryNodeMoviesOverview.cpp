@@ -74,7 +74,7 @@ bool CDirectoryNodeMoviesOverview::GetContent(CFileItemList& items) const
     if (i == 6)
     {
       CVideoDatabase db;
-      if (db.Open() && !db.HasSets())
+      if (db.OpenReadOnly() && !db.HasSets())
         continue;
     }
 
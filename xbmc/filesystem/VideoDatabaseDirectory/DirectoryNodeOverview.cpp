@@ -65,7 +65,7 @@ std::string CDirectoryNodeOverview::GetLocalizedName() const
 bool CDirectoryNodeOverview::GetContent(CFileItemList& items) const
 {
   CVideoDatabase database;
-  database.Open();
+  database.OpenReadOnly();
   bool hasMovies = database.HasContent(VIDEODB_CONTENT_MOVIES);
   bool hasTvShows = database.HasContent(VIDEODB_CONTENT_TVSHOWS);
   bool hasMusicVideos = database.HasContent(VIDEODB_CONTENT_MUSICVIDEOS);
@@ -32,7 +32,7 @@ CDirectoryNodeRecentlyAddedEpisodes::CDirectoryNodeRecentlyAddedEpisodes(const s
 bool CDirectoryNodeRecentlyAddedEpisodes::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
   
   bool bSuccess=videodatabase.GetRecentlyAddedEpisodesNav(BuildPath(), items);
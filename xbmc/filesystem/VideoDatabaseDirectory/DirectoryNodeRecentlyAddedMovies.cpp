@@ -32,7 +32,7 @@ CDirectoryNodeRecentlyAddedMovies::CDirectoryNodeRecentlyAddedMovies(const std::
 bool CDirectoryNodeRecentlyAddedMovies::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
   
   bool bSuccess=videodatabase.GetRecentlyAddedMoviesNav(BuildPath(), items);
@@ -32,7 +32,7 @@ CDirectoryNodeRecentlyAddedMusicVideos::CDirectoryNodeRecentlyAddedMusicVideos(c
 bool CDirectoryNodeRecentlyAddedMusicVideos::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
   
   bool bSuccess=videodatabase.GetRecentlyAddedMusicVideosNav(BuildPath(), items);
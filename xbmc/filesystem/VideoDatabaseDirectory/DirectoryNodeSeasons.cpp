@@ -65,7 +65,7 @@ std::string CDirectoryNodeSeasons::GetLocalizedName() const
 bool CDirectoryNodeSeasons::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -33,7 +33,7 @@ CDirectoryNodeTitleMusicVideos::CDirectoryNodeTitleMusicVideos(const std::string
 bool CDirectoryNodeTitleMusicVideos::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
@@ -38,7 +38,7 @@ NODE_TYPE CDirectoryNodeTitleTvShows::GetChildType() const
 std::string CDirectoryNodeTitleTvShows::GetLocalizedName() const
 {
   CVideoDatabase db;
-  if (db.Open())
+  if (db.OpenReadOnly())
     return db.GetTvShowTitleById(GetID());
   return "";
 }
@@ -46,7 +46,7 @@ std::string CDirectoryNodeTitleTvShows::GetLocalizedName() const
 bool CDirectoryNodeTitleTvShows::GetContent(CFileItemList& items) const
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return false;
 
   CQueryParams params;
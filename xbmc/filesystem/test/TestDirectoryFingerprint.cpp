@@ -0,0 +1,184 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/Directory.h"
+#include "filesystem/DirectoryFingerprint.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <utime.h>
+
+using namespace XFILE;
+
+class TestDirectoryFingerprint : public testing::Test
+{
+protected:
+  TestDirectoryFingerprint()
+    : m_propagated(g_advancedSettings.m_propagatedMTimePaths)
+  {
+    m_file = XBMC_CREATETEMPFILE("");
+    if (m_file != NULL)
+    {
+      m_file->Close();
+      m_root = URIUtils::AddFileToFolder(CXBMCTestUtils::Instance().TempFileDirectory(m_file), "TestDirectoryFingerprint/");
+      Create("");
+      Create("a/");
+      Create("a/b/");
+      Create("c/");
+    }
+  }
+
+  ~TestDirectoryFingerprint()
+  {
+    g_advancedSettings.m_propagatedMTimePaths = m_propagated;
+
+    for (std::vector<std::string>::reverse_iterator it = m_created.rbegin(); it != m_created.rend(); ++it)
+    {
+      if (URIUtils::HasSlashAtEnd(*it))
+        CDirectory::Remove(*it);
+      else
+        CFile::Delete(*it);
+    }
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  void Create(const std::string &path)
+  {
+    std::string created = URIUtils::AddFileToFolder(m_root, path);
+    if (URIUtils::HasSlashAtEnd(created))
+      EXPECT_TRUE(CDirectory::Create(created));
+    else
+    {
+      CFile file;
+      EXPECT_TRUE(file.OpenForWrite(created, true));
+      file.Close();
+    }
+    m_created.push_back(created);
+  }
+
+  // move the mtimes of the folders back, so that changes within the second are noticed
+  void Age()
+  {
+    for (std::vector<std::string>::const_iterator it = m_created.begin(); it != m_created.end(); ++it)
+    {
+      struct utimbuf times;
+      times.actime = times.modtime = 1000000000;
+      EXPECT_EQ(0, utime(CSpecialProtocol::TranslatePath(*it).c_str(), &times));
+    }
+  }
+
+  // a fingerprint loaded with the folders of another, as if from the database
+  CDirectoryFingerprint Stored(const CDirectoryFingerprint &fingerprint, const std::vector<std::string> &excludes)
+  {
+    CDirectoryFingerprint stored(m_root, excludes);
+    stored.SetFolders(fingerprint.GetFolders());
+    return stored;
+  }
+
+  std::vector<std::string> m_propagated;
+  CFile *m_file;
+  std::string m_root;
+  std::vector<std::string> m_created;
+};
+
+TEST_F(TestDirectoryFingerprint, Update)
+{
+  ASSERT_TRUE(m_file != NULL);
+  Age();
+
+  std::vector<std::string> excludes;
+  CDirectoryFingerprint fingerprint(m_root, excludes);
+  EXPECT_TRUE(fingerprint.Update());
+  EXPECT_EQ(4U, fingerprint.GetFolders().size());
+  EXPECT_FALSE(fingerprint.GetHash().empty());
+
+  CDirectoryFingerprint unchanged = Stored(fingerprint, excludes);
+  EXPECT_FALSE(unchanged.Update());
+  EXPECT_EQ(fingerprint.GetHash(), unchanged.GetHash());
+
+  // a change deep down is found even though the mtimes above it stay the same
+  Create("a/b/movie.mkv");
+  CDirectoryFingerprint changed = Stored(fingerprint, excludes);
+  EXPECT_TRUE(changed.Update());
+  EXPECT_NE(fingerprint.GetHash(), changed.GetHash());
+
+  // as is a new folder
+  Age();
+  fingerprint = Stored(changed, excludes);
+  fingerprint.Update();
+  Create("c/d/");
+  changed = Stored(fingerprint, excludes);
+  EXPECT_TRUE(changed.Update());
+  EXPECT_EQ(5U, changed.GetFolders().size());
+}
+
+TEST_F(TestDirectoryFingerprint, Excludes)
+{
+  ASSERT_TRUE(m_file != NULL);
+  Age();
+
+  std::vector<std::string> excludes;
+  excludes.push_back("/c/");
+  CDirectoryFingerprint fingerprint(m_root, excludes);
+  EXPECT_TRUE(fingerprint.Update());
+  EXPECT_EQ(3U, fingerprint.GetFolders().size());
+
+  // changes in excluded folders don't count
+  Create("c/movie.mkv");
+  CDirectoryFingerprint unchanged = Stored(fingerprint, excludes);
+  EXPECT_FALSE(unchanged.Update());
+
+  // but a fingerprint taken with other excludes isn't trusted
+  CDirectoryFingerprint changed = Stored(fingerprint, std::vector<std::string>());
+  EXPECT_TRUE(changed.Update());
+  EXPECT_EQ(4U, changed.GetFolders().size());
+}
+
+TEST_F(TestDirectoryFingerprint, Propagated)
+{
+  ASSERT_TRUE(m_file != NULL);
+  Age();
+  g_advancedSettings.m_propagatedMTimePaths.push_back(m_root);
+  EXPECT_TRUE(CDirectoryFingerprint::PropagatesTimes(URIUtils::AddFileToFolder(m_root, "a/")));
+
+  std::vector<std::string> excludes;
+  CDirectoryFingerprint fingerprint(m_root, excludes);
+  EXPECT_TRUE(fingerprint.Update());
+
+  // the unchanged mtime of the root is trusted for everything below it
+  Create("a/b/movie.mkv");
+  CDirectoryFingerprint unchanged = Stored(fingerprint, excludes);
+  EXPECT_FALSE(unchanged.Update());
+  EXPECT_EQ(4U, unchanged.GetFolders().size());
+
+  // which is what a filesystem propagating mtimes would have changed
+  struct utimbuf times;
+  times.actime = times.modtime = 1100000000;
+  ASSERT_EQ(0, utime(CSpecialProtocol::TranslatePath(m_root).c_str(), &times));
+  ASSERT_EQ(0, utime(CSpecialProtocol::TranslatePath(URIUtils::AddFileToFolder(m_root, "a/")).c_str(), &times));
+  CDirectoryFingerprint changed = Stored(fingerprint, excludes);
+  EXPECT_TRUE(changed.Update());
+  EXPECT_NE(fingerprint.GetHash(), changed.GetHash());
+}
@@ -35,6 +35,7 @@
 #include "utils/Variant.h"
 #include "Key.h"
 #include "utils/StringUtils.h"
+#include "utils/PerformanceTrace.h"
 
 using namespace std;
 
@@ -550,6 +551,7 @@ void CGUIWindowManager::RenderPass() const
 
 bool CGUIWindowManager::Render()
 {
+  TRACE_FUNCTION;
   assert(g_application.IsCurrentThread());
   CSingleLock lock(g_graphicsContext);
 
@@ -26,6 +26,7 @@
 #include "ApplicationMessenger.h"
 #include "Autorun.h"
 #include "Builtins.h"
+#include "LibraryMonitor.h"
 #include "input/ButtonTranslator.h"
 #include "FileItem.h"
 #include "addons/GUIDialogAddonSettings.h"
@@ -52,6 +53,7 @@
 #include "storage/MediaManager.h"
 #include "utils/RssManager.h"
 #include "utils/JSONVariantParser.h"
+#include "utils/PerformanceTrace.h"
 #include "PartyModeManager.h"
 #include "profiles/ProfilesManager.h"
 #include "settings/DisplaySettings.h"
@@ -68,6 +70,7 @@
 
 #include "filesystem/PluginDirectory.h"
 #include "filesystem/ZipManager.h"
+#include "filesystem/SpecialProtocol.h"
 
 #include "guilib/GUIWindowManager.h"
 #include "guilib/LocalizeStrings.h"
@@ -221,6 +224,8 @@ const BUILT_IN commands[] = {
   { "ToggleDebug",                false,  "Enables/disables debug mode" },
   { "StartPVRManager",            false,  "(Re)Starts the PVR manager" },
   { "StopPVRManager",             false,  "Stops the PVR manager" },
+  { "StartPerformanceTrace",      false,  "Starts recording a performance trace" },
+  { "StopPerformanceTrace",       false,  "Stops the performance trace and saves it. Optional parameter is the file to save to (default special://temp/xbmc-trace.json)" },
 #if defined(TARGET_ANDROID)
   { "StartAndroidActivity",       true,   "Launch an Android native app with the given package name.  Optional parms (in order): intent, dataType, dataURI." },
 #endif
@@ -1369,6 +1374,10 @@ int CBuiltins::Execute(const std::string& execString)
       return -1;
 
     g_application.StopPlaying();
+
+    // the sources watched are those of the profile logged off, it's started again on login
+    CLibraryMonitor::Get().Stop();
+
     if (g_application.IsMusicScanning())
       g_application.StopMusicScan();
 
@@ -1748,6 +1757,15 @@ int CBuiltins::Execute(const std::string& execString)
   {
     g_application.StopPVRManager();
   }
+  else if (execute == "startperformancetrace")
+  {
+    CPerformanceTrace::Start();
+  }
+  else if (execute == "stopperformancetrace")
+  {
+    CPerformanceTrace::Stop();
+    CPerformanceTrace::Save(CSpecialProtocol::TranslatePath(params.empty() ? "special://temp/xbmc-trace.json" : params[0]));
+  }
   else if (execute == "startandroidactivity" && !params.empty())
   {
     CApplicationMessenger::Get().StartAndroidActivity(params);
@@ -41,7 +41,7 @@ using namespace XFILE;
 JSONRPC_STATUS CAudioLibrary::GetArtists(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   CMusicDbUrl musicUrl;
@@ -89,7 +89,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtists(const std::string &method, ITransportLa
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("artistid", false, "artists", items, param, result, size, false);
+  StreamFileItemList("artistid", false, "artists", items, param, result, size, false);
   return OK;
 }
 
@@ -102,7 +102,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtistDetails(const std::string &method, ITrans
     return InternalError;
 
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   musicUrl.AddOption("artistid", artistID);
@@ -125,7 +125,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtistDetails(const std::string &method, ITrans
 JSONRPC_STATUS CAudioLibrary::GetAlbums(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   CMusicDbUrl musicUrl;
@@ -165,7 +165,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbums(const std::string &method, ITransportLay
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
+  StreamFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -175,7 +175,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbumDetails(const std::string &method, ITransp
   int albumID = (int)parameterObject["albumid"].asInteger();
 
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   CAlbum album;
@@ -203,7 +203,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbumDetails(const std::string &method, ITransp
 JSONRPC_STATUS CAudioLibrary::GetSongs(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   CMusicDbUrl musicUrl;
@@ -247,7 +247,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongs(const std::string &method, ITransportLaye
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
+  StreamFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -257,7 +257,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongDetails(const std::string &method, ITranspo
   int idSong = (int)parameterObject["songid"].asInteger();
 
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   CSong song;
@@ -277,7 +277,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongDetails(const std::string &method, ITranspo
 JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedAlbums(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   VECALBUMS albums;
@@ -298,14 +298,14 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedAlbums(const std::string &method,
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result);
+  StreamFileItemList("albumid", false, "albums", items, parameterObject, result);
   return OK;
 }
 
 JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedSongs(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   int amount = (int)parameterObject["albumlimit"].asInteger();
@@ -320,14 +320,14 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedSongs(const std::string &method, I
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result);
+  StreamFileItemList("songid", true, "songs", items, parameterObject, result);
   return OK;
 }
 
 JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedAlbums(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   VECALBUMS albums;
@@ -348,14 +348,14 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedAlbums(const std::string &method,
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result);
+  StreamFileItemList("albumid", false, "albums", items, parameterObject, result);
   return OK;
 }
 
 JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedSongs(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   CFileItemList items;
@@ -366,14 +366,14 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedSongs(const std::string &method,
   if (ret != OK)
     return ret;
 
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result);
+  StreamFileItemList("songid", true, "songs", items, parameterObject, result);
   return OK;
 }
 
 JSONRPC_STATUS CAudioLibrary::GetGenres(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   CFileItemList items;
@@ -384,7 +384,7 @@ JSONRPC_STATUS CAudioLibrary::GetGenres(const std::string &method, ITransportLay
   for (unsigned int i = 0; i < (unsigned int)items.Size(); i++)
     items[i]->GetMusicInfoTag()->SetTitle(items[i]->GetLabel());
 
-  HandleFileItemList("genreid", false, "genres", items, parameterObject, result);
+  StreamFileItemList("genreid", false, "genres", items, parameterObject, result);
   return OK;
 }
 
@@ -656,7 +656,7 @@ void CAudioLibrary::FillAlbumItem(const CAlbum &album, const std::string &path,
 
 JSONRPC_STATUS CAudioLibrary::GetAdditionalAlbumDetails(const CVariant &parameterObject, CFileItemList &items, CMusicDatabase &musicdatabase)
 {
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   std::set<std::string> checkProperties;
@@ -700,7 +700,7 @@ JSONRPC_STATUS CAudioLibrary::GetAdditionalAlbumDetails(const CVariant &paramete
 
 JSONRPC_STATUS CAudioLibrary::GetAdditionalSongDetails(const CVariant &parameterObject, CFileItemList &items, CMusicDatabase &musicdatabase)
 {
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenReadOnly())
     return InternalError;
 
   std::set<std::string> checkProperties;
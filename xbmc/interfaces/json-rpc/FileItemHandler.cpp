@@ -213,6 +213,77 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
 void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
 {
   int start, end;
+  PrepareFileItemList(items, parameterObject, result, size, sortLimit, start, end);
+
+  CThumbLoader *thumbLoader = CreateThumbLoader(items, start, end);
+
+  std::set<std::string> fields;
+  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
+  {
+    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
+      fields.insert(field->asString());
+  }
+
+  if (end - start > 0)
+  {
+    CVariant &list = result[resultname];
+    if (list.isNull())
+      list = CVariant(CVariant::VariantTypeArray);
+    list.reserve(list.size() + end - start);
+  }
+
+  for (int i = start; i < end; i++)
+  {
+    CFileItemPtr item = items.Get(i);
+    HandleFileItem(ID, allowFile, resultname, item, parameterObject, fields, result, true, thumbLoader);
+  }
+
+  delete thumbLoader;
+}
+
+class CFileItemHandler::CFileItemListStream : public IStreamedResult
+{
+public:
+  // takes the values over, leaving values empty
+  CFileItemListStream(CVariant &values)
+    : m_current(0)
+  {
+    m_values.swap(values);
+  }
+
+  virtual bool WriteNext(CJSONStreamWriter &writer)
+  {
+    if (m_current >= m_values.size())
+      return false;
+
+    bool written = writer.Value(m_values[m_current]);
+    // release the item as soon as it has been written
+    m_values[m_current++] = CVariant();
+    return written;
+  }
+
+private:
+  CVariant m_values;
+  unsigned int m_current;
+};
+
+void CFileItemHandler::StreamFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, bool sortLimit /* = true */)
+{
+  StreamFileItemList(ID, allowFile, resultname, items, parameterObject, result, items.Size(), sortLimit);
+}
+
+void CFileItemHandler::StreamFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
+{
+  // the items are filled in (which takes the thumb and info loaders to the databases) right away,
+  // so that only their serialization is left to be done while the response is written
+  HandleFileItemList(ID, allowFile, resultname, items, parameterObject, result, size, sortLimit);
+
+  if (CJSONRPC::CanStreamResult(result) && result.isMember(resultname) && !result[resultname].empty())
+    CJSONRPC::StreamResult(result, resultname, new CFileItemListStream(result[resultname]));
+}
+
+void CFileItemHandler::PrepareFileItemList(CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit, int &start, int &end)
+{
   HandleLimits(parameterObject, result, size, start, end);
 
   if (sortLimit)
@@ -222,7 +293,10 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
     start = 0;
     end = items.Size();
   }
+}
 
+CThumbLoader* CFileItemHandler::CreateThumbLoader(const CFileItemList &items, int start, int end)
+{
   CThumbLoader *thumbLoader = NULL;
   if (end - start > 0)
   {
@@ -235,20 +309,7 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
       thumbLoader->OnLoaderStart();
   }
 
-  std::set<std::string> fields;
-  if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
-  {
-    for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
-      fields.insert(field->asString());
-  }
-
-  for (int i = start; i < end; i++)
-  {
-    CFileItemPtr item = items.Get(i);
-    HandleFileItem(ID, allowFile, resultname, item, parameterObject, fields, result, true, thumbLoader);
-  }
-
-  delete thumbLoader;
+  return thumbLoader;
 }
 
 void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append /* = true */, CThumbLoader *thumbLoader /* = NULL */)
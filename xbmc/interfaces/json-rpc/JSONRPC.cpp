@@ -18,15 +18,22 @@
  *
  */
 
+#include <algorithm>
 #include <string.h>
+#include <boost/shared_ptr.hpp>
 
 #include "JSONRPC.h"
+#include "JSONResponseCache.h"
 #include "ServiceDescription.h"
 #include "dbwrappers/DatabaseQuery.h"
 #include "input/ButtonTranslator.h"
 #include "interfaces/AnnouncementManager.h"
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/Atomics.h"
+#include "threads/Event.h"
+#include "threads/ThreadLocal.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
@@ -38,6 +45,121 @@ using namespace std;
 
 bool CJSONRPC::m_initialized = false;
 
+namespace
+{
+  // result of the method currently being executed on a thread which may be streamed
+  typedef struct
+  {
+    const CVariant *result;
+    std::string member;
+    IStreamedResult *streamed;
+  } StreamableResult;
+
+  XbmcThreads::ThreadLocal<StreamableResult> streamableResult;
+
+  // maximum number of jobs helping with the execution of a single batch
+  const unsigned int MaxParallelBatchJobs = 4;
+}
+
+/*!
+ Executes a group of method calls of a batch request concurrently.
+
+ The calls are handed out one by one to whoever asks for the next one, which
+ is the calling thread itself and a few jobs. As the calling thread keeps
+ working on the calls until none are left the batch completes even if no
+ job worker becomes available in time. The outputs are kept in the order of
+ the requests.
+ */
+class CJSONRPC::CParallelBatch
+{
+public:
+  CParallelBatch(const std::vector<const CVariant*> &requests, ITransportLayer *transport, IClient *client)
+    : m_requests(requests),
+      m_outputs(requests.size()),
+      m_transport(transport),
+      m_client(client),
+      m_next(0),
+      m_done(0)
+  { }
+
+  ~CParallelBatch()
+  {
+    for (std::vector<Output>::iterator it = m_outputs.begin(); it != m_outputs.end(); ++it)
+      delete it->streamed;
+  }
+
+  static void Execute(const boost::shared_ptr<CParallelBatch> &batch, CJSONResponseStream &response)
+  {
+    unsigned int jobs = std::min((unsigned int)batch->m_requests.size() - 1, MaxParallelBatchJobs);
+    for (unsigned int i = 0; i < jobs; i++)
+    {
+      CJob *job = new CBatchJob(batch);
+      if (CJobManager::GetInstance().AddJob(job, NULL, CJob::PRIORITY_HIGH) == 0)
+      {
+        delete job;
+        break;
+      }
+    }
+
+    batch->Run();
+    batch->m_completed.Wait();
+
+    for (std::vector<Output>::iterator it = batch->m_outputs.begin(); it != batch->m_outputs.end(); ++it)
+    {
+      if (!it->hasResponse)
+        continue;
+
+      response.AddResponse(it->output, it->streamed, it->member);
+      it->streamed = NULL;
+    }
+  }
+
+private:
+  class CBatchJob : public CJob
+  {
+  public:
+    CBatchJob(const boost::shared_ptr<CParallelBatch> &batch) : m_batch(batch) { }
+
+    virtual bool DoWork() { m_batch->Run(); return true; }
+    virtual const char *GetType() const { return "jsonrpc"; }
+
+  private:
+    boost::shared_ptr<CParallelBatch> m_batch;
+  };
+
+  struct Output
+  {
+    Output() : streamed(NULL), hasResponse(false) { }
+
+    CVariant output;
+    IStreamedResult *streamed;
+    std::string member;
+    bool hasResponse;
+  };
+
+  void Run()
+  {
+    long count = (long)m_requests.size();
+    long index;
+    while ((index = AtomicIncrement(&m_next) - 1) < count)
+    {
+      Output &output = m_outputs[index];
+      output.hasResponse = ExecuteMethodCall(*m_requests[index], m_transport, m_client, output.output, output.streamed, output.member);
+
+      if (AtomicIncrement(&m_done) == count)
+        m_completed.Set();
+    }
+  }
+
+  std::vector<const CVariant*> m_requests;
+  std::vector<Output> m_outputs;
+  ITransportLayer *m_transport;
+  IClient *m_client;
+  volatile long m_next;
+  volatile long m_done;
+  CEvent m_completed;
+};
+
 void CJSONRPC::Initialize()
 {
   if (m_initialized)
@@ -103,6 +225,10 @@ void CJSONRPC::Initialize()
 
   for (unsigned int index = 0; index < size; index++)
     CJSONServiceDescription::AddNotification(JSONRPC_SERVICE_NOTIFICATIONS[index]);
+
+  CJSONServiceDescription::Compile();
+
+  CAnnouncementManager::Get().AddAnnouncer(&CJSONResponseCache::Get());
   
   m_initialized = true;
   CLog::Log(LOGINFO, "JSONRPC v%s: Successfully initialized", CJSONServiceDescription::GetVersion());
@@ -110,6 +236,13 @@ void CJSONRPC::Initialize()
 
 void CJSONRPC::Cleanup()
 {
+  CJSONResponseCache &cache = CJSONResponseCache::Get();
+  CJSONResponseCache::Statistics statistics = cache.GetStatistics();
+  CLog::Log(LOGDEBUG, "JSONRPC: Response cache had %u hits, %u misses and %u evictions",
+            statistics.hits, statistics.misses, statistics.evictions);
+  CAnnouncementManager::Get().RemoveAnnouncer(&cache);
+  cache.Clear();
+
   CJSONServiceDescription::Cleanup();
   m_initialized = false;
 }
@@ -229,8 +362,20 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const std::string &method, ITransportLayer *t
 
 std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
-  bool hasResponse = false;
+  std::string str;
+  CJSONResponseStream response(g_advancedSettings.m_jsonOutputCompact);
+  if (MethodCall(inputString, transport, client, response))
+  {
+    CJSONStringSink sink(str);
+    response.Write(sink);
+  }
+
+  return str;
+}
+
+bool CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, CJSONResponseStream &response)
+{
+  CVariant inputroot;
 
   if(g_advancedSettings.CanLogComponent(LOGJSONRPC))
     CLog::Log(LOGDEBUG, "JSONRPC: Incoming request: %s", inputString.c_str());
@@ -243,41 +388,86 @@ std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer
       if (inputroot.size() <= 0)
       {
         CLog::Log(LOGERROR, "JSONRPC: Empty batch call\n");
+        CVariant outputroot;
         BuildResponse(inputroot, InvalidRequest, CVariant(), outputroot);
-        hasResponse = true;
+        response.AddResponse(outputroot);
       }
       else
       {
+        response.SetBatch(true);
+
+        // consecutive calls to methods which are safe to run concurrently
+        // are executed together, any other call waits for them to finish
+        std::vector<const CVariant*> parallel;
         for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
         {
-          CVariant response;
-          if (HandleMethodCall(*itr, response, transport, client))
+          if (IsParallelMethodCall(*itr))
           {
-            outputroot.append(response);
-            hasResponse = true;
+            parallel.push_back(&(*itr));
+            continue;
           }
+
+          HandleMethodCalls(parallel, response, transport, client);
+          parallel.clear();
+          HandleMethodCall(*itr, response, transport, client);
         }
+        HandleMethodCalls(parallel, response, transport, client);
       }
     }
     else
-      hasResponse = HandleMethodCall(inputroot, outputroot, transport, client);
+      HandleMethodCall(inputroot, response, transport, client);
   }
   else
   {
     CLog::Log(LOGERROR, "JSONRPC: Failed to parse '%s'\n", inputString.c_str());
+    CVariant outputroot;
     BuildResponse(inputroot, ParseError, CVariant(), outputroot);
-    hasResponse = true;
+    response.AddResponse(outputroot);
   }
 
-  std::string str = hasResponse ? CJSONVariantWriter::Write(outputroot, g_advancedSettings.m_jsonOutputCompact) : "";
-  return str;
+  return !response.IsEmpty();
+}
+
+bool CJSONRPC::CanStreamResult(const CVariant &result)
+{
+  StreamableResult *streamable = streamableResult.get();
+  return streamable != NULL && streamable->result == &result && streamable->streamed == NULL;
+}
+
+bool CJSONRPC::StreamResult(CVariant &result, const std::string &member, IStreamedResult *streamed)
+{
+  if (!CanStreamResult(result))
+  {
+    delete streamed;
+    return false;
+  }
+
+  StreamableResult *streamable = streamableResult.get();
+  streamable->member = member;
+  streamable->streamed = streamed;
+  result[member] = CVariant(CVariant::VariantTypeArray);
+  return true;
+}
+
+bool CJSONRPC::HandleMethodCall(const CVariant& request, CJSONResponseStream& response, ITransportLayer *transport, IClient *client)
+{
+  CVariant output;
+  IStreamedResult *streamed = NULL;
+  std::string member;
+
+  if (!ExecuteMethodCall(request, transport, client, output, streamed, member))
+    return false;
+
+  response.AddResponse(output, streamed, member);
+  return true;
 }
 
-bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
+bool CJSONRPC::ExecuteMethodCall(const CVariant& request, ITransportLayer *transport, IClient *client, CVariant &output, IStreamedResult *&streamed, std::string &member)
 {
   JSONRPC_STATUS errorCode = OK;
   CVariant result;
   bool isNotification = false;
+  StreamableResult streamable = { &result, "", NULL };
 
   if (IsProperJSONRPC(request))
   {
@@ -290,7 +480,22 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     CVariant params;
 
     if ((errorCode = CJSONServiceDescription::CheckCall(methodName.c_str(), request["params"], transport, client, isNotification, method, params)) == OK)
-      errorCode = method(methodName, transport, client, params, result);
+    {
+      CJSONResponseCache &cache = CJSONResponseCache::Get();
+      CJSONResponseCache::Key key;
+      bool cacheable = !isNotification && CJSONResponseCache::GetKey(methodName, params, key);
+
+      if (!cacheable || !cache.Lookup(key, result, streamable.streamed, streamable.member))
+      {
+        StreamableResult *previous = streamableResult.get();
+        streamableResult.set(isNotification ? NULL : &streamable);
+        errorCode = method(methodName, transport, client, params, result);
+        streamableResult.set(previous);
+
+        if (cacheable && errorCode == OK)
+          cache.Store(key, result, streamable.streamed, streamable.member);
+      }
+    }
     else
       result = params;
   }
@@ -300,9 +505,42 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     errorCode = InvalidRequest;
   }
 
-  BuildResponse(request, errorCode, result, response);
+  if (isNotification || errorCode != OK)
+  {
+    delete streamable.streamed;
+    streamable.streamed = NULL;
+  }
+
+  if (isNotification)
+    return false;
+
+  BuildResponse(request, errorCode, result, output);
+  streamed = streamable.streamed;
+  member = streamable.member;
+
+  return true;
+}
+
+void CJSONRPC::HandleMethodCalls(const std::vector<const CVariant*> &requests, CJSONResponseStream& response, ITransportLayer *transport, IClient *client)
+{
+  if (requests.size() == 1)
+    HandleMethodCall(*requests.front(), response, transport, client);
+  else if (requests.size() > 1)
+  {
+    boost::shared_ptr<CParallelBatch> batch(new CParallelBatch(requests, transport, client));
+    CParallelBatch::Execute(batch, response);
+  }
+}
+
+bool CJSONRPC::IsParallelMethodCall(const CVariant& request)
+{
+  if (!IsProperJSONRPC(request))
+    return false;
+
+  std::string methodName = request["method"].asString();
+  StringUtils::ToLower(methodName);
 
-  return !isNotification;
+  return CJSONServiceDescription::IsParallel(methodName.c_str());
 }
 
 inline bool CJSONRPC::IsProperJSONRPC(const CVariant& inputroot)
@@ -23,8 +23,10 @@
 #include <map>
 #include <stdio.h>
 #include <string>
+#include <vector>
 
 #include "JSONRPCUtils.h"
+#include "JSONResponseStream.h"
 #include "JSONServiceDescription.h"
 #include "interfaces/IAnnouncer.h"
 
@@ -63,6 +65,36 @@ namespace JSONRPC
      */
     static std::string MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client);
 
+    /*
+     \brief Handles an incoming JSON-RPC request without serializing the response
+     \param inputString received JSON-RPC request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \param response Stream to generate the JSON-RPC response with
+     \return True if there is a response to be sent back to the client
+
+     Same as the string variant but leaves writing the response to the
+     transport so that large results can be sent out while they are
+     still being serialized.
+     */
+    static bool MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client, CJSONResponseStream &response);
+
+    /*
+     \brief Whether the given result object of the method currently being
+     executed on this thread can have one of its members streamed
+     */
+    static bool CanStreamResult(const CVariant &result);
+
+    /*
+     \brief Let the given member of the method result be written by the
+     streamed result while the response is generated
+     \param result Result object of the method currently being executed
+     \param member Name of the (array) member in result
+     \param streamed Streamed result, ownership is taken in any case
+     \return False if streaming is not possible (see CanStreamResult)
+     */
+    static bool StreamResult(CVariant &result, const std::string &member, IStreamedResult *streamed);
+
     static JSONRPC_STATUS Introspect(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -72,8 +104,13 @@ namespace JSONRPC
     static JSONRPC_STATUS NotifyAll(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
   
   private:
+    class CParallelBatch;
+
     static void setup();
-    static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
+    static bool HandleMethodCall(const CVariant& request, CJSONResponseStream& response, ITransportLayer *transport, IClient *client);
+    static bool ExecuteMethodCall(const CVariant& request, ITransportLayer *transport, IClient *client, CVariant &output, IStreamedResult *&streamed, std::string &member);
+    static void HandleMethodCalls(const std::vector<const CVariant*> &requests, CJSONResponseStream& response, ITransportLayer *transport, IClient *client);
+    static bool IsParallelMethodCall(const CVariant& request);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
 
     inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
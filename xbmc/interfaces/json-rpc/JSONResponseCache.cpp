@@ -0,0 +1,337 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+
+#include "JSONResponseCache.h"
+#include "JSONServiceDescription.h"
+#include "music/MusicDatabase.h"
+#include "profiles/ProfilesManager.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoDatabase.h"
+
+using namespace ANNOUNCEMENT;
+using namespace JSONRPC;
+
+namespace
+{
+  // rough amount of memory used by the given value
+  size_t EstimateSize(const CVariant &value)
+  {
+    size_t size = sizeof(CVariant);
+
+    if (value.isString())
+      size += value.size();
+    else if (value.isArray())
+    {
+      for (CVariant::const_iterator_array it = value.begin_array(); it != value.end_array(); ++it)
+        size += EstimateSize(*it);
+    }
+    else if (value.isObject())
+    {
+      for (CVariant::const_iterator_map it = value.begin_map(); it != value.end_map(); ++it)
+        size += sizeof(std::string) + it->first.size() + EstimateSize(it->second);
+    }
+
+    return size;
+  }
+}
+
+class CJSONResponseCache::CCachedArrayStream : public IStreamedResult
+{
+public:
+  CCachedArrayStream(const boost::shared_ptr<const CVariant> &result, const std::string &member)
+    : m_result(result),
+      m_array((*result)[member]),
+      m_current(0)
+  { }
+
+  virtual bool WriteNext(CJSONStreamWriter &writer)
+  {
+    if (m_current >= m_array.size())
+      return false;
+
+    return writer.Value(m_array[m_current++]);
+  }
+
+private:
+  boost::shared_ptr<const CVariant> m_result;
+  const CVariant &m_array;
+  unsigned int m_current;
+};
+
+class CJSONResponseCache::CCapturingStream : public IStreamedResult
+{
+public:
+  CCapturingStream(CJSONResponseCache &cache, const Entry &entry, const CVariant &result, IStreamedResult *streamed, size_t budget)
+    : m_cache(cache),
+      m_entry(entry),
+      m_result(result),
+      m_streamed(streamed),
+      m_budget(budget),
+      m_values(CVariant::VariantTypeArray),
+      m_capturing(true)
+  { }
+
+  virtual ~CCapturingStream()
+  {
+    delete m_streamed;
+  }
+
+  virtual bool WriteNext(CJSONStreamWriter &writer)
+  {
+    if (!m_capturing)
+      return m_streamed->WriteNext(writer);
+
+    unsigned int captured = m_values.size();
+    writer.StartCapture(m_values);
+    bool more = m_streamed->WriteNext(writer);
+    m_capturing = writer.EndCapture() && writer.IsGood();
+
+    for (unsigned int i = captured; i < m_values.size() && m_capturing; i++)
+    {
+      m_entry.size += EstimateSize(m_values[i]);
+      m_capturing = m_entry.size <= m_budget;
+    }
+
+    if (!m_capturing)
+      m_values.clear();
+    else if (!more)
+    {
+      // all values have been written, the result is complete
+      CVariant *cached = new CVariant();
+      cached->swap(m_result);
+      (*cached)[m_entry.member].swap(m_values);
+      m_entry.result.reset(cached);
+      m_cache.Insert(m_entry);
+      m_capturing = false;
+    }
+
+    return more;
+  }
+
+private:
+  CJSONResponseCache &m_cache;
+  Entry m_entry;
+  CVariant m_result;
+  IStreamedResult *m_streamed;
+  size_t m_budget;
+  CVariant m_values;
+  bool m_capturing;
+};
+
+CJSONResponseCache::CJSONResponseCache()
+{
+  memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+CJSONResponseCache& CJSONResponseCache::Get()
+{
+  static CJSONResponseCache sResponseCache;
+  return sResponseCache;
+}
+
+bool CJSONResponseCache::GetKey(const std::string &method, const CVariant &params, Key &key)
+{
+  // only methods which don't change anything may be answered from the cache
+  if (g_advancedSettings.m_jsonCacheSize == 0 || !CJSONServiceDescription::IsParallel(method.c_str()))
+    return false;
+
+  if (StringUtils::StartsWith(method, "videolibrary."))
+  {
+    // changes made by other clients of a shared database would go unnoticed
+    if (StringUtils::EqualsNoCase(g_advancedSettings.m_databaseVideo.type, "mysql"))
+      return false;
+
+    key.library = VideoLibrary;
+    key.revision = CVideoDatabase::GetRevision();
+  }
+  else if (StringUtils::StartsWith(method, "audiolibrary."))
+  {
+    if (StringUtils::EqualsNoCase(g_advancedSettings.m_databaseMusic.type, "mysql"))
+      return false;
+
+    key.library = AudioLibrary;
+    key.revision = CMusicDatabase::GetRevision();
+  }
+  else
+    return false;
+
+  // every profile has its own databases
+  key.id = StringUtils::Format("%u:%s:", CProfilesManager::Get().GetCurrentProfileIndex(), method.c_str());
+  key.id += CJSONVariantWriter::Write(params, true);
+  return true;
+}
+
+bool CJSONResponseCache::Lookup(const Key &key, CVariant &result, IStreamedResult *&streamed, std::string &member)
+{
+  CSingleLock lock(m_critSection);
+  EntryMap::iterator it = m_index.find(key.id);
+  if (it == m_index.end() || it->second->revision != key.revision)
+  {
+    if (it != m_index.end() && it->second->revision < key.revision)
+      Remove(it);
+
+    m_statistics.misses++;
+    return false;
+  }
+
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  m_statistics.hits++;
+
+  Entry entry = *it->second;
+  lock.Leave();
+
+  GetResult(entry, result, streamed, member);
+  return true;
+}
+
+void CJSONResponseCache::Store(const Key &key, CVariant &result, IStreamedResult *&streamed, std::string &member)
+{
+  Entry entry;
+  entry.id = key.id;
+  entry.library = key.library;
+  entry.revision = key.revision;
+  entry.size = key.id.size() + EstimateSize(result);
+
+  size_t budget = (size_t)g_advancedSettings.m_jsonCacheSize * 1024;
+  if (entry.size > budget)
+    return;
+
+  // results which are streamed by the method itself are stored once they have been written
+  if (streamed != NULL)
+  {
+    entry.member = member;
+    streamed = new CCapturingStream(*this, entry, result, streamed, budget);
+    return;
+  }
+
+  // the largest array is written from the cached result on every hit
+  unsigned int largest = 0;
+  if (result.isObject())
+  {
+    for (CVariant::const_iterator_map it = result.begin_map(); it != result.end_map(); ++it)
+    {
+      if (it->second.isArray() && it->second.size() > largest)
+      {
+        largest = it->second.size();
+        entry.member = it->first;
+      }
+    }
+  }
+
+  CVariant *cached = new CVariant();
+  cached->swap(result);
+  entry.result.reset(cached);
+
+  Insert(entry);
+  GetResult(entry, result, streamed, member);
+}
+
+void CJSONResponseCache::Insert(const Entry &entry)
+{
+  size_t budget = (size_t)g_advancedSettings.m_jsonCacheSize * 1024;
+
+  CSingleLock lock(m_critSection);
+  EntryMap::iterator it = m_index.find(entry.id);
+  if (it == m_index.end() || it->second->revision < entry.revision)
+  {
+    if (it != m_index.end())
+      Remove(it);
+
+    while (!m_entries.empty() && m_statistics.size + entry.size > budget)
+    {
+      Remove(m_index.find(m_entries.back().id));
+      m_statistics.evictions++;
+    }
+
+    m_entries.push_front(entry);
+    m_index.insert(std::make_pair(entry.id, m_entries.begin()));
+    m_statistics.entries++;
+    m_statistics.size += entry.size;
+  }
+}
+
+void CJSONResponseCache::Invalidate(AnnouncementFlag library)
+{
+  CSingleLock lock(m_critSection);
+  for (EntryMap::iterator it = m_index.begin(); it != m_index.end(); )
+  {
+    if (it->second->library == library)
+      Remove(it++);
+    else
+      ++it;
+  }
+}
+
+void CJSONResponseCache::Clear()
+{
+  CSingleLock lock(m_critSection);
+  m_index.clear();
+  m_entries.clear();
+  m_statistics.entries = 0;
+  m_statistics.size = 0;
+}
+
+CJSONResponseCache::Statistics CJSONResponseCache::GetStatistics() const
+{
+  CSingleLock lock(m_critSection);
+  return m_statistics;
+}
+
+void CJSONResponseCache::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+{
+  if (flag != VideoLibrary && flag != AudioLibrary)
+    return;
+
+  if (strcmp(message, "OnUpdate") == 0 || strcmp(message, "OnRemove") == 0 ||
+      strcmp(message, "OnScanFinished") == 0 || strcmp(message, "OnCleanFinished") == 0)
+    Invalidate(flag);
+}
+
+void CJSONResponseCache::GetResult(const Entry &entry, CVariant &result, IStreamedResult *&streamed, std::string &member)
+{
+  const CVariant &cached = *entry.result;
+  if (entry.member.empty())
+  {
+    result = cached;
+    return;
+  }
+
+  CVariant head(CVariant::VariantTypeObject);
+  for (CVariant::const_iterator_map it = cached.begin_map(); it != cached.end_map(); ++it)
+    head[it->first] = it->first == entry.member ? CVariant(CVariant::VariantTypeArray) : it->second;
+  result.swap(head);
+
+  streamed = new CCachedArrayStream(entry.result, entry.member);
+  member = entry.member;
+}
+
+void CJSONResponseCache::Remove(EntryMap::iterator entry)
+{
+  m_statistics.entries--;
+  m_statistics.size -= entry->second->size;
+  m_entries.erase(entry->second);
+  m_index.erase(entry);
+}
@@ -0,0 +1,148 @@
+#pragma once
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <list>
+#include <map>
+#include <string>
+#include <boost/shared_ptr.hpp>
+
+#include "JSONResponseStream.h"
+#include "interfaces/IAnnouncer.h"
+#include "threads/CriticalSection.h"
+
+class CVariant;
+
+namespace JSONRPC
+{
+  /*!
+   \ingroup jsonrpc
+   \brief Cache for the results of read-only library methods
+
+   Results are stored under the method name and its normalized parameters
+   together with the revision of the library's database at the time the
+   method was called. As soon as the database has been written to the
+   revision no longer matches and the result is computed again. Library
+   updates announced through the CAnnouncementManager drop the results of
+   that library right away. The memory used by the results is limited by
+   the "cachesize" advanced setting of the jsonrpc section, the least
+   recently used results are dropped first.
+
+   Cached results are shared between responses. The largest array of a
+   cached result is written by an IStreamedResult so a hit never has to
+   copy more than the few remaining members.
+
+   Results a method streams itself are still streamed on a miss. Their
+   values are captured while the response is written and the result is
+   only stored once all of them have been written without exceeding the
+   budget.
+   */
+  class CJSONResponseCache : public ANNOUNCEMENT::IAnnouncer
+  {
+  public:
+    typedef struct
+    {
+      std::string id;
+      ANNOUNCEMENT::AnnouncementFlag library;
+      long revision;
+    } Key;
+
+    typedef struct
+    {
+      unsigned int hits;
+      unsigned int misses;
+      unsigned int evictions;
+      unsigned int entries;
+      size_t size;
+    } Statistics;
+
+    static CJSONResponseCache& Get();
+
+    /*!
+     \brief Get the cache key for a call of the given method
+     \param method Name of the method in lower case
+     \param params Checked (and therefore normalized) parameters of the call
+     \param key Key of the result
+     \return False if results of the method are not cached
+     */
+    static bool GetKey(const std::string &method, const CVariant &params, Key &key);
+
+    /*!
+     \brief Get the cached result for the given key
+     \param key Key of the result
+     \param result Result without the streamed member
+     \param streamed Streamed result (may be NULL), owned by the caller afterwards
+     \param member Member of result which is filled by streamed
+     \return False if there is no valid result for the key
+     */
+    bool Lookup(const Key &key, CVariant &result, IStreamedResult *&streamed, std::string &member);
+
+    /*!
+     \brief Store the result of a method call
+     \param key Key of the result as retrieved before the call
+     \param result Result of the call, replaced as by Lookup() if stored
+     \param streamed Streamed result (may be NULL), owned by the caller afterwards.
+     If set it's replaced by one capturing its values to store the result once written.
+     \param member Member of result which is filled by streamed
+     */
+    void Store(const Key &key, CVariant &result, IStreamedResult *&streamed, std::string &member);
+
+    /*!
+     \brief Drop all cached results of the given library
+     */
+    void Invalidate(ANNOUNCEMENT::AnnouncementFlag library);
+    void Clear();
+
+    Statistics GetStatistics() const;
+
+    virtual void Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data);
+
+  private:
+    CJSONResponseCache();
+    CJSONResponseCache(const CJSONResponseCache&);
+    CJSONResponseCache const& operator=(CJSONResponseCache const&);
+    virtual ~CJSONResponseCache() { }
+
+    class CCachedArrayStream;
+    class CCapturingStream;
+
+    typedef struct
+    {
+      std::string id;
+      ANNOUNCEMENT::AnnouncementFlag library;
+      long revision;
+      boost::shared_ptr<const CVariant> result;
+      std::string member;
+      size_t size;
+    } Entry;
+
+    typedef std::list<Entry> EntryList;
+    typedef std::map<std::string, EntryList::iterator> EntryMap;
+
+    static void GetResult(const Entry &entry, CVariant &result, IStreamedResult *&streamed, std::string &member);
+    void Insert(const Entry &entry);
+    void Remove(EntryMap::iterator entry);
+
+    mutable CCriticalSection m_critSection;
+    EntryList m_entries; // most recently used first
+    EntryMap m_index;
+    Statistics m_statistics;
+  };
+}
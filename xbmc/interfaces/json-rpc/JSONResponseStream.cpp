@@ -0,0 +1,252 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <string.h>
+
+#include "JSONResponseStream.h"
+#include "utils/log.h"
+
+using namespace JSONRPC;
+
+bool CJSONResponseStream::CBufferSink::Write(const char *data, size_t length)
+{
+  // drop what has already been read before the buffer grows any further
+  if (m_position > 0 && m_position >= m_buffer.size() / 2)
+  {
+    m_buffer.erase(0, m_position);
+    m_position = 0;
+  }
+
+  m_buffer.append(data, length);
+  return true;
+}
+
+size_t CJSONResponseStream::CBufferSink::Read(char *buffer, size_t size)
+{
+  size_t length = std::min(size, Size());
+  memcpy(buffer, Data(), length);
+  m_position += length;
+
+  if (m_position >= m_buffer.size())
+    Clear();
+
+  return length;
+}
+
+CJSONResponseStream::CJSONResponseStream(bool compact, size_t chunkSize /* = CJSONStreamWriter::DefaultChunkSize */)
+  : m_batch(false),
+    m_chunkSize(chunkSize),
+    m_state(StateStart),
+    m_current(0),
+    m_failed(false),
+    m_writer(m_buffer, compact, chunkSize)
+{ }
+
+CJSONResponseStream::~CJSONResponseStream()
+{
+  for (std::vector<Response*>::iterator it = m_responses.begin(); it != m_responses.end(); ++it)
+  {
+    delete (*it)->streamed;
+    delete *it;
+  }
+}
+
+void CJSONResponseStream::AddResponse(CVariant &response, IStreamedResult *streamed /* = NULL */, const std::string &member /* = "" */)
+{
+  Response *entry = new Response();
+  entry->response.swap(response);
+  entry->streamed = streamed;
+  entry->member = member;
+
+  // the streamed values take the place of an (empty) array member of the result
+  const CVariant &output = entry->response;
+  if (streamed != NULL &&
+     (!output.isMember("result") || !output["result"].isObject() || !output["result"].isMember(member)))
+  {
+    delete streamed;
+    entry->streamed = NULL;
+  }
+
+  m_responses.push_back(entry);
+}
+
+bool CJSONResponseStream::Write(IJSONStreamSink &sink)
+{
+  while (Generate())
+  {
+    if (m_buffer.Size() >= m_chunkSize)
+    {
+      if (!sink.Write(m_buffer.Data(), m_buffer.Size()))
+        return false;
+      m_buffer.Clear();
+    }
+  }
+
+  if (m_buffer.Size() > 0 && !sink.Write(m_buffer.Data(), m_buffer.Size()))
+    return false;
+  m_buffer.Clear();
+
+  return !m_failed;
+}
+
+size_t CJSONResponseStream::Read(char *buffer, size_t size)
+{
+  while (m_buffer.Size() < size && Generate())
+    ;
+
+  return m_buffer.Read(buffer, size);
+}
+
+bool CJSONResponseStream::Generate()
+{
+  bool success = true;
+  Response *response = m_current < m_responses.size() ? m_responses[m_current] : NULL;
+
+  switch (m_state)
+  {
+    case StateStart:
+      success = !m_batch || m_writer.StartArray();
+      m_state = StateResponse;
+      break;
+
+    case StateResponse:
+      if (response == NULL)
+        m_state = StateEnd;
+      else if (response->streamed == NULL)
+      {
+        success = m_writer.Value(response->response);
+        response->response.clear();
+        m_current++;
+      }
+      else
+      {
+        success = WriteHead(*response);
+        m_state = StateStreamed;
+      }
+      break;
+
+    case StateStreamed:
+      if (!response->streamed->WriteNext(m_writer))
+      {
+        success = WriteTail(*response);
+        delete response->streamed;
+        response->streamed = NULL;
+        response->response.clear();
+        m_current++;
+        m_state = StateResponse;
+      }
+      success &= m_writer.IsGood();
+      break;
+
+    case StateEnd:
+      success = !m_batch || m_writer.EndArray();
+      m_state = StateDone;
+      break;
+
+    case StateDone:
+    default:
+      return false;
+  }
+
+  if (success)
+    success = m_writer.Flush();
+
+  if (!success)
+  {
+    CLog::Log(LOGERROR, "JSONRPC: Failed to write response");
+    m_failed = true;
+    m_state = StateDone;
+  }
+
+  return success;
+}
+
+bool CJSONResponseStream::WriteHead(const Response &response)
+{
+  if (!m_writer.StartObject())
+    return false;
+
+  for (CVariant::const_iterator_map it = response.response.begin_map(); it != response.response.end_map(); ++it)
+  {
+    if (!m_writer.Key(it->first))
+      return false;
+
+    if (it->first != "result")
+    {
+      if (!m_writer.Value(it->second))
+        return false;
+      continue;
+    }
+
+    if (!m_writer.StartObject())
+      return false;
+
+    for (CVariant::const_iterator_map member = it->second.begin_map(); member != it->second.end_map(); ++member)
+    {
+      if (!m_writer.Key(member->first))
+        return false;
+      if (member->first == response.member)
+        return m_writer.StartArray();
+      if (!m_writer.Value(member->second))
+        return false;
+    }
+  }
+
+  return false;
+}
+
+bool CJSONResponseStream::WriteTail(const Response &response)
+{
+  if (!m_writer.EndArray())
+    return false;
+
+  bool afterResult = false;
+  for (CVariant::const_iterator_map it = response.response.begin_map(); it != response.response.end_map(); ++it)
+  {
+    if (afterResult)
+    {
+      if (!m_writer.Key(it->first) || !m_writer.Value(it->second))
+        return false;
+      continue;
+    }
+
+    if (it->first != "result")
+      continue;
+
+    bool afterMember = false;
+    for (CVariant::const_iterator_map member = it->second.begin_map(); member != it->second.end_map(); ++member)
+    {
+      if (afterMember)
+      {
+        if (!m_writer.Key(member->first) || !m_writer.Value(member->second))
+          return false;
+      }
+      else if (member->first == response.member)
+        afterMember = true;
+    }
+
+    if (!m_writer.EndObject())
+      return false;
+    afterResult = true;
+  }
+
+  return m_writer.EndObject();
+}
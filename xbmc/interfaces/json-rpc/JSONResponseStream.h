@@ -0,0 +1,135 @@
+#pragma once
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "utils/JSONStreamWriter.h"
+#include "utils/Variant.h"
+
+namespace JSONRPC
+{
+  /*!
+   \ingroup jsonrpc
+   \brief Array member of a method result whose values are only
+   produced while the response is being written.
+   */
+  class IStreamedResult
+  {
+  public:
+    virtual ~IStreamedResult() { }
+
+    /*!
+     \brief Write the next value of the array
+     \return false once all values have been written
+     */
+    virtual bool WriteNext(CJSONStreamWriter &writer) = 0;
+  };
+
+  /*!
+   \ingroup jsonrpc
+   \brief Incrementally generated JSON-RPC response
+
+   Holds the responses of a (batch) call together with their streamed
+   results and generates the JSON output piece by piece, either pushed
+   into a sink or pulled chunk by chunk by the transport.
+   */
+  class CJSONResponseStream
+  {
+  public:
+    CJSONResponseStream(bool compact, size_t chunkSize = CJSONStreamWriter::DefaultChunkSize);
+    ~CJSONResponseStream();
+
+    void SetBatch(bool batch) { m_batch = batch; }
+
+    /*!
+     \brief Add the response of a single method call
+     \param response Response object, its content is taken over
+     \param streamed Optional streamed result, owned by the stream afterwards
+     \param member Member of response["result"] which is filled by streamed
+     */
+    void AddResponse(CVariant &response, IStreamedResult *streamed = NULL, const std::string &member = "");
+    bool IsEmpty() const { return m_responses.empty(); }
+
+    /*!
+     \brief Write the whole response to the given sink
+     \return false if generating or writing the response failed
+     */
+    bool Write(IJSONStreamSink &sink);
+
+    /*!
+     \brief Generate the next part of the response
+     \param buffer Buffer to copy the output to
+     \param size Maximum number of bytes to copy
+     \return Number of bytes copied, 0 once the response is complete
+     */
+    size_t Read(char *buffer, size_t size);
+
+  private:
+    CJSONResponseStream(const CJSONResponseStream&);
+    CJSONResponseStream const& operator=(CJSONResponseStream const&);
+
+    typedef struct
+    {
+      CVariant response;
+      IStreamedResult *streamed;
+      std::string member;
+    } Response;
+
+    class CBufferSink : public IJSONStreamSink
+    {
+    public:
+      CBufferSink() : m_position(0) { }
+
+      virtual bool Write(const char *data, size_t length);
+      const char* Data() const { return m_buffer.c_str() + m_position; }
+      size_t Size() const { return m_buffer.size() - m_position; }
+      size_t Read(char *buffer, size_t size);
+      void Clear() { m_buffer.clear(); m_position = 0; }
+
+    private:
+      std::string m_buffer;
+      size_t m_position;
+    };
+
+    bool Generate();
+    bool WriteHead(const Response &response);
+    bool WriteTail(const Response &response);
+
+    enum State
+    {
+      StateStart,
+      StateResponse,
+      StateStreamed,
+      StateEnd,
+      StateDone
+    };
+
+    std::vector<Response*> m_responses;
+    bool m_batch;
+    size_t m_chunkSize;
+    State m_state;
+    size_t m_current;
+    bool m_failed;
+    CBufferSink m_buffer;
+    CJSONStreamWriter m_writer;
+  };
+}
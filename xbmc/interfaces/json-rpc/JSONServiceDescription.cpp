@@ -18,6 +18,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "ServiceDescription.h"
 #include "JSONServiceDescription.h"
 #include "utils/log.h"
@@ -48,6 +50,15 @@ map<string, CVariant> CJSONServiceDescription::m_notifications = map<string, CVa
 CJSONServiceDescription::CJsonRpcMethodMap CJSONServiceDescription::m_actionMap;
 map<string, JSONSchemaTypeDefinitionPtr> CJSONServiceDescription::m_types = map<string, JSONSchemaTypeDefinitionPtr>();
 CJSONServiceDescription::IncompleteSchemaDefinitionMap CJSONServiceDescription::m_incompleteDefinitions = CJSONServiceDescription::IncompleteSchemaDefinitionMap();
+bool CJSONServiceDescription::m_compiled = false;
+
+namespace
+{
+  bool PropertyNameLess(const JSONSchemaTypeDefinition *lhs, const JSONSchemaTypeDefinition *rhs)
+  {
+    return lhs->name < rhs->name;
+  }
+}
 
 JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
 // JSON-RPC
@@ -230,7 +241,9 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
 
 // XBMC operations
   { "XBMC.GetInfoLabels",                           CXBMCOperations::GetInfoLabels },
-  { "XBMC.GetInfoBooleans",                         CXBMCOperations::GetInfoBooleans }
+  { "XBMC.GetInfoBooleans",                         CXBMCOperations::GetInfoBooleans },
+  { "XBMC.GetJobStatistics",                        CXBMCOperations::GetJobStatistics },
+  { "XBMC.GetQueryStatistics",                      CXBMCOperations::GetQueryStatistics }
 };
 
 JSONSchemaTypeDefinition::JSONSchemaTypeDefinition()
@@ -239,7 +252,7 @@ JSONSchemaTypeDefinition::JSONSchemaTypeDefinition()
     exclusiveMinimum(false), exclusiveMaximum(false), divisibleBy(0),
     minLength(-1), maxLength(-1),
     minItems(0), maxItems(0), uniqueItems(false),
-    hasAdditionalProperties(false)
+    hasAdditionalProperties(false), compiled(false)
 { }
 
 bool JSONSchemaTypeDefinition::Parse(const CVariant &value, bool isParameter /* = false */)
@@ -617,14 +630,80 @@ bool JSONSchemaTypeDefinition::Parse(const CVariant &value, bool isParameter /*
 
 JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &outputValue, CVariant &errorData)
 {
-  if (!name.empty())
-    errorData["name"] = name;
-  SchemaValueTypeToJson(type, errorData["type"]);
-  std::string errorMessage;
-
-  if (referencedType != NULL && !referencedTypeSet)
+  if (!compiled && referencedType != NULL && !referencedTypeSet)
     Set(referencedType);
 
+  JSONRPC_STATUS status = checkValue(value, outputValue, errorData);
+  if (status != OK)
+  {
+    // a failing extended type has already described itself
+    if (!name.empty() && !errorData.isMember("name"))
+      errorData["name"] = name;
+    if (!errorData.isMember("type"))
+      SchemaValueTypeToJson(type, errorData["type"]);
+  }
+
+  return status;
+}
+
+void JSONSchemaTypeDefinition::Compile()
+{
+  if (compiled)
+    return;
+
+  resolveReference();
+  // set before compiling the nested types as those may refer back to this one
+  compiled = true;
+
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = extends.begin(); it != extends.end(); ++it)
+    (*it)->Compile();
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = unionTypes.begin(); it != unionTypes.end(); ++it)
+    (*it)->Compile();
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = items.begin(); it != items.end(); ++it)
+    (*it)->Compile();
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = additionalItems.begin(); it != additionalItems.end(); ++it)
+    (*it)->Compile();
+  if (additionalProperties != NULL)
+    additionalProperties->Compile();
+
+  sortedProperties.clear();
+  sortedProperties.reserve(properties.size());
+  for (CJsonSchemaPropertiesMap::JSONSchemaPropertiesIterator it = properties.begin(); it != properties.end(); ++it)
+  {
+    it->second->Compile();
+    sortedProperties.push_back(it->second.get());
+  }
+  std::sort(sortedProperties.begin(), sortedProperties.end(), PropertyNameLess);
+
+  sortedEnums.clear();
+  for (std::vector<CVariant>::const_iterator enumItr = enums.begin(); enumItr != enums.end(); ++enumItr)
+  {
+    if (!enumItr->isString())
+    {
+      sortedEnums.clear();
+      break;
+    }
+    sortedEnums.push_back(enumItr->asString());
+  }
+  std::sort(sortedEnums.begin(), sortedEnums.end());
+}
+
+void JSONSchemaTypeDefinition::resolveReference()
+{
+  if (referencedType == NULL || referencedTypeSet)
+    return;
+
+  // the referenced type may itself be based on another type
+  if (referencedType.get() != this)
+    referencedType->resolveReference();
+
+  Set(referencedType);
+}
+
+JSONRPC_STATUS JSONSchemaTypeDefinition::checkValue(const CVariant &value, CVariant &outputValue, CVariant &errorData)
+{
+  std::string errorMessage;
+
   // Let's check the type of the provided parameter
   if (!IsType(value, type))
   {
@@ -704,16 +783,18 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
       outputValue = value;
     else if (items.size() == 1)
     {
-      JSONSchemaTypeDefinitionPtr itemType = items.at(0);
+      const JSONSchemaTypeDefinitionPtr &itemType = items.at(0);
 
       // Loop through all array elements
+      outputValue.reserve(value.size());
       for (unsigned int arrayIndex = 0; arrayIndex < value.size(); arrayIndex++)
       {
-        CVariant temp;
-        JSONRPC_STATUS status = itemType->Check(value[arrayIndex], temp, errorData["property"]);
-        outputValue.push_back(temp);
+        outputValue.push_back(CVariant());
+        CVariant propertyError;
+        JSONRPC_STATUS status = itemType->Check(value[arrayIndex], outputValue[arrayIndex], propertyError);
         if (status != OK)
         {
+          errorData["property"].swap(propertyError);
           CLog::Log(LOGDEBUG, "JSONRPC: Array element at index %u does not match in type %s", arrayIndex, name.c_str());
           errorMessage = StringUtils::Format("array element at index %u does not match", arrayIndex);
           errorData["message"] = errorMessage.c_str();
@@ -746,9 +827,11 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
       unsigned int arrayIndex;
       for (arrayIndex = 0; arrayIndex < min(items.size(), (size_t)value.size()); arrayIndex++)
       {
-        JSONRPC_STATUS status = items.at(arrayIndex)->Check(value[arrayIndex], outputValue[arrayIndex], errorData["property"]);
+        CVariant propertyError;
+        JSONRPC_STATUS status = items.at(arrayIndex)->Check(value[arrayIndex], outputValue[arrayIndex], propertyError);
         if (status != OK)
         {
+          errorData["property"].swap(propertyError);
           CLog::Log(LOGDEBUG, "JSONRPC: Array element at index %u does not match with items schema in type %s", arrayIndex, name.c_str());
           return status;
         }
@@ -809,6 +892,9 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
   // against the defined "properties"
   if (HasType(type, ObjectValue) && value.isObject())
   {
+    if (compiled)
+      return checkProperties(value, outputValue, errorData);
+
     unsigned int handled = 0;
     JSONSchemaTypeDefinition::CJsonSchemaPropertiesMap::JSONSchemaPropertiesIterator propertiesEnd = properties.end();
     JSONSchemaTypeDefinition::CJsonSchemaPropertiesMap::JSONSchemaPropertiesIterator propertiesIterator;
@@ -816,9 +902,11 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
     {
       if (value.isMember(propertiesIterator->second->name))
       {
-        JSONRPC_STATUS status = propertiesIterator->second->Check(value[propertiesIterator->second->name], outputValue[propertiesIterator->second->name], errorData["property"]);
+        CVariant propertyError;
+        JSONRPC_STATUS status = propertiesIterator->second->Check(value[propertiesIterator->second->name], outputValue[propertiesIterator->second->name], propertyError);
         if (status != OK)
         {
+          errorData["property"].swap(propertyError);
           CLog::Log(LOGDEBUG, "JSONRPC: Invalid property \"%s\" in type %s", propertiesIterator->second->name.c_str(), name.c_str());
           return status;
         }
@@ -858,9 +946,11 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
             continue;
           }
 
-          JSONRPC_STATUS status = additionalProperties->Check(value[iter->first], outputValue[iter->first], errorData["property"]);
+          CVariant propertyError;
+          JSONRPC_STATUS status = additionalProperties->Check(value[iter->first], outputValue[iter->first], propertyError);
           if (status != OK)
           {
+            errorData["property"].swap(propertyError);
             CLog::Log(LOGDEBUG, "JSONRPC: Invalid additional property \"%s\" in type %s", iter->first.c_str(), name.c_str());
             return status;
           }
@@ -886,12 +976,17 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
   if (enums.size() > 0)
   {
     bool valid = false;
-    for (std::vector<CVariant>::const_iterator enumItr = enums.begin(); enumItr != enums.end(); ++enumItr)
+    if (!sortedEnums.empty())
+      valid = value.isString() && std::binary_search(sortedEnums.begin(), sortedEnums.end(), value.asString());
+    else
     {
-      if (*enumItr == value)
+      for (std::vector<CVariant>::const_iterator enumItr = enums.begin(); enumItr != enums.end(); ++enumItr)
       {
-        valid = true;
-        break;
+        if (*enumItr == value)
+        {
+          valid = true;
+          break;
+        }
       }
     }
 
@@ -963,6 +1058,86 @@ JSONRPC_STATUS JSONSchemaTypeDefinition::Check(const CVariant &value, CVariant &
   return OK;
 }
 
+JSONRPC_STATUS JSONSchemaTypeDefinition::checkProperties(const CVariant &value, CVariant &outputValue, CVariant &errorData)
+{
+  // The members of an object are sorted by their name just like
+  // sortedProperties so both can be matched up in a single pass
+  unsigned int handled = 0;
+  CVariant::const_iterator_map member = value.begin_map();
+  CVariant::const_iterator_map membersEnd = value.end_map();
+  for (std::vector<JSONSchemaTypeDefinition*>::const_iterator property = sortedProperties.begin(); property != sortedProperties.end(); ++property)
+  {
+    const std::string &propertyName = (*property)->name;
+    while (member != membersEnd && member->first < propertyName)
+      ++member;
+
+    if (member != membersEnd && member->first == propertyName)
+    {
+      CVariant propertyError;
+      JSONRPC_STATUS status = (*property)->Check(member->second, outputValue[propertyName], propertyError);
+      if (status != OK)
+      {
+        errorData["property"].swap(propertyError);
+        CLog::Log(LOGDEBUG, "JSONRPC: Invalid property \"%s\" in type %s", propertyName.c_str(), name.c_str());
+        return status;
+      }
+      handled++;
+      ++member;
+    }
+    else if ((*property)->optional)
+      outputValue[propertyName] = (*property)->defaultValue;
+    else
+    {
+      errorData["property"]["name"] = propertyName.c_str();
+      errorData["property"]["type"] = SchemaValueTypeToString((*property)->type);
+      errorData["message"] = "Missing property";
+      return InvalidParams;
+    }
+  }
+
+  if (handled >= value.size())
+    return OK;
+
+  // If we still have unchecked properties but additional
+  // properties are not allowed, we have invalid parameters
+  if (!hasAdditionalProperties || additionalProperties == NULL)
+  {
+    errorData["message"] = "Unexpected additional properties received";
+    errorData.erase("property");
+    return InvalidParams;
+  }
+
+  // Check the members which didn't match any of the properties
+  std::vector<JSONSchemaTypeDefinition*>::const_iterator property = sortedProperties.begin();
+  for (member = value.begin_map(); member != membersEnd; ++member)
+  {
+    while (property != sortedProperties.end() && (*property)->name < member->first)
+      ++property;
+    if (property != sortedProperties.end() && (*property)->name == member->first)
+      continue;
+
+    // If the additional property is of type "any"
+    // we can simply copy its value to the output
+    // object
+    if (additionalProperties->type == AnyValue)
+    {
+      outputValue[member->first] = member->second;
+      continue;
+    }
+
+    CVariant propertyError;
+    JSONRPC_STATUS status = additionalProperties->Check(member->second, outputValue[member->first], propertyError);
+    if (status != OK)
+    {
+      errorData["property"].swap(propertyError);
+      CLog::Log(LOGDEBUG, "JSONRPC: Invalid additional property \"%s\" in type %s", member->first.c_str(), name.c_str());
+      return status;
+    }
+  }
+
+  return OK;
+}
+
 void JSONSchemaTypeDefinition::Print(bool isParameter, bool isGlobal, bool printDefault, bool printDescriptions, CVariant &output) const
 {
   bool typeReference = false;
@@ -1152,6 +1327,11 @@ void JSONSchemaTypeDefinition::Set(const JSONSchemaTypeDefinitionPtr typeDefinit
     referencedType = referencedTypeDef;
 
   referencedTypeSet = true;
+
+  // the lookup tables are set up by Compile() for every type on its own
+  compiled = false;
+  sortedProperties.clear();
+  sortedEnums.clear();
 }
 
 JSONSchemaTypeDefinition::CJsonSchemaPropertiesMap::CJsonSchemaPropertiesMap()
@@ -1187,7 +1367,7 @@ unsigned int JSONSchemaTypeDefinition::CJsonSchemaPropertiesMap::size() const
 }
 
 JsonRpcMethod::JsonRpcMethod()
-  : missingReference(""), method(NULL),
+  : missingReference(""), method(NULL), parallel(false),
     returns(new JSONSchemaTypeDefinition())
 { }
 
@@ -1216,6 +1396,8 @@ bool JsonRpcMethod::Parse(const CVariant &value)
   else
     permission = StringToPermission(value.isMember("permission") ? value["permission"].asString() : "");
 
+  parallel = value.isMember("parallel") && value["parallel"].isBoolean() && value["parallel"].asBoolean();
+
   description = GetString(value["description"], "");
 
   // Check whether there are parameters defined
@@ -1270,8 +1452,8 @@ JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITranspor
       // Count the number of actually handled (present)
       // parameters
       unsigned int handled = 0;
-      CVariant errorData = CVariant(CVariant::VariantTypeObject);
-      errorData["method"] = name;
+      // only filled in (and turned into an object) on errors
+      CVariant errorData;
 
       // Loop through all the parameters to check
       for (unsigned int i = 0; i < parameters.size(); i++)
@@ -1281,6 +1463,7 @@ JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITranspor
         if (status != OK)
         {
           // Return the error data object in the outputParameters reference
+          errorData["method"] = name;
           outputParameters = errorData;
           return status;
         }
@@ -1289,6 +1472,7 @@ JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITranspor
       // Check if there were unnecessary parameters
       if (handled < requestParameters.size())
       {
+        errorData["method"] = name;
         errorData["message"] = "Too many parameters";
         outputParameters = errorData;
         return InvalidParams;
@@ -1303,6 +1487,14 @@ JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITranspor
   return MethodNotFound;
 }
 
+void JsonRpcMethod::Compile()
+{
+  for (std::vector<JSONSchemaTypeDefinitionPtr>::iterator it = parameters.begin(); it != parameters.end(); ++it)
+    (*it)->Compile();
+  if (returns != NULL)
+    returns->Compile();
+}
+
 bool JsonRpcMethod::parseParameter(const CVariant &value, JSONSchemaTypeDefinitionPtr parameter)
 {
   parameter->name = GetString(value["name"], "");
@@ -1334,18 +1526,22 @@ bool JsonRpcMethod::parseReturn(const CVariant &value)
   return true;
 }
 
-JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters, JSONSchemaTypeDefinitionPtr type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant &errorData)
+JSONRPC_STATUS JsonRpcMethod::checkParameter(const CVariant &requestParameters, const JSONSchemaTypeDefinitionPtr &type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant &errorData)
 {
   // Let's check if the parameter has been provided
   if (ParameterExists(requestParameters, type->name, position))
   {
     // Get the parameter
-    CVariant parameterValue = GetParameter(requestParameters, type->name, position);
+    const CVariant &parameterValue = IsValueMember(requestParameters, type->name) ? requestParameters[type->name] : requestParameters[position];
 
     // Evaluate the type of the parameter
-    JSONRPC_STATUS status = type->Check(parameterValue, outputParameters[type->name], errorData["stack"]);
+    CVariant parameterError;
+    JSONRPC_STATUS status = type->Check(parameterValue, outputParameters[type->name], parameterError);
     if (status != OK)
+    {
+      errorData["stack"].swap(parameterError);
       return status;
+    }
 
     // The parameter was present and valid
     handled++;
@@ -1373,6 +1569,7 @@ void CJSONServiceDescription::Cleanup()
   m_actionMap.clear();
   m_types.clear();
   m_incompleteDefinitions.clear();
+  m_compiled = false;
 }
 
 bool CJSONServiceDescription::prepareDescription(std::string &description, CVariant &descriptionObject, std::string &name)
@@ -1482,6 +1679,9 @@ bool CJSONServiceDescription::addMethod(const std::string &jsonMethod, MethodCal
     return false;
   }
 
+  if (m_compiled)
+    newMethod.Compile();
+
   m_actionMap.add(newMethod);
 
   return true;
@@ -1536,6 +1736,9 @@ bool CJSONServiceDescription::AddType(const std::string &jsonType)
     return false;
   }
 
+  if (m_compiled)
+    globalType->Compile();
+
   return true;
 }
 
@@ -1826,6 +2029,9 @@ JSONRPC_STATUS CJSONServiceDescription::Print(CVariant &result, ITransportLayer
         currentMethod["permission"] = permissions[0];
       else
         currentMethod["permission"] = permissions;
+
+      if (methodIterator->second.parallel)
+        currentMethod["parallel"] = true;
     }
 
     currentMethod["params"] = CVariant(CVariant::VariantTypeArray);
@@ -1859,6 +2065,24 @@ JSONRPC_STATUS CJSONServiceDescription::CheckCall(const char* const method, cons
   return MethodNotFound;
 }
 
+void CJSONServiceDescription::Compile()
+{
+  for (std::map<std::string, JSONSchemaTypeDefinitionPtr>::iterator it = m_types.begin(); it != m_types.end(); ++it)
+    it->second->Compile();
+
+  m_actionMap.compile();
+  m_compiled = true;
+}
+
+bool CJSONServiceDescription::IsParallel(const char* const method)
+{
+  if (!m_compiled)
+    return false;
+
+  CJsonRpcMethodMap::JsonRpcMethodIterator iter = m_actionMap.find(method);
+  return iter != m_actionMap.end() && iter->second.parallel;
+}
+
 JSONSchemaTypeDefinitionPtr CJSONServiceDescription::GetType(const std::string &identification)
 {
   std::map<std::string, JSONSchemaTypeDefinitionPtr>::iterator iter = m_types.find(identification);
@@ -2008,6 +2232,12 @@ CJSONServiceDescription::CJsonRpcMethodMap::CJsonRpcMethodMap()
   m_actionmap = std::map<std::string, JsonRpcMethod>();
 }
 
+void CJSONServiceDescription::CJsonRpcMethodMap::compile()
+{
+  for (std::map<std::string, JsonRpcMethod>::iterator it = m_actionmap.begin(); it != m_actionmap.end(); ++it)
+    it->second.Compile();
+}
+
 void CJSONServiceDescription::CJsonRpcMethodMap::clear()
 {
   m_actionmap.clear();
@@ -50,6 +50,15 @@ namespace JSONRPC
     JSONRPC_STATUS Check(const CVariant &value, CVariant &outputValue, CVariant &errorData);
     void Print(bool isParameter, bool isGlobal, bool printDefault, bool printDescriptions, CVariant &output) const;
     void Set(const JSONSchemaTypeDefinitionPtr typeDefinition);
+
+    /*!
+     \brief Resolves the referenced type of this and all nested
+     type definitions and prepares the lookup tables used by Check()
+
+     A compiled type definition is never modified by Check() so it can
+     be used to validate several requests concurrently.
+     */
+    void Compile();
     
     std::string missingReference;
 
@@ -221,6 +230,29 @@ namespace JSONRPC
      \brief Type definition for additional properties
      */
     JSONSchemaTypeDefinitionPtr additionalProperties;
+
+    /*!
+     \brief Whether Compile() has been run on the type
+     */
+    bool compiled;
+
+    /*!
+     \brief Properties sorted by their name (as set up by Compile())
+     so that they can be matched against the (sorted) members of an
+     object in a single pass
+     */
+    std::vector<JSONSchemaTypeDefinition*> sortedProperties;
+
+    /*!
+     \brief Sorted copy of "enum" if all of its values are strings
+     (as set up by Compile())
+     */
+    std::vector<std::string> sortedEnums;
+
+  private:
+    void resolveReference();
+    JSONRPC_STATUS checkValue(const CVariant &value, CVariant &outputValue, CVariant &errorData);
+    JSONRPC_STATUS checkProperties(const CVariant &value, CVariant &outputValue, CVariant &errorData);
   };
 
   /*! 
@@ -239,6 +271,7 @@ namespace JSONRPC
   
     bool Parse(const CVariant &value);
     JSONRPC_STATUS Check(const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters) const;
+    void Compile();
     
     std::string missingReference;    
     
@@ -261,6 +294,12 @@ namespace JSONRPC
      to execute the method
      */
     OperationPermission permission;
+    /*!
+     \brief Whether the method may be executed
+     concurrently with other such methods of the
+     same batch request
+     */
+    bool parallel;
     /*!
      \brief Description of the method
      */
@@ -277,7 +316,7 @@ namespace JSONRPC
   private:
     bool parseParameter(const CVariant &value, JSONSchemaTypeDefinitionPtr parameter);
     bool parseReturn(const CVariant &value);
-    static JSONRPC_STATUS checkParameter(const CVariant &requestParameters, JSONSchemaTypeDefinitionPtr type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant &errorData);
+    static JSONRPC_STATUS checkParameter(const CVariant &requestParameters, const JSONSchemaTypeDefinitionPtr &type, unsigned int position, CVariant &outputParameters, unsigned int &handled, CVariant &errorData);
   };
 
   /*! 
@@ -389,9 +428,26 @@ namespace JSONRPC
      given parameters from the request against the json schema description for the given method.
      */
     static JSONRPC_STATUS CheckCall(const char* method, const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters);
+
+    /*!
+     \brief Checks whether the given method has been marked as "parallel"
+     \param method Name of the method (in lower case)
+     \return True if the method is known and may run concurrently with other parallel methods
+
+     Only compiled descriptions allow parallel calls, as checking a call against
+     an uncompiled description resolves the referenced types on the fly.
+     */
+    static bool IsParallel(const char* method);
     
     static JSONSchemaTypeDefinitionPtr GetType(const std::string &identification);
 
+    /*!
+     \brief Compiles all types and methods for faster validation of calls
+
+     Methods and types added afterwards are compiled right away.
+     */
+    static void Compile();
+
     static void Cleanup();
 
   private:
@@ -416,6 +472,7 @@ namespace JSONRPC
       JsonRpcMethodIterator find(const std::string& key) const;
       JsonRpcMethodIterator end() const;
 
+      void compile();
       void clear();
     private:
       std::map<std::string, JsonRpcMethod> m_actionmap;
@@ -425,6 +482,7 @@ namespace JSONRPC
     static std::map<std::string, JSONSchemaTypeDefinitionPtr> m_types;
     static std::map<std::string, CVariant> m_notifications;
     static JsonRpcMethodMap m_methodMaps[];
+    static bool m_compiled;
 
     typedef enum SchemaDefinition
     {
@@ -31,7 +31,7 @@ using namespace JSONRPC;
 JSONRPC_STATUS CVideoLibrary::GetMovies(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   SortDescription sorting;
@@ -88,7 +88,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieDetails(const std::string &method, ITransp
   int id = (int)parameterObject["movieid"].asInteger();
 
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   CVideoInfoTag infos;
@@ -102,14 +102,14 @@ JSONRPC_STATUS CVideoLibrary::GetMovieDetails(const std::string &method, ITransp
 JSONRPC_STATUS CVideoLibrary::GetMovieSets(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   CFileItemList items;
   if (!videodatabase.GetSetsNav("videodb://movies/sets/", items, VIDEODB_CONTENT_MOVIES))
     return InternalError;
 
-  HandleFileItemList("setid", false, "sets", items, parameterObject, result);
+  StreamFileItemList("setid", false, "sets", items, parameterObject, result);
   return OK;
 }
 
@@ -118,7 +118,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieSetDetails(const std::string &method, ITra
   int id = (int)parameterObject["setid"].asInteger();
 
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   // Get movie set details
@@ -139,7 +139,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieSetDetails(const std::string &method, ITra
 JSONRPC_STATUS CVideoLibrary::GetTVShows(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   SortDescription sorting;
@@ -193,7 +193,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShows(const std::string &method, ITransportLa
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("tvshowid", true, "tvshows", items, parameterObject, result, size, false);
+  StreamFileItemList("tvshowid", true, "tvshows", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -201,7 +201,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShows(const std::string &method, ITransportLa
 JSONRPC_STATUS CVideoLibrary::GetTVShowDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   int id = (int)parameterObject["tvshowid"].asInteger();
@@ -219,7 +219,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShowDetails(const std::string &method, ITrans
 JSONRPC_STATUS CVideoLibrary::GetSeasons(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   int tvshowID = (int)parameterObject["tvshowid"].asInteger();
@@ -229,14 +229,14 @@ JSONRPC_STATUS CVideoLibrary::GetSeasons(const std::string &method, ITransportLa
   if (!videodatabase.GetSeasonsNav(strPath, items, -1, -1, -1, -1, tvshowID, false))
     return InternalError;
 
-  HandleFileItemList("seasonid", false, "seasons", items, parameterObject, result);
+  StreamFileItemList("seasonid", false, "seasons", items, parameterObject, result);
   return OK;
 }
 
 JSONRPC_STATUS CVideoLibrary::GetSeasonDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   int id = (int)parameterObject["seasonid"].asInteger();
@@ -254,7 +254,7 @@ JSONRPC_STATUS CVideoLibrary::GetSeasonDetails(const std::string &method, ITrans
 JSONRPC_STATUS CVideoLibrary::GetEpisodes(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   SortDescription sorting;
@@ -309,7 +309,7 @@ JSONRPC_STATUS CVideoLibrary::GetEpisodes(const std::string &method, ITransportL
 JSONRPC_STATUS CVideoLibrary::GetEpisodeDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   int id = (int)parameterObject["episodeid"].asInteger();
@@ -334,7 +334,7 @@ JSONRPC_STATUS CVideoLibrary::GetEpisodeDetails(const std::string &method, ITran
 JSONRPC_STATUS CVideoLibrary::GetMusicVideos(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   SortDescription sorting;
@@ -379,7 +379,7 @@ JSONRPC_STATUS CVideoLibrary::GetMusicVideos(const std::string &method, ITranspo
 JSONRPC_STATUS CVideoLibrary::GetMusicVideoDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   int id = (int)parameterObject["musicvideoid"].asInteger();
@@ -395,7 +395,7 @@ JSONRPC_STATUS CVideoLibrary::GetMusicVideoDetails(const std::string &method, IT
 JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedMovies(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   CFileItemList items;
@@ -408,7 +408,7 @@ JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedMovies(const std::string &method,
 JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedEpisodes(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   CFileItemList items;
@@ -421,7 +421,7 @@ JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedEpisodes(const std::string &method
 JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedMusicVideos(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   CFileItemList items;
@@ -457,7 +457,7 @@ JSONRPC_STATUS CVideoLibrary::GetGenres(const std::string &method, ITransportLay
   strPath += "/genres/";
  
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   CFileItemList items;
@@ -468,7 +468,7 @@ JSONRPC_STATUS CVideoLibrary::GetGenres(const std::string &method, ITransportLay
   for (unsigned int i = 0; i < (unsigned int)items.Size(); i++)
     items[i]->GetVideoInfoTag()->m_strTitle = items[i]->GetLabel();
 
-  HandleFileItemList("genreid", false, "genres", items, parameterObject, result);
+  StreamFileItemList("genreid", false, "genres", items, parameterObject, result);
   return OK;
 }
 
@@ -860,7 +860,7 @@ bool CVideoLibrary::FillFileItemList(const CVariant &parameterObject, CFileItemL
 
 JSONRPC_STATUS CVideoLibrary::GetAdditionalMovieDetails(const CVariant &parameterObject, CFileItemList &items, CVariant &result, CVideoDatabase &videodatabase, bool limit /* = true */)
 {
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   bool additionalInfo = false;
@@ -883,14 +883,14 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMovieDetails(const CVariant &paramete
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("movieid", true, "movies", items, parameterObject, result, size, limit);
+  StreamFileItemList("movieid", true, "movies", items, parameterObject, result, size, limit);
 
   return OK;
 }
 
 JSONRPC_STATUS CVideoLibrary::GetAdditionalEpisodeDetails(const CVariant &parameterObject, CFileItemList &items, CVariant &result, CVideoDatabase &videodatabase, bool limit /* = true */)
 {
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   bool additionalInfo = false;
@@ -913,14 +913,14 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalEpisodeDetails(const CVariant &parame
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("episodeid", true, "episodes", items, parameterObject, result, size, limit);
+  StreamFileItemList("episodeid", true, "episodes", items, parameterObject, result, size, limit);
 
   return OK;
 }
 
 JSONRPC_STATUS CVideoLibrary::GetAdditionalMusicVideoDetails(const CVariant &parameterObject, CFileItemList &items, CVariant &result, CVideoDatabase &videodatabase, bool limit /* = true */)
 {
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenReadOnly())
     return InternalError;
 
   bool streamdetails = false;
@@ -939,7 +939,7 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMusicVideoDetails(const CVariant &par
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("musicvideoid", true, "musicvideos", items, parameterObject, result, size, limit);
+  StreamFileItemList("musicvideoid", true, "musicvideos", items, parameterObject, result, size, limit);
 
   return OK;
 }
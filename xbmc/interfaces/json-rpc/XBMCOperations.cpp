@@ -21,6 +21,8 @@
 #include "XBMCOperations.h"
 #include "ApplicationMessenger.h"
 #include "Util.h"
+#include "dbwrappers/DatabaseProfiler.h"
+#include "utils/JobManager.h"
 #include "utils/Variant.h"
 #include "powermanagement/PowerManager.h"
 
@@ -92,3 +94,17 @@ JSONRPC_STATUS CXBMCOperations::GetInfoBooleans(const std::string &method, ITran
 
   return OK;
 }
+
+JSONRPC_STATUS CXBMCOperations::GetJobStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CJobManager::GetInstance().GetStatistics(result);
+  return OK;
+}
+
+JSONRPC_STATUS CXBMCOperations::GetQueryStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CDatabaseProfiler::Get().GetStatistics(result);
+  if (parameterObject["reset"].asBoolean())
+    CDatabaseProfiler::Get().Reset();
+  return OK;
+}
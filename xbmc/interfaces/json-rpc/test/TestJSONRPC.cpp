@@ -0,0 +1,208 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace JSONRPC;
+
+namespace
+{
+  const unsigned int MethodDuration = 20;
+  const unsigned int BatchSize = 20;
+
+  class TestTransport : public ITransportLayer
+  {
+  public:
+    virtual bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) { return false; }
+    virtual bool Download(const char *path, CVariant &result) { return false; }
+    virtual int GetCapabilities() { return Response; }
+  };
+
+  class TestClient : public IClient
+  {
+  public:
+    virtual int GetPermissionFlags() { return OPERATION_PERMISSION_ALL; }
+    virtual int GetAnnouncementFlags() { return 0; }
+    virtual bool SetAnnouncementFlags(int flags) { return false; }
+  };
+
+  // number of calls running at the same time, now and at most
+  CCriticalSection overlapSection;
+  unsigned int running = 0;
+  unsigned int maxRunning = 0;
+
+  JSONRPC_STATUS Echo(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    {
+      CSingleLock lock(overlapSection);
+      maxRunning = std::max(maxRunning, ++running);
+    }
+    XbmcThreads::ThreadSleep(MethodDuration);
+    {
+      CSingleLock lock(overlapSection);
+      running--;
+    }
+    result = parameterObject["value"];
+    return OK;
+  }
+
+  unsigned int GetMaxRunning()
+  {
+    CSingleLock lock(overlapSection);
+    unsigned int result = maxRunning;
+    maxRunning = 0;
+    return result;
+  }
+
+  const char *ParallelMethod =
+    "\"JSONRPCTest.Parallel\": {"
+      "\"type\": \"method\","
+      "\"description\": \"Echo the value, may run concurrently\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"parallel\": true,"
+      "\"params\": [ { \"name\": \"value\", \"type\": \"integer\", \"required\": true } ],"
+      "\"returns\": \"integer\""
+    "}";
+
+  const char *SerialMethod =
+    "\"JSONRPCTest.Serial\": {"
+      "\"type\": \"method\","
+      "\"description\": \"Echo the value\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": [ { \"name\": \"value\", \"type\": \"integer\", \"required\": true } ],"
+      "\"returns\": \"integer\""
+    "}";
+}
+
+class TestJSONRPC : public testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    CJSONServiceDescription::AddMethod(ParallelMethod, Echo);
+    CJSONServiceDescription::AddMethod(SerialMethod, Echo);
+    CJSONServiceDescription::Compile();
+  }
+
+  static void TearDownTestCase()
+  {
+    CJSONServiceDescription::Cleanup();
+  }
+
+  std::string Batch(const std::string &method, unsigned int size)
+  {
+    std::string batch = "[";
+    for (unsigned int i = 0; i < size; i++)
+    {
+      if (i > 0)
+        batch += ",";
+      batch += StringUtils::Format("{ \"jsonrpc\": \"2.0\", \"method\": \"%s\", \"params\": { \"value\": %u }, \"id\": %u }",
+                                   method.c_str(), i * 10, i);
+    }
+    return batch + "]";
+  }
+
+  CVariant Call(const std::string &request, unsigned int &duration)
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    std::string response = CJSONRPC::MethodCall(request, &m_transport, &m_client);
+    duration = XbmcThreads::SystemClockMillis() - start;
+    return CJSONVariantParser::Parse((const unsigned char *)response.c_str(), response.size());
+  }
+
+  TestTransport m_transport;
+  TestClient m_client;
+};
+
+TEST_F(TestJSONRPC, ParallelFlag)
+{
+  EXPECT_TRUE(CJSONServiceDescription::IsParallel("jsonrpctest.parallel"));
+  EXPECT_FALSE(CJSONServiceDescription::IsParallel("jsonrpctest.serial"));
+  EXPECT_FALSE(CJSONServiceDescription::IsParallel("jsonrpctest.unknown"));
+}
+
+TEST_F(TestJSONRPC, BatchOrder)
+{
+  // parallel calls separated by a serial call and an invalid one
+  std::string request = "["
+    "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPCTest.Parallel\", \"params\": { \"value\": 0 }, \"id\": 0 },"
+    "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPCTest.Parallel\", \"params\": { \"value\": 10 }, \"id\": 1 },"
+    "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPCTest.Parallel\", \"params\": { \"value\": 20 } },"
+    "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPCTest.Serial\", \"params\": { \"value\": 30 }, \"id\": 3 },"
+    "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPCTest.Parallel\", \"params\": { \"value\": 40 }, \"id\": 4 },"
+    "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPCTest.Parallel\", \"params\": { }, \"id\": 5 },"
+    "{ \"jsonrpc\": \"2.0\", \"method\": \"JSONRPCTest.Parallel\", \"params\": { \"value\": 60 }, \"id\": 6 }"
+    "]";
+
+  unsigned int duration;
+  CVariant response = Call(request, duration);
+  ASSERT_TRUE(response.isArray());
+  // the notification (id 2) has no response
+  ASSERT_EQ(6U, response.size());
+
+  int ids[] = { 0, 1, 3, 4, 5, 6 };
+  for (unsigned int i = 0; i < response.size(); i++)
+  {
+    EXPECT_EQ(ids[i], response[i]["id"].asInteger());
+    if (ids[i] == 5)
+      EXPECT_EQ(InvalidParams, response[i]["error"]["code"].asInteger());
+    else
+      EXPECT_EQ(ids[i] * 10, response[i]["result"].asInteger());
+  }
+}
+
+TEST_F(TestJSONRPC, BatchLatency)
+{
+  unsigned int serial, parallel;
+  GetMaxRunning();
+  CVariant serialResponse = Call(Batch("JSONRPCTest.Serial", BatchSize), serial);
+  unsigned int serialOverlap = GetMaxRunning();
+  CVariant parallelResponse = Call(Batch("JSONRPCTest.Parallel", BatchSize), parallel);
+  unsigned int parallelOverlap = GetMaxRunning();
+
+  std::cout << "Batch of " << BatchSize << " calls taking " << MethodDuration << "ms each: "
+            << serial << "ms serial, " << parallel << "ms parallel with up to "
+            << parallelOverlap << " calls at a time" << std::endl;
+
+  ASSERT_EQ(BatchSize, serialResponse.size());
+  ASSERT_EQ(BatchSize, parallelResponse.size());
+  for (unsigned int i = 0; i < BatchSize; i++)
+  {
+    EXPECT_EQ(i, parallelResponse[i]["id"].asUnsignedInteger());
+    EXPECT_EQ(serialResponse[i]["result"].asInteger(), parallelResponse[i]["result"].asInteger());
+  }
+
+  // timings depend on the machine, whether the calls overlapped doesn't
+  EXPECT_EQ(1U, serialOverlap);
+  EXPECT_LT(1U, parallelOverlap);
+}
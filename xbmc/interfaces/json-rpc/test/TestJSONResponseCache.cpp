@@ -0,0 +1,364 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/json-rpc/JSONResponseCache.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoDatabase.h"
+
+#include "gtest/gtest.h"
+
+using namespace ANNOUNCEMENT;
+using namespace JSONRPC;
+
+namespace
+{
+  CJSONResponseCache::Key MakeKey(const std::string &id, AnnouncementFlag library, long revision)
+  {
+    CJSONResponseCache::Key key;
+    key.id = id;
+    key.library = library;
+    key.revision = revision;
+    return key;
+  }
+
+  CVariant MakeResult(int count)
+  {
+    CVariant result(CVariant::VariantTypeObject);
+    result["limits"]["start"] = 0;
+    result["limits"]["end"] = count;
+    result["limits"]["total"] = count;
+    result["movies"] = CVariant(CVariant::VariantTypeArray);
+    for (int i = 0; i < count; i++)
+    {
+      CVariant movie(CVariant::VariantTypeObject);
+      movie["movieid"] = i;
+      movie["label"] = StringUtils::Format("Movie %d", i);
+      result["movies"].push_back(movie);
+    }
+
+    return result;
+  }
+
+  // writes the values of an array the way a method streaming its result does
+  class CArrayStream : public IStreamedResult
+  {
+  public:
+    CArrayStream(const CVariant &values) : m_values(values), m_current(0) { }
+
+    virtual bool WriteNext(CJSONStreamWriter &writer)
+    {
+      if (m_current >= m_values.size())
+        return false;
+
+      return writer.Value(m_values[m_current++]);
+    }
+
+  private:
+    CVariant m_values;
+    unsigned int m_current;
+  };
+
+  class CTestVideoDatabase : public CVideoDatabase
+  {
+  public:
+    bool Create(const std::string &folder, const std::string &name)
+    {
+      DatabaseSettings settings;
+      settings.type = "sqlite3";
+      settings.host = folder;
+      settings.name = name;
+      return Update(settings);
+    }
+
+    std::string GetFile() const
+    {
+      return URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+    }
+  };
+
+  // serializes the response the same way a transport would
+  std::string WriteResponse(CVariant &result, IStreamedResult *streamed, const std::string &member)
+  {
+    CVariant response(CVariant::VariantTypeObject);
+    response["id"] = 1;
+    response["jsonrpc"] = "2.0";
+    response["result"] = result;
+
+    std::string str;
+    CJSONStringSink sink(str);
+    CJSONResponseStream stream(true);
+    stream.AddResponse(response, streamed, member);
+    stream.Write(sink);
+    return str;
+  }
+
+  std::string ExpectedResponse(const CVariant &result)
+  {
+    CVariant response(CVariant::VariantTypeObject);
+    response["id"] = 1;
+    response["jsonrpc"] = "2.0";
+    response["result"] = result;
+    return CJSONVariantWriter::Write(response, true);
+  }
+}
+
+class TestJSONResponseCache : public testing::Test
+{
+protected:
+  TestJSONResponseCache()
+    : m_cache(CJSONResponseCache::Get()),
+      m_cacheSize(g_advancedSettings.m_jsonCacheSize)
+  {
+    m_cache.Clear();
+  }
+
+  ~TestJSONResponseCache()
+  {
+    m_cache.Clear();
+    g_advancedSettings.m_jsonCacheSize = m_cacheSize;
+  }
+
+  CJSONResponseCache &m_cache;
+  unsigned int m_cacheSize;
+};
+
+TEST_F(TestJSONResponseCache, StoreAndLookup)
+{
+  CJSONResponseCache::Key key = MakeKey("videolibrary.getmovies:{}", VideoLibrary, 1);
+  CJSONResponseCache::Statistics before = m_cache.GetStatistics();
+
+  CVariant result;
+  IStreamedResult *streamed = NULL;
+  std::string member;
+  EXPECT_FALSE(m_cache.Lookup(key, result, streamed, member));
+  EXPECT_TRUE(streamed == NULL);
+
+  CVariant original = MakeResult(100);
+  result = original;
+  m_cache.Store(key, result, streamed, member);
+  ASSERT_TRUE(streamed != NULL);
+  EXPECT_STREQ("movies", member.c_str());
+  EXPECT_TRUE(result["movies"].empty());
+  EXPECT_STREQ(ExpectedResponse(original).c_str(), WriteResponse(result, streamed, member).c_str());
+
+  // every hit streams the shared cached array
+  for (int i = 0; i < 2; i++)
+  {
+    CVariant cached;
+    streamed = NULL;
+    member.clear();
+    ASSERT_TRUE(m_cache.Lookup(key, cached, streamed, member));
+    ASSERT_TRUE(streamed != NULL);
+    EXPECT_STREQ(ExpectedResponse(original).c_str(), WriteResponse(cached, streamed, member).c_str());
+  }
+
+  CJSONResponseCache::Statistics after = m_cache.GetStatistics();
+  EXPECT_EQ(before.hits + 2, after.hits);
+  EXPECT_EQ(before.misses + 1, after.misses);
+  EXPECT_EQ(1U, after.entries);
+  EXPECT_LT(0U, after.size);
+}
+
+TEST_F(TestJSONResponseCache, ScalarResult)
+{
+  CJSONResponseCache::Key key = MakeKey("audiolibrary.getproperties:{}", AudioLibrary, 1);
+
+  CVariant result = "value";
+  IStreamedResult *streamed = NULL;
+  std::string member;
+  m_cache.Store(key, result, streamed, member);
+  EXPECT_TRUE(streamed == NULL);
+  EXPECT_STREQ("value", result.asString().c_str());
+
+  CVariant cached;
+  ASSERT_TRUE(m_cache.Lookup(key, cached, streamed, member));
+  EXPECT_TRUE(streamed == NULL);
+  EXPECT_STREQ("value", cached.asString().c_str());
+}
+
+TEST_F(TestJSONResponseCache, Revision)
+{
+  CVariant result = MakeResult(10);
+  IStreamedResult *streamed = NULL;
+  std::string member;
+  m_cache.Store(MakeKey("videolibrary.getmovies:{}", VideoLibrary, 1), result, streamed, member);
+  delete streamed;
+  streamed = NULL;
+
+  // a write to the database outdates the result
+  CVariant cached;
+  EXPECT_FALSE(m_cache.Lookup(MakeKey("videolibrary.getmovies:{}", VideoLibrary, 2), cached, streamed, member));
+  EXPECT_TRUE(streamed == NULL);
+  EXPECT_EQ(0U, m_cache.GetStatistics().entries);
+  EXPECT_EQ(0U, m_cache.GetStatistics().size);
+}
+
+TEST_F(TestJSONResponseCache, Budget)
+{
+  g_advancedSettings.m_jsonCacheSize = 16;
+
+  for (int i = 0; i < 100; i++)
+  {
+    CVariant result = MakeResult(5);
+    IStreamedResult *streamed = NULL;
+    std::string member;
+    m_cache.Store(MakeKey(StringUtils::Format("videolibrary.getmovies:%d", i), VideoLibrary, 1), result, streamed, member);
+    delete streamed;
+  }
+
+  CJSONResponseCache::Statistics statistics = m_cache.GetStatistics();
+  EXPECT_LT(0U, statistics.evictions);
+  EXPECT_GT(100U, statistics.entries);
+  EXPECT_GE(16U * 1024, statistics.size);
+
+  // the least recently used results are dropped first
+  CVariant cached;
+  IStreamedResult *streamed = NULL;
+  std::string member;
+  EXPECT_FALSE(m_cache.Lookup(MakeKey("videolibrary.getmovies:0", VideoLibrary, 1), cached, streamed, member));
+  EXPECT_TRUE(m_cache.Lookup(MakeKey("videolibrary.getmovies:99", VideoLibrary, 1), cached, streamed, member));
+  delete streamed;
+
+  // results larger than the whole budget are not cached at all
+  CVariant result = MakeResult(1000);
+  streamed = NULL;
+  m_cache.Store(MakeKey("videolibrary.getmovies:large", VideoLibrary, 1), result, streamed, member);
+  EXPECT_TRUE(streamed == NULL);
+  EXPECT_EQ(1000U, result["movies"].size());
+}
+
+TEST_F(TestJSONResponseCache, Announcement)
+{
+  IStreamedResult *streamed = NULL;
+  std::string member;
+
+  CVariant movies = MakeResult(5);
+  m_cache.Store(MakeKey("videolibrary.getmovies:{}", VideoLibrary, 1), movies, streamed, member);
+  delete streamed;
+  streamed = NULL;
+
+  CVariant albums = MakeResult(5);
+  m_cache.Store(MakeKey("audiolibrary.getalbums:{}", AudioLibrary, 1), albums, streamed, member);
+  delete streamed;
+  streamed = NULL;
+
+  m_cache.Announce(Player, "xbmc", "OnUpdate", CVariant());
+  EXPECT_EQ(2U, m_cache.GetStatistics().entries);
+
+  m_cache.Announce(VideoLibrary, "xbmc", "OnUpdate", CVariant());
+  EXPECT_EQ(1U, m_cache.GetStatistics().entries);
+
+  CVariant cached;
+  EXPECT_FALSE(m_cache.Lookup(MakeKey("videolibrary.getmovies:{}", VideoLibrary, 1), cached, streamed, member));
+  EXPECT_TRUE(m_cache.Lookup(MakeKey("audiolibrary.getalbums:{}", AudioLibrary, 1), cached, streamed, member));
+  delete streamed;
+}
+
+TEST_F(TestJSONResponseCache, StreamedMiss)
+{
+  CJSONResponseCache::Key key = MakeKey("videolibrary.getmovies:{}", VideoLibrary, 1);
+  CVariant original = MakeResult(100);
+
+  // the method streams its result itself
+  CVariant result = original;
+  result["movies"] = CVariant(CVariant::VariantTypeArray);
+  IStreamedResult *method = new CArrayStream(original["movies"]);
+  IStreamedResult *streamed = method;
+  std::string member = "movies";
+  m_cache.Store(key, result, streamed, member);
+  ASSERT_TRUE(streamed != NULL);
+  EXPECT_TRUE(streamed != method);
+  EXPECT_STREQ("movies", member.c_str());
+
+  // nothing is stored before the response has been written
+  EXPECT_EQ(0U, m_cache.GetStatistics().entries);
+  EXPECT_STREQ(ExpectedResponse(original).c_str(), WriteResponse(result, streamed, member).c_str());
+  EXPECT_EQ(1U, m_cache.GetStatistics().entries);
+
+  CVariant cached;
+  streamed = NULL;
+  member.clear();
+  ASSERT_TRUE(m_cache.Lookup(key, cached, streamed, member));
+  ASSERT_TRUE(streamed != NULL);
+  EXPECT_STREQ(ExpectedResponse(original).c_str(), WriteResponse(cached, streamed, member).c_str());
+}
+
+TEST_F(TestJSONResponseCache, StreamedOverBudget)
+{
+  g_advancedSettings.m_jsonCacheSize = 16;
+  CJSONResponseCache::Key key = MakeKey("videolibrary.getmovies:{}", VideoLibrary, 1);
+  CVariant original = MakeResult(1000);
+
+  CVariant result = original;
+  result["movies"] = CVariant(CVariant::VariantTypeArray);
+  IStreamedResult *streamed = new CArrayStream(original["movies"]);
+  std::string member = "movies";
+  m_cache.Store(key, result, streamed, member);
+
+  // capturing stops once the budget is exceeded, the response is still complete
+  EXPECT_STREQ(ExpectedResponse(original).c_str(), WriteResponse(result, streamed, member).c_str());
+  EXPECT_EQ(0U, m_cache.GetStatistics().entries);
+
+  CVariant cached;
+  streamed = NULL;
+  EXPECT_FALSE(m_cache.Lookup(key, cached, streamed, member));
+}
+
+TEST_F(TestJSONResponseCache, DatabaseWrite)
+{
+  XFILE::CFile *file = XBMC_CREATETEMPFILE(".db");
+  ASSERT_TRUE(file != NULL);
+  file->Close();
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Create(CXBMCTestUtils::Instance().TempFileDirectory(file), "TestJSONResponseCache"));
+
+  CVariant original = MakeResult(10);
+  CVariant result = original;
+  IStreamedResult *streamed = NULL;
+  std::string member;
+  m_cache.Store(MakeKey("videolibrary.getmovies:{}", VideoLibrary, CVideoDatabase::GetRevision()), result, streamed, member);
+  delete streamed;
+  streamed = NULL;
+
+  CVariant cached;
+  EXPECT_TRUE(m_cache.Lookup(MakeKey("videolibrary.getmovies:{}", VideoLibrary, CVideoDatabase::GetRevision()), cached, streamed, member));
+  delete streamed;
+  streamed = NULL;
+
+  // adding a file writes to the database, which outdates the result
+  long revision = CVideoDatabase::GetRevision();
+  EXPECT_LT(0, db.AddFile("/media/Movies/TestJSONResponseCache.mkv"));
+  EXPECT_LT(revision, CVideoDatabase::GetRevision());
+  EXPECT_FALSE(m_cache.Lookup(MakeKey("videolibrary.getmovies:{}", VideoLibrary, CVideoDatabase::GetRevision()), cached, streamed, member));
+  EXPECT_TRUE(streamed == NULL);
+
+  std::string path = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(path);
+  XBMC_DELETETEMPFILE(file);
+}
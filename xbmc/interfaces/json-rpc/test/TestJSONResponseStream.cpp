@@ -0,0 +1,241 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/json-rpc/JSONResponseStream.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <vector>
+
+using namespace JSONRPC;
+
+namespace
+{
+  /* Streams objects { "id": <n> } for n in [0, count), then, if asked to,
+     a value the generator rejects. */
+  class CTestStreamedResult : public IStreamedResult
+  {
+  public:
+    CTestStreamedResult(unsigned int count, unsigned int &written, bool fail = false)
+      : m_count(count), m_written(written), m_fail(fail)
+    {
+      m_written = 0;
+    }
+
+    virtual bool WriteNext(CJSONStreamWriter &writer)
+    {
+      if (m_written >= m_count)
+      {
+        if (!m_fail)
+          return false;
+        return writer.Value(std::numeric_limits<double>::infinity());
+      }
+
+      CVariant item(CVariant::VariantTypeObject);
+      item["id"] = m_written++;
+      return writer.Value(item);
+    }
+
+    static CVariant Expected(unsigned int count)
+    {
+      CVariant items(CVariant::VariantTypeArray);
+      for (unsigned int i = 0; i < count; i++)
+      {
+        CVariant item(CVariant::VariantTypeObject);
+        item["id"] = i;
+        items.push_back(item);
+      }
+      return items;
+    }
+
+  private:
+    unsigned int m_count;
+    unsigned int &m_written;
+    bool m_fail;
+  };
+
+  class CTestSink : public IJSONStreamSink
+  {
+  public:
+    CTestSink(size_t accept = std::numeric_limits<size_t>::max()) : m_accept(accept) { }
+
+    virtual bool Write(const char *data, size_t length)
+    {
+      m_chunks.push_back(std::string(data, length));
+      return m_chunks.size() <= m_accept;
+    }
+
+    std::string Joined() const
+    {
+      std::string joined;
+      for (std::vector<std::string>::const_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+        joined += *it;
+      return joined;
+    }
+
+    size_t m_accept;
+    std::vector<std::string> m_chunks;
+  };
+
+  CVariant ListResponse(int id)
+  {
+    // members sorting before and after both "result" and the streamed member
+    CVariant response(CVariant::VariantTypeObject);
+    response["id"] = id;
+    response["jsonrpc"] = "2.0";
+    response["result"]["limits"]["start"] = 0;
+    response["result"]["limits"]["total"] = 3;
+    response["result"]["movies"] = CVariant(CVariant::VariantTypeArray);
+    response["result"]["trailing"] = "after";
+    response["zfinal"] = true;
+    return response;
+  }
+
+  std::string ReadAll(CJSONResponseStream &stream, size_t size)
+  {
+    std::string output;
+    std::vector<char> buffer(size);
+    size_t read;
+    while ((read = stream.Read(&buffer[0], size)) > 0)
+      output.append(&buffer[0], read);
+    return output;
+  }
+}
+
+TEST(TestJSONResponseStream, Framing)
+{
+  CVariant expected = ListResponse(1);
+  expected["result"]["movies"] = CTestStreamedResult::Expected(3);
+
+  unsigned int written;
+  CVariant response = ListResponse(1);
+  std::string output;
+  CJSONStringSink sink(output);
+  CJSONResponseStream stream(true);
+  stream.AddResponse(response, new CTestStreamedResult(3, written), "movies");
+  EXPECT_TRUE(stream.Write(sink));
+  EXPECT_EQ(3U, written);
+  EXPECT_STREQ(CJSONVariantWriter::Write(expected, true).c_str(), output.c_str());
+
+  // pulled by the transport in pieces smaller than the values
+  response = ListResponse(1);
+  CJSONResponseStream pulled(true, 16);
+  pulled.AddResponse(response, new CTestStreamedResult(3, written), "movies");
+  EXPECT_STREQ(output.c_str(), ReadAll(pulled, 7).c_str());
+}
+
+TEST(TestJSONResponseStream, FramingEmpty)
+{
+  unsigned int written;
+  CVariant response = ListResponse(1);
+  CJSONResponseStream stream(true);
+  stream.AddResponse(response, new CTestStreamedResult(0, written), "movies");
+  EXPECT_STREQ(CJSONVariantWriter::Write(ListResponse(1), true).c_str(), ReadAll(stream, 1024).c_str());
+}
+
+TEST(TestJSONResponseStream, FramingMissingMember)
+{
+  // a result without the member is written as it is
+  unsigned int written;
+  CVariant response = ListResponse(1);
+  response["result"].erase("movies");
+  CVariant expected = response;
+  CJSONResponseStream stream(true);
+  stream.AddResponse(response, new CTestStreamedResult(3, written), "movies");
+  EXPECT_STREQ(CJSONVariantWriter::Write(expected, true).c_str(), ReadAll(stream, 1024).c_str());
+  EXPECT_EQ(0U, written);
+}
+
+TEST(TestJSONResponseStream, GeneratorError)
+{
+  unsigned int written;
+  CVariant response = ListResponse(1);
+  CTestSink sink;
+  CJSONResponseStream stream(true, 64);
+  stream.AddResponse(response, new CTestStreamedResult(20, written, true), "movies");
+  EXPECT_FALSE(stream.Write(sink));
+  EXPECT_EQ(20U, written);
+
+  // what was generated up to the failure is passed on, but the response is never closed
+  std::string output = sink.Joined();
+  std::string head = CJSONVariantWriter::Write(ListResponse(1), true);
+  head = head.substr(0, head.find("\"movies\":[") + 10);
+  EXPECT_EQ(0U, output.find(head));
+  EXPECT_NE(std::string::npos, output.find("{\"id\":19}"));
+  EXPECT_EQ(std::string::npos, output.find("]"));
+
+  // nor is anything generated afterwards
+  char buffer[16];
+  EXPECT_EQ(0U, stream.Read(buffer, sizeof(buffer)));
+  EXPECT_FALSE(stream.Write(sink));
+}
+
+TEST(TestJSONResponseStream, SinkError)
+{
+  // the client going away stops the streamed result
+  unsigned int written;
+  CVariant response = ListResponse(1);
+  CTestSink sink(3);
+  CJSONResponseStream stream(true, 64);
+  stream.AddResponse(response, new CTestStreamedResult(1000, written), "movies");
+  EXPECT_FALSE(stream.Write(sink));
+  EXPECT_EQ(4U, sink.m_chunks.size());
+  EXPECT_GT(100U, written);
+}
+
+TEST(TestJSONResponseStream, BatchMixed)
+{
+  CVariant plain(CVariant::VariantTypeObject);
+  plain["id"] = 1;
+  plain["jsonrpc"] = "2.0";
+  plain["result"] = "OK";
+
+  CVariant error(CVariant::VariantTypeObject);
+  error["id"] = 3;
+  error["jsonrpc"] = "2.0";
+  error["error"]["code"] = -32601;
+  error["error"]["message"] = "Method not found.";
+
+  CVariant expected(CVariant::VariantTypeArray);
+  expected.push_back(plain);
+  expected.push_back(ListResponse(2));
+  expected[1]["result"]["movies"] = CTestStreamedResult::Expected(5);
+  expected.push_back(error);
+  expected.push_back(ListResponse(4));
+
+  unsigned int written[2];
+  CVariant first = ListResponse(2), second = ListResponse(4);
+  CJSONResponseStream stream(true, 32);
+  stream.SetBatch(true);
+  stream.AddResponse(plain);
+  stream.AddResponse(first, new CTestStreamedResult(5, written[0]), "movies");
+  stream.AddResponse(error);
+  stream.AddResponse(second, new CTestStreamedResult(0, written[1]), "movies");
+
+  CTestSink sink;
+  EXPECT_TRUE(stream.Write(sink));
+  EXPECT_LT(1U, sink.m_chunks.size());
+  EXPECT_STREQ(CJSONVariantWriter::Write(expected, true).c_str(), sink.Joined().c_str());
+  EXPECT_EQ(5U, written[0]);
+  EXPECT_EQ(0U, written[1]);
+}
@@ -0,0 +1,197 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "threads/SystemClock.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace JSONRPC;
+
+namespace
+{
+  const unsigned int Iterations = 20000;
+
+  class TestTransport : public ITransportLayer
+  {
+  public:
+    virtual bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) { return false; }
+    virtual bool Download(const char *path, CVariant &result) { return false; }
+    virtual int GetCapabilities() { return Response; }
+  };
+
+  class TestClient : public IClient
+  {
+  public:
+    virtual int GetPermissionFlags() { return OPERATION_PERMISSION_ALL; }
+    virtual int GetAnnouncementFlags() { return 0; }
+    virtual bool SetAnnouncementFlags(int flags) { return false; }
+  };
+
+  JSONRPC_STATUS GetProperties(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+  {
+    return OK;
+  }
+
+  const char *Types[] = {
+    "\"Test.Property.Name\": {"
+      "\"type\": \"string\","
+      "\"enum\": [ \"time\", \"percentage\", \"speed\", \"totaltime\", \"position\", \"repeat\", \"shuffled\", \"partymode\" ]"
+    "}",
+    "\"Test.Limits\": {"
+      "\"type\": \"object\","
+      "\"properties\": {"
+        "\"start\": { \"type\": \"integer\", \"minimum\": 0, \"default\": 0 },"
+        "\"end\": { \"type\": \"integer\", \"minimum\": -1, \"default\": -1 }"
+      "},"
+      "\"additionalProperties\": false"
+    "}",
+    "\"Test.Sort\": {"
+      "\"type\": \"object\","
+      "\"properties\": {"
+        "\"order\": { \"type\": \"string\", \"default\": \"ascending\", \"enum\": [ \"ascending\", \"descending\" ] },"
+        "\"method\": { \"type\": \"string\", \"default\": \"none\", \"enum\": [ \"none\", \"title\", \"year\" ] },"
+        "\"ignorearticle\": { \"type\": \"boolean\", \"default\": false }"
+      "}"
+    "}"
+  };
+
+  const char *Method =
+    "\"Test.GetProperties\": {"
+      "\"type\": \"method\","
+      "\"description\": \"Retrieves the values of the given properties\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": ["
+        "{ \"name\": \"playerid\", \"type\": \"integer\", \"minimum\": 0, \"maximum\": 2, \"required\": true },"
+        "{ \"name\": \"properties\", \"type\": \"array\", \"uniqueItems\": true, \"required\": true, \"items\": { \"$ref\": \"Test.Property.Name\" } },"
+        "{ \"name\": \"limits\", \"$ref\": \"Test.Limits\" },"
+        "{ \"name\": \"sort\", \"$ref\": \"Test.Sort\" }"
+      "],"
+      "\"returns\": \"object\""
+    "}";
+
+  const char *Parameters[] = {
+    "{ \"playerid\": 1, \"properties\": [ \"time\", \"percentage\", \"speed\", \"totaltime\" ] }",
+    "[ 1, [ \"speed\" ], { \"start\": 5 } ]",
+    "{ \"playerid\": 0, \"properties\": [ \"position\" ], \"limits\": { \"start\": 0, \"end\": 10 }, \"sort\": { \"method\": \"title\" } }",
+    "{ \"playerid\": 3, \"properties\": [ \"time\" ] }",
+    "{ \"playerid\": 1, \"properties\": [ \"time\", \"unknown\" ] }",
+    "{ \"playerid\": 1, \"properties\": [ \"time\", \"time\" ] }",
+    "{ \"playerid\": 1 }",
+    "{ \"playerid\": 1, \"properties\": [], \"limits\": { \"start\": 0, \"count\": 10 } }",
+    "{ \"playerid\": 1, \"properties\": [], \"sort\": { \"order\": \"random\" } }",
+    "{ \"playerid\": 1, \"properties\": [], \"unknown\": true }"
+  };
+}
+
+class TestJSONServiceDescription : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    for (unsigned int i = 0; i < sizeof(Types) / sizeof(Types[0]); i++)
+      ASSERT_TRUE(CJSONServiceDescription::AddType(Types[i]));
+    ASSERT_TRUE(CJSONServiceDescription::AddMethod(Method, GetProperties));
+  }
+
+  virtual void TearDown()
+  {
+    CJSONServiceDescription::Cleanup();
+  }
+
+  JSONRPC_STATUS Check(const CVariant &parameters, CVariant &output)
+  {
+    MethodCall method;
+    return CJSONServiceDescription::CheckCall("test.getproperties", parameters, &m_transport, &m_client, false, method, output);
+  }
+
+  std::vector<std::string> CheckAll()
+  {
+    std::vector<std::string> results;
+    for (unsigned int i = 0; i < sizeof(Parameters) / sizeof(Parameters[0]); i++)
+    {
+      CVariant output;
+      JSONRPC_STATUS status = Check(CJSONVariantParser::Parse((const unsigned char *)Parameters[i], strlen(Parameters[i])), output);
+      results.push_back(StringUtils::Format("%d %s", status, CJSONVariantWriter::Write(output, true).c_str()));
+    }
+    return results;
+  }
+
+  unsigned int Throughput()
+  {
+    CVariant parameters = CJSONVariantParser::Parse((const unsigned char *)Parameters[2], strlen(Parameters[2]));
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (unsigned int i = 0; i < Iterations; i++)
+    {
+      CVariant output;
+      Check(parameters, output);
+    }
+    unsigned int duration = std::max(XbmcThreads::SystemClockMillis() - start, 1U);
+    return Iterations * 1000 / duration;
+  }
+
+  TestTransport m_transport;
+  TestClient m_client;
+};
+
+TEST_F(TestJSONServiceDescription, Check)
+{
+  CVariant output;
+  const char *parameters = Parameters[1];
+  EXPECT_EQ(OK, Check(CJSONVariantParser::Parse((const unsigned char *)parameters, strlen(parameters)), output));
+  EXPECT_EQ(1, output["playerid"].asInteger());
+  ASSERT_EQ(1U, output["properties"].size());
+  EXPECT_STREQ("speed", output["properties"][0].asString().c_str());
+  EXPECT_EQ(5, output["limits"]["start"].asInteger());
+  EXPECT_EQ(-1, output["limits"]["end"].asInteger());
+  EXPECT_STREQ("none", output["sort"]["method"].asString().c_str());
+
+  parameters = Parameters[4];
+  EXPECT_EQ(InvalidParams, Check(CJSONVariantParser::Parse((const unsigned char *)parameters, strlen(parameters)), output));
+  EXPECT_STREQ("Test.GetProperties", output["method"].asString().c_str());
+  EXPECT_STREQ("properties", output["stack"]["name"].asString().c_str());
+}
+
+TEST_F(TestJSONServiceDescription, Compile)
+{
+  std::vector<std::string> interpreted = CheckAll();
+  CJSONServiceDescription::Compile();
+  std::vector<std::string> compiled = CheckAll();
+
+  ASSERT_EQ(interpreted.size(), compiled.size());
+  for (unsigned int i = 0; i < interpreted.size(); i++)
+    EXPECT_STREQ(interpreted[i].c_str(), compiled[i].c_str());
+}
+
+TEST_F(TestJSONServiceDescription, Throughput)
+{
+  unsigned int interpreted = Throughput();
+  CJSONServiceDescription::Compile();
+  unsigned int compiled = Throughput();
+
+  std::cout << "Validated calls per second: " << interpreted << " interpreted, " << compiled << " compiled" << std::endl;
+}
@@ -72,7 +72,6 @@ using namespace MUSICDATABASEDIRECTORY;
 using ADDON::AddonPtr;
 
 #define RECENTLY_PLAYED_LIMIT 25
-#define MIN_FULL_SEARCH_LENGTH 3
 
 #ifdef HAS_DVD_DRIVE
 using namespace CDDB;
@@ -181,6 +180,8 @@ void CMusicDatabase::CreateTables()
   CLog::Log(LOGINFO, "create art table");
   m_pDS->exec("CREATE TABLE art(art_id INTEGER PRIMARY KEY, media_id INTEGER, media_type TEXT, type TEXT, url TEXT)");
 
+  CreateFingerprintTable();
+
   // Add 'Karaoke' genre
   AddGenre( "Karaoke" );
 }
@@ -205,6 +206,7 @@ void CMusicDatabase::CreateAnalytics()
   m_pDS->exec("CREATE UNIQUE INDEX idxArtist1 ON artist(strMusicBrainzArtistID(36))");
 
   m_pDS->exec("CREATE INDEX idxPath ON path(strPath(255))");
+  m_pDS->exec("CREATE INDEX idxPathFingerprint ON pathfingerprint(strPath(255))");
 
   m_pDS->exec("CREATE INDEX idxSong ON song(strTitle(255))");
   m_pDS->exec("CREATE INDEX idxSong1 ON song(iTimesPlayed)");
@@ -250,6 +252,11 @@ void CMusicDatabase::CreateAnalytics()
               "  DELETE FROM art WHERE media_id=old.idSong AND media_type='song';"
               " END");
 
+  CLog::Log(LOGINFO, "%s - creating search indices", __FUNCTION__);
+  CreateSearchIndex("artist", "idArtist", "strArtist");
+  CreateSearchIndex("album", "idAlbum", "strAlbum");
+  CreateSearchIndex("song", "idSong", "strTitle");
+
   // we create views last to ensure all indexes are rolled in
   CreateViews();
 }
@@ -1499,8 +1506,8 @@ int CMusicDatabase::AddPath(const std::string& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL.c_str());
+    strSQL = "select * from path where strPath=?";
+    m_pDS->query(strSQL, Parameters(strPath));
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
@@ -1787,15 +1794,8 @@ bool CMusicDatabase::SearchArtists(const std::string& search, CFileItemList &art
     if (NULL == m_pDS.get()) return false;
 
     std::string strVariousArtists = g_localizeStrings.Get(340).c_str();
-    std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from artist "
-                                "where (strArtist like '%s%%' or strArtist like '%% %s%%') and strArtist <> '%s' "
-                                , search.c_str(), search.c_str(), strVariousArtists.c_str() );
-    else
-      strSQL=PrepareSQL("select * from artist "
-                                "where strArtist like '%s%%' and strArtist <> '%s' "
-                                , search.c_str(), strVariousArtists.c_str() );
+    std::string strSQL=PrepareSQL("select * from artist where strArtist <> '%s' and ", strVariousArtists.c_str()) +
+                       GetSearchCondition("artist", "idArtist", "strArtist", "artist.idArtist", search);
 
     if (!m_pDS->query(strSQL.c_str())) return false;
     if (m_pDS->num_rows() == 0)
@@ -2211,11 +2211,7 @@ bool CMusicDatabase::SearchSongs(const std::string& search, CFileItemList &items
     if (!baseUrl.FromString("musicdb://songs/"))
       return false;
 
-    std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' or strTitle like '%% %s%%' limit 1000", search.c_str(), search.c_str());
-    else
-      strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' limit 1000", search.c_str());
+    std::string strSQL = "select * from songview where " + GetSearchCondition("song", "idSong", "strTitle", "songview.idSong", search) + " limit 1000";
 
     if (!m_pDS->query(strSQL.c_str())) return false;
     if (m_pDS->num_rows() == 0) return false;
@@ -2247,11 +2243,7 @@ bool CMusicDatabase::SearchAlbums(const std::string& search, CFileItemList &albu
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%' or strAlbum like '%% %s%%'", search.c_str(), search.c_str());
-    else
-      strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%'", search.c_str());
+    std::string strSQL = "select * from albumview where " + GetSearchCondition("album", "idAlbum", "strAlbum", "albumview.idAlbum", search);
 
     if (!m_pDS->query(strSQL.c_str())) return false;
 
@@ -3184,13 +3176,17 @@ bool CMusicDatabase::GetArtistsByWhere(const std::string& strBaseDir, const Filt
     if (!BuildSQL(strSQLExtra, extFilter, strSQLExtra))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
+    // Apply the limiting directly here if there's no special sorting or the
+    // database can sort the rows itself
+    std::string strSQLOrder;
     if (extFilter.limit.empty() &&
-        sortDescription.sortBy == SortByNone &&
-       (sortDescription.limitStart > 0 || sortDescription.limitEnd > 0))
+       (sorting.limitStart > 0 || sorting.limitEnd > 0) &&
+       (sorting.sortBy == SortByNone ||
+       (!countOnly && extFilter.order.empty() && extFilter.group.empty() && BuildOrderClause(sorting, MediaTypeArtist, strSQLOrder))))
     {
       total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sortDescription.limitEnd, sortDescription.limitStart);
+      strSQLExtra += strSQLOrder + DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      sorting.sortBy = SortByNone;
     }
 
     strSQL = PrepareSQL(strSQL.c_str(), !extFilter.fields.empty() && extFilter.fields.compare("*") != 0 ? extFilter.fields.c_str() : "artistview.*") + strSQLExtra;
@@ -3222,7 +3218,7 @@ bool CMusicDatabase::GetArtistsByWhere(const std::string& strBaseDir, const Filt
     
     DatabaseResults results;
     results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeArtist, m_pDS, results))
+    if (!SortUtils::SortFromDataset(sorting, MediaTypeArtist, m_pDS, results))
       return false;
 
     // get data from returned rows
@@ -3343,13 +3339,17 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
     if (!BuildSQL(strSQLExtra, extFilter, strSQLExtra))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
+    // Apply the limiting directly here if there's no special sorting or the
+    // database can sort the rows itself
+    std::string strSQLOrder;
     if (extFilter.limit.empty() &&
-        sortDescription.sortBy == SortByNone &&
-       (sortDescription.limitStart > 0 || sortDescription.limitEnd > 0))
+       (sorting.limitStart > 0 || sorting.limitEnd > 0) &&
+       (sorting.sortBy == SortByNone ||
+       (!countOnly && extFilter.order.empty() && extFilter.group.empty() && BuildOrderClause(sorting, MediaTypeAlbum, strSQLOrder))))
     {
       total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sortDescription.limitEnd, sortDescription.limitStart);
+      strSQLExtra += strSQLOrder + DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      sorting.sortBy = SortByNone;
     }
 
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "albumview.*") + strSQLExtra;
@@ -3386,7 +3386,7 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
     
     DatabaseResults results;
     results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeAlbum, m_pDS, results))
+    if (!SortUtils::SortFromDataset(sorting, MediaTypeAlbum, m_pDS, results))
       return false;
 
     // get data from returned rows
@@ -3456,18 +3456,49 @@ bool CMusicDatabase::GetSongsByWhere(const std::string &baseDir, const Filter &f
     if (!BuildSQL(strSQLExtra, extFilter, strSQLExtra))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
+    // Apply the limiting directly here if there's no special sorting or the
+    // database can sort the rows itself
+    std::string strSQLOrder;
     if (extFilter.limit.empty() &&
-        sortDescription.sortBy == SortByNone &&
-       (sortDescription.limitStart > 0 || sortDescription.limitEnd > 0))
+       (sorting.limitStart > 0 || sorting.limitEnd > 0) &&
+       (sorting.sortBy == SortByNone ||
+       (extFilter.order.empty() && extFilter.group.empty() && BuildOrderClause(sorting, MediaTypeSong, strSQLOrder))))
     {
       total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sortDescription.limitEnd, sortDescription.limitStart);
+      strSQLExtra += strSQLOrder + DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      sorting.sortBy = SortByNone;
     }
 
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "songview.*") + strSQLExtra;
 
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
+
+    // without sorting the songs are added in the order of the rows, which
+    // therefore don't need to be held in memory all at once
+    if (sorting.sortBy == SortByNone)
+    {
+      if (!m_pDS->query_streamed(strSQL))
+        return false;
+
+      int count = 0;
+      while (!m_pDS->eof())
+      {
+        CFileItemPtr item(new CFileItem);
+        GetFileItemFromDataset(m_pDS->get_sql_record(), item.get(), musicUrl);
+        // HACK for sorting by database returned order
+        item->m_iprogramCount = ++count;
+        items.Add(item);
+        m_pDS->next();
+      }
+      m_pDS->close();
+
+      if (total < count)
+        total = count;
+      items.SetProperty("total", total);
+      CLog::Log(LOGDEBUG, "%s(%s) - took %d ms", __FUNCTION__, filter.where.c_str(), XbmcThreads::SystemClockMillis() - time);
+      return true;
+    }
+
     // run query
     if (!m_pDS->query(strSQL.c_str()))
       return false;
@@ -3486,7 +3517,7 @@ bool CMusicDatabase::GetSongsByWhere(const std::string &baseDir, const Filter &f
     
     DatabaseResults results;
     results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeSong, m_pDS, results))
+    if (!SortUtils::SortFromDataset(sorting, MediaTypeSong, m_pDS, results))
       return false;
 
     // get data from returned rows
@@ -3933,11 +3964,13 @@ void CMusicDatabase::UpdateTables(int version)
                 " bookmark integer, file text, duration integer"
                 " dateAdded varchar (20) default NULL)");
   }
+  if (version < 50)
+    CreateFingerprintTable();
 }
 
 int CMusicDatabase::GetSchemaVersion() const
 {
-  return 48;
+  return 50;
 }
 
 unsigned int CMusicDatabase::GetSongIDs(const Filter &filter, vector<pair<int,int> > &songIDs)
@@ -5702,6 +5735,9 @@ bool CMusicDatabase::GetFilter(CDbUrl &musicUrl, Filter &filter, SortDescription
       musicUrl.RemoveOption("filter");
   }
 
+  // a page of the items, see CGUIMediaWindow::GetDirectory()
+  musicUrl.TakeSorting(sorting);
+
   return true;
 }
 
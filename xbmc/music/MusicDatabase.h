@@ -96,6 +96,10 @@ public:
 
   virtual bool Open();
   virtual bool CommitTransaction();
+
+  /*! \brief Revision of the music database, see CDatabase::GetRevision() */
+  static long GetRevision() { return CDatabase::GetRevision("MyMusic"); }
+
   void EmptyCache();
   void Clean();
   int  Cleanup(CGUIDialogProgress *pDlgProgress=NULL);
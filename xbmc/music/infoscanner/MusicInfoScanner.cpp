@@ -20,7 +20,7 @@
 
 #include "threads/SystemClock.h"
 #include "MusicInfoScanner.h"
-#include "music/tags/MusicInfoTagLoaderFactory.h"
+#include "music/tags/MusicInfoTagLoaderQueue.h"
 #include "MusicAlbumInfo.h"
 #include "MusicInfoScraper.h"
 #include "filesystem/MusicDatabaseDirectory.h"
@@ -38,6 +38,7 @@
 #include "guilib/GUIKeyboardFactory.h"
 #include "filesystem/File.h"
 #include "filesystem/Directory.h"
+#include "filesystem/DirectoryFingerprint.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "FileItem.h"
@@ -131,7 +132,7 @@ void CMusicInfoScanner::Process()
           CLog::Log(LOGWARNING, "%s directory '%s' does not exist - skipping scan.", __FUNCTION__, it->c_str());
           continue;
         }
-        else if (!DoScan(*it))
+        else if (!ScanTree(*it))
         {
           commit = false;
           break;
@@ -386,6 +387,28 @@ static std::string Prettify(const std::string& strDirectory)
   return CURL::Decode(url.GetWithoutUserDetails());
 }
 
+bool CMusicInfoScanner::ScanTree(const std::string& strDirectory)
+{
+  if ((m_flags & SCAN_RESCAN) || !CDirectoryFingerprint::PropagatesTimes(strDirectory))
+    return DoScan(strDirectory);
+
+  CDirectoryFingerprint fingerprint(strDirectory, g_advancedSettings.m_audioExcludeFromScanRegExps);
+  bool stored = m_musicDatabase.GetFingerprint(fingerprint);
+  if (!fingerprint.Update() && stored)
+  {
+    CLog::Log(LOGDEBUG, "%s Skipping tree '%s' due to no change", __FUNCTION__, strDirectory.c_str());
+    if (m_handle)
+      OnDirectoryScanned(strDirectory);
+    return true;
+  }
+
+  if (!DoScan(strDirectory))
+    return false;
+
+  m_musicDatabase.SetFingerprint(fingerprint);
+  return true;
+}
+
 bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
 {
   if (m_handle)
@@ -475,11 +498,11 @@ INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items, CFileItemList&
 {
   vector<string> regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
 
+  // read the tags of the directory's files a few at a time
+  CMusicInfoTagLoaderQueue loader(g_advancedSettings.m_iMusicLibraryTagReaders);
+  vector<CFileItemPtr> songs;
   for (int i = 0; i < items.Size(); ++i)
   {
-    if (m_bStop)
-      return INFO_CANCELLED;
-
     CFileItemPtr pItem = items[i];
 
     if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
@@ -488,26 +511,41 @@ INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items, CFileItemList&
     if (pItem->m_bIsFolder || pItem->IsPlayList() || pItem->IsPicture() || pItem->IsLyrics())
       continue;
 
-    m_currentItem++;
+    if (!pItem->GetMusicInfoTag()->Loaded())
+      loader.Add(pItem);
+    songs.push_back(pItem);
+  }
 
-    CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
-    if (!tag.Loaded())
+  unsigned int pending = songs.empty() ? 0 : loader.Wait(0);
+  while (pending > 0)
+  {
+    if (m_bStop)
     {
-      auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->GetPath()));
-      if (NULL != pLoader.get())
-        pLoader->Load(pItem->GetPath(), tag);
+      // the tags being read are waited for when the loader goes out of scope
+      loader.Cancel();
+      return INFO_CANCELLED;
     }
 
     if (m_handle && m_itemCount>0)
-      m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
+      m_handle->SetPercentage((m_currentItem + songs.size() - pending)/(float)m_itemCount*100);
+
+    pending = loader.Wait(100);
+  }
 
-    if (!tag.Loaded())
+  // add them in the order of the directory
+  for (vector<CFileItemPtr>::const_iterator i = songs.begin(); i != songs.end(); ++i)
+  {
+    m_currentItem++;
+    if (!(*i)->GetMusicInfoTag()->Loaded())
     {
-      CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
+      CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, (*i)->GetPath().c_str());
       continue;
     }
-    scannedItems.Add(pItem);
+    scannedItems.Add(*i);
   }
+  if (m_handle && m_itemCount>0)
+    m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
+
   return INFO_ADDED;
 }
 
@@ -185,6 +185,13 @@ protected:
   int GetPathHash(const CFileItemList &items, std::string &hash);
   void GetAlbumArtwork(long id, const CAlbum &artist);
 
+  /*! \brief Scan a directory tree, skipping it as a whole if its stored fingerprint shows nothing changed.
+   Only done on paths where folder mtimes propagate (see XFILE::CDirectoryFingerprint), as elsewhere
+   changes to the tags of files would go unnoticed.
+   \param strDirectory the root of the tree.
+   \return false if the scan was cancelled, true otherwise.
+   */
+  bool ScanTree(const std::string& strDirectory);
   bool DoScan(const std::string& strDirectory);
 
   virtual void Run();
@@ -0,0 +1,113 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MusicInfoTagLoaderQueue.h"
+#include "MusicInfoTag.h"
+#include "MusicInfoTagLoaderFactory.h"
+#include "threads/SingleLock.h"
+
+#include <memory>
+
+using namespace MUSIC_INFO;
+
+namespace
+{
+  class CMusicInfoTagLoaderJob : public CJob
+  {
+  public:
+    CMusicInfoTagLoaderJob(const CFileItemPtr &item, const CMusicInfoTagLoaderQueue *queue) : m_item(item), m_queue(queue) {}
+
+    virtual const char *GetType() const { return "musictagloader"; }
+
+    virtual bool operator==(const CJob *job) const
+    {
+      const CMusicInfoTagLoaderJob *loaderJob = dynamic_cast<const CMusicInfoTagLoaderJob *>(job);
+      return loaderJob && loaderJob->m_item == m_item;
+    }
+
+    virtual bool DoWork()
+    {
+      if (m_queue->IsCancelled())
+        return false;
+
+      std::auto_ptr<IMusicInfoTagLoader> pLoader(CMusicInfoTagLoaderFactory::CreateLoader(m_item->GetPath()));
+      if (NULL != pLoader.get())
+        return pLoader->Load(m_item->GetPath(), *m_item->GetMusicInfoTag());
+      return false;
+    }
+
+  private:
+    CFileItemPtr m_item;
+    const CMusicInfoTagLoaderQueue *m_queue;
+  };
+}
+
+CMusicInfoTagLoaderQueue::CMusicInfoTagLoaderQueue(unsigned int jobs)
+  : CJobQueue(false, jobs, CJob::PRIORITY_NORMAL)
+{
+  m_pending = 0;
+  m_cancelled = false;
+}
+
+CMusicInfoTagLoaderQueue::~CMusicInfoTagLoaderQueue()
+{
+  // the jobs refer to us until their completion is handled
+  Cancel();
+  while (Wait(1000) > 0)
+    ;
+}
+
+void CMusicInfoTagLoaderQueue::Add(const CFileItemPtr &item)
+{
+  {
+    CSingleLock lock(m_pendingSection);
+    m_pending++;
+  }
+  AddJob(new CMusicInfoTagLoaderJob(item, this));
+}
+
+unsigned int CMusicInfoTagLoaderQueue::Wait(unsigned int timeout)
+{
+  CSingleLock lock(m_pendingSection);
+  if (m_pending > 0)
+  {
+    lock.Leave();
+    m_loadedEvent.WaitMSec(timeout);
+    lock.Enter();
+  }
+  return m_pending;
+}
+
+void CMusicInfoTagLoaderQueue::Cancel()
+{
+  // CancelJobs() would drop the callbacks of the running jobs, except for those being made
+  // already, so we couldn't tell when we're safe to go. The jobs run and return right away instead.
+  m_cancelled = true;
+}
+
+void CMusicInfoTagLoaderQueue::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CJobQueue::OnJobComplete(jobID, success, job);
+
+  // the queue may be destroyed once the last job is accounted for
+  CSingleLock lock(m_pendingSection);
+  m_pending--;
+  m_loadedEvent.Set();
+}
@@ -0,0 +1,72 @@
+#pragma once
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "utils/JobManager.h"
+
+namespace MUSIC_INFO
+{
+  /*! \brief Reads the tags of several files at once
+   Reading a tag mostly waits on opening the file, which is slow on network shares, so the
+   tags of a directory's files are read by a bounded number of jobs running concurrently.
+   Each job fills in the music info tag of its own item, so the items keep their order.
+   */
+  class CMusicInfoTagLoaderQueue : public CJobQueue
+  {
+  public:
+    /*! \brief Create a queue
+     \param jobs the number of tags to read at once.
+     */
+    CMusicInfoTagLoaderQueue(unsigned int jobs);
+
+    /*! \brief Destroy the queue, cancelling it and waiting for the tags being read
+     */
+    virtual ~CMusicInfoTagLoaderQueue();
+
+    /*! \brief Queue reading the tag of an item
+     \param item the item whose music info tag is filled in.
+     */
+    void Add(const CFileItemPtr &item);
+
+    /*! \brief Wait for the queued tags to be read
+     \param timeout the milliseconds to wait for.
+     \return the number of tags still to be read.
+     */
+    unsigned int Wait(unsigned int timeout);
+
+    /*! \brief Skip the tags not being read yet
+     The jobs already running finish and are waited for by Wait() and the destructor, as they
+     may be calling back already.
+     */
+    void Cancel();
+    bool IsCancelled() const { return m_cancelled; }
+
+    virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
+  private:
+    unsigned int m_pending;
+    volatile bool m_cancelled;
+    CCriticalSection m_pendingSection;
+    CEvent m_loadedEvent;
+  };
+}
@@ -0,0 +1,214 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "music/tags/MusicInfoTagLoaderQueue.h"
+#include "music/tags/MusicInfoTag.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+#include <iostream>
+
+using namespace MUSIC_INFO;
+
+namespace
+{
+  const int Albums = 10;
+  const int TracksPerAlbum = 20;
+
+  void AddFrame(std::string &tag, const char *id, const std::string &text)
+  {
+    // ID3v2.3 text frame: id, big endian size, flags, ISO-8859-1 encoding and the text
+    unsigned int size = text.size() + 1;
+    tag.append(id, 4);
+    tag += (char)(size >> 24);
+    tag += (char)(size >> 16);
+    tag += (char)(size >> 8);
+    tag += (char)size;
+    tag.append(3, '\0');
+    tag += text;
+  }
+
+  // writes an mp3 made of an ID3v2.3 tag and a few silent MPEG-1 layer 3 frames
+  bool WriteTrack(const std::string &path, int album, int track)
+  {
+    std::string frames;
+    AddFrame(frames, "TIT2", StringUtils::Format("Track %02d", track));
+    AddFrame(frames, "TPE1", "Artist");
+    AddFrame(frames, "TALB", StringUtils::Format("Album %d", album));
+    AddFrame(frames, "TRCK", StringUtils::Format("%d", track));
+
+    std::string data("ID3\x03\x00\x00", 6);
+    unsigned int size = frames.size(); // syncsafe
+    data += (char)((size >> 21) & 0x7f);
+    data += (char)((size >> 14) & 0x7f);
+    data += (char)((size >> 7) & 0x7f);
+    data += (char)(size & 0x7f);
+    data += frames;
+    for (int i = 0; i < 4; i++)
+    { // 128 kbit/s, 44.1 kHz
+      data.append("\xff\xfb\x90\x64", 4);
+      data.append(417 - 4, '\0');
+    }
+
+    XFILE::CFile file;
+    if (!file.OpenForWrite(path, true))
+      return false;
+    bool written = file.Write(data.c_str(), data.size()) == (int)data.size();
+    file.Close();
+    return written;
+  }
+
+  std::string GetAlbumPath(const std::string &root, int album)
+  {
+    return URIUtils::AddFileToFolder(root, StringUtils::Format("Album %d/", album));
+  }
+
+  std::string GetTrackPath(const std::string &root, int album, int track)
+  {
+    return URIUtils::AddFileToFolder(GetAlbumPath(root, album), StringUtils::Format("%02d - Track.mp3", track));
+  }
+}
+
+class TestMusicInfoTagLoaderQueue : public testing::Test
+{
+protected:
+  TestMusicInfoTagLoaderQueue()
+  {
+    m_file = XBMC_CREATETEMPFILE("");
+    if (m_file != NULL)
+    {
+      m_file->Close();
+      m_root = URIUtils::AddFileToFolder(CXBMCTestUtils::Instance().TempFileDirectory(m_file), "TestMusicTags/");
+    }
+  }
+
+  ~TestMusicInfoTagLoaderQueue()
+  {
+    if (!m_root.empty())
+    {
+      for (int album = 0; album < Albums; album++)
+      {
+        for (int track = 1; track <= TracksPerAlbum; track++)
+          XFILE::CFile::Delete(GetTrackPath(m_root, album, track));
+        XFILE::CDirectory::Remove(GetAlbumPath(m_root, album));
+      }
+      XFILE::CDirectory::Remove(m_root);
+    }
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(m_file != NULL);
+    ASSERT_TRUE(XFILE::CDirectory::Create(m_root));
+    for (int album = 0; album < Albums; album++)
+    {
+      ASSERT_TRUE(XFILE::CDirectory::Create(GetAlbumPath(m_root, album)));
+      for (int track = 1; track <= TracksPerAlbum; track++)
+        ASSERT_TRUE(WriteTrack(GetTrackPath(m_root, album, track), album, track));
+    }
+  }
+
+  // reads the tags of each album with the given number of jobs, returns the milliseconds it took
+  unsigned int ReadTags(unsigned int jobs, std::vector<CFileItemPtr> &items)
+  {
+    items.clear();
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (int album = 0; album < Albums; album++)
+    {
+      CMusicInfoTagLoaderQueue loader(jobs);
+      for (int track = 1; track <= TracksPerAlbum; track++)
+      {
+        CFileItemPtr item(new CFileItem(GetTrackPath(m_root, album, track), false));
+        loader.Add(item);
+        items.push_back(item);
+      }
+      while (loader.Wait(1000) > 0)
+        ;
+    }
+    return XbmcThreads::SystemClockMillis() - start;
+  }
+
+  XFILE::CFile *m_file;
+  std::string m_root;
+};
+
+TEST_F(TestMusicInfoTagLoaderQueue, Load)
+{
+  std::vector<CFileItemPtr> items;
+  ReadTags(4, items);
+
+  // every item has its own tag, in the order they were added
+  ASSERT_EQ((size_t)(Albums * TracksPerAlbum), items.size());
+  for (int album = 0; album < Albums; album++)
+  {
+    for (int track = 1; track <= TracksPerAlbum; track++)
+    {
+      const CMusicInfoTag &tag = *items[album * TracksPerAlbum + track - 1]->GetMusicInfoTag();
+      ASSERT_TRUE(tag.Loaded());
+      EXPECT_STREQ(StringUtils::Format("Track %02d", track).c_str(), tag.GetTitle().c_str());
+      EXPECT_STREQ(StringUtils::Format("Album %d", album).c_str(), tag.GetAlbum().c_str());
+      EXPECT_EQ(track, tag.GetTrackNumber());
+    }
+  }
+}
+
+TEST_F(TestMusicInfoTagLoaderQueue, Benchmark)
+{
+  std::vector<CFileItemPtr> items;
+  unsigned int sequential = ReadTags(1, items);
+  unsigned int parallel = ReadTags(4, items);
+
+  std::cout << Albums * TracksPerAlbum << " tags read in " << sequential << " ms one at a time, "
+            << parallel << " ms four at a time" << std::endl;
+}
+
+TEST_F(TestMusicInfoTagLoaderQueue, Cancel)
+{
+  // the tags not being read yet are skipped, and the queue is only gone once its jobs are
+  std::vector<CFileItemPtr> items;
+  {
+    CMusicInfoTagLoaderQueue loader(1);
+    for (int album = 0; album < Albums; album++)
+    {
+      for (int track = 1; track <= TracksPerAlbum; track++)
+      {
+        CFileItemPtr item(new CFileItem(GetTrackPath(m_root, album, track), false));
+        loader.Add(item);
+        items.push_back(item);
+      }
+    }
+    loader.Cancel();
+    EXPECT_TRUE(loader.IsCancelled());
+  }
+
+  int loaded = 0;
+  for (std::vector<CFileItemPtr>::const_iterator it = items.begin(); it != items.end(); ++it)
+  {
+    if ((*it)->GetMusicInfoTag()->Loaded())
+      loaded++;
+  }
+  EXPECT_LT(loaded, Albums * TracksPerAlbum / 2);
+}
@@ -318,6 +318,18 @@ bool CGUIWindowMusicNav::Update(const std::string &strDirectory, bool updateFilt
   return false;
 }
 
+int CGUIWindowMusicNav::GetPageSize(const std::string &strDirectory) const
+{
+  if (g_advancedSettings.m_iMusicLibraryPageSize <= 0 || !URIUtils::IsMusicDb(strDirectory))
+    return 0;
+
+  NODE_TYPE node = CMusicDatabaseDirectory::GetDirectoryChildType(strDirectory);
+  if (node == NODE_TYPE_ARTIST || node == NODE_TYPE_ALBUM || node == NODE_TYPE_SONG)
+    return g_advancedSettings.m_iMusicLibraryPageSize;
+
+  return 0;
+}
+
 bool CGUIWindowMusicNav::GetDirectory(const std::string &strDirectory, CFileItemList &items)
 {
   if (m_bDisplayEmptyDatabaseMessage)
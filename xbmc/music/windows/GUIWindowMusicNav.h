@@ -41,6 +41,7 @@ protected:
   // override base class methods
   virtual bool Update(const std::string &strDirectory, bool updateFilterPath = true);
   virtual bool GetDirectory(const std::string &strDirectory, CFileItemList &items);
+  virtual int GetPageSize(const std::string &strDirectory) const;
   virtual void UpdateButtons();
   virtual void PlayItem(int iItem);
   virtual void OnWindowLoaded();
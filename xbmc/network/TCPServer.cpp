@@ -530,6 +530,28 @@ void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
   } while (sent < size);
 }
 
+void CTCPServer::CTCPClient::SendResponse(CJSONResponseStream &response)
+{
+  // send every chunk as soon as it has been generated
+  class CClientSink : public IJSONStreamSink
+  {
+  public:
+    CClientSink(CTCPClient &client) : m_client(client) { }
+
+    virtual bool Write(const char *data, size_t length)
+    {
+      m_client.Send(data, (unsigned int)length);
+      return true;
+    }
+
+  private:
+    CTCPClient &m_client;
+  };
+
+  CClientSink sink(*this);
+  response.Write(sink);
+}
+
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   m_new = false;
@@ -558,8 +580,9 @@ void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, in
         m_endBrackets++;
       if (m_beginBrackets > 0 && m_endBrackets > 0 && m_beginBrackets == m_endBrackets)
       {
-        std::string line = CJSONRPC::MethodCall(m_buffer, host, this);
-        Send(line.c_str(), line.size());
+        CJSONResponseStream response(g_advancedSettings.m_jsonOutputCompact);
+        if (CJSONRPC::MethodCall(m_buffer, host, this, response))
+          SendResponse(response);
         m_beginChar = m_beginBrackets = m_endBrackets = 0;
         m_buffer.clear();
       }
@@ -634,6 +657,15 @@ void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
     CTCPClient::Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
 }
 
+void CTCPServer::CWebSocketClient::SendResponse(CJSONResponseStream &response)
+{
+  // every websocket message has to be sent as a single text frame
+  std::string message;
+  CJSONStringSink sink(message);
+  if (response.Write(sink))
+    Send(message.c_str(), message.size());
+}
+
 void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   bool send;
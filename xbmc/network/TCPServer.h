@@ -31,6 +31,8 @@
 
 namespace JSONRPC
 {
+  class CJSONResponseStream;
+
   class CTCPServer : public ITransportLayer, public JSONRPC::IJSONRPCAnnouncer, public CThread
   {
   public:
@@ -67,6 +69,7 @@ namespace JSONRPC
       virtual bool SetAnnouncementFlags(int flags);
 
       virtual void Send(const char *data, unsigned int size);
+      virtual void SendResponse(CJSONResponseStream &response);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
@@ -98,6 +101,7 @@ namespace JSONRPC
       ~CWebSocketClient();
 
       virtual void Send(const char *data, unsigned int size);
+      virtual void SendResponse(CJSONResponseStream &response);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
@@ -337,6 +337,10 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &r
       ret = CreateMemoryDownloadResponse(request.connection, handler->GetHTTPResponseData(), handler->GetHTTPResonseDataLength(), true, true, response);
       break;
 
+    case HTTPStreamDownload:
+      ret = CreateStreamDownloadResponse(request.connection, handler, response);
+      break;
+
     case HTTPError:
       ret = CreateErrorResponse(request.connection, handler->GetHTTPResonseCode(), request.method, response);
       break;
@@ -356,9 +360,13 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &r
   for (multimap<string, string>::const_iterator it = header.begin(); it != header.end(); it++)
     AddHeader(response, it->first.c_str(), it->second.c_str());
 
+  // a streamed response keeps using the handler until it has been sent
+  bool streamed = handler->GetHTTPResponseType() == HTTPStreamDownload;
+
   MHD_queue_response(request.connection, responseCode, response);
   MHD_destroy_response(response);
-  delete handler;
+  if (!streamed)
+    delete handler;
 
   return MHD_YES;
 }
@@ -620,6 +628,22 @@ int CWebServer::CreateMemoryDownloadResponse(struct MHD_Connection *connection,
   return MHD_NO;
 }
 
+int CWebServer::CreateStreamDownloadResponse(struct MHD_Connection *connection, IHTTPRequestHandler *handler, struct MHD_Response *&response)
+{
+  // without a known size the response is sent with chunked transfer encoding
+#ifdef MHD_SIZE_UNKNOWN
+  response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN,
+#else
+  response = MHD_create_response_from_callback(-1,
+#endif
+                                               16384,
+                                               &CWebServer::StreamReaderCallback, handler,
+                                               &CWebServer::StreamReaderFreeCallback);
+  if (response)
+    return MHD_YES;
+  return MHD_NO;
+}
+
 int CWebServer::SendErrorResponse(struct MHD_Connection *connection, int errorType, HTTPMethod method)
 {
   struct MHD_Response *response = NULL;
@@ -738,6 +762,35 @@ void CWebServer::ContentReaderFreeCallback(void *cls)
 #endif
 }
 
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  IHTTPRequestHandler *handler = (IHTTPRequestHandler *)cls;
+  if (handler == NULL || max <= 0)
+    return -1;
+
+  size_t written = handler->ReadHTTPResponseData(buf, (size_t)max);
+  if (written == 0)
+    return -1; // end of stream
+
+#ifdef WEBSERVER_DEBUG
+  CLog::Log(LOGDEBUG, "webserver [OUT] streamed %u bytes at %" PRIu64, (unsigned int)written, (uint64_t)pos);
+#endif
+
+  return written;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  IHTTPRequestHandler *handler = (IHTTPRequestHandler *)cls;
+  delete handler;
+}
+
 struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
 {
   unsigned int timeout = 60 * 60 * 24;
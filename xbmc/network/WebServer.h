@@ -79,6 +79,13 @@ private:
 #else
   static int ContentReaderCallback (void *cls, size_t pos, char *buf, int max);
 #endif
+#if (MHD_VERSION >= 0x00090200)
+  static ssize_t StreamReaderCallback (void *cls, uint64_t pos, char *buf, size_t max);
+#elif (MHD_VERSION >= 0x00040001)
+  static int StreamReaderCallback (void *cls, uint64_t pos, char *buf, int max);
+#else
+  static int StreamReaderCallback (void *cls, size_t pos, char *buf, int max);
+#endif
 
 #if (MHD_VERSION >= 0x00040001)
   static int AnswerToConnection (void *cls, struct MHD_Connection *connection,
@@ -101,10 +108,12 @@ private:
 #endif
   static int HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &request);
   static void ContentReaderFreeCallback (void *cls);
+  static void StreamReaderFreeCallback (void *cls);
   static int CreateRedirect(struct MHD_Connection *connection, const std::string &strURL, struct MHD_Response *&response);
   static int CreateFileDownloadResponse(struct MHD_Connection *connection, const std::string &strURL, HTTPMethod methodType, struct MHD_Response *&response, int &responseCode);
   static int CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response);
   static int CreateMemoryDownloadResponse(struct MHD_Connection *connection, void *data, size_t size, bool free, bool copy, struct MHD_Response *&response);
+  static int CreateStreamDownloadResponse(struct MHD_Connection *connection, IHTTPRequestHandler *handler, struct MHD_Response *&response);
 
   static int SendErrorResponse(struct MHD_Connection *connection, int errorType, HTTPMethod method);
   
@@ -23,6 +23,7 @@
 #include "interfaces/json-rpc/JSONServiceDescription.h"
 #include "interfaces/json-rpc/JSONUtils.h"
 #include "network/WebServer.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/JSONVariantWriter.h"
 #include "utils/log.h"
 
@@ -31,6 +32,11 @@
 using namespace std;
 using namespace JSONRPC;
 
+CHTTPJsonRpcHandler::~CHTTPJsonRpcHandler()
+{
+  delete m_stream;
+}
+
 bool CHTTPJsonRpcHandler::CheckHTTPRequest(const HTTPRequest &request)
 {
   return (request.url.compare("/jsonrpc") == 0);
@@ -69,8 +75,14 @@ int CHTTPJsonRpcHandler::HandleHTTPRequest(const HTTPRequest &request)
     }
   }
 
+  m_responseType = HTTPMemoryDownloadNoFreeCopy;
   if (isRequest)
-    m_response = CJSONRPC::MethodCall(m_request, request.webserver, &client);
+  {
+    // the response is generated while it is being sent to the client
+    m_stream = new CJSONResponseStream(g_advancedSettings.m_jsonOutputCompact);
+    if (CJSONRPC::MethodCall(m_request, request.webserver, &client, *m_stream))
+      m_responseType = HTTPStreamDownload;
+  }
   else
   {
     // get the whole output of JSONRPC.Introspect
@@ -83,7 +95,6 @@ int CHTTPJsonRpcHandler::HandleHTTPRequest(const HTTPRequest &request)
 
   m_request.clear();
   
-  m_responseType = HTTPMemoryDownloadNoFreeCopy;
   m_responseCode = MHD_HTTP_OK;
 
   return MHD_YES;
@@ -106,6 +117,14 @@ bool CHTTPJsonRpcHandler::appendPostData(const char *data, unsigned int size)
   return true;
 }
 
+size_t CHTTPJsonRpcHandler::ReadHTTPResponseData(char *buffer, size_t size)
+{
+  if (m_stream == NULL)
+    return 0;
+
+  return m_stream->Read(buffer, size);
+}
+
 int CHTTPJsonRpcHandler::CHTTPClient::GetPermissionFlags()
 {
   return OPERATION_PERMISSION_ALL;
@@ -22,17 +22,24 @@
 #include "IHTTPRequestHandler.h"
 #include "interfaces/json-rpc/IClient.h"
 
+namespace JSONRPC
+{
+  class CJSONResponseStream;
+}
+
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
 {
 public:
-  CHTTPJsonRpcHandler() { };
-  
+  CHTTPJsonRpcHandler() : m_stream(NULL) { };
+  virtual ~CHTTPJsonRpcHandler();
+
   virtual IHTTPRequestHandler* GetInstance() { return new CHTTPJsonRpcHandler(); }
   virtual bool CheckHTTPRequest(const HTTPRequest &request);
   virtual int HandleHTTPRequest(const HTTPRequest &request);
 
   virtual void* GetHTTPResponseData() const { return (void *)m_response.c_str(); };
   virtual size_t GetHTTPResonseDataLength() const { return m_response.size(); }
+  virtual size_t ReadHTTPResponseData(char *buffer, size_t size);
 
   virtual int GetPriority() const { return 2; }
 
@@ -46,6 +53,7 @@ protected:
 private:
   std::string m_request;
   std::string m_response;
+  JSONRPC::CJSONResponseStream *m_stream;
 
   class CHTTPClient : public JSONRPC::IClient
   {
@@ -50,7 +50,8 @@ enum HTTPResponseType
   HTTPMemoryDownloadNoFreeNoCopy,
   HTTPMemoryDownloadNoFreeCopy,
   HTTPMemoryDownloadFreeNoCopy,
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  HTTPStreamDownload
 };
 
 typedef struct HTTPRequest
@@ -75,6 +76,11 @@ public:
   virtual size_t GetHTTPResonseDataLength() const { return 0; }
   virtual std::string GetHTTPRedirectUrl() const { return ""; }
   virtual std::string GetHTTPResponseFile() const { return ""; }
+  /*!
+   \brief Produce the next part of a HTTPStreamDownload response
+   \return Number of bytes written to buffer, 0 once the response is complete
+   */
+  virtual size_t ReadHTTPResponseData(char *buffer, size_t size) { return 0; }
 
   // The higher the more important
   virtual int GetPriority() const { return 0; }
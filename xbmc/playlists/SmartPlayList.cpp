@@ -665,6 +665,30 @@ std::string CSmartPlaylistRule::GetBooleanQuery(const std::string &negate, const
   return "";
 }
 
+std::string CSmartPlaylistRule::GetSearchQuery(const std::string &param, const CDatabase &db, const std::string &strType) const
+{
+  // only the names which have a search index in the databases
+  std::string table, idField, field;
+  if (strType == "songs" && m_field == FieldTitle)
+  { table = "song"; idField = "idSong"; field = "strTitle"; }
+  else if (strType == "albums" && m_field == FieldAlbum)
+  { table = "album"; idField = "idAlbum"; field = "strAlbum"; }
+  else if (strType == "artists" && m_field == FieldArtist)
+  { table = "artist"; idField = "idArtist"; field = "strArtist"; }
+  else if (strType == "movies" && m_field == FieldTitle)
+  { table = "movie"; idField = "idMovie"; field = StringUtils::Format("c%02d", VIDEODB_ID_TITLE); }
+  else if (strType == "tvshows" && m_field == FieldTitle)
+  { table = "tvshow"; idField = "idShow"; field = StringUtils::Format("c%02d", VIDEODB_ID_TV_TITLE); }
+  else if (strType == "episodes" && m_field == FieldTitle)
+  { table = "episode"; idField = "idEpisode"; field = StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_TITLE); }
+  else if (strType == "musicvideos" && m_field == FieldTitle)
+  { table = "musicvideo"; idField = "idMVideo"; field = StringUtils::Format("c%02d", VIDEODB_ID_MUSICVIDEO_TITLE); }
+  else
+    return "";
+
+  return db.GetSearchCondition(table, idField, field, GetField(FieldId, strType), param);
+}
+
 CDatabaseQueryRule::SEARCH_OPERATOR CSmartPlaylistRule::GetOperator(const std::string &strType) const
 {
   SEARCH_OPERATOR op = CDatabaseQueryRule::GetOperator(strType);
@@ -73,6 +73,9 @@ protected:
   virtual SEARCH_OPERATOR     GetOperator(const std::string &type) const;
   virtual std::string         GetBooleanQuery(const std::string &negate,
                                               const std::string &strType) const;
+  virtual std::string         GetSearchQuery(const std::string &param,
+                                             const CDatabase &db,
+                                             const std::string &strType) const;
 
 private:
   std::string GetVideoResolutionQuery(const std::string &parameter) const;
@@ -76,6 +76,7 @@ void CAdvancedSettings::OnSettingsLoaded()
     CLog::Log(LOGNOTICE, "Disabled debug logging due to GUI setting. Level %d.", m_logLevel);
   }
   CLog::SetLogLevel(m_logLevel);
+  CLog::SetAsynchronous(m_asyncLogging);
 
   m_extraLogEnabled = CSettings::Get().GetBool("debug.extralogging");
   setExtraLogLevel(CSettings::Get().GetList("debug.setextraloglevel"));
@@ -250,6 +251,8 @@ void CAdvancedSettings::Initialize()
   m_fanartRes = 1080;
   m_imageRes = 720;
   m_useDDSFanart = false;
+  m_textureCacheSize = 0;
+  m_scraperHttpCacheSize = 50;
 
   m_sambaclienttimeout = 10;
   m_sambadoscodepage = "";
@@ -266,7 +269,9 @@ void CAdvancedSettings::Initialize()
   m_bMusicLibraryAllItemsOnBottom = false;
   m_bMusicLibraryAlbumsSortByArtistThenYear = false;
   m_bMusicLibraryCleanOnUpdate = false;
+  m_iMusicLibraryTagReaders = 4;
   m_iMusicLibraryRecentlyAddedItems = 25;
+  m_iMusicLibraryPageSize = 0;
   m_strMusicLibraryAlbumFormat = "";
   m_strMusicLibraryAlbumFormatRight = "";
   m_prioritiseAPEv2tags = false;
@@ -276,12 +281,18 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryHideAllItems = false;
   m_bVideoLibraryAllItemsOnBottom = false;
   m_iVideoLibraryRecentlyAddedItems = 25;
+  m_iVideoLibraryPageSize = 0;
   m_bVideoLibraryHideEmptySeries = false;
   m_bVideoLibraryCleanOnUpdate = false;
   m_bVideoLibraryExportAutoThumbs = false;
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
   m_bVideoScannerIgnoreErrors = false;
+  m_iVideoScannerLookupThreads = 4;
+  m_iVideoScannerArtThreads = 2;
+  m_bLibraryMonitorEnabled = true;
+  m_iLibraryMonitorSettleTime = 3000;
+  m_iLibraryMonitorPollInterval = 30;
   m_iVideoLibraryDateAdded = 1; // prefer mtime over ctime and current time
 
   m_iTuxBoxStreamtsPort = 31339;
@@ -373,6 +384,15 @@ void CAdvancedSettings::Initialize()
 
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
+  m_jsonCacheSize = 16384;
+
+  m_jobStatisticsLogInterval = 0;
+
+  m_databaseWAL = true;
+  m_databaseProfiling = false;
+  m_databaseSlowQueryTime = 100;
+  m_databaseProfileStatements = 50;
+  m_databaseProfileLogInterval = 0;
 
   m_enableMultimediaKeys = false;
 
@@ -403,6 +423,7 @@ void CAdvancedSettings::Initialize()
   m_logLevelHint = m_logLevel = LOG_LEVEL_NORMAL;
   m_extraLogEnabled = false;
   m_extraLogLevels = 0;
+  m_asyncLogging = false;
 
   #if defined(TARGET_DARWIN)
     std::string logDir = getenv("HOME");
@@ -742,10 +763,12 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   {
     XMLUtils::GetBoolean(pElement, "hideallitems", m_bMusicLibraryHideAllItems);
     XMLUtils::GetInt(pElement, "recentlyaddeditems", m_iMusicLibraryRecentlyAddedItems, 1, INT_MAX);
+    XMLUtils::GetInt(pElement, "pagesize", m_iMusicLibraryPageSize, 0, INT_MAX);
     XMLUtils::GetBoolean(pElement, "prioritiseapetags", m_prioritiseAPEv2tags);
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bMusicLibraryAllItemsOnBottom);
     XMLUtils::GetBoolean(pElement, "albumssortbyartistthenyear", m_bMusicLibraryAlbumsSortByArtistThenYear);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bMusicLibraryCleanOnUpdate);
+    XMLUtils::GetInt(pElement, "tagreaders", m_iMusicLibraryTagReaders, 1, 16);
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "albumformatright", m_strMusicLibraryAlbumFormatRight);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
@@ -757,6 +780,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "hideallitems", m_bVideoLibraryHideAllItems);
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bVideoLibraryAllItemsOnBottom);
     XMLUtils::GetInt(pElement, "recentlyaddeditems", m_iVideoLibraryRecentlyAddedItems, 1, INT_MAX);
+    XMLUtils::GetInt(pElement, "pagesize", m_iVideoLibraryPageSize, 0, INT_MAX);
     XMLUtils::GetBoolean(pElement, "hideemptyseries", m_bVideoLibraryHideEmptySeries);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bVideoLibraryCleanOnUpdate);
     XMLUtils::GetString(pElement, "itemseparator", m_videoItemSeparator);
@@ -770,6 +794,16 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "ignoreerrors", m_bVideoScannerIgnoreErrors);
+    XMLUtils::GetInt(pElement, "lookupthreads", m_iVideoScannerLookupThreads, 1, 16);
+    XMLUtils::GetInt(pElement, "artthreads", m_iVideoScannerArtThreads, 1, 16);
+  }
+
+  pElement = pRootElement->FirstChildElement("librarymonitor");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "enabled", m_bLibraryMonitorEnabled);
+    XMLUtils::GetInt(pElement, "settletime", m_iLibraryMonitorSettleTime, 0, 60000);
+    XMLUtils::GetInt(pElement, "pollinterval", m_iLibraryMonitorPollInterval, 1, 1440);
   }
 
   // Backward-compatibility of ExternalPlayer config
@@ -803,6 +837,20 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   {
     XMLUtils::GetBoolean(pElement, "compactoutput", m_jsonOutputCompact);
     XMLUtils::GetUInt(pElement, "tcpport", m_jsonTcpPort);
+    XMLUtils::GetUInt(pElement, "cachesize", m_jsonCacheSize);
+  }
+
+  pElement = pRootElement->FirstChildElement("jobmanager");
+  if (pElement)
+    XMLUtils::GetUInt(pElement, "statisticsloginterval", m_jobStatisticsLogInterval);
+
+  pElement = pRootElement->FirstChildElement("databaseprofiling");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "enabled", m_databaseProfiling);
+    XMLUtils::GetUInt(pElement, "slowquerytime", m_databaseSlowQueryTime);
+    XMLUtils::GetUInt(pElement, "statements", m_databaseProfileStatements);
+    XMLUtils::GetUInt(pElement, "loginterval", m_databaseProfileLogInterval);
   }
 
   pElement = pRootElement->FirstChildElement("samba");
@@ -841,6 +889,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     g_advancedSettings.m_logLevel = std::max(g_advancedSettings.m_logLevel, g_advancedSettings.m_logLevelHint);
     CLog::SetLogLevel(g_advancedSettings.m_logLevel);
   }
+  XMLUtils::GetBoolean(pRootElement, "asynclogging", m_asyncLogging);
 
   XMLUtils::GetString(pRootElement, "cddbaddress", m_cddbAddress);
 
@@ -1034,6 +1083,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
 #if !defined(TARGET_RASPBERRY_PI)
   XMLUtils::GetBoolean(pRootElement, "useddsfanart", m_useDDSFanart);
 #endif
+  XMLUtils::GetUInt(pRootElement, "texturecachesize", m_textureCacheSize);
+  XMLUtils::GetUInt(pRootElement, "scraperhttpcachesize", m_scraperHttpCacheSize);
   XMLUtils::GetBoolean(pRootElement, "playlistasfolders", m_playlistAsFolders);
   XMLUtils::GetBoolean(pRootElement, "detectasudf", m_detectAsUdf);
 
@@ -1060,6 +1111,23 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     }
   }
 
+  // paths whose folder mtimes change whenever anything below them does
+  TiXmlElement* propagated = pRootElement->FirstChildElement("propagatedmtimes");
+  if (propagated)
+  {
+    TiXmlNode* path = propagated->FirstChild("path");
+    while (path)
+    {
+      if (path->FirstChild())
+      {
+        std::string strPath = path->FirstChild()->ValueStr();
+        URIUtils::AddSlashAtEnd(strPath);
+        m_propagatedMTimePaths.push_back(strPath);
+      }
+      path = path->NextSibling("path");
+    }
+  }
+
   TiXmlElement* pHostEntries = pRootElement->FirstChildElement("hosts");
   if (pHostEntries)
   {
@@ -1096,6 +1164,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   }
 
   XMLUtils::GetBoolean(pRootElement, "measurerefreshrate", m_measureRefreshrate);
+  XMLUtils::GetBoolean(pRootElement, "sqlitewal", m_databaseWAL);
 
   TiXmlElement* pDatabase = pRootElement->FirstChildElement("videodatabase");
   if (pDatabase)
@@ -210,6 +210,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_logLevelHint;
     bool m_extraLogEnabled;
     int m_extraLogLevels;
+    bool m_asyncLogging;
     std::string m_cddbAddress;
 
     //airtunes + airplay
@@ -248,6 +249,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
      */
     unsigned int GetThumbSize() const { return m_imageRes / 2; };
     bool m_useDDSFanart;
+    unsigned int m_textureCacheSize; ///< \brief the disk space in MB the cached images may take, 0 for no limit
+    unsigned int m_scraperHttpCacheSize; ///< \brief the disk space in MB the pages fetched by scrapers may take, 0 to not cache them
 
     int m_sambaclienttimeout;
     std::string m_sambadoscodepage;
@@ -262,9 +265,11 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
 
     bool m_bMusicLibraryHideAllItems;
     int m_iMusicLibraryRecentlyAddedItems;
+    int m_iMusicLibraryPageSize; ///< \brief number of items per page of the title listings, 0 to list all items
     bool m_bMusicLibraryAllItemsOnBottom;
     bool m_bMusicLibraryAlbumsSortByArtistThenYear;
     bool m_bMusicLibraryCleanOnUpdate;
+    int m_iMusicLibraryTagReaders;
     std::string m_strMusicLibraryAlbumFormat;
     std::string m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
@@ -275,6 +280,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bVideoLibraryHideAllItems;
     bool m_bVideoLibraryAllItemsOnBottom;
     int m_iVideoLibraryRecentlyAddedItems;
+    int m_iVideoLibraryPageSize; ///< \brief number of items per page of the title listings, 0 to list all items
     bool m_bVideoLibraryHideEmptySeries;
     bool m_bVideoLibraryCleanOnUpdate;
     bool m_bVideoLibraryExportAutoThumbs;
@@ -282,6 +288,12 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bVideoLibraryImportResumePoint;
 
     bool m_bVideoScannerIgnoreErrors;
+    int m_iVideoScannerLookupThreads;
+    int m_iVideoScannerArtThreads;
+    bool m_bLibraryMonitorEnabled;
+    int m_iLibraryMonitorSettleTime;
+    int m_iLibraryMonitorPollInterval;
+    std::vector<std::string> m_propagatedMTimePaths;
     int m_iVideoLibraryDateAdded;
 
     std::vector<std::string> m_vecTokens; // cleaning strings tied to language
@@ -384,6 +396,15 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
+    unsigned int m_jsonCacheSize; // KB of memory for cached library responses, 0 to disable
+
+    unsigned int m_jobStatisticsLogInterval; // seconds, 0 to disable
+
+    bool m_databaseWAL; // use WAL journaling for SQLite databases not on a network file system
+    bool m_databaseProfiling;
+    unsigned int m_databaseSlowQueryTime;      // milliseconds, the plans of slower statements are logged
+    unsigned int m_databaseProfileStatements;  // number of statements kept by the profiler
+    unsigned int m_databaseProfileLogInterval; // seconds, 0 to disable
 
     bool m_enableMultimediaKeys;
     std::vector<std::string> m_settingsFiles;
@@ -0,0 +1,230 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifdef HAVE_INOTIFY
+#include "LibraryMonitor.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+  class CTestLibraryMonitor : public CLibraryMonitor
+  {
+  public:
+    CTestLibraryMonitor(const std::string &root, bool shows) : m_root(root), m_shows(shows) {}
+
+    ~CTestLibraryMonitor()
+    {
+      StopThread();
+    }
+
+    // waits until the sources are watched
+    bool Started()
+    {
+      return m_started.WaitMSec(5000);
+    }
+
+    // waits for the scans or removals queued so far to be handed out
+    void WaitFor(unsigned int scans, unsigned int removals)
+    {
+      XbmcThreads::EndTime timeout(10000);
+      while (!timeout.IsTimePast())
+      {
+        {
+          CSingleLock lock(m_section);
+          if (m_scans.size() >= scans && m_removals.size() >= removals)
+            break;
+        }
+        XbmcThreads::ThreadSleep(50);
+      }
+      // and for anything that shouldn't have come
+      XbmcThreads::ThreadSleep(2 * g_advancedSettings.m_iLibraryMonitorSettleTime);
+    }
+
+    std::vector<std::string> m_scans;
+    std::vector<std::string> m_removals;
+
+  protected:
+    virtual void GetSources(std::vector<CSource> &sources)
+    {
+      sources.push_back(CSource(VIDEO, m_root, m_shows));
+    }
+
+    virtual bool IsScanning(LIBRARY library)
+    {
+      m_started.Set();
+      return false;
+    }
+
+    virtual void Scan(LIBRARY library, const std::string &path)
+    {
+      CSingleLock lock(m_section);
+      m_scans.push_back(path);
+    }
+
+    virtual void Remove(LIBRARY library, const std::string &path)
+    {
+      CSingleLock lock(m_section);
+      m_removals.push_back(path);
+    }
+
+  private:
+    std::string m_root;
+    bool m_shows;
+    CEvent m_started;
+    CCriticalSection m_section;
+  };
+
+  bool WriteFile(const std::string &path)
+  {
+    XFILE::CFile file;
+    if (!file.OpenForWrite(path, true))
+      return false;
+    bool written = file.Write("xbmc", 4) == 4;
+    file.Close();
+    return written;
+  }
+}
+
+class TestLibraryMonitor : public testing::Test
+{
+protected:
+  TestLibraryMonitor()
+    : m_enabled(g_advancedSettings.m_bLibraryMonitorEnabled),
+      m_settleTime(g_advancedSettings.m_iLibraryMonitorSettleTime)
+  {
+    g_advancedSettings.m_bLibraryMonitorEnabled = true;
+    g_advancedSettings.m_iLibraryMonitorSettleTime = 250;
+
+    m_file = XBMC_CREATETEMPFILE("");
+    if (m_file != NULL)
+    {
+      m_file->Close();
+      m_root = URIUtils::AddFileToFolder(CXBMCTestUtils::Instance().TempFileDirectory(m_file), "TestLibraryMonitor/");
+      XFILE::CDirectory::Create(m_root);
+    }
+  }
+
+  ~TestLibraryMonitor()
+  {
+    g_advancedSettings.m_bLibraryMonitorEnabled = m_enabled;
+    g_advancedSettings.m_iLibraryMonitorSettleTime = m_settleTime;
+
+    for (std::vector<std::string>::reverse_iterator it = m_created.rbegin(); it != m_created.rend(); ++it)
+    {
+      if (URIUtils::HasSlashAtEnd(*it))
+        XFILE::CDirectory::Remove(*it);
+      else
+        XFILE::CFile::Delete(*it);
+    }
+    if (!m_root.empty())
+      XFILE::CDirectory::Remove(m_root);
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  std::string Create(const std::string &path)
+  {
+    std::string created = URIUtils::AddFileToFolder(m_root, path);
+    if (URIUtils::HasSlashAtEnd(created))
+      EXPECT_TRUE(XFILE::CDirectory::Create(created));
+    else
+      EXPECT_TRUE(WriteFile(created));
+    m_created.push_back(created);
+    return created;
+  }
+
+  bool m_enabled;
+  int m_settleTime;
+  XFILE::CFile *m_file;
+  std::string m_root;
+  std::vector<std::string> m_created;
+};
+
+TEST_F(TestLibraryMonitor, Scan)
+{
+  ASSERT_TRUE(m_file != NULL);
+  Create("Movies/");
+
+  CTestLibraryMonitor monitor(m_root, false);
+  monitor.Start();
+  ASSERT_TRUE(monitor.Started());
+
+  // a new folder and what's copied into it make a single scan
+  std::string folder = Create("Movies/Movie (2014)/");
+  Create("Movies/Movie (2014)/Movie (2014).mkv");
+  Create("Movies/Movie (2014)/Movie (2014).nfo");
+  monitor.WaitFor(1, 0);
+  ASSERT_EQ(1U, monitor.m_scans.size());
+  EXPECT_STREQ(folder.c_str(), monitor.m_scans[0].c_str());
+  EXPECT_TRUE(monitor.m_removals.empty());
+
+  // and the new folder is watched from then on
+  Create("Movies/Movie (2014)/extras.mkv");
+  monitor.WaitFor(2, 0);
+  ASSERT_EQ(2U, monitor.m_scans.size());
+  EXPECT_STREQ(folder.c_str(), monitor.m_scans[1].c_str());
+}
+
+TEST_F(TestLibraryMonitor, Remove)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = Create("Movie/");
+  std::string movie = Create("Movie/Movie.mkv");
+
+  CTestLibraryMonitor monitor(m_root, false);
+  monitor.Start();
+  ASSERT_TRUE(monitor.Started());
+
+  EXPECT_TRUE(XFILE::CFile::Delete(movie));
+  monitor.WaitFor(0, 1);
+  ASSERT_EQ(1U, monitor.m_removals.size());
+  EXPECT_STREQ(folder.c_str(), monitor.m_removals[0].c_str());
+  EXPECT_TRUE(monitor.m_scans.empty());
+}
+
+TEST_F(TestLibraryMonitor, Shows)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string show = Create("Show/");
+  Create("Show/Season 1/");
+
+  CTestLibraryMonitor monitor(m_root, true);
+  monitor.Start();
+  ASSERT_TRUE(monitor.Started());
+
+  // episodes are scanned from their show's folder, files next to the shows are ignored
+  Create("Show/Season 1/Show S01E01.mkv");
+  Create("Show/Season 1/Show S01E02.mkv");
+  Create("readme.txt");
+  monitor.WaitFor(1, 0);
+  ASSERT_EQ(1U, monitor.m_scans.size());
+  EXPECT_STREQ(show.c_str(), monitor.m_scans[0].c_str());
+}
+#endif
@@ -0,0 +1,217 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TextureCacheJob.h"
+#include "TextureDatabase.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "utils/JobManager.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+  // every texture takes 1000 bytes, every other one has a .dds version of 500 bytes
+  const int Textures = 20;
+  const uint64_t TextureSize = 1000;
+  const uint64_t DDSSize = 500;
+  const uint64_t CacheSize = Textures * TextureSize + Textures / 2 * DDSSize;
+
+  class CTestTextureDatabase : public CTextureDatabase
+  {
+  public:
+    bool Create(const std::string &folder, const std::string &name)
+    {
+      DatabaseSettings settings;
+      settings.type = "sqlite3";
+      settings.host = folder;
+      settings.name = name;
+      return Update(settings);
+    }
+
+    std::string GetFile() const
+    {
+      return URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+    }
+  };
+
+  std::string MakeURL(int i)
+  {
+    return StringUtils::Format("/media/Movies/Movie %d/poster.jpg", i);
+  }
+
+  std::string MakeFile(int i)
+  {
+    return StringUtils::Format("%08x.jpg", i);
+  }
+
+  bool WriteFile(const std::string &path, uint64_t size)
+  {
+    std::string content((size_t)size, 'x');
+    XFILE::CFile file;
+    return file.OpenForWrite(path, true) && file.Write(content.c_str(), content.size()) == (int)content.size();
+  }
+}
+
+class TestTextureCacheJob : public testing::Test
+{
+protected:
+  TestTextureCacheJob()
+  {
+    m_file = XBMC_CREATETEMPFILE(".db");
+    if (m_file != NULL)
+    {
+      m_file->Close();
+      m_folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+      m_cacheFolder = URIUtils::AddFileToFolder(m_folder, "TestTextureCacheJob/");
+    }
+  }
+
+  ~TestTextureCacheJob()
+  {
+    if (!m_cacheFolder.empty())
+    {
+      for (int i = 0; i < Textures; i++)
+      {
+        XFILE::CFile::Delete(GetPath(i));
+        XFILE::CFile::Delete(URIUtils::ReplaceExtension(GetPath(i), ".dds"));
+      }
+      XFILE::CDirectory::Remove(m_cacheFolder);
+    }
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  // caches the textures, the ones added first are the first to be evicted
+  void Fill(CTestTextureDatabase &db)
+  {
+    ASSERT_TRUE(XFILE::CDirectory::Create(m_cacheFolder));
+    for (int i = 0; i < Textures; i++)
+    {
+      CTextureDetails details;
+      details.file = MakeFile(i);
+      details.width = 1000;
+      details.height = 1500;
+      ASSERT_TRUE(db.AddCachedTexture(MakeURL(i), details));
+      ASSERT_TRUE(WriteFile(GetPath(i), TextureSize));
+      if (i % 2 == 0)
+        ASSERT_TRUE(WriteFile(URIUtils::ReplaceExtension(GetPath(i), ".dds"), DDSSize));
+    }
+  }
+
+  std::string GetPath(int i) const
+  {
+    return URIUtils::AddFileToFolder(m_cacheFolder, MakeFile(i));
+  }
+
+  XFILE::CFile *m_file;
+  std::string m_folder;
+  std::string m_cacheFolder;
+};
+
+TEST_F(TestTextureCacheJob, Cleanup)
+{
+  ASSERT_TRUE(m_file != NULL);
+
+  CTestTextureDatabase cache;
+  ASSERT_TRUE(cache.Create(m_folder, "TestTexturesCleanup"));
+  Fill(cache);
+
+  // the job uses a connection of its own, the lookups of the cache have to see its evictions
+  CTextureDetails details;
+  ASSERT_TRUE(cache.GetCachedTexture(MakeURL(0), details));
+  CTestTextureDatabase db;
+  ASSERT_TRUE(db.Create(m_folder, "TestTexturesCleanup"));
+
+  const uint64_t budget = CacheSize - 5000;
+  CTextureCleanupJob job(budget);
+  ASSERT_TRUE(job.Cleanup(db, m_cacheFolder));
+  EXPECT_EQ(CacheSize, job.m_size);
+
+  // evicted down to 90% of the budget, but not further
+  EXPECT_LE(job.m_size - job.m_reclaimed, budget / 10 * 9);
+  EXPECT_GT(job.m_size - job.m_reclaimed + TextureSize + DDSSize, budget / 10 * 9);
+
+  // the bytes accounted for are those of the files deleted and their .dds versions
+  uint64_t deleted = 0;
+  unsigned int evicted = 0;
+  for (int i = 0; i < Textures; i++)
+  {
+    bool exists = XFILE::CFile::Exists(GetPath(i));
+    bool ddsExists = XFILE::CFile::Exists(URIUtils::ReplaceExtension(GetPath(i), ".dds"));
+    if (!exists)
+    {
+      deleted += TextureSize + (i % 2 == 0 ? DDSSize : 0);
+      evicted++;
+      EXPECT_FALSE(ddsExists) << i;
+    }
+    else
+      EXPECT_EQ(i % 2 == 0, ddsExists) << i;
+
+    // and the textures evicted are gone from the index
+    EXPECT_EQ(exists, cache.GetCachedTexture(MakeURL(i), details)) << i;
+  }
+  EXPECT_EQ(job.m_reclaimed, deleted);
+  EXPECT_EQ(job.m_evicted, evicted);
+  EXPECT_LT(0U, evicted);
+
+  std::vector<CTextureUsage> textures;
+  ASSERT_TRUE(db.GetTexturesByUsage(textures));
+  EXPECT_EQ(Textures - evicted, textures.size());
+
+  std::string file = db.GetFile();
+  db.Close();
+  cache.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestTextureCacheJob, Paused)
+{
+  ASSERT_TRUE(m_file != NULL);
+
+  CTestTextureDatabase db;
+  ASSERT_TRUE(db.Create(m_folder, "TestTexturesCleanupPaused"));
+  Fill(db);
+
+  // nothing is evicted during playback
+  CJobManager::GetInstance().PauseJobs();
+  CTextureCleanupJob job(CacheSize / 2);
+  bool cleaned = job.Cleanup(db, m_cacheFolder);
+  CJobManager::GetInstance().UnPauseJobs();
+
+  EXPECT_TRUE(cleaned);
+  EXPECT_EQ(CacheSize, job.m_size);
+  EXPECT_EQ(0U, job.m_evicted);
+  EXPECT_EQ(0U, job.m_reclaimed);
+  for (int i = 0; i < Textures; i++)
+  {
+    CTextureDetails details;
+    EXPECT_TRUE(XFILE::CFile::Exists(GetPath(i))) << i;
+    EXPECT_TRUE(db.GetCachedTexture(MakeURL(i), details)) << i;
+  }
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
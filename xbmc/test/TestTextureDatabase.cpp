@@ -0,0 +1,266 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TextureDatabase.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+#include <iostream>
+
+namespace
+{
+  const int Textures = 5000;
+
+  class CTestTextureDatabase : public CTextureDatabase
+  {
+  public:
+    bool Create(const std::string &folder, const std::string &name)
+    {
+      DatabaseSettings settings;
+      settings.type = "sqlite3";
+      settings.host = folder;
+      settings.name = name;
+      return Update(settings);
+    }
+
+    std::string GetFile() const
+    {
+      return URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+    }
+
+    void Exec(const std::string &sql)
+    {
+      m_pDS->exec(sql);
+    }
+
+    // looks up the texture the way it was done before the index
+    bool QueryCachedTexture(const std::string &url, CTextureDetails &details)
+    {
+      m_pDS->query("SELECT id, cachedurl, lasthashcheck, imagehash, width, height FROM texture JOIN sizes ON (texture.id=sizes.idtexture AND sizes.size=1) WHERE url=?", Parameters(url));
+      bool found = !m_pDS->eof();
+      if (found)
+      {
+        details.id = m_pDS->fv(0).get_asInt();
+        details.file = m_pDS->fv(1).get_asString();
+      }
+      m_pDS->close();
+      return found;
+    }
+  };
+
+  CTextureDetails MakeDetails(int i)
+  {
+    CTextureDetails details;
+    details.file = StringUtils::Format("%x/%08x.jpg", i % 16, i);
+    details.hash = StringUtils::Format("d%i", i);
+    details.width = 1000;
+    details.height = 1500;
+    details.updateable = true;
+    return details;
+  }
+
+  std::string MakeURL(int i)
+  {
+    return StringUtils::Format("/media/Movies/Movie %d/poster.jpg", i);
+  }
+}
+
+class TestTextureDatabase : public testing::Test
+{
+protected:
+  TestTextureDatabase()
+  {
+    m_file = XBMC_CREATETEMPFILE(".db");
+    if (m_file != NULL)
+      m_file->Close();
+  }
+
+  ~TestTextureDatabase()
+  {
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  XFILE::CFile *m_file;
+};
+
+TEST_F(TestTextureDatabase, Index)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestTextureDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestTexturesIndex"));
+  for (int i = 0; i < 10; i++)
+    EXPECT_TRUE(db.AddCachedTexture(MakeURL(i), MakeDetails(i)));
+
+  CTextureDetails details;
+  ASSERT_TRUE(db.GetCachedTexture(MakeURL(3), details));
+  EXPECT_STREQ(MakeDetails(3).file.c_str(), details.file.c_str());
+  EXPECT_EQ(1500U, details.height);
+  // checked for updates less than a day ago
+  EXPECT_TRUE(details.hash.empty());
+  EXPECT_FALSE(db.GetCachedTexture(MakeURL(10), details));
+
+  // lookups are answered from memory once the index is loaded
+  db.Exec("DELETE FROM texture");
+  EXPECT_TRUE(db.GetCachedTexture(MakeURL(5), details));
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestTextureDatabase, Coherence)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestTextureDatabase cache;
+  ASSERT_TRUE(cache.Create(folder, "TestTexturesCoherence"));
+  CTestTextureDatabase other;
+  ASSERT_TRUE(other.Create(folder, "TestTexturesCoherence"));
+
+  CTextureDetails details;
+  EXPECT_FALSE(cache.GetCachedTexture(MakeURL(1), details));
+
+  // writes through any connection are seen by the lookups
+  EXPECT_TRUE(other.AddCachedTexture(MakeURL(1), MakeDetails(1)));
+  ASSERT_TRUE(cache.GetCachedTexture(MakeURL(1), details));
+  EXPECT_TRUE(details.hash.empty());
+  int id = details.id;
+
+  EXPECT_TRUE(other.InvalidateCachedTexture(MakeURL(1)));
+  ASSERT_TRUE(cache.GetCachedTexture(MakeURL(1), details));
+  EXPECT_STREQ(MakeDetails(1).hash.c_str(), details.hash.c_str());
+
+  CTextureDetails valid;
+  EXPECT_TRUE(other.SetCachedTextureValid(MakeURL(1), true));
+  ASSERT_TRUE(cache.GetCachedTexture(MakeURL(1), valid));
+  EXPECT_TRUE(valid.hash.empty());
+
+  std::string cacheFile;
+  EXPECT_TRUE(other.ClearCachedTexture(id, cacheFile));
+  EXPECT_STREQ(MakeDetails(1).file.c_str(), cacheFile.c_str());
+  EXPECT_FALSE(cache.GetCachedTexture(MakeURL(1), details));
+
+  std::string file = cache.GetFile();
+  cache.Close();
+  other.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestTextureDatabase, LoadFailure)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestTextureDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestTexturesLoadFailure"));
+  for (int i = 0; i < 10; i++)
+    EXPECT_TRUE(db.AddCachedTexture(MakeURL(i), MakeDetails(i)));
+
+  // the index can't be loaded
+  db.Exec("ALTER TABLE sizes RENAME TO sizes_moved");
+  CTextureDetails details;
+  EXPECT_FALSE(db.GetCachedTexture(MakeURL(1), details));
+
+  // and isn't tried again right away, lookups are answered by the database meanwhile
+  db.Exec("ALTER TABLE sizes_moved RENAME TO sizes");
+  ASSERT_TRUE(db.GetCachedTexture(MakeURL(1), details));
+  EXPECT_STREQ(MakeDetails(1).file.c_str(), details.file.c_str());
+  db.Exec("DELETE FROM texture");
+  EXPECT_FALSE(db.GetCachedTexture(MakeURL(2), details));
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestTextureDatabase, Benchmark)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestTextureDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestTexturesBenchmark"));
+  db.BeginTransaction();
+  for (int i = 0; i < Textures; i++)
+    db.AddCachedTexture(MakeURL(i), MakeDetails(i));
+  db.CommitTransaction();
+
+  CTextureDetails details;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < Textures; i++)
+    EXPECT_TRUE(db.QueryCachedTexture(MakeURL(i), details));
+  unsigned int queried = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < Textures; i++)
+    EXPECT_TRUE(db.GetCachedTexture(MakeURL(i), details));
+  unsigned int indexed = XbmcThreads::SystemClockMillis() - start;
+
+  std::cout << Textures << " textures looked up in " << queried << " ms from the database and "
+            << indexed << " ms from the index (including loading it)" << std::endl;
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestTextureDatabase, Usage)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestTextureDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestTexturesUsage"));
+  for (int i = 0; i < 4; i++)
+    EXPECT_TRUE(db.AddCachedTexture(MakeURL(i), MakeDetails(i)));
+
+  // textures used often and recently are the last to go
+  CTextureDetails details;
+  ASSERT_TRUE(db.GetCachedTexture(MakeURL(2), details));
+  for (int i = 0; i < 3; i++)
+    db.IncrementUseCount(details);
+  ASSERT_TRUE(db.GetCachedTexture(MakeURL(0), details));
+  db.IncrementUseCount(details);
+  // and those never used go first
+  ASSERT_TRUE(db.GetCachedTexture(MakeURL(1), details));
+  db.Exec(StringUtils::Format("UPDATE sizes SET lastusetime=NULL WHERE idtexture=%i", details.id));
+
+  std::vector<CTextureUsage> textures;
+  ASSERT_TRUE(db.GetTexturesByUsage(textures));
+  ASSERT_EQ(4U, textures.size());
+  EXPECT_STREQ(MakeDetails(1).file.c_str(), textures[0].file.c_str());
+  EXPECT_STREQ(MakeDetails(3).file.c_str(), textures[1].file.c_str());
+  EXPECT_STREQ(MakeDetails(0).file.c_str(), textures[2].file.c_str());
+  EXPECT_STREQ(MakeDetails(2).file.c_str(), textures[3].file.c_str());
+  EXPECT_LE(textures[0].score, textures[3].score);
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
@@ -205,7 +205,7 @@ long AtomicIncrement(volatile long* pAddr)
     "lock/xaddq %q0, %1"
     : "=r" (result), "=m" (*pAddr)
     : "0" ((long) (1)), "m" (*pAddr));
-  return *pAddr;
+  return result + 1; // xadd leaves the previous value in result
 
 #else // Linux / OSX86 (GCC)
   register long reg __asm__ ("eax") = 1;
@@ -283,7 +283,7 @@ long AtomicAdd(volatile long* pAddr, long amount)
     "lock/xaddq %q0, %1"
     : "=r" (result), "=m" (*pAddr)
     : "0" ((long) (amount)), "m" (*pAddr));
-  return *pAddr;
+  return result + amount;
 
 #else // Linux / OSX86 (GCC)
   register long reg __asm__ ("eax") = amount;
@@ -361,7 +361,7 @@ long AtomicDecrement(volatile long* pAddr)
     "lock/xaddq %q0, %1"
     : "=r" (result), "=m" (*pAddr)
     : "0" ((long) (-1)), "m" (*pAddr));
-  return *pAddr;
+  return result - 1;
 
 #else // Linux / OSX86 (GCC)
   register long reg __asm__ ("eax") = -1;
@@ -440,7 +440,7 @@ long AtomicSubtract(volatile long* pAddr, long amount)
     "lock/xaddq %q0, %1"
     : "=r" (result), "=m" (*pAddr)
     : "0" ((long) (-1 * amount)), "m" (*pAddr));
-  return *pAddr;
+  return result - amount;
 
 #else // Linux / OSX86 (GCC)
   register long reg __asm__ ("eax") = -1 * amount;
@@ -27,12 +27,15 @@ namespace XbmcThreads
   /**
    * A thin wrapper around pthreads thread specific storage
    * functionality.
+   *
+   * If a cleanup function is given it's called with a thread's
+   * (non NULL) value when that thread exits.
    */
   template <typename T> class ThreadLocal
   {
     pthread_key_t key;
   public:
-    inline ThreadLocal() : key(0) { pthread_key_create(&key,NULL); }
+    inline ThreadLocal(void (*cleanup)(T*) = NULL) : key(0) { pthread_key_create(&key,(void (*)(void*))cleanup); }
 
     inline ~ThreadLocal() { pthread_key_delete(key); }
 
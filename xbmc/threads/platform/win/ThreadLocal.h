@@ -28,30 +28,77 @@ namespace XbmcThreads
   /**
    * A thin wrapper around windows thread specific storage
    * functionality.
+   *
+   * If a cleanup function is given it's called with a thread's
+   * (non NULL) value when that thread exits. The value is then kept in
+   * fiber local storage, which unlike thread local storage has a callback.
    */
   template <typename T> class ThreadLocal
   {
+    struct Entry
+    {
+      T* val;
+      void (*cleanup)(T*);
+    };
+
+    static void WINAPI Release(PVOID data)
+    {
+      Entry* entry = (Entry*)data;
+      if (entry && entry->val)
+        entry->cleanup(entry->val);
+      delete entry;
+    }
+
     DWORD key;
+    void (*cleanup)(T*);
   public:
-    inline ThreadLocal()
+    inline ThreadLocal(void (*cleanupFunc)(T*) = NULL) : cleanup(cleanupFunc)
     {
-       if ((key = TlsAlloc()) == TLS_OUT_OF_INDEXES)
+       if (cleanup)
+       {
+          if ((key = FlsAlloc(Release)) == FLS_OUT_OF_INDEXES)
+             throw XbmcCommons::UncheckedException("Ran out of Windows FLS Indexes. Windows Error Code %d",(int)GetLastError());
+       }
+       else if ((key = TlsAlloc()) == TLS_OUT_OF_INDEXES)
           throw XbmcCommons::UncheckedException("Ran out of Windows TLS Indexes. Windows Error Code %d",(int)GetLastError());
     }
 
     inline ~ThreadLocal() 
     {
-       if (!TlsFree(key))
+       if (!(cleanup ? FlsFree(key) : TlsFree(key)))
           throw XbmcCommons::UncheckedException("Failed to free Tls %d, Windows Error Code %d",(int)key, (int)GetLastError());
     }
 
     inline void set(T* val)
     {
-       if (!TlsSetValue(key,(LPVOID)val))
+       if (cleanup)
+       {
+          Entry* entry = (Entry*)FlsGetValue(key);
+          if (!entry)
+          {
+             entry = new Entry;
+             entry->cleanup = cleanup;
+             if (!FlsSetValue(key,(LPVOID)entry))
+             {
+                delete entry;
+                throw XbmcCommons::UncheckedException("Failed to set Fls %d, Windows Error Code %d",(int)key, (int)GetLastError());
+             }
+          }
+          entry->val = val;
+       }
+       else if (!TlsSetValue(key,(LPVOID)val))
           throw XbmcCommons::UncheckedException("Failed to set Tls %d, Windows Error Code %d",(int)key, (int)GetLastError());
     }
 
-    inline T* get() { return (T*)TlsGetValue(key); }
+    inline T* get()
+    {
+       if (cleanup)
+       {
+          Entry* entry = (Entry*)FlsGetValue(key);
+          return entry ? entry->val : NULL;
+       }
+       return (T*)TlsGetValue(key);
+    }
   };
 }
 
@@ -352,7 +352,7 @@ bool DatabaseUtils::GetFieldValue(const dbiplus::field_value &fieldValue, CVaria
   return false;
 }
 
-bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results)
+bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results, int firstColumn /* = -1 */)
 {
   if (dataset->num_rows() == 0)
     return true;
@@ -378,7 +378,7 @@ bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldLi
   std::vector<int> fieldIndexLookup;
   fieldIndexLookup.reserve(fields.size());
   for (FieldList::const_iterator it = fields.begin(); it != fields.end(); ++it)
-    fieldIndexLookup.push_back(GetFieldIndex(*it, mediaType));
+    fieldIndexLookup.push_back(firstColumn < 0 ? GetFieldIndex(*it, mediaType) : firstColumn + (int)fieldIndexLookup.size());
 
   results.reserve(resultSet.records.size() + offset);
   for (unsigned int index = 0; index < resultSet.records.size(); index++)
@@ -0,0 +1,250 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <locale>
+
+#include "JSONStreamWriter.h"
+#include "Variant.h"
+
+namespace
+{
+  // Set locale to classic ("C") to ensure valid JSON numbers
+  class CClassicNumericLocale
+  {
+  public:
+    CClassicNumericLocale()
+    {
+      const char *currentLocale = setlocale(LC_NUMERIC, NULL);
+      if (currentLocale != NULL)
+      {
+        m_backupLocale = currentLocale;
+        setlocale(LC_NUMERIC, "C");
+      }
+    }
+
+    ~CClassicNumericLocale()
+    {
+      // Re-set locale to what it was before using yajl
+      if (!m_backupLocale.empty())
+        setlocale(LC_NUMERIC, m_backupLocale.c_str());
+    }
+
+  private:
+    std::string m_backupLocale;
+  };
+}
+
+CJSONStreamWriter::CJSONStreamWriter(IJSONStreamSink &sink, bool compact, size_t chunkSize /* = DefaultChunkSize */)
+  : m_sink(sink),
+    m_chunkSize(chunkSize),
+    m_failed(false),
+    m_capture(NULL),
+    m_captureComplete(true)
+{
+#if YAJL_MAJOR == 2
+  m_generator = yajl_gen_alloc(NULL);
+  yajl_gen_config(m_generator, yajl_gen_beautify, compact ? 0 : 1);
+  yajl_gen_config(m_generator, yajl_gen_indent_string, "\t");
+#else
+  yajl_gen_config conf = { compact ? 0 : 1, "\t" };
+  m_generator = yajl_gen_alloc(&conf, NULL);
+#endif
+}
+
+CJSONStreamWriter::~CJSONStreamWriter()
+{
+  yajl_gen_clear(m_generator);
+  yajl_gen_free(m_generator);
+}
+
+bool CJSONStreamWriter::StartObject()
+{
+  Uncaptured();
+  return Generated(!m_failed && yajl_gen_status_ok == yajl_gen_map_open(m_generator));
+}
+
+bool CJSONStreamWriter::EndObject()
+{
+  Uncaptured();
+  return Generated(!m_failed && yajl_gen_status_ok == yajl_gen_map_close(m_generator));
+}
+
+bool CJSONStreamWriter::StartArray()
+{
+  Uncaptured();
+  return Generated(!m_failed && yajl_gen_status_ok == yajl_gen_array_open(m_generator));
+}
+
+bool CJSONStreamWriter::EndArray()
+{
+  Uncaptured();
+  return Generated(!m_failed && yajl_gen_status_ok == yajl_gen_array_close(m_generator));
+}
+
+bool CJSONStreamWriter::Key(const std::string &key)
+{
+  Uncaptured();
+#if YAJL_MAJOR == 2
+  return Generated(!m_failed && yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)key.c_str(), (size_t)key.length()));
+#else
+  return Generated(!m_failed && yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)key.c_str(), key.length()));
+#endif
+}
+
+bool CJSONStreamWriter::Value(const CVariant &value)
+{
+  if (m_failed)
+    return false;
+
+  CClassicNumericLocale locale;
+  if (!Generated(InternalValue(value)))
+    return false;
+
+  if (m_capture != NULL)
+    m_capture->push_back(value);
+  return true;
+}
+
+void CJSONStreamWriter::StartCapture(CVariant &values)
+{
+  m_capture = &values;
+  m_captureComplete = true;
+}
+
+bool CJSONStreamWriter::EndCapture()
+{
+  m_capture = NULL;
+  return m_captureComplete;
+}
+
+bool CJSONStreamWriter::Flush()
+{
+  if (m_failed)
+    return false;
+
+  const unsigned char *buffer;
+#if YAJL_MAJOR == 2
+  size_t length;
+#else
+  unsigned int length;
+#endif
+  yajl_gen_get_buf(m_generator, &buffer, &length);
+  if (length == 0)
+    return true;
+
+  if (!m_sink.Write((const char *)buffer, length))
+    m_failed = true;
+
+  // only drops the generated output, the generator keeps its state
+  yajl_gen_clear(m_generator);
+  return !m_failed;
+}
+
+bool CJSONStreamWriter::Generated(bool success)
+{
+  if (!success)
+  {
+    m_failed = true;
+    return false;
+  }
+
+  const unsigned char *buffer;
+#if YAJL_MAJOR == 2
+  size_t length;
+#else
+  unsigned int length;
+#endif
+  yajl_gen_get_buf(m_generator, &buffer, &length);
+  if (length < m_chunkSize)
+    return true;
+
+  return Flush();
+}
+
+bool CJSONStreamWriter::InternalValue(const CVariant &value)
+{
+  bool success = false;
+
+  switch (value.type())
+  {
+  case CVariant::VariantTypeInteger:
+#if YAJL_MAJOR == 2
+    success = yajl_gen_status_ok == yajl_gen_integer(m_generator, (long long int)value.asInteger());
+#else
+    success = yajl_gen_status_ok == yajl_gen_integer(m_generator, (long int)value.asInteger());
+#endif
+    break;
+  case CVariant::VariantTypeUnsignedInteger:
+#if YAJL_MAJOR == 2
+    success = yajl_gen_status_ok == yajl_gen_integer(m_generator, (long long int)value.asUnsignedInteger());
+#else
+    success = yajl_gen_status_ok == yajl_gen_integer(m_generator, (long int)value.asUnsignedInteger());
+#endif
+    break;
+  case CVariant::VariantTypeDouble:
+    success = yajl_gen_status_ok == yajl_gen_double(m_generator, value.asDouble());
+    break;
+  case CVariant::VariantTypeBoolean:
+    success = yajl_gen_status_ok == yajl_gen_bool(m_generator, value.asBoolean() ? 1 : 0);
+    break;
+  case CVariant::VariantTypeString:
+#if YAJL_MAJOR == 2
+    success = yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)value.c_str(), (size_t)value.size());
+#else
+    success = yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)value.c_str(), value.size());
+#endif
+    break;
+  case CVariant::VariantTypeArray:
+    success = yajl_gen_status_ok == yajl_gen_array_open(m_generator);
+
+    for (CVariant::const_iterator_array itr = value.begin_array(); itr != value.end_array() && success; ++itr)
+      success &= InternalValue(*itr);
+
+    if (success)
+      success = yajl_gen_status_ok == yajl_gen_array_close(m_generator);
+
+    break;
+  case CVariant::VariantTypeObject:
+    success = yajl_gen_status_ok == yajl_gen_map_open(m_generator);
+
+    for (CVariant::const_iterator_map itr = value.begin_map(); itr != value.end_map() && success; ++itr)
+    {
+#if YAJL_MAJOR == 2
+      success &= yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)itr->first.c_str(), (size_t)itr->first.length());
+#else
+      success &= yajl_gen_status_ok == yajl_gen_string(m_generator, (const unsigned char*)itr->first.c_str(), itr->first.length());
+#endif
+      if (success)
+        success &= InternalValue(itr->second);
+    }
+
+    if (success)
+      success &= yajl_gen_status_ok == yajl_gen_map_close(m_generator);
+
+    break;
+  case CVariant::VariantTypeConstNull:
+  case CVariant::VariantTypeNull:
+  default:
+    success = yajl_gen_status_ok == yajl_gen_null(m_generator);
+    break;
+  }
+
+  return success;
+}
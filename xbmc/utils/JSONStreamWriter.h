@@ -0,0 +1,116 @@
+#pragma once
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include <string>
+#include <yajl/yajl_gen.h>
+#ifdef HAVE_YAJL_YAJL_VERSION_H
+#include <yajl/yajl_version.h>
+#endif
+
+class CVariant;
+
+/*!
+ \brief Receives the output of a CJSONStreamWriter chunk by chunk.
+ */
+class IJSONStreamSink
+{
+public:
+  virtual ~IJSONStreamSink() { }
+
+  /*!
+   \brief Consume the next chunk of JSON output
+   \return false to abort writing
+   */
+  virtual bool Write(const char *data, size_t length) = 0;
+};
+
+/*!
+ \brief Sink appending everything to a string
+ */
+class CJSONStringSink : public IJSONStreamSink
+{
+public:
+  CJSONStringSink(std::string &output) : m_output(output) { }
+
+  virtual bool Write(const char *data, size_t length) { m_output.append(data, length); return true; }
+
+private:
+  std::string &m_output;
+};
+
+/*!
+ \brief Event based JSON generator
+
+ Generates JSON one structural element or value at a time instead of
+ serializing a complete CVariant tree. Output is handed to the sink whenever
+ more than the chunk size has been generated and on Flush(), so large
+ responses never have to exist as a whole in memory.
+ */
+class CJSONStreamWriter
+{
+public:
+  static const size_t DefaultChunkSize = 16384;
+
+  CJSONStreamWriter(IJSONStreamSink &sink, bool compact, size_t chunkSize = DefaultChunkSize);
+  ~CJSONStreamWriter();
+
+  bool StartObject();
+  bool EndObject();
+  bool StartArray();
+  bool EndArray();
+  bool Key(const std::string &key);
+  bool Value(const CVariant &value);
+
+  /*!
+   \brief Pass everything generated so far on to the sink
+   */
+  bool Flush();
+
+  /*!
+   \return false once generating or writing to the sink has failed
+   */
+  bool IsGood() const { return !m_failed; }
+
+  /*!
+   \brief Also append every value passed to Value() to the given array
+   \param values Array receiving copies of the values
+   */
+  void StartCapture(CVariant &values);
+
+  /*!
+   \brief Stop appending values to the array passed to StartCapture()
+   \return false if anything but whole values was written in the meantime
+   */
+  bool EndCapture();
+
+private:
+  bool Generated(bool success);
+  bool InternalValue(const CVariant &value);
+  void Uncaptured() { m_captureComplete &= m_capture == NULL; }
+
+  IJSONStreamSink &m_sink;
+  yajl_gen m_generator;
+  size_t m_chunkSize;
+  bool m_failed;
+  CVariant *m_capture;
+  bool m_captureComplete;
+};
@@ -26,6 +26,7 @@ class CJob;
 #define kJobTypeMediaFlags  "mediaflags"
 #define kJobTypeCacheImage  "cacheimage"
 #define kJobTypeDDSCompress "ddscompress"
+#define kJobTypeCleanupImages "cleanupimages"
 
 /*!
  \ingroup jobs
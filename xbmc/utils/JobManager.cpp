@@ -21,8 +21,12 @@
 #include "JobManager.h"
 #include <algorithm>
 #include <stdexcept>
+#include "threads/Atomics.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
+#include "utils/PerformanceTrace.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
 #ifdef TARGET_POSIX
 #include "linux/XTimeUtils.h"
 #endif
@@ -39,9 +43,10 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
+CJobWorker::CJobWorker(CJobManager *manager, unsigned int lane) : CThread("JobWorker")
 {
   m_jobManager = manager;
+  m_lane = lane;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -68,13 +73,14 @@ void CJobWorker::Process()
     bool success = false;
     try
     {
+      TRACE_SCOPE(job->GetType());
       success = job->DoWork();
     }
     catch (...)
     {
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, job->GetType());
     }
-    m_jobManager->OnJobComplete(success, job);
+    m_jobManager->OnJobComplete(success, job, this);
   }
 }
 
@@ -169,6 +175,72 @@ bool CJobQueue::QueueEmpty() const
   return m_jobQueue.empty();
 }
 
+const unsigned int CJobStatistics::HistogramBuckets;
+
+CJobStatistics::CTiming::CTiming()
+{
+  m_total = 0;
+  m_max = 0;
+  for (unsigned int i = 0; i < HistogramBuckets; i++)
+    m_histogram[i] = 0;
+}
+
+void CJobStatistics::CTiming::Record(int64_t us)
+{
+  m_total += us;
+  if (us > m_max)
+    m_max = us;
+
+  unsigned int bucket = 0;
+  for (int64_t ms = us / 1000; ms > 0 && bucket < HistogramBuckets - 1; ms >>= 1)
+    bucket++;
+  m_histogram[bucket]++;
+}
+
+void CJobStatistics::CTiming::Add(const CTiming &other)
+{
+  m_total += other.m_total;
+  if (other.m_max > m_max)
+    m_max = other.m_max;
+  for (unsigned int i = 0; i < HistogramBuckets; i++)
+    m_histogram[i] += other.m_histogram[i];
+}
+
+void CJobStatistics::CTiming::Serialize(CVariant &value, unsigned int samples) const
+{
+  value["average"] = samples ? (double)m_total / samples / 1000.0 : 0.0;
+  value["max"] = (double)m_max / 1000.0;
+  value["histogram"] = CVariant(CVariant::VariantTypeArray);
+  for (unsigned int i = 0; i < HistogramBuckets; i++)
+    value["histogram"].push_back(m_histogram[i]);
+}
+
+CJobStatistics::CJobStatistics()
+{
+  m_queued = 0;
+  m_processing = 0;
+  m_completed = 0;
+}
+
+void CJobStatistics::Add(const CJobStatistics &other)
+{
+  m_queued += other.m_queued;
+  m_processing += other.m_processing;
+  m_completed += other.m_completed;
+  m_wait.Add(other.m_wait);
+  m_run.Add(other.m_run);
+}
+
+void CJobStatistics::Serialize(CVariant &value) const
+{
+  value["queued"] = m_queued;
+  value["processing"] = m_processing;
+  value["completed"] = m_completed;
+  // only jobs that have finished have a run time, but all that have started have waited
+  m_wait.Serialize(value["wait"], m_processing + m_completed);
+  m_run.Serialize(value["run"], m_completed);
+}
+
 CJobManager &CJobManager::GetInstance()
 {
   static CJobManager sJobManager;
@@ -178,8 +250,21 @@ CJobManager &CJobManager::GetInstance()
 CJobManager::CJobManager()
 {
   m_jobCounter = 0;
+  m_nextLane = 0;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    m_queued[priority] = 0;
+  m_processingCount = 0;
+  m_workerCount = 0;
+  m_workerLane = 0;
+  m_counterFrequency = CurrentHostFrequency() / 1000000;
+  if (m_counterFrequency <= 0)
+    m_counterFrequency = 1;
   m_running = true;
   m_pauseJobs = false;
+
+  // one lane per worker we may run at most
+  for (unsigned int lane = 0; lane < GetMaxWorkers(CJob::PRIORITY_HIGH); ++lane)
+    m_lanes.push_back(new CJobLane);
 }
 
 void CJobManager::Restart()
@@ -196,15 +281,26 @@ void CJobManager::CancelJobs()
   CSingleLock lock(m_section);
   m_running = false;
 
-  // clear any pending jobs
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  LockLanes();
+  for (Lanes::iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
   {
-    for_each(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), mem_fun_ref(&CWorkItem::FreeJob));
-    m_jobQueue[priority].clear();
-  }
+    // clear any pending jobs
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      JobQueue &queue = (*lane)->m_jobQueue[priority];
+      for (JobQueue::iterator i = queue.begin(); i != queue.end(); ++i)
+      {
+        (*lane)->GetStatistics(*i).m_queued--;
+        i->FreeJob();
+      }
+      AtomicSubtract(&m_queued[priority], queue.size());
+      queue.clear();
+    }
 
-  // cancel any callbacks on jobs still processing
-  for_each(m_processing.begin(), m_processing.end(), mem_fun_ref(&CWorkItem::Cancel));
+    // cancel any callbacks on jobs still processing
+    for_each((*lane)->m_processing.begin(), (*lane)->m_processing.end(), mem_fun_ref(&CWorkItem::Cancel));
+  }
+  UnlockLanes();
 
   // tell our workers to finish
   while (m_workers.size())
@@ -218,115 +314,236 @@ void CJobManager::CancelJobs()
 
 CJobManager::~CJobManager()
 {
+  for (Lanes::iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+    delete *lane;
 }
 
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
-
   if (!m_running)
     return 0;
 
   // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
+  unsigned int jobID;
+  do
+  {
+    jobID = (unsigned int)AtomicIncrement(&m_jobCounter);
+  } while (jobID == 0);
 
   // create a work item for this job
-  CWorkItem work(job, m_jobCounter, priority, callback);
-  m_jobQueue[priority].push_back(work);
+  CWorkItem work(job, jobID, priority, callback);
+  work.m_queuedAt = CurrentHostCounter();
+  {
+    CJobLane *lane = m_lanes[GetLaneForCaller()];
+    CSingleLock lock(lane->m_section);
+
+    // CancelJobs() stops us running before it locks the lanes to free what's queued, so checking
+    // again under the lane lock means the job is either left to the caller or owned by us
+    if (!m_running)
+      return 0;
+
+    lane->m_jobQueue[priority].push_back(work);
+    lane->GetStatistics(work).m_queued++;
+    AtomicIncrement(&m_queued[priority]);
+  }
 
   StartWorkers(priority);
-  return work.m_id;
+  return jobID;
 }
 
 void CJobManager::CancelJob(unsigned int jobID)
 {
-  CSingleLock lock(m_section);
-
-  // check whether we have this job in the queue
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  // lock all lanes, so we can't miss a job being stolen from one lane to another
+  LockLanes();
+  for (Lanes::iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
   {
-    JobQueue::iterator i = find(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), jobID);
-    if (i != m_jobQueue[priority].end())
+    // check whether we have this job in the queue
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
     {
-      delete i->m_job;
-      m_jobQueue[priority].erase(i);
-      return;
+      JobQueue &queue = (*lane)->m_jobQueue[priority];
+      JobQueue::iterator i = find(queue.begin(), queue.end(), jobID);
+      if (i != queue.end())
+      {
+        (*lane)->GetStatistics(*i).m_queued--;
+        delete i->m_job;
+        queue.erase(i);
+        AtomicDecrement(&m_queued[priority]);
+        UnlockLanes();
+        return;
+      }
+    }
+    // or if we're processing it
+    Processing::iterator it = find((*lane)->m_processing.begin(), (*lane)->m_processing.end(), jobID);
+    if (it != (*lane)->m_processing.end())
+    {
+      it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+      break;
     }
   }
-  // or if we're processing it
-  Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
-  if (it != m_processing.end())
-    it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+  UnlockLanes();
 }
 
 void CJobManager::StartWorkers(CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
-
   // check how many free threads we have
-  if (m_processing.size() >= GetMaxWorkers(priority))
+  if (m_processingCount >= (long)GetMaxWorkers(priority))
     return;
 
   // do we have any sleeping threads?
-  if (m_processing.size() < m_workers.size())
+  if (m_processingCount < m_workerCount)
   {
     m_jobEvent.Set();
     return;
   }
 
   // everyone is busy - we need more workers
-  m_workers.push_back(new CJobWorker(this));
+  CSingleLock lock(m_section);
+  if (!m_running)
+    return;
+
+  // check again now that we hold the lock, another thread may have beaten us to it
+  if (m_processingCount < (long)m_workers.size())
+  {
+    m_jobEvent.Set();
+    return;
+  }
+
+  m_workers.push_back(new CJobWorker(this, m_workerLane++ % m_lanes.size()));
+  AtomicIncrement(&m_workerCount);
 }
 
-CJob *CJobManager::PopJob()
+unsigned int CJobManager::GetLaneForCaller()
+{
+  CJobWorker *worker = dynamic_cast<CJobWorker*>(CThread::GetCurrentThread());
+  if (worker && worker->GetLane() < m_lanes.size())
+    return worker->GetLane();
+  return (unsigned long)AtomicIncrement(&m_nextLane) % m_lanes.size();
+}
+
+void CJobManager::LockLanes() const
+{
+  // always lock in the same order to avoid deadlocks
+  for (Lanes::const_iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+    (*lane)->m_section.lock();
+}
+
+void CJobManager::UnlockLanes() const
+{
+  for (Lanes::const_reverse_iterator lane = m_lanes.rbegin(); lane != m_lanes.rend(); ++lane)
+    (*lane)->m_section.unlock();
+}
+
+CJob *CJobManager::PopJob(unsigned int lane)
 {
-  CSingleLock lock(m_section);
   for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
   {
     // Check whether we're pausing pausable jobs
     if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
       continue;
 
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    if (m_queued[priority] <= 0)
+      continue;
+
+    // reserve a processing slot, unless we're at the workers allowed at this priority
+    long processing;
+    do
+    {
+      processing = m_processingCount;
+    } while (processing < (long)GetMaxWorkers(CJob::PRIORITY(priority)) &&
+             cas(&m_processingCount, processing, processing + 1) != processing);
+    if (processing >= (long)GetMaxWorkers(CJob::PRIORITY(priority)))
+      continue;
+
+    // try our own lane first, then steal from the others
+    for (unsigned int i = 0; i < m_lanes.size(); ++i)
     {
+      unsigned int victim = (lane + i) % m_lanes.size();
+      CJobLane *home = m_lanes[lane];
+      CJobLane *from = m_lanes[victim];
+
+      // lock both lanes in index order so the job is never in neither
+      CSingleLock lock1(m_lanes[std::min(lane, victim)]->m_section);
+      CSingleLock lock2(m_lanes[std::max(lane, victim)]->m_section);
+
+      // check for pausing again, as jobs may have been paused and queued since we looked
+      JobQueue &queue = from->m_jobQueue[priority];
+      if (queue.empty() || (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs))
+        continue;
+
       // pop the job off the queue
-      CWorkItem job = m_jobQueue[priority].front();
-      m_jobQueue[priority].pop_front();
+      CWorkItem job = queue.front();
+      queue.pop_front();
+      AtomicDecrement(&m_queued[priority]);
+      from->GetStatistics(job).m_queued--;
 
       // add to the processing vector
-      m_processing.push_back(job);
+      job.m_startedAt = CurrentHostCounter();
+      CJobStatistics &stats = home->GetStatistics(job);
+      stats.m_processing++;
+      stats.m_wait.Record(ToMicroseconds(job.m_startedAt - job.m_queuedAt));
+      home->m_processing.push_back(job);
       job.m_job->m_callback = this;
+
+      lock2.Leave();
+      lock1.Leave();
+
+      // more work about and someone idle to do it? wake them up
+      if (m_processingCount < m_workerCount)
+      {
+        for (int p = CJob::PRIORITY_HIGH; p >= CJob::PRIORITY_LOW_PAUSABLE; --p)
+        {
+          if (m_queued[p] > 0)
+          {
+            m_jobEvent.Set();
+            break;
+          }
+        }
+      }
       return job.m_job;
     }
+
+    // lost the race for the queued job(s). Our reservation may have kept whoever queued
+    // a job meanwhile from waking a worker, so check again once we've given it back
+    AtomicDecrement(&m_processingCount);
+    if (m_queued[priority] > 0)
+      ++priority;
   }
   return NULL;
 }
 
 void CJobManager::PauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = true;
 }
 
 void CJobManager::UnPauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = false;
+
+  // get going on whatever was held back while we were paused
+  if (m_queued[CJob::PRIORITY_LOW_PAUSABLE] > 0)
+    StartWorkers(CJob::PRIORITY_LOW_PAUSABLE);
 }
 
-bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
+bool CJobManager::IsPaused() const
 {
-  CSingleLock lock(m_section);
+  return m_pauseJobs;
+}
 
+bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
+{
   if (m_pauseJobs)
     return false;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
+  for (Lanes::const_iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
   {
-    if (priority == it->m_priority)
-      return true;
+    CSingleLock lock((*lane)->m_section);
+    const Processing &processing = (*lane)->m_processing;
+    for(Processing::const_iterator it = processing.begin(); it < processing.end(); ++it)
+    {
+      if (priority == it->m_priority)
+        return true;
+    }
   }
   return false;
 }
@@ -334,69 +551,81 @@ bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 int CJobManager::IsProcessing(const std::string &type) const
 {
   int jobsMatched = 0;
-  CSingleLock lock(m_section);
 
   if (m_pauseJobs)
     return 0;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
+  for (Lanes::const_iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
   {
-    if (type == std::string(it->m_job->GetType()))
-      jobsMatched++;
+    CSingleLock lock((*lane)->m_section);
+    const Processing &processing = (*lane)->m_processing;
+    for(Processing::const_iterator it = processing.begin(); it < processing.end(); ++it)
+    {
+      if (type == std::string(it->m_job->GetType()))
+        jobsMatched++;
+    }
   }
   return jobsMatched;
 }
 
 CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
   while (m_running)
   {
     // grab a job off the queue if we have one
-    CJob *job = PopJob();
+    CJob *job = PopJob(worker->GetLane());
     if (job)
       return job;
     // no jobs are left - sleep for 30 seconds to allow new jobs to come in
-    lock.Leave();
-    bool newJob = m_jobEvent.WaitMSec(30000);
-    lock.Enter();
-    if (!newJob)
+    if (!m_jobEvent.WaitMSec(30000))
       break;
   }
-  // ensure no jobs have come in during the period after
-  // timeout and before we held the lock
-  CJob *job = PopJob();
+
+  // we're going away. Remove ourselves first and then ensure no jobs have come
+  // in meanwhile, as whoever added them may have counted on us to process them
+  CSingleLock lock(m_section);
+  RemoveWorker(worker);
+  CJob *job = PopJob(worker->GetLane());
   if (job)
+  {
+    m_workers.push_back(const_cast<CJobWorker*>(worker));
+    AtomicIncrement(&m_workerCount);
     return job;
+  }
   // have no jobs
-  RemoveWorker(worker);
   return NULL;
 }
 
 bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
 {
-  CSingleLock lock(m_section);
-  // find the job in the processing queue, and check whether it's cancelled (no callback)
-  Processing::const_iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  // find the job in the processing queues, and check whether it's cancelled (no callback)
+  for (Lanes::const_iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
   {
-    CWorkItem item(*i);
-    lock.Leave(); // leave section prior to call
-    if (item.m_callback)
+    CSingleLock lock((*lane)->m_section);
+    const Processing &processing = (*lane)->m_processing;
+    Processing::const_iterator i = find(processing.begin(), processing.end(), job);
+    if (i != processing.end())
     {
-      item.m_callback->OnJobProgress(item.m_id, progress, total, job);
-      return false;
+      CWorkItem item(*i);
+      lock.Leave(); // leave section prior to call
+      if (item.m_callback)
+      {
+        item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+        return false;
+      }
+      break;
     }
   }
   return true; // couldn't find the job, or it's been cancelled
 }
 
-void CJobManager::OnJobComplete(bool success, CJob *job)
+void CJobManager::OnJobComplete(bool success, CJob *job, const CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
+  CJobLane *lane = m_lanes[worker->GetLane()];
+  CSingleLock lock(lane->m_section);
   // remove the job from the processing queue
-  Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  Processing::iterator i = find(lane->m_processing.begin(), lane->m_processing.end(), job);
+  if (i != lane->m_processing.end())
   {
     // tell any listeners we're done with the job, then delete it
     CWorkItem item(*i);
@@ -411,10 +640,15 @@ void CJobManager::OnJobComplete(bool success, CJob *job)
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
     }
     lock.Enter();
-    Processing::iterator j = find(m_processing.begin(), m_processing.end(), job);
-    if (j != m_processing.end())
-      m_processing.erase(j);
+    Processing::iterator j = find(lane->m_processing.begin(), lane->m_processing.end(), job);
+    if (j != lane->m_processing.end())
+      lane->m_processing.erase(j);
+    CJobStatistics &stats = lane->GetStatistics(item);
+    stats.m_processing--;
+    stats.m_completed++;
+    stats.m_run.Record(ToMicroseconds(CurrentHostCounter() - item.m_startedAt));
     lock.Leave();
+    AtomicDecrement(&m_processingCount);
     item.FreeJob();
   }
 }
@@ -425,7 +659,10 @@ void CJobManager::RemoveWorker(const CJobWorker *worker)
   // remove our worker
   Workers::iterator i = find(m_workers.begin(), m_workers.end(), worker);
   if (i != m_workers.end())
+  {
     m_workers.erase(i); // workers auto-delete
+    AtomicDecrement(&m_workerCount);
+  }
 }
 
 unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority)
@@ -433,3 +670,56 @@ unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority)
   static const unsigned int max_workers = 5;
   return max_workers - (CJob::PRIORITY_HIGH - priority);
 }
+
+int64_t CJobManager::ToMicroseconds(int64_t ticks) const
+{
+  return ticks / m_counterFrequency;
+}
+
+void CJobManager::GetStatistics(CVariant &stats) const
+{
+  static const char *priorities[] = { "lowpausable", "low", "normal", "high" };
+
+  // gather up the statistics of all lanes
+  Statistics statistics;
+  for (Lanes::const_iterator lane = m_lanes.begin(); lane != m_lanes.end(); ++lane)
+  {
+    CSingleLock lock((*lane)->m_section);
+    for (Statistics::const_iterator i = (*lane)->m_statistics.begin(); i != (*lane)->m_statistics.end(); ++i)
+      statistics[i->first].Add(i->second);
+  }
+
+  stats["workers"] = (int)m_workerCount;
+  stats["processing"] = (int)m_processingCount;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    stats["queued"][priorities[priority]] = (int)m_queued[priority];
+
+  stats["jobs"] = CVariant(CVariant::VariantTypeArray);
+  for (Statistics::const_iterator i = statistics.begin(); i != statistics.end(); ++i)
+  {
+    CVariant job;
+    i->second.Serialize(job);
+    job["type"] = i->first.first;
+    job["priority"] = priorities[i->first.second];
+    stats["jobs"].push_back(job);
+  }
+}
+
+void CJobManager::DumpStatistics() const
+{
+  CVariant stats;
+  GetStatistics(stats);
+
+  CLog::Log(LOGNOTICE, "Job statistics: %d workers, %d processing, queued %d/%d/%d/%d (high/normal/low/lowpausable)",
+            (int)stats["workers"].asInteger(), (int)stats["processing"].asInteger(),
+            (int)stats["queued"]["high"].asInteger(), (int)stats["queued"]["normal"].asInteger(),
+            (int)stats["queued"]["low"].asInteger(), (int)stats["queued"]["lowpausable"].asInteger());
+  for (CVariant::const_iterator_array job = stats["jobs"].begin_array(); job != stats["jobs"].end_array(); ++job)
+  {
+    CLog::Log(LOGNOTICE, "  %s (%s): queued %d, processing %d, completed %d, wait avg %.2f max %.2f ms, run avg %.2f max %.2f ms",
+              (*job)["type"].asString().c_str(), (*job)["priority"].asString().c_str(),
+              (int)(*job)["queued"].asInteger(), (int)(*job)["processing"].asInteger(), (int)(*job)["completed"].asInteger(),
+              (*job)["wait"]["average"].asDouble(), (*job)["wait"]["max"].asDouble(),
+              (*job)["run"]["average"].asDouble(), (*job)["run"]["max"].asDouble());
+  }
+}
@@ -19,11 +19,14 @@
  *
  */
 
+#include <stdint.h>
+#include <map>
 #include <queue>
 #include <vector>
 #include <string>
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
+#include "utils/ISerializable.h"
 #include "Job.h"
 
 class CJobManager;
@@ -31,12 +34,19 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  CJobWorker(CJobManager *manager, unsigned int lane);
   virtual ~CJobWorker();
 
   void Process();
+
+  /*!
+   \brief The lane (queue shard) this worker pulls jobs from before stealing from others.
+   \sa CJobManager
+   */
+  unsigned int GetLane() const { return m_lane; };
 private:
   CJobManager  *m_jobManager;
+  unsigned int  m_lane;
 };
 
 /*!
@@ -156,6 +166,51 @@ private:
   bool m_lifo;
 };
 
+/*!
+ \ingroup jobs
+ \brief Statistics on the jobs of one type and priority.
+
+ Tracks how many jobs are queued, processing and completed, and how long they waited in
+ the queue (enqueue to start) and took to run (start to finish).  Timings are kept as
+ totals, maxima and a histogram whose bucket i counts the jobs taking less than 2^i
+ milliseconds, the last bucket counting everything longer.
+
+ \sa CJobManager::GetStatistics
+ */
+class CJobStatistics : public ISerializable
+{
+public:
+  static const unsigned int HistogramBuckets = 16;
+
+  class CTiming
+  {
+  public:
+    CTiming();
+    void Record(int64_t us);
+    void Add(const CTiming &other);
+    void Serialize(CVariant &value, unsigned int samples) const;
+
+    int64_t      m_total; ///< in microseconds
+    int64_t      m_max;   ///< in microseconds
+    unsigned int m_histogram[HistogramBuckets];
+  };
+
+  CJobStatistics();
+
+  /*!
+   \brief Merge the statistics of another set of jobs into this one.
+   */
+  void Add(const CJobStatistics &other);
+
+  virtual void Serialize(CVariant &value) const;
+
+  unsigned int m_queued;
+  unsigned int m_processing;
+  unsigned int m_completed;
+  CTiming      m_wait;
+  CTiming      m_run;
+};
+
 /*!
  \ingroup jobs
  \brief Job Manager class for scheduling asynchronous jobs.
@@ -165,6 +220,12 @@ private:
  priority levels.  Lower priority jobs are executed only if there are sufficient
  spare worker threads free to allow for higher priority jobs that may arise.
 
+ Queued jobs are sharded over a number of lanes, each with its own lock, so that
+ adding and fetching jobs from many threads doesn't serialize on a single lock.
+ Workers take jobs from their own lane first and steal from the other lanes once
+ it runs dry.  Jobs are always taken oldest first, and a higher priority job queued
+ on any lane is taken before a lower priority one.
+
  \sa CJob and IJobCallback
  */
 class CJobManager
@@ -178,6 +239,8 @@ class CJobManager
       m_id = id;
       m_callback = callback;
       m_priority = priority;
+      m_queuedAt = 0;
+      m_startedAt = 0;
     }
     bool operator==(unsigned int jobID) const
     {
@@ -200,6 +263,8 @@ class CJobManager
     unsigned int  m_id;
     IJobCallback *m_callback;
     CJob::PRIORITY m_priority;
+    int64_t       m_queuedAt;
+    int64_t       m_startedAt;
   };
 
 public:
@@ -262,6 +327,13 @@ public:
    */
   void UnPauseJobs();
 
+  /*!
+   \brief Checks whether queueing of jobs with priority PRIORITY_LOW_PAUSABLE is suspended
+   Long running pausable jobs may use this to stop early.
+   \sa PauseJobs()
+   */
+  bool IsPaused() const;
+
   /*!
    \brief Checks to see if any jobs with specific priority are currently processing.
    \param priority to search for
@@ -269,6 +341,20 @@ public:
    */
   bool IsProcessing(const CJob::PRIORITY &priority) const;
 
+  /*!
+   \brief Retrieve statistics on the jobs seen since startup, per job type and priority.
+   \param stats object to fill with the number of workers, the queue depth per priority and
+   a list of CJobStatistics per job type and priority.
+   \sa CJobStatistics, DumpStatistics()
+   */
+  void GetStatistics(CVariant &stats) const;
+
+  /*!
+   \brief Write the job statistics to the log.
+   \sa GetStatistics()
+   */
+  void DumpStatistics() const;
+
 protected:
   friend class CJobWorker;
   friend class CJob;
@@ -283,11 +369,12 @@ protected:
   /*!
    \brief Callback from CJobWorker after a job has completed.
    Calls IJobCallback::OnJobComplete(), and then destroys job.
-   \param job a pointer to the calling subclassed CJob instance.
    \param success the result from the DoWork call
+   \param job a pointer to the calling subclassed CJob instance.
+   \param worker a pointer to the CJobWorker instance that processed the job.
    \sa IJobCallback, CJob
    */
-  void  OnJobComplete(bool success, CJob *job);
+  void  OnJobComplete(bool success, CJob *job, const CJobWorker *worker);
 
   /*!
    \brief Callback from CJob to report progress and check for cancellation.
@@ -307,27 +394,68 @@ private:
   CJobManager const& operator=(CJobManager const&);
   virtual ~CJobManager();
 
-  /*! \brief Pop a job off the job queue and add to the processing queue ready to process
+  typedef std::deque<CWorkItem>    JobQueue;
+  typedef std::vector<CWorkItem>   Processing;
+  typedef std::vector<CJobWorker*> Workers;
+  typedef std::map<std::pair<std::string, CJob::PRIORITY>, CJobStatistics> Statistics;
+
+  /*!
+   \brief A shard of the job queue.
+   Holds the jobs queued to this lane and the jobs being processed by the workers
+   that call this lane home, along with the statistics of those jobs.  Each lane is
+   protected by its own lock.
+   */
+  class CJobLane
+  {
+  public:
+    JobQueue         m_jobQueue[CJob::PRIORITY_HIGH+1];
+    Processing       m_processing;
+    Statistics       m_statistics;
+    CCriticalSection m_section;
+
+    CJobStatistics &GetStatistics(const CWorkItem &item)
+    {
+      return m_statistics[std::make_pair(std::string(item.m_job->GetType()), item.m_priority)];
+    };
+  };
+  typedef std::vector<CJobLane*>   Lanes;
+
+  /*! \brief Pop a job off the job queues and add to the processing queue ready to process
+   Jobs are taken from the given lane first, then stolen from the other lanes.
+   \param lane the home lane of the worker requesting the job.
    \return the job to process, NULL if no jobs are available
    */
-  CJob *PopJob();
+  CJob *PopJob(unsigned int lane);
+
+  /*! \brief Lane that jobs added from the calling thread are queued to
+   Workers queue to their own lane, all other threads are spread round robin over the lanes.
+   */
+  unsigned int GetLaneForCaller();
+
+  void LockLanes() const;
+  void UnlockLanes() const;
 
   void StartWorkers(CJob::PRIORITY priority);
   void RemoveWorker(const CJobWorker *worker);
   static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
 
-  unsigned int m_jobCounter;
+  /*! \brief Convert a CurrentHostCounter() interval to microseconds
+   */
+  int64_t ToMicroseconds(int64_t ticks) const;
 
-  typedef std::deque<CWorkItem>    JobQueue;
-  typedef std::vector<CWorkItem>   Processing;
-  typedef std::vector<CJobWorker*> Workers;
+  volatile long m_jobCounter;
+  volatile long m_nextLane;
+  volatile long m_queued[CJob::PRIORITY_HIGH+1]; ///< number of jobs queued per priority over all lanes
+  volatile long m_processingCount;              ///< number of jobs being processed over all lanes
+  volatile long m_workerCount;                  ///< number of live workers, mirrors m_workers.size()
 
-  JobQueue   m_jobQueue[CJob::PRIORITY_HIGH+1];
-  bool       m_pauseJobs;
-  Processing m_processing;
+  Lanes      m_lanes;
+  volatile bool m_pauseJobs;
   Workers    m_workers;
+  unsigned int m_workerLane;
+  int64_t    m_counterFrequency; ///< CurrentHostCounter() ticks per microsecond
 
-  CCriticalSection m_section;
+  CCriticalSection m_section;  ///< protects the worker list and the running state
   CEvent           m_jobEvent;
-  bool             m_running;
+  volatile bool    m_running;
 };
@@ -27,6 +27,7 @@
 
 #include "Application.h"
 #include "log.h"
+#include "PerformanceTrace.h"
 #include "TimeUtils.h"
 
 using namespace std;
@@ -81,6 +82,9 @@ void CPerformanceSample::CheckPoint()
   g_application.GetPerformanceStats().AddSample(m_statName, PerformanceCounter(elapsed,dUser,dSys));
 #endif
 
+  if (CPerformanceTrace::IsEnabled())
+    CPerformanceTrace::Complete(CPerformanceTrace::Intern(m_statName), m_tmStart, CurrentHostCounter());
+
   Reset();
 }
 
@@ -0,0 +1,262 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PerformanceTrace.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "threads/ThreadLocal.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace
+{
+  struct TraceEvent
+  {
+    const char *name;
+    char        phase;
+    int64_t     start;
+    int64_t     end;
+  };
+
+  /* Each thread appends to its own buffer, so the lock is only ever contended
+     while the trace is being reset or exported. The buffer of a thread that
+     exited is kept for its events until the trace is started again. */
+  class CTraceBuffer
+  {
+  public:
+    CTraceBuffer() : m_threadId((uint64_t)CThread::GetCurrentThreadId()), m_dropped(0), m_exited(false)
+    {
+      CThread *thread = CThread::GetCurrentThread();
+      if (thread)
+        m_name = thread->GetName();
+      else
+        m_name = StringUtils::Format("thread %" PRIu64, m_threadId);
+    }
+
+    CCriticalSection        m_lock;
+    std::vector<TraceEvent> m_events;
+    uint64_t                m_threadId;
+    unsigned int            m_dropped;
+    bool                    m_exited;
+    std::string             m_name;
+  };
+
+  void ReleaseBuffer(CTraceBuffer *buffer);
+
+  CCriticalSection                      traceSection;
+  std::vector<CTraceBuffer*>            traceBuffers;
+  std::set<std::string>                 traceNames;
+  XbmcThreads::ThreadLocal<CTraceBuffer> traceBuffer(ReleaseBuffer);
+  unsigned int                          traceMaxEvents = CPerformanceTrace::DefaultMaxEvents;
+  int64_t                               traceStart = 0;
+
+  CTraceBuffer *GetBuffer()
+  {
+    CTraceBuffer *buffer = traceBuffer.get();
+    if (!buffer)
+    {
+      CSingleLock lock(traceSection);
+      buffer = new CTraceBuffer();
+      traceBuffers.push_back(buffer);
+      traceBuffer.set(buffer);
+    }
+    return buffer;
+  }
+
+  std::vector<CTraceBuffer*>::iterator DeleteBuffer(std::vector<CTraceBuffer*>::iterator it)
+  {
+    delete *it;
+    return traceBuffers.erase(it);
+  }
+
+  // called as a thread exits
+  void ReleaseBuffer(CTraceBuffer *buffer)
+  {
+    CSingleLock lock(traceSection);
+    std::vector<CTraceBuffer*>::iterator it = std::find(traceBuffers.begin(), traceBuffers.end(), buffer);
+    if (it == traceBuffers.end())
+      return;
+
+    CSingleLock bufferLock(buffer->m_lock);
+    buffer->m_exited = true;
+    if (buffer->m_events.empty())
+    {
+      bufferLock.Leave();
+      DeleteBuffer(it);
+    }
+  }
+
+  void Record(const char *name, char phase, int64_t start, int64_t end)
+  {
+    CTraceBuffer *buffer = GetBuffer();
+    CSingleLock lock(buffer->m_lock);
+    if (buffer->m_events.size() >= traceMaxEvents)
+    {
+      buffer->m_dropped++;
+      return;
+    }
+    TraceEvent event = { name, phase, start, end };
+    buffer->m_events.push_back(event);
+  }
+}
+
+volatile bool CPerformanceTrace::m_enabled = false;
+
+void CPerformanceTrace::Start(unsigned int maxEventsPerThread /* = DefaultMaxEvents */)
+{
+  CSingleLock lock(traceSection);
+  for (std::vector<CTraceBuffer*>::iterator it = traceBuffers.begin(); it != traceBuffers.end(); )
+  {
+    if ((*it)->m_exited)
+    {
+      it = DeleteBuffer(it);
+      continue;
+    }
+    CSingleLock bufferLock((*it)->m_lock);
+    std::vector<TraceEvent>().swap((*it)->m_events);
+    (*it)->m_dropped = 0;
+    ++it;
+  }
+  traceMaxEvents = maxEventsPerThread;
+  traceStart = CurrentHostCounter();
+  m_enabled = true;
+  CLog::Log(LOGNOTICE, "%s - performance tracing started", __FUNCTION__);
+}
+
+void CPerformanceTrace::Stop()
+{
+  if (!m_enabled)
+    return;
+  m_enabled = false;
+  CLog::Log(LOGNOTICE, "%s - performance tracing stopped, %u events recorded, %u dropped",
+            __FUNCTION__, GetEventCount(), GetDroppedEvents());
+}
+
+void CPerformanceTrace::Begin(const char *name)
+{
+  Record(name, 'B', CurrentHostCounter(), 0);
+}
+
+void CPerformanceTrace::End(const char *name)
+{
+  Record(name, 'E', CurrentHostCounter(), 0);
+}
+
+void CPerformanceTrace::Complete(const char *name, int64_t start, int64_t end)
+{
+  Record(name, 'X', start, end);
+}
+
+const char *CPerformanceTrace::Intern(const std::string &name)
+{
+  CSingleLock lock(traceSection);
+  return traceNames.insert(name).first->c_str();
+}
+
+unsigned int CPerformanceTrace::GetEventCount()
+{
+  unsigned int count = 0;
+  CSingleLock lock(traceSection);
+  for (std::vector<CTraceBuffer*>::iterator it = traceBuffers.begin(); it != traceBuffers.end(); ++it)
+  {
+    CSingleLock bufferLock((*it)->m_lock);
+    count += (*it)->m_events.size();
+  }
+  return count;
+}
+
+unsigned int CPerformanceTrace::GetDroppedEvents()
+{
+  unsigned int dropped = 0;
+  CSingleLock lock(traceSection);
+  for (std::vector<CTraceBuffer*>::iterator it = traceBuffers.begin(); it != traceBuffers.end(); ++it)
+  {
+    CSingleLock bufferLock((*it)->m_lock);
+    dropped += (*it)->m_dropped;
+  }
+  return dropped;
+}
+
+void CPerformanceTrace::Serialize(CVariant &value)
+{
+  // trace-event timestamps are in microseconds
+  double toMicroseconds = 1000000.0 / (double)CurrentHostFrequency();
+
+  value = CVariant(CVariant::VariantTypeObject);
+  value["displayTimeUnit"] = "ms";
+  value["traceEvents"] = CVariant(CVariant::VariantTypeArray);
+  CVariant &events = value["traceEvents"];
+
+  CSingleLock lock(traceSection);
+  for (std::vector<CTraceBuffer*>::iterator it = traceBuffers.begin(); it != traceBuffers.end(); ++it)
+  {
+    CTraceBuffer *buffer = *it;
+    CSingleLock bufferLock(buffer->m_lock);
+    if (buffer->m_events.empty())
+      continue;
+
+    CVariant thread(CVariant::VariantTypeObject);
+    thread["name"] = "thread_name";
+    thread["ph"] = "M";
+    thread["pid"] = 1;
+    thread["tid"] = buffer->m_threadId;
+    thread["args"]["name"] = buffer->m_name;
+    events.push_back(thread);
+
+    for (std::vector<TraceEvent>::const_iterator event = buffer->m_events.begin(); event != buffer->m_events.end(); ++event)
+    {
+      CVariant item(CVariant::VariantTypeObject);
+      item["name"] = event->name;
+      item["cat"] = "xbmc";
+      item["ph"] = std::string(1, event->phase);
+      item["ts"] = (double)(event->start - traceStart) * toMicroseconds;
+      if (event->phase == 'X')
+        item["dur"] = (double)(event->end - event->start) * toMicroseconds;
+      item["pid"] = 1;
+      item["tid"] = buffer->m_threadId;
+      events.push_back(item);
+    }
+  }
+}
+
+bool CPerformanceTrace::Save(const std::string &path)
+{
+  CVariant trace;
+  Serialize(trace);
+  std::string json = CJSONVariantWriter::Write(trace, true);
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(path, true) || file.Write(json.c_str(), json.size()) != (int)json.size())
+  {
+    CLog::Log(LOGERROR, "%s - unable to write performance trace to %s", __FUNCTION__, path.c_str());
+    return false;
+  }
+  file.Close();
+  CLog::Log(LOGNOTICE, "%s - performance trace written to %s", __FUNCTION__, path.c_str());
+  return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <string>
+
+class CVariant;
+
+#ifndef NO_PERFORMANCE_MEASURE
+#define TRACE_SCOPE_CONCAT2(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) CPerformanceTraceScope TRACE_SCOPE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_FUNCTION TRACE_SCOPE(__FUNCTION__)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_FUNCTION
+#endif
+
+/*!
+ \brief Records begin/end events into per-thread buffers for export in the
+ Chrome trace-event format (load the result in chrome://tracing or a compatible viewer).
+
+ Event names are stored as pointers, so they have to outlive the trace: use string
+ literals, or run dynamic names through Intern().
+ While tracing is stopped a scope costs a single flag check.
+ */
+class CPerformanceTrace
+{
+public:
+  static const unsigned int DefaultMaxEvents = 262144;
+
+  /*! \brief Discard any recorded events and start tracing.
+   \param maxEventsPerThread events beyond this per thread are dropped
+   */
+  static void Start(unsigned int maxEventsPerThread = DefaultMaxEvents);
+  static void Stop();
+  static inline bool IsEnabled() { return m_enabled; }
+
+  static void Begin(const char *name);
+  static void End(const char *name);
+  static void Complete(const char *name, int64_t start, int64_t end);
+
+  /*! \brief Return a copy of name that lives as long as the process.
+   */
+  static const char *Intern(const std::string &name);
+
+  static unsigned int GetEventCount();
+  static unsigned int GetDroppedEvents();
+
+  /*! \brief Build the trace as a Chrome trace-event object ({ "traceEvents": [...] }).
+   */
+  static void Serialize(CVariant &value);
+
+  /*! \brief Write the recorded trace to the given file as JSON.
+   \return true if the file was written
+   */
+  static bool Save(const std::string &path);
+
+private:
+  static volatile bool m_enabled;
+};
+
+class CPerformanceTraceScope
+{
+public:
+  inline CPerformanceTraceScope(const char *name) : m_name(NULL)
+  {
+    if (CPerformanceTrace::IsEnabled())
+    {
+      m_name = name;
+      CPerformanceTrace::Begin(name);
+    }
+  }
+  inline ~CPerformanceTraceScope()
+  {
+    if (m_name)
+      CPerformanceTrace::End(m_name);
+  }
+private:
+  const char *m_name;
+};
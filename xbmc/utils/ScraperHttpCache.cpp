@@ -0,0 +1,324 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ScraperHttpCache.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "XBDateTime.h"
+#include "filesystem/CurlFile.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/HttpHeader.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace std;
+using namespace XFILE;
+
+// header kept with each response, the time it was fetched or last revalidated at
+#define STORED_HEADER "x-xbmc-stored"
+
+// heuristic freshness of responses with just a Last-Modified is capped at a day
+#define MAX_HEURISTIC_LIFETIME (24 * 60 * 60)
+
+CScraperHttpCache &CScraperHttpCache::Get()
+{
+  static CScraperHttpCache cache(URIUtils::AddFileToFolder(g_advancedSettings.m_cachePath, "scrapers/http/"),
+                                 (int64_t)g_advancedSettings.m_scraperHttpCacheSize * 1024 * 1024);
+  return cache;
+}
+
+CScraperHttpCache::CScraperHttpCache(const std::string &folder, int64_t budget)
+  : m_folder(folder), m_budget(budget), m_size(-1)
+{
+  URIUtils::AddSlashAtEnd(m_folder);
+}
+
+bool CScraperHttpCache::Fetch(CCurlFile &http, const std::string &url, std::string &content, CHttpHeader &headers)
+{
+  if (m_budget <= 0)
+  {
+    if (!http.Get(url, content))
+      return false;
+    headers = http.GetHttpHeader();
+    return true;
+  }
+
+  std::string path = GetPath(url);
+  CHttpHeader stored;
+  std::string storedContent;
+  bool cached = Load(path, stored, storedContent);
+  if (cached)
+  {
+    if (IsFresh(stored))
+    {
+      CLog::Log(LOGDEBUG, "%s - using cached response for %s", __FUNCTION__, CURL::GetRedacted(url).c_str());
+      content = storedContent;
+      headers = stored;
+      return true;
+    }
+
+    if (!stored.GetValue("etag").empty())
+      http.SetRequestHeader("If-None-Match", stored.GetValue("etag"));
+    if (!stored.GetValue("last-modified").empty())
+      http.SetRequestHeader("If-Modified-Since", stored.GetValue("last-modified"));
+  }
+
+  bool fetched = http.Get(url, content);
+
+  // blank headers aren't sent, so the curl file can go on to other urls
+  if (cached)
+  {
+    http.SetRequestHeader("If-None-Match", "");
+    http.SetRequestHeader("If-Modified-Since", "");
+  }
+
+  if (!fetched)
+    return false;
+
+  const CHttpHeader &response = http.GetHttpHeader();
+  if (cached && GetStatus(response) == 304)
+  {
+    CLog::Log(LOGDEBUG, "%s - cached response for %s is still valid", __FUNCTION__, CURL::GetRedacted(url).c_str());
+
+    // the headers sent along with a 304 replace the stored ones
+    const char *updated[] = { "cache-control", "expires", "date", "etag", "last-modified" };
+    for (unsigned int i = 0; i < sizeof(updated) / sizeof(updated[0]); i++)
+    {
+      std::string value = response.GetValue(updated[i]);
+      if (!value.empty())
+        stored.AddParam(updated[i], value, true);
+    }
+    stored.AddParam(STORED_HEADER, CDateTime::GetUTCDateTime().GetAsRFC1123DateTime(), true);
+    Store(path, stored, storedContent);
+
+    content = storedContent;
+    headers = stored;
+    return true;
+  }
+
+  headers = response;
+  if (GetStatus(headers) == 200 && IsStorable(headers))
+  {
+    CHttpHeader store(headers);
+    store.AddParam(STORED_HEADER, CDateTime::GetUTCDateTime().GetAsRFC1123DateTime(), true);
+    Store(path, store, content);
+  }
+  else if (cached)
+    Remove(path);
+
+  return true;
+}
+
+void CScraperHttpCache::Clear()
+{
+  CSingleLock lock(m_section);
+  CFileItemList items;
+  CDirectory::GetDirectory(m_folder, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    if (!items[i]->m_bIsFolder)
+      CFile::Delete(items[i]->GetPath());
+  }
+  m_size = 0;
+}
+
+std::string CScraperHttpCache::GetPath(const std::string &url) const
+{
+  return m_folder + XBMC::XBMC_MD5::GetMD5(url);
+}
+
+bool CScraperHttpCache::Load(const std::string &path, CHttpHeader &headers, std::string &content)
+{
+  CSingleLock lock(m_section);
+  if (!CFile::Exists(path))
+    return false;
+
+  CFile file;
+  auto_buffer buffer;
+  if (file.LoadFile(path, buffer) <= 0)
+    return false;
+
+  std::string response(buffer.get(), buffer.size());
+  size_t end = response.find("\r\n\r\n");
+  if (end == std::string::npos)
+    return false;
+
+  headers.Parse(response.substr(0, end + 4));
+  if (headers.GetValue(STORED_HEADER).empty())
+    return false;
+
+  content = response.substr(end + 4);
+  return true;
+}
+
+void CScraperHttpCache::Store(const std::string &path, const CHttpHeader &headers, const std::string &content)
+{
+  CSingleLock lock(m_section);
+  int64_t size = GetSize();
+
+  struct __stat64 buffer;
+  if (CFile::Stat(path, &buffer) == 0)
+    size -= buffer.st_size;
+  else if (!CDirectory::Exists(m_folder))
+  {
+    CDirectory::Create(URIUtils::GetParentPath(m_folder));
+    CDirectory::Create(m_folder);
+  }
+
+  std::string header = headers.GetHeader();
+  CFile file;
+  if (!file.OpenForWrite(path, true) ||
+      file.Write(header.c_str(), header.size()) != (int)header.size() ||
+      file.Write(content.c_str(), content.size()) != (int)content.size())
+  {
+    CLog::Log(LOGWARNING, "%s - unable to write %s", __FUNCTION__, path.c_str());
+    file.Close();
+    CFile::Delete(path);
+    m_size = -1;
+    return;
+  }
+  file.Close();
+
+  m_size = size + header.size() + content.size();
+  if (m_size > m_budget)
+    Trim(path);
+}
+
+void CScraperHttpCache::Remove(const std::string &path)
+{
+  CSingleLock lock(m_section);
+  struct __stat64 buffer;
+  if (CFile::Stat(path, &buffer) == 0 && CFile::Delete(path) && m_size >= 0)
+    m_size -= buffer.st_size;
+}
+
+void CScraperHttpCache::Trim(const std::string &keep)
+{
+  // remove the responses fetched longest ago until we're back to 90% of the budget, keeping
+  // the one just stored even if others share its mtime
+  CFileItemList items;
+  CDirectory::GetDirectory(m_folder, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+  items.Sort(SortByDate, SortOrderAscending);
+
+  int64_t target = m_budget / 10 * 9;
+  int removed = 0;
+  for (int i = 0; i < items.Size() && m_size > target; i++)
+  {
+    if (!items[i]->m_bIsFolder && items[i]->GetPath() != keep && CFile::Delete(items[i]->GetPath()))
+    {
+      m_size -= items[i]->m_dwSize;
+      removed++;
+    }
+  }
+  CLog::Log(LOGDEBUG, "%s - removed %i responses, %" PRId64 " bytes left", __FUNCTION__, removed, m_size);
+}
+
+int64_t CScraperHttpCache::GetSize()
+{
+  if (m_size < 0)
+  {
+    m_size = 0;
+    CFileItemList items;
+    CDirectory::GetDirectory(m_folder, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+    for (int i = 0; i < items.Size(); i++)
+    {
+      if (!items[i]->m_bIsFolder)
+        m_size += items[i]->m_dwSize;
+    }
+  }
+  return m_size;
+}
+
+int CScraperHttpCache::GetStatus(const CHttpHeader &headers)
+{
+  // the status code follows the protocol, as in "HTTP/1.1 200 OK"
+  std::string protoLine = headers.GetProtoLine();
+  size_t pos = protoLine.find(' ');
+  if (pos == std::string::npos)
+    return -1;
+  return atoi(protoLine.c_str() + pos + 1);
+}
+
+bool CScraperHttpCache::IsFresh(const CHttpHeader &headers)
+{
+  CDateTime stored;
+  if (!stored.SetFromRFC1123DateTime(headers.GetValue(STORED_HEADER)))
+    return false;
+  int age = (CDateTime::GetUTCDateTime() - stored).GetSecondsTotal();
+
+  // Cache-Control takes precedence over Expires
+  int lifetime = 0;
+  bool maxAge = false;
+  vector<string> directives = StringUtils::Split(headers.GetValue("cache-control"), ",");
+  for (vector<string>::iterator it = directives.begin(); it != directives.end(); ++it)
+  {
+    std::string directive(*it);
+    StringUtils::Trim(directive);
+    StringUtils::ToLower(directive);
+    if (directive == "no-cache" || directive == "no-store")
+      return false;
+    if (StringUtils::StartsWith(directive, "max-age="))
+    {
+      lifetime = atoi(directive.c_str() + 8);
+      maxAge = true;
+    }
+  }
+
+  if (!maxAge)
+  {
+    // times are taken relative to the server's Date, so that its clock doesn't need to match ours
+    CDateTime date;
+    if (!date.SetFromRFC1123DateTime(headers.GetValue("date")))
+      date = stored;
+
+    CDateTime expires, modified;
+    if (!headers.GetValue("expires").empty())
+    {
+      if (expires.SetFromRFC1123DateTime(headers.GetValue("expires")))
+        lifetime = (expires - date).GetSecondsTotal();
+    }
+    else if (modified.SetFromRFC1123DateTime(headers.GetValue("last-modified")))
+      lifetime = std::min((date - modified).GetSecondsTotal() / 10, MAX_HEURISTIC_LIFETIME);
+  }
+
+  return age < lifetime;
+}
+
+bool CScraperHttpCache::IsStorable(const CHttpHeader &headers)
+{
+  std::string cacheControl = headers.GetValue("cache-control");
+  StringUtils::ToLower(cacheControl);
+  if (cacheControl.find("no-store") != std::string::npos)
+    return false;
+
+  // responses that are never fresh and can't be revalidated are of no use
+  return !cacheControl.empty() ||
+         !headers.GetValue("expires").empty() ||
+         !headers.GetValue("etag").empty() ||
+         !headers.GetValue("last-modified").empty();
+}
@@ -0,0 +1,83 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+#include <stdint.h>
+
+#include "threads/CriticalSection.h"
+
+class CHttpHeader;
+namespace XFILE { class CCurlFile; }
+
+/*!
+ \ingroup utils
+ \brief Disk cache of the pages fetched by scrapers.
+
+ Responses are kept with their headers in files named after the hash of their url, and reused
+ for as long as their Cache-Control (or Expires) headers allow. Stale responses with an ETag or
+ Last-Modified are revalidated with a conditional request, so that an unchanged page costs a
+ round trip rather than a download. Once the cache grows beyond its budget the least recently
+ fetched responses are removed.
+ */
+class CScraperHttpCache
+{
+public:
+  /*! \brief The cache used by the scrapers, in the scrapers/http folder of the cache path and
+   with the <scraperhttpcachesize> budget of advancedsettings.xml.
+   */
+  static CScraperHttpCache &Get();
+
+  /*! \brief A cache in the given folder.
+   \param budget the disk space the responses may take in bytes, 0 to not cache at all.
+   */
+  CScraperHttpCache(const std::string &folder, int64_t budget);
+
+  /*! \brief Fetch a url, from the cache where possible.
+   \param http the curl file to fetch with.
+   \param url the url to fetch.
+   \param content [out] the body of the response.
+   \param headers [out] the headers of the response, those stored with it if it came from the cache.
+   \return true if the url was fetched (or found in the cache), false otherwise.
+   */
+  bool Fetch(XFILE::CCurlFile &http, const std::string &url, std::string &content, CHttpHeader &headers);
+
+  /*! \brief Remove all cached responses.
+   */
+  void Clear();
+
+private:
+  std::string GetPath(const std::string &url) const;
+  bool Load(const std::string &path, CHttpHeader &headers, std::string &content);
+  void Store(const std::string &path, const CHttpHeader &headers, const std::string &content);
+  void Remove(const std::string &path);
+  void Trim(const std::string &keep);
+  int64_t GetSize();
+
+  static int GetStatus(const CHttpHeader &headers);
+  static bool IsFresh(const CHttpHeader &headers);
+  static bool IsStorable(const CHttpHeader &headers);
+
+  std::string m_folder;
+  int64_t m_budget;
+  int64_t m_size; ///< the disk space taken by the responses, -1 until it's been counted
+  CCriticalSection m_section;
+};
@@ -32,6 +32,8 @@
 #include "utils/StringUtils.h"
 #include "utils/XSLTUtils.h"
 #include "utils/XMLUtils.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
 #include <sstream>
 #include <cstring>
 
@@ -39,6 +41,90 @@ using namespace std;
 using namespace ADDON;
 using namespace XFILE;
 
+/*! \brief A <RegExp> or <XSLT> element of a scraper function, ready to run
+ */
+struct CScraperParser::CStep
+{
+  CStep()
+    : xslt(false), dest(1), append(false), hasInput(false), hasConditional(false), inverse(false),
+      hasExpression(false), dynamicExpression(false), dynamicOutput(false), caseless(true),
+      utf8(CRegExp::autoUtf8), repeat(false), clear(false), optional(-1), compare(-1)
+  {
+  }
+
+  std::vector<CStep> children; ///< the elements to run before this one
+  bool xslt;
+  int dest;
+  bool append;
+  bool hasInput;
+  std::string input;
+  bool hasConditional;
+  bool inverse;
+  std::string conditional;
+
+  std::string stylesheet;
+
+  bool hasExpression;
+  std::string expression;
+  bool dynamicExpression; ///< the expression uses buffers or settings, so it's compiled on each run
+  bool dynamicOutput;     ///< the output uses buffers or settings, so its tokens are inserted on each run
+  CRegExp regexp;         ///< the compiled expression, unless it's dynamic
+  std::string output;
+  bool caseless;
+  CRegExp::utf8Mode utf8;
+  bool repeat;
+  bool clear;
+  bool clean[MAX_SCRAPER_BUFFERS];
+  bool trim[MAX_SCRAPER_BUFFERS];
+  bool fixChars[MAX_SCRAPER_BUFFERS];
+  bool encode[MAX_SCRAPER_BUFFERS];
+  int optional;
+  int compare;
+};
+
+/*! \brief The functions of a scraper, compiled
+ */
+struct CScraperParser::CProgram
+{
+  struct CFunction
+  {
+    CFunction() : dest(1), clearBuffers(true) {}
+    int dest;
+    bool clearBuffers;
+    std::vector<CStep> steps;
+  };
+  std::map<std::string, CFunction> functions;
+
+  // expressions used on the matches
+  CRegExp optional;
+  CRegExp jsonUnicode;
+  CRegExp jsonHex;
+};
+
+CScraperParser::PROGRAMS CScraperParser::m_programs;
+CCriticalSection CScraperParser::m_programsSection;
+
+static bool IsDynamic(const std::string& str)
+{
+  return str.find("$$") != std::string::npos ||
+         str.find("$INFO[") != std::string::npos ||
+         str.find("$LOCALIZE[") != std::string::npos;
+}
+
+// the modification times and sizes of the files, empty if one can't be stat'ed
+static std::string GetStamp(const vector<string>& files)
+{
+  std::string stamp;
+  for (vector<string>::const_iterator it = files.begin(); it != files.end(); ++it)
+  {
+    struct __stat64 buffer;
+    if (CFile::Stat(*it, &buffer) != 0)
+      return "";
+    stamp += StringUtils::Format("%s:%" PRId64 ":%" PRId64 "|", it->c_str(), (int64_t)buffer.st_mtime, (int64_t)buffer.st_size);
+  }
+  return stamp;
+}
+
 CScraperParser::CScraperParser()
 {
   m_pRootElement = NULL;
@@ -67,7 +153,11 @@ CScraperParser &CScraperParser::operator=(const CScraperParser &parser)
     {
       m_scraper = parser.m_scraper;
       m_document = new CXBMCTinyXML(*parser.m_document);
-      LoadFromXML();
+      if (LoadFromXML())
+      {
+        m_files = parser.m_files;
+        m_program = parser.m_program;
+      }
     }
     else
       m_scraper = NULL;
@@ -87,6 +177,8 @@ void CScraperParser::Clear()
 
   m_document = NULL;
   m_strFile.clear();
+  m_files.clear();
+  m_program.reset();
 }
 
 bool CScraperParser::Load(const std::string& strXMLFile)
@@ -101,7 +193,10 @@ bool CScraperParser::Load(const std::string& strXMLFile)
   m_strFile = strXMLFile;
 
   if (m_document->LoadFile(strXMLFile))
+  {
+    m_files.push_back(strXMLFile);
     return LoadFromXML();
+  }
 
   delete m_document;
   m_document = NULL;
@@ -192,161 +287,111 @@ void CScraperParser::ReplaceBuffers(std::string& strDest)
     strDest.replace(strDest.begin()+iIndex,strDest.begin()+iIndex+2,"\n");
 }
 
-void CScraperParser::ParseExpression(const std::string& input, std::string& dest, TiXmlElement* element, bool bAppend)
+void CScraperParser::ParseExpression(const std::string& input, std::string& dest, const CStep& step, bool bAppend)
 {
-  std::string strOutput = XMLUtils::GetAttribute(element, "output");
+  if (!step.hasExpression)
+    return;
 
-  TiXmlElement* pExpression = element->FirstChildElement("expression");
-  if (pExpression)
+  CRegExp reg(step.caseless, step.utf8);
+  if (step.dynamicExpression)
   {
-    bool bInsensitive=true;
-    const char* sensitive = pExpression->Attribute("cs");
-    if (sensitive)
-      if (stricmp(sensitive,"yes") == 0)
-        bInsensitive=false; // match case sensitive
-
-    CRegExp::utf8Mode eUtf8 = CRegExp::autoUtf8;
-    const char* const strUtf8 = pExpression->Attribute("utf8");
-    if (strUtf8)
-    {
-      if (stricmp(strUtf8, "yes") == 0)
-        eUtf8 = CRegExp::forceUtf8;
-      else if (stricmp(strUtf8, "no") == 0)
-        eUtf8 = CRegExp::asciiOnly;
-      else if (stricmp(strUtf8, "auto") == 0)
-        eUtf8 = CRegExp::autoUtf8;
-    }
-
-    CRegExp reg(bInsensitive, eUtf8);
-    std::string strExpression;
-    if (pExpression->FirstChild())
-      strExpression = pExpression->FirstChild()->Value();
-    else
-      strExpression = "(.*)";
+    std::string strExpression = step.expression;
     ReplaceBuffers(strExpression);
-    ReplaceBuffers(strOutput);
-
     if (!reg.RegComp(strExpression.c_str()))
-    {
       return;
-    }
-
-    bool bRepeat = false;
-    const char* szRepeat = pExpression->Attribute("repeat");
-    if (szRepeat)
-      if (stricmp(szRepeat,"yes") == 0)
-        bRepeat = true;
-
-    const char* szClear = pExpression->Attribute("clear");
-    if (szClear)
-      if (stricmp(szClear,"yes") == 0)
-        dest=""; // clear no matter if regexp fails
-
-    bool bClean[MAX_SCRAPER_BUFFERS];
-    GetBufferParams(bClean,pExpression->Attribute("noclean"),true);
-
-    bool bTrim[MAX_SCRAPER_BUFFERS];
-    GetBufferParams(bTrim,pExpression->Attribute("trim"),false);
+  }
+  else if (step.regexp.IsCompiled())
+    reg = step.regexp;
+  else
+    return;
 
-    bool bFixChars[MAX_SCRAPER_BUFFERS];
-    GetBufferParams(bFixChars,pExpression->Attribute("fixchars"),false);
+  if (step.clear)
+    dest=""; // clear no matter if regexp fails
 
-    bool bEncode[MAX_SCRAPER_BUFFERS];
-    GetBufferParams(bEncode,pExpression->Attribute("encode"),false);
+  int iOptional = step.optional;
+  std::string strOutput = step.output;
+  if (step.dynamicOutput)
+  {
+    ReplaceBuffers(strOutput);
+    InsertTokens(strOutput, step);
+  }
 
-    int iOptional = -1;
-    pExpression->QueryIntAttribute("optional",&iOptional);
+  // after the buffers went into the output, which sees the compared one unchanged
+  int iCompare = step.compare;
+  if (iCompare > -1)
+    StringUtils::ToLower(m_param[iCompare-1]);
 
-    int iCompare = -1;
-    pExpression->QueryIntAttribute("compare",&iCompare);
-    if (iCompare > -1)
-      StringUtils::ToLower(m_param[iCompare-1]);
-    std::string curInput = input;
-    for (int iBuf=0;iBuf<MAX_SCRAPER_BUFFERS;++iBuf)
+  std::string curInput = input;
+  int i = reg.RegFind(curInput.c_str());
+  while (i > -1 && (i < (int)curInput.size() || curInput.size() == 0))
+  {
+    if (!bAppend)
     {
-      if (bClean[iBuf])
-        InsertToken(strOutput,iBuf+1,"!!!CLEAN!!!");
-      if (bTrim[iBuf])
-        InsertToken(strOutput,iBuf+1,"!!!TRIM!!!");
-      if (bFixChars[iBuf])
-        InsertToken(strOutput,iBuf+1,"!!!FIXCHARS!!!");
-      if (bEncode[iBuf])
-        InsertToken(strOutput,iBuf+1,"!!!ENCODE!!!");
+      dest = "";
+      bAppend = true;
     }
-    int i = reg.RegFind(curInput.c_str());
-    while (i > -1 && (i < (int)curInput.size() || curInput.size() == 0))
-    {
-      if (!bAppend)
-      {
-        dest = "";
-        bAppend = true;
-      }
-      std::string strCurOutput=strOutput;
+    std::string strCurOutput=strOutput;
 
-      if (iOptional > -1) // check that required param is there
+    if (iOptional > -1) // check that required param is there
+    {
+      char temp[4];
+      sprintf(temp,"\\%i",iOptional);
+      std::string szParam = reg.GetReplaceString(temp);
+      CRegExp reg2(m_program->optional);
+      int i2=reg2.RegFind(strCurOutput.c_str());
+      while (i2 > -1)
       {
-        char temp[4];
-        sprintf(temp,"\\%i",iOptional);
-        std::string szParam = reg.GetReplaceString(temp);
-        CRegExp reg2;
-        reg2.RegComp("(.*)(\\\\\\(.*\\\\2.*)\\\\\\)(.*)");
-        int i2=reg2.RegFind(strCurOutput.c_str());
-        while (i2 > -1)
+        std::string szRemove(reg2.GetMatch(2));
+        int iRemove = szRemove.size();
+        int i3 = strCurOutput.find(szRemove);
+        if (!szParam.empty())
         {
-          std::string szRemove(reg2.GetMatch(2));
-          int iRemove = szRemove.size();
-          int i3 = strCurOutput.find(szRemove);
-          if (!szParam.empty())
-          {
-            strCurOutput.erase(i3+iRemove,2);
-            strCurOutput.erase(i3,2);
-          }
-          else
-            strCurOutput.replace(strCurOutput.begin()+i3,strCurOutput.begin()+i3+iRemove+2,"");
-
-          i2 = reg2.RegFind(strCurOutput.c_str());
+          strCurOutput.erase(i3+iRemove,2);
+          strCurOutput.erase(i3,2);
         }
+        else
+          strCurOutput.replace(strCurOutput.begin()+i3,strCurOutput.begin()+i3+iRemove+2,"");
+
+        i2 = reg2.RegFind(strCurOutput.c_str());
       }
+    }
 
-      int iLen = reg.GetFindLen();
-      // nasty hack #1 - & means \0 in a replace string
-      StringUtils::Replace(strCurOutput, "&","!!!AMPAMP!!!");
-      std::string result = reg.GetReplaceString(strCurOutput.c_str());
-      if (!result.empty())
+    int iLen = reg.GetFindLen();
+    // nasty hack #1 - & means \0 in a replace string
+    StringUtils::Replace(strCurOutput, "&","!!!AMPAMP!!!");
+    std::string result = reg.GetReplaceString(strCurOutput.c_str());
+    if (!result.empty())
+    {
+      std::string strResult(result);
+      StringUtils::Replace(strResult, "!!!AMPAMP!!!","&");
+      Clean(strResult);
+      ReplaceBuffers(strResult);
+      if (iCompare > -1)
       {
-        std::string strResult(result);
-        StringUtils::Replace(strResult, "!!!AMPAMP!!!","&");
-        Clean(strResult);
-        ReplaceBuffers(strResult);
-        if (iCompare > -1)
-        {
-          std::string strResultNoCase = strResult;
-          StringUtils::ToLower(strResultNoCase);
-          if (strResultNoCase.find(m_param[iCompare-1]) != std::string::npos)
-            dest += strResult;
-        }
-        else
+        std::string strResultNoCase = strResult;
+        StringUtils::ToLower(strResultNoCase);
+        if (strResultNoCase.find(m_param[iCompare-1]) != std::string::npos)
           dest += strResult;
       }
-      if (bRepeat && iLen > 0)
-      {
-        curInput.erase(0,i+iLen>(int)curInput.size()?curInput.size():i+iLen);
-        i = reg.RegFind(curInput.c_str());
-      }
       else
-        i = -1;
+        dest += strResult;
     }
+    if (step.repeat && iLen > 0)
+    {
+      curInput.erase(0,i+iLen>(int)curInput.size()?curInput.size():i+iLen);
+      i = reg.RegFind(curInput.c_str());
+    }
+    else
+      i = -1;
   }
 }
 
-void CScraperParser::ParseXSLT(const std::string& input, std::string& dest, TiXmlElement* element, bool bAppend)
+void CScraperParser::ParseXSLT(const std::string& input, std::string& dest, const CStep& step, bool bAppend)
 {
-  TiXmlElement* pSheet = element->FirstChildElement();
-  if (pSheet)
+  if (!step.stylesheet.empty())
   {
     XSLTUtils xsltUtils;
-    std::string strXslt;
-    strXslt << *pSheet;
+    std::string strXslt = step.stylesheet;
     ReplaceBuffers(strXslt);
 
     if (!xsltUtils.SetInput(input))
@@ -379,98 +424,231 @@ TiXmlElement *NextSiblingScraperElement(TiXmlElement *element)
   return NULL;
 }
 
-void CScraperParser::ParseNext(TiXmlElement* element)
+void CScraperParser::ParseNext(const std::vector<CStep>& steps)
 {
-  TiXmlElement* pReg = element;
-  while (pReg)
+  for (std::vector<CStep>::const_iterator step = steps.begin(); step != steps.end(); ++step)
   {
-    TiXmlElement* pChildReg = FirstChildScraperElement(pReg);
-    if (pChildReg)
-      ParseNext(pChildReg);
-    else
-    {
-      TiXmlElement* pChildReg = pReg->FirstChildElement("clear");
-      if (pChildReg)
-        ParseNext(pChildReg);
-    }
-
-    int iDest = 1;
-    bool bAppend = false;
-    const char* szDest = pReg->Attribute("dest");
-    if (szDest && strlen(szDest))
-    {
-      if (szDest[strlen(szDest)-1] == '+')
-        bAppend = true;
+    ParseNext(step->children);
 
-      iDest = atoi(szDest);
-    }
-
-    const char *szInput = pReg->Attribute("input");
     std::string strInput;
-    if (szInput)
+    if (step->hasInput)
     {
-      strInput = szInput;
+      strInput = step->input;
       ReplaceBuffers(strInput);
     }
     else
       strInput = m_param[0];
 
-    const char* szConditional = pReg->Attribute("conditional");
     bool bExecute = true;
-    if (szConditional)
+    if (step->hasConditional)
     {
-      bool bInverse=false;
-      if (szConditional[0] == '!')
-      {
-        bInverse = true;
-        szConditional++;
-      }
       std::string strSetting;
       if (m_scraper && m_scraper->HasSettings())
-        strSetting = m_scraper->GetSetting(szConditional);
-      bExecute = bInverse != (strSetting == "true");
+        strSetting = m_scraper->GetSetting(step->conditional);
+      bExecute = step->inverse != (strSetting == "true");
     }
 
     if (bExecute)
     {
-      if (iDest-1 < MAX_SCRAPER_BUFFERS && iDest-1 > -1)
+      if (step->dest-1 < MAX_SCRAPER_BUFFERS && step->dest-1 > -1)
       {
-        if (pReg->ValueStr() == "XSLT")
-          ParseXSLT(strInput, m_param[iDest - 1], pReg, bAppend);
+        if (step->xslt)
+          ParseXSLT(strInput, m_param[step->dest - 1], *step, step->append);
         else
-          ParseExpression(strInput, m_param[iDest - 1],pReg,bAppend);
+          ParseExpression(strInput, m_param[step->dest - 1], *step, step->append);
       }
       else
         CLog::Log(LOGERROR,"CScraperParser::ParseNext: destination buffer "
                            "out of bounds, skipping expression");
     }
-    pReg = NextSiblingScraperElement(pReg);
   }
 }
 
 const std::string CScraperParser::Parse(const std::string& strTag,
                                        CScraper* scraper)
 {
-  TiXmlElement* pChildElement = m_pRootElement->FirstChildElement(strTag.c_str());
-  if(pChildElement == NULL)
+  if (!m_program)
+    m_program = GetProgram();
+
+  std::map<std::string, CProgram::CFunction>::const_iterator function = m_program->functions.find(strTag);
+  if (function == m_program->functions.end())
   {
     CLog::Log(LOGERROR,"%s: Could not find scraper function %s",__FUNCTION__,strTag.c_str());
     return "";
   }
-  int iResult = 1; // default to param 1
-  pChildElement->QueryIntAttribute("dest",&iResult);
-  TiXmlElement* pChildStart = FirstChildScraperElement(pChildElement);
   m_scraper = scraper;
-  ParseNext(pChildStart);
-  std::string tmp = m_param[iResult-1];
+  ParseNext(function->second.steps);
+  std::string tmp = m_param[function->second.dest-1];
 
-  const char* szClearBuffers = pChildElement->Attribute("clearbuffers");
-  if (!szClearBuffers || stricmp(szClearBuffers,"no") != 0)
+  if (function->second.clearBuffers)
     ClearBuffers();
 
   return tmp;
 }
 
+boost::shared_ptr<const CScraperParser::CProgram> CScraperParser::GetProgram()
+{
+  std::string stamp = GetStamp(m_files);
+  if (!stamp.empty())
+  {
+    CSingleLock lock(m_programsSection);
+    PROGRAMS::const_iterator it = m_programs.find(m_strFile);
+    if (it != m_programs.end() && it->second.first == stamp)
+      return it->second.second;
+  }
+
+  boost::shared_ptr<CProgram> program(new CProgram);
+  Compile(*program);
+
+  if (!stamp.empty())
+  {
+    CSingleLock lock(m_programsSection);
+    m_programs[m_strFile] = std::make_pair(stamp, boost::shared_ptr<const CProgram>(program));
+  }
+  return program;
+}
+
+void CScraperParser::Compile(CProgram& program)
+{
+  program.optional.RegComp("(.*)(\\\\\\(.*\\\\2.*)\\\\\\)(.*)");
+  program.jsonUnicode.RegComp("\\\\u([0-f]{4})");
+  program.jsonHex.RegComp("\\\\x([0-9]{2})([^\\\\]+;)");
+
+  if (!m_pRootElement)
+    return;
+
+  for (TiXmlElement* pFunction = m_pRootElement->FirstChildElement(); pFunction; pFunction = pFunction->NextSiblingElement())
+  {
+    // the first function of a name is the one used
+    if (program.functions.find(pFunction->ValueStr()) != program.functions.end())
+      continue;
+
+    CProgram::CFunction &function = program.functions[pFunction->ValueStr()];
+    pFunction->QueryIntAttribute("dest",&function.dest);
+    const char* szClearBuffers = pFunction->Attribute("clearbuffers");
+    function.clearBuffers = !szClearBuffers || stricmp(szClearBuffers,"no") != 0;
+    CompileSteps(FirstChildScraperElement(pFunction), function.steps);
+  }
+}
+
+void CScraperParser::CompileSteps(TiXmlElement* element, std::vector<CStep>& steps)
+{
+  for (TiXmlElement* pReg = element; pReg; pReg = NextSiblingScraperElement(pReg))
+  {
+    steps.push_back(CStep());
+    CompileStep(pReg, steps.back());
+  }
+}
+
+void CScraperParser::CompileStep(TiXmlElement* element, CStep& step)
+{
+  TiXmlElement* pChildReg = FirstChildScraperElement(element);
+  if (!pChildReg)
+    pChildReg = element->FirstChildElement("clear");
+  if (pChildReg)
+    CompileSteps(pChildReg, step.children);
+
+  step.xslt = element->ValueStr() == "XSLT";
+
+  const char* szDest = element->Attribute("dest");
+  if (szDest && strlen(szDest))
+  {
+    if (szDest[strlen(szDest)-1] == '+')
+      step.append = true;
+
+    step.dest = atoi(szDest);
+  }
+
+  const char *szInput = element->Attribute("input");
+  if (szInput)
+  {
+    step.hasInput = true;
+    step.input = szInput;
+  }
+
+  const char* szConditional = element->Attribute("conditional");
+  if (szConditional)
+  {
+    step.hasConditional = true;
+    if (szConditional[0] == '!')
+    {
+      step.inverse = true;
+      szConditional++;
+    }
+    step.conditional = szConditional;
+  }
+
+  if (step.xslt)
+  {
+    TiXmlElement* pSheet = element->FirstChildElement();
+    if (pSheet)
+      step.stylesheet << *pSheet;
+    return;
+  }
+
+  TiXmlElement* pExpression = element->FirstChildElement("expression");
+  if (!pExpression)
+    return;
+  step.hasExpression = true;
+
+  const char* sensitive = pExpression->Attribute("cs");
+  if (sensitive)
+    if (stricmp(sensitive,"yes") == 0)
+      step.caseless=false; // match case sensitive
+
+  const char* const strUtf8 = pExpression->Attribute("utf8");
+  if (strUtf8)
+  {
+    if (stricmp(strUtf8, "yes") == 0)
+      step.utf8 = CRegExp::forceUtf8;
+    else if (stricmp(strUtf8, "no") == 0)
+      step.utf8 = CRegExp::asciiOnly;
+    else if (stricmp(strUtf8, "auto") == 0)
+      step.utf8 = CRegExp::autoUtf8;
+  }
+
+  if (pExpression->FirstChild())
+    step.expression = pExpression->FirstChild()->Value();
+  else
+    step.expression = "(.*)";
+
+  const char* szRepeat = pExpression->Attribute("repeat");
+  if (szRepeat)
+    if (stricmp(szRepeat,"yes") == 0)
+      step.repeat = true;
+
+  const char* szClear = pExpression->Attribute("clear");
+  if (szClear)
+    if (stricmp(szClear,"yes") == 0)
+      step.clear = true;
+
+  GetBufferParams(step.clean,pExpression->Attribute("noclean"),true);
+  GetBufferParams(step.trim,pExpression->Attribute("trim"),false);
+  GetBufferParams(step.fixChars,pExpression->Attribute("fixchars"),false);
+  GetBufferParams(step.encode,pExpression->Attribute("encode"),false);
+
+  pExpression->QueryIntAttribute("optional",&step.optional);
+  pExpression->QueryIntAttribute("compare",&step.compare);
+
+  // whatever doesn't depend on the buffers or settings is prepared once
+  step.dynamicExpression = IsDynamic(step.expression);
+  if (!step.dynamicExpression)
+  {
+    ReplaceBuffers(step.expression);
+    CRegExp reg(step.caseless, step.utf8);
+    if (reg.RegComp(step.expression.c_str()))
+      step.regexp = reg;
+  }
+
+  step.output = XMLUtils::GetAttribute(element, "output");
+  step.dynamicOutput = IsDynamic(step.output);
+  if (!step.dynamicOutput)
+  {
+    ReplaceBuffers(step.output);
+    InsertTokens(step.output, step);
+  }
+}
+
 void CScraperParser::Clean(std::string& strDirty)
 {
   size_t i = 0;
@@ -541,8 +719,7 @@ void CScraperParser::Clean(std::string& strDirty)
 
 void CScraperParser::ConvertJSON(std::string &string)
 {
-  CRegExp reg;
-  reg.RegComp("\\\\u([0-f]{4})");
+  CRegExp reg(m_program->jsonUnicode);
   while (reg.RegFind(string.c_str()) > -1)
   {
     int pos = reg.GetSubStart(1);
@@ -552,8 +729,7 @@ void CScraperParser::ConvertJSON(std::string &string)
     string.replace(string.begin()+pos-2, string.begin()+pos+4, replace);
   }
 
-  CRegExp reg2;
-  reg2.RegComp("\\\\x([0-9]{2})([^\\\\]+;)");
+  CRegExp reg2(m_program->jsonHex);
   while (reg2.RegFind(string.c_str()) > -1)
   {
     int pos1 = reg2.GetSubStart(1);
@@ -591,6 +767,21 @@ void CScraperParser::GetBufferParams(bool* result, const char* attribute, bool d
   }
 }
 
+void CScraperParser::InsertTokens(std::string& strOutput, const CStep& step)
+{
+  for (int iBuf=0;iBuf<MAX_SCRAPER_BUFFERS;++iBuf)
+  {
+    if (step.clean[iBuf])
+      InsertToken(strOutput,iBuf+1,"!!!CLEAN!!!");
+    if (step.trim[iBuf])
+      InsertToken(strOutput,iBuf+1,"!!!TRIM!!!");
+    if (step.fixChars[iBuf])
+      InsertToken(strOutput,iBuf+1,"!!!FIXCHARS!!!");
+    if (step.encode[iBuf])
+      InsertToken(strOutput,iBuf+1,"!!!ENCODE!!!");
+  }
+}
+
 void CScraperParser::InsertToken(std::string& strOutput, int buf, const char* token)
 {
   char temp[4];
@@ -612,5 +803,7 @@ void CScraperParser::AddDocument(const CXBMCTinyXML* doc)
     m_pRootElement->InsertEndChild(*node);
     node = node->NextSibling();
   }
+  m_files.push_back(doc->ValueStr());
+  m_program.reset();
 }
 
@@ -21,9 +21,13 @@
  *
  */
 
+#include <map>
 #include <string>
 #include <vector>
 
+#include "boost/shared_ptr.hpp"
+#include "threads/CriticalSection.h"
+
 #define MAX_SCRAPER_BUFFERS 20
 
 namespace ADDON
@@ -58,9 +62,24 @@ public:
   std::string m_param[MAX_SCRAPER_BUFFERS];
 
 private:
+  struct CStep;
+  struct CProgram;
+
   bool LoadFromXML();
+
+  /*! \brief Get the compiled program of the loaded scraper (and its libraries)
+   The scraper functions are compiled once into steps with their attributes parsed and
+   their regular expressions compiled wherever they don't depend on buffers or settings.
+   Programs are shared by all parsers of the same files, and compiled again once a file
+   changes, e.g. when the addon is updated.
+   */
+  boost::shared_ptr<const CProgram> GetProgram();
+  void Compile(CProgram& program);
+  void CompileSteps(TiXmlElement* element, std::vector<CStep>& steps);
+  void CompileStep(TiXmlElement* element, CStep& step);
+
   void ReplaceBuffers(std::string& strDest);
-  void ParseExpression(const std::string& input, std::string& dest, TiXmlElement* element, bool bAppend);
+  void ParseExpression(const std::string& input, std::string& dest, const CStep& step, bool bAppend);
 
   /*! \brief Parse an 'XSLT' declaration from the scraper
    This allow us to transform an inbound XML document using XSLT
@@ -71,13 +90,14 @@ private:
    \param element the current XML element
    \param bAppend append or clear the buffer
    */
-  void ParseXSLT(const std::string& input, std::string& dest, TiXmlElement* element, bool bAppend);
-  void ParseNext(TiXmlElement* element);
+  void ParseXSLT(const std::string& input, std::string& dest, const CStep& step, bool bAppend);
+  void ParseNext(const std::vector<CStep>& steps);
   void Clean(std::string& strDirty);
   void ConvertJSON(std::string &string);
   void ClearBuffers();
   void GetBufferParams(bool* result, const char* attribute, bool defvalue);
   void InsertToken(std::string& strOutput, int buf, const char* token);
+  void InsertTokens(std::string& strOutput, const CStep& step);
 
   CXBMCTinyXML* m_document;
   TiXmlElement* m_pRootElement;
@@ -86,7 +106,13 @@ private:
   bool m_isNoop;
 
   std::string m_strFile;
+  std::vector<std::string> m_files; ///< the scraper and the libraries added to it
+  boost::shared_ptr<const CProgram> m_program;
   ADDON::CScraper* m_scraper;
+
+  typedef std::map<std::string, std::pair<std::string, boost::shared_ptr<const CProgram> > > PROGRAMS;
+  static PROGRAMS m_programs; ///< compiled programs by scraper file, with the stamp of the files they were compiled from
+  static CCriticalSection m_programsSection;
 };
 
 #endif
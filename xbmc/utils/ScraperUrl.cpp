@@ -32,6 +32,8 @@
 #include "utils/XBMCTinyXML.h"
 #include "utils/XMLUtils.h"
 #include "utils/Mime.h"
+#include "utils/HttpHeader.h"
+#include "utils/ScraperHttpCache.h"
 
 #include <cstring>
 #include <sstream>
@@ -193,7 +195,7 @@ unsigned int CScraperUrl::GetMaxSeasonThumb() const
   return maxSeason;
 }
 
-bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CCurlFile& http, const std::string& cacheContext)
+bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CCurlFile& http, const std::string& cacheContext, bool httpCache)
 {
   CURL url(scrURL.m_url);
   http.SetReferer(scrURL.m_spoof);
@@ -219,6 +221,7 @@ bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CCur
   }
 
   std::string strHTML1(strHTML);
+  CHttpHeader headers;
 
   if (scrURL.m_post)
   {
@@ -228,14 +231,23 @@ bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CCur
 
     if (!http.Post(url.Get(), strOptions, strHTML1))
       return false;
+    headers = http.GetHttpHeader();
+  }
+  else if (httpCache)
+  {
+    if (!CScraperHttpCache::Get().Fetch(http, url.Get(), strHTML1, headers))
+      return false;
   }
   else
+  {
     if (!http.Get(url.Get(), strHTML1))
       return false;
+    headers = http.GetHttpHeader();
+  }
 
   strHTML = strHTML1;
 
-  std::string mimeType(http.GetMimeType());
+  std::string mimeType(headers.GetMimeType());
   CMime::EFileType ftype = CMime::GetFileTypeFromMime(mimeType);
   if (ftype == CMime::FileTypeUnknown)
     ftype = CMime::GetFileTypeFromContent(strHTML);
@@ -254,7 +266,7 @@ bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CCur
       CLog::Log(LOGWARNING, "%s: \"%s\" looks like archive, but cannot be unpacked", __FUNCTION__, scrURL.m_url.c_str());
   }
 
-  std::string reportedCharset(http.GetServerReportedCharset());
+  std::string reportedCharset(headers.GetCharset());
   if (ftype == CMime::FileTypeHtml)
   {
     std::string realHtmlCharset, converted;
@@ -76,8 +76,16 @@ public:
    */
   void GetThumbURLs(std::vector<std::string> &thumbs, const std::string &type = "", int season = -1) const;
   void Clear();
-  static bool Get(const SUrlEntry&, std::string&, XFILE::CCurlFile& http,
-                 const std::string& cacheContext);
+  /*! \brief fetch the content of a URL entry
+   \param scrURL the URL entry to fetch
+   \param strHTML [out] the content, converted to UTF-8
+   \param http the curl file to fetch with
+   \param cacheContext the scraper whose cache folder holds the entries cached by name
+   \param httpCache whether to go through the disk cache of HTTP responses (GET requests only)
+   \return true if the content was fetched, false otherwise
+   */
+  static bool Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CCurlFile& http,
+                 const std::string& cacheContext, bool httpCache);
 
   std::string m_xml;
   std::string m_spoof; // for backwards compatibility only!
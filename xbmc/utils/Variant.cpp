@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sstream>
+#include <algorithm>
 
 #include "Variant.h"
 
@@ -130,9 +131,51 @@ double str2double(const wstring &str, double fallback /* = 0.0 */)
 
 CVariant CVariant::ConstNullVariant = CVariant::VariantTypeConstNull;
 
+namespace
+{
+  inline void swapElement(CVariant &lhs, CVariant &rhs)
+  {
+    lhs.swap(rhs);
+  }
+
+  /* std::vector would copy every (deep) element when it reallocates, so grow
+     by swapping the elements into default constructed ones instead. */
+  template<typename T>
+  void reserveElements(std::vector<T> &elements, size_t capacity)
+  {
+    if (capacity <= elements.capacity())
+      return;
+
+    std::vector<T> grown;
+    grown.reserve(capacity);
+    grown.resize(elements.size());
+    for (size_t index = 0; index < elements.size(); index++)
+      swapElement(grown[index], elements[index]);
+    elements.swap(grown);
+  }
+
+  template<typename T>
+  T &appendElement(std::vector<T> &elements)
+  {
+    if (elements.size() == elements.capacity())
+      reserveElements(elements, std::max<size_t>(4, elements.capacity() * 2));
+    elements.resize(elements.size() + 1);
+    return elements.back();
+  }
+
+  template<typename T>
+  void eraseElement(std::vector<T> &elements, size_t position)
+  {
+    for (size_t index = position; index + 1 < elements.size(); index++)
+      swapElement(elements[index], elements[index + 1]);
+    elements.pop_back();
+  }
+}
+
 CVariant::CVariant(VariantType type)
 {
   m_type = type;
+  m_smallString = false;
 
   switch (type)
   {
@@ -149,7 +192,7 @@ CVariant::CVariant(VariantType type)
       m_data.dvalue = 0.0;
       break;
     case VariantTypeString:
-      m_data.string = new string();
+      setString("", 0);
       break;
     case VariantTypeWideString:
       m_data.wstring = new wstring();
@@ -169,93 +212,104 @@ CVariant::CVariant(VariantType type)
 CVariant::CVariant(int integer)
 {
   m_type = VariantTypeInteger;
+  m_smallString = false;
   m_data.integer = integer;
 }
 
 CVariant::CVariant(int64_t integer)
 {
   m_type = VariantTypeInteger;
+  m_smallString = false;
   m_data.integer = integer;
 }
 
 CVariant::CVariant(unsigned int unsignedinteger)
 {
   m_type = VariantTypeUnsignedInteger;
+  m_smallString = false;
   m_data.unsignedinteger = unsignedinteger;
 }
 
 CVariant::CVariant(uint64_t unsignedinteger)
 {
   m_type = VariantTypeUnsignedInteger;
+  m_smallString = false;
   m_data.unsignedinteger = unsignedinteger;
 }
 
 CVariant::CVariant(double value)
 {
   m_type = VariantTypeDouble;
+  m_smallString = false;
   m_data.dvalue = value;
 }
 
 CVariant::CVariant(float value)
 {
   m_type = VariantTypeDouble;
+  m_smallString = false;
   m_data.dvalue = (double)value;
 }
 
 CVariant::CVariant(bool boolean)
 {
   m_type = VariantTypeBoolean;
+  m_smallString = false;
   m_data.boolean = boolean;
 }
 
 CVariant::CVariant(const char *str)
 {
   m_type = VariantTypeString;
-  m_data.string = new string(str);
+  setString(str, strlen(str));
 }
 
 CVariant::CVariant(const char *str, unsigned int length)
 {
   m_type = VariantTypeString;
-  m_data.string = new string(str, length);
+  setString(str, length);
 }
 
 CVariant::CVariant(const string &str)
 {
   m_type = VariantTypeString;
-  m_data.string = new string(str);
+  setString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(const wchar_t *str)
 {
   m_type = VariantTypeWideString;
+  m_smallString = false;
   m_data.wstring = new wstring(str);
 }
 
 CVariant::CVariant(const wchar_t *str, unsigned int length)
 {
   m_type = VariantTypeWideString;
+  m_smallString = false;
   m_data.wstring = new wstring(str, length);
 }
 
 CVariant::CVariant(const wstring &str)
 {
   m_type = VariantTypeWideString;
+  m_smallString = false;
   m_data.wstring = new wstring(str);
 }
 
 CVariant::CVariant(const std::vector<std::string> &strArray)
 {
   m_type = VariantTypeArray;
-  m_data.array = new VariantArray;
-  m_data.array->reserve(strArray.size());
+  m_smallString = false;
+  m_data.array = new VariantArray(strArray.size());
   for (unsigned int index = 0; index < strArray.size(); index++)
-    m_data.array->push_back(strArray.at(index));
+    (*m_data.array)[index] = strArray.at(index);
 }
 
 CVariant::CVariant(const std::map<std::string, std::string> &strMap)
 {
   m_type = VariantTypeObject;
+  m_smallString = false;
   m_data.map = new VariantMap;
   for (std::map<std::string, std::string>::const_iterator it = strMap.begin(); it != strMap.end(); ++it)
     m_data.map->insert(make_pair(it->first, CVariant(it->second)));
@@ -264,12 +318,14 @@ CVariant::CVariant(const std::map<std::string, std::string> &strMap)
 CVariant::CVariant(const std::map<std::string, CVariant> &variantMap)
 {
   m_type = VariantTypeObject;
+  m_smallString = false;
   m_data.map = new VariantMap(variantMap.begin(), variantMap.end());
 }
 
 CVariant::CVariant(const CVariant &variant)
 {
   m_type = VariantTypeNull;
+  m_smallString = false;
   *this = variant;
 }
 
@@ -280,7 +336,7 @@ CVariant::~CVariant()
 
 void CVariant::cleanup()
 {
-  if (m_type == VariantTypeString)
+  if (m_type == VariantTypeString && !m_smallString)
     delete m_data.string;
   else if (m_type == VariantTypeWideString)
     delete m_data.wstring;
@@ -289,6 +345,31 @@ void CVariant::cleanup()
   else if (m_type == VariantTypeObject)
     delete m_data.map;
   m_type = VariantTypeNull;
+  m_smallString = false;
+}
+
+void CVariant::setString(const char *str, size_t length)
+{
+  // embedded NULs would get lost in the inline copy
+  m_smallString = length <= SmallStringSize && memchr(str, '\0', length) == NULL;
+  if (m_smallString)
+  {
+    memcpy(m_data.smallstring, str, length);
+    m_data.smallstring[length] = '\0';
+  }
+  else
+    m_data.string = new string(str, length);
+}
+
+const char *CVariant::stringData(size_t &length) const
+{
+  if (m_smallString)
+  {
+    length = strlen(m_data.smallstring);
+    return m_data.smallstring;
+  }
+  length = m_data.string->size();
+  return m_data.string->c_str();
 }
 
 bool CVariant::isInteger() const
@@ -352,7 +433,7 @@ int64_t CVariant::asInteger(int64_t fallback) const
     case VariantTypeDouble:
       return (int64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2int64(*m_data.string, fallback);
+      return str2int64(asString(), fallback);
     case VariantTypeWideString:
       return str2int64(*m_data.wstring, fallback);
     default:
@@ -373,7 +454,7 @@ uint64_t CVariant::asUnsignedInteger(uint64_t fallback) const
     case VariantTypeDouble:
       return (uint64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2uint64(*m_data.string, fallback);
+      return str2uint64(asString(), fallback);
     case VariantTypeWideString:
       return str2uint64(*m_data.wstring, fallback);
     default:
@@ -394,7 +475,7 @@ double CVariant::asDouble(double fallback) const
     case VariantTypeUnsignedInteger:
       return (double)m_data.unsignedinteger;
     case VariantTypeString:
-      return str2double(*m_data.string, fallback);
+      return str2double(asString(), fallback);
     case VariantTypeWideString:
       return str2double(*m_data.wstring, fallback);
     default:
@@ -415,7 +496,7 @@ float CVariant::asFloat(float fallback) const
     case VariantTypeUnsignedInteger:
       return (float)m_data.unsignedinteger;
     case VariantTypeString:
-      return (float)str2double(*m_data.string, fallback);
+      return (float)str2double(asString(), fallback);
     case VariantTypeWideString:
       return (float)str2double(*m_data.wstring, fallback);
     default:
@@ -438,9 +519,13 @@ bool CVariant::asBoolean(bool fallback) const
     case VariantTypeDouble:
       return (m_data.dvalue != 0);
     case VariantTypeString:
-      if (m_data.string->empty() || m_data.string->compare("0") == 0 || m_data.string->compare("false") == 0)
+    {
+      size_t length;
+      const char *str = stringData(length);
+      if (length == 0 || (length == 1 && str[0] == '0') || (length == 5 && memcmp(str, "false", 5) == 0))
         return false;
       return true;
+    }
     case VariantTypeWideString:
       if (m_data.wstring->empty() || m_data.wstring->compare(L"0") == 0 || m_data.wstring->compare(L"false") == 0)
         return false;
@@ -457,7 +542,11 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   switch (m_type)
   {
     case VariantTypeString:
-      return *m_data.string;
+    {
+      size_t length;
+      const char *str = stringData(length);
+      return std::string(str, length);
+    }
     case VariantTypeBoolean:
       return m_data.boolean ? "true" : "false";
     case VariantTypeInteger:
@@ -571,16 +660,20 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.dvalue = rhs.m_data.dvalue;
     break;
   case VariantTypeString:
-    m_data.string = new string(*rhs.m_data.string);
+    m_smallString = rhs.m_smallString;
+    if (m_smallString)
+      memcpy(m_data.smallstring, rhs.m_data.smallstring, sizeof(m_data.smallstring));
+    else
+      m_data.string = new string(*rhs.m_data.string);
     break;
   case VariantTypeWideString:
     m_data.wstring = new wstring(*rhs.m_data.wstring);
     break;
   case VariantTypeArray:
-    m_data.array = new VariantArray(rhs.m_data.array->begin(), rhs.m_data.array->end());
+    m_data.array = new VariantArray(*rhs.m_data.array);
     break;
   case VariantTypeObject:
-    m_data.map = new VariantMap(rhs.m_data.map->begin(), rhs.m_data.map->end());
+    m_data.map = new VariantMap(*rhs.m_data.map);
     break;
   default:
     break;
@@ -604,7 +697,12 @@ bool CVariant::operator==(const CVariant &rhs) const
     case VariantTypeDouble:
       return m_data.dvalue == rhs.m_data.dvalue;
     case VariantTypeString:
-      return *m_data.string == *rhs.m_data.string;
+    {
+      size_t length, rhsLength;
+      const char *str = stringData(length);
+      const char *rhsStr = rhs.stringData(rhsLength);
+      return length == rhsLength && memcmp(str, rhsStr, length) == 0;
+    }
     case VariantTypeWideString:
       return *m_data.wstring == *rhs.m_data.wstring;
     case VariantTypeArray:
@@ -628,7 +726,7 @@ void CVariant::push_back(const CVariant &variant)
   }
 
   if (m_type == VariantTypeArray)
-    m_data.array->push_back(variant);
+    appendElement(*m_data.array) = variant;
 }
 
 void CVariant::append(const CVariant &variant)
@@ -639,7 +737,7 @@ void CVariant::append(const CVariant &variant)
 const char *CVariant::c_str() const
 {
   if (m_type == VariantTypeString)
-    return m_data.string->c_str();
+    return m_smallString ? m_data.smallstring : m_data.string->c_str();
   else
     return NULL;
 }
@@ -647,12 +745,15 @@ const char *CVariant::c_str() const
 void CVariant::swap(CVariant &rhs)
 {
   VariantType  temp_type = m_type;
+  bool         temp_small = m_smallString;
   VariantUnion temp_data = m_data;
 
   m_type = rhs.m_type;
+  m_smallString = rhs.m_smallString;
   m_data = rhs.m_data;
 
   rhs.m_type = temp_type;
+  rhs.m_smallString = temp_small;
   rhs.m_data = temp_data;
 }
 
@@ -727,7 +828,7 @@ unsigned int CVariant::size() const
   else if (m_type == VariantTypeArray)
     return m_data.array->size();
   else if (m_type == VariantTypeString)
-    return m_data.string->size();
+    return m_smallString ? strlen(m_data.smallstring) : m_data.string->size();
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->size();
   else
@@ -741,7 +842,7 @@ bool CVariant::empty() const
   else if (m_type == VariantTypeArray)
     return m_data.array->empty();
   else if (m_type == VariantTypeString)
-    return m_data.string->empty();
+    return m_smallString ? m_data.smallstring[0] == '\0' : m_data.string->empty();
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->empty();
   else if (m_type == VariantTypeNull)
@@ -757,7 +858,12 @@ void CVariant::clear()
   else if (m_type == VariantTypeArray)
     m_data.array->clear();
   else if (m_type == VariantTypeString)
-    m_data.string->clear();
+  {
+    if (m_smallString)
+      m_data.smallstring[0] = '\0';
+    else
+      m_data.string->clear();
+  }
   else if (m_type == VariantTypeWideString)
     m_data.wstring->clear();
 }
@@ -782,7 +888,13 @@ void CVariant::erase(unsigned int position)
   }
 
   if (m_type == VariantTypeArray && position < size())
-    m_data.array->erase(m_data.array->begin() + position);
+    eraseElement(*m_data.array, position);
+}
+
+void CVariant::reserve(unsigned int size)
+{
+  if (m_type == VariantTypeArray)
+    reserveElements(*m_data.array, size);
 }
 
 bool CVariant::isMember(const std::string &key) const
@@ -131,12 +131,23 @@ public:
   void erase(const std::string &key);
   void erase(unsigned int position);
 
+  /*! \brief Preallocate room for the given number of array elements
+   */
+  void reserve(unsigned int size);
+
   bool isMember(const std::string &key) const;
 
   static CVariant ConstNullVariant;
 
 private:
+  // strings up to this length are stored inline instead of on the heap, in the
+  // room of the union so that CVariant doesn't grow
+  static const unsigned int SmallStringSize = 7;
+
   void cleanup();
+  void setString(const char *str, size_t length);
+  const char *stringData(size_t &length) const;
+
   union VariantUnion
   {
     int64_t integer;
@@ -147,8 +158,10 @@ private:
     std::wstring *wstring;
     VariantArray *array;
     VariantMap *map;
+    char smallstring[SmallStringSize + 1];
   };
 
   VariantType m_type;
+  bool m_smallString;
   VariantUnion m_data;
 };
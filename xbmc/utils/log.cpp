@@ -22,7 +22,9 @@
 #include "log.h"
 #include "stdio_utf8.h"
 #include "stat_utf8.h"
+#include "threads/Atomics.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "threads/SingleLock.h"
 #include "threads/Thread.h"
 #include "utils/StringUtils.h"
@@ -42,10 +44,189 @@
 #define m_repeatLine XBMC_GLOBAL_USE(CLog::CLogGlobals).m_repeatLine
 #define m_logLevel XBMC_GLOBAL_USE(CLog::CLogGlobals).m_logLevel
 #define m_extraLogLevels XBMC_GLOBAL_USE(CLog::CLogGlobals).m_extraLogLevels
+#define m_writer XBMC_GLOBAL_USE(CLog::CLogGlobals).m_writer
+#define m_writerUsers XBMC_GLOBAL_USE(CLog::CLogGlobals).m_writerUsers
 
 static char levelNames[][8] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
 
+struct CLog::LogLine
+{
+  LogLine() : level(0), threadId(0) {}
+  int         level;
+  SYSTEMTIME  time;
+  uint64_t    threadId;
+  std::string data;
+};
+
+/*!
+ \brief Background writer for asynchronous logging.
+
+ Producers push formatted lines into a bounded multi-producer/single-consumer
+ ring without taking any lock: a slot is claimed by advancing the enqueue position
+ with a CAS and published by bumping the slot's sequence number. The writer thread
+ is the only consumer and writes out whole batches with a single flush.
+ */
+class CLog::CLogWriter : public CThread
+{
+public:
+  CLogWriter();
+
+  bool Push(LogLine& line);
+  unsigned int GetDropped() const { return (unsigned int)m_dropped; }
+
+  virtual void StopThread(bool bWait = true);
+
+protected:
+  virtual void Process();
+
+private:
+  bool Pop(LogLine& line);
+  bool IsEmpty() const;
+  void Drain();
+
+  static const unsigned int RingSize = 8192; // must be a power of two
+  static const unsigned int BatchSize = 256;
+
+  struct Cell
+  {
+    volatile long sequence;
+    LogLine       line;
+  };
+
+  Cell          m_ring[RingSize];
+  volatile long m_enqueuePos;
+  long          m_dequeuePos;
+  volatile long m_sleeping;
+  volatile long m_dropped;
+  long          m_droppedReported;
+  CEvent        m_wakeup;
+};
+
+CLog::CLogWriter::CLogWriter()
+  : CThread("LogWriter"),
+    m_enqueuePos(0),
+    m_dequeuePos(0),
+    m_sleeping(0),
+    m_dropped(0),
+    m_droppedReported(0)
+{
+  for (unsigned int i = 0; i < RingSize; i++)
+    m_ring[i].sequence = i;
+}
+
+bool CLog::CLogWriter::Push(LogLine& line)
+{
+  Cell* cell;
+  long pos = AtomicAdd(&m_enqueuePos, 0);
+  for (;;)
+  {
+    cell = &m_ring[(unsigned long)pos & (RingSize - 1)];
+    long diff = (long)((unsigned long)AtomicAdd(&cell->sequence, 0) - (unsigned long)pos);
+    if (diff == 0)
+    {
+      long prev = cas(&m_enqueuePos, pos, (long)((unsigned long)pos + 1));
+      if (prev == pos)
+        break;
+      pos = prev;
+    }
+    else if (diff < 0)
+    { // the writer hasn't caught up yet, drop the line rather than stall the caller
+      AtomicIncrement(&m_dropped);
+      return false;
+    }
+    else
+      pos = AtomicAdd(&m_enqueuePos, 0);
+  }
+
+  cell->line.level    = line.level;
+  cell->line.time     = line.time;
+  cell->line.threadId = line.threadId;
+  cell->line.data.swap(line.data);
+  AtomicIncrement(&cell->sequence);
+
+  // only pay for the event if the writer actually went to sleep
+  if (AtomicAdd(&m_sleeping, 0) && cas(&m_sleeping, 1, 0) == 1)
+    m_wakeup.Set();
+  return true;
+}
+
+bool CLog::CLogWriter::Pop(LogLine& line)
+{
+  Cell* cell = &m_ring[(unsigned long)m_dequeuePos & (RingSize - 1)];
+  if (AtomicAdd(&cell->sequence, 0) != (long)((unsigned long)m_dequeuePos + 1))
+    return false;
+
+  line.level    = cell->line.level;
+  line.time     = cell->line.time;
+  line.threadId = cell->line.threadId;
+  line.data.clear();
+  line.data.swap(cell->line.data);
+  // hand the slot back to the producers for the next lap
+  AtomicAdd(&cell->sequence, RingSize - 1);
+  m_dequeuePos = (long)((unsigned long)m_dequeuePos + 1);
+  return true;
+}
+
+bool CLog::CLogWriter::IsEmpty() const
+{
+  const Cell* cell = &m_ring[(unsigned long)m_dequeuePos & (RingSize - 1)];
+  return AtomicAdd(const_cast<volatile long*>(&cell->sequence), 0) != (long)((unsigned long)m_dequeuePos + 1);
+}
+
+void CLog::CLogWriter::Drain()
+{
+  LogLine line;
+  bool more = true;
+  while (more)
+  {
+    CSingleLock waitLock(critSec);
+    unsigned int count = 0;
+    long dropped = AtomicAdd(&m_dropped, 0);
+    if (dropped != m_droppedReported && m_file)
+    {
+      line.level = LOGWARNING;
+      GetLocalTime(&line.time);
+      line.threadId = (uint64_t)CThread::GetCurrentThreadId();
+      line.data = StringUtils::Format("Log queue overflow, %ld lines dropped", dropped - m_droppedReported);
+      m_droppedReported = dropped;
+      CLog::WriteLine(line);
+      count++;
+    }
+
+    while (count < BatchSize && (more = Pop(line)))
+    {
+      CLog::WriteLine(line);
+      count++;
+    }
+    if (count && m_file)
+      fflush(m_file);
+  }
+}
+
+void CLog::CLogWriter::Process()
+{
+  while (!m_bStop)
+  {
+    Drain();
+
+    // announce that we are about to sleep, then check once more so a line
+    // pushed in between isn't left waiting for the timeout
+    cas(&m_sleeping, 0, 1);
+    if (IsEmpty())
+      m_wakeup.WaitMSec(100);
+    cas(&m_sleeping, 1, 0);
+  }
+  Drain();
+}
+
+void CLog::CLogWriter::StopThread(bool bWait /* = true */)
+{
+  m_bStop = true;
+  m_wakeup.Set();
+  CThread::StopThread(bWait);
+}
+
 CLog::CLog()
 {}
 
@@ -54,7 +235,8 @@ CLog::~CLog()
 
 void CLog::Close()
 {
-  
+  SetAsynchronous(false);
+
   CSingleLock waitLock(critSec);
   if (m_file)
   {
@@ -66,8 +248,6 @@ void CLog::Close()
 
 void CLog::Log(int loglevel, const char *format, ... )
 {
-  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%" PRIu64" %7s: ";
-  CSingleLock waitLock(critSec);
   int extras = (loglevel >> LOGMASKBIT) << LOGMASKBIT;
   loglevel = loglevel & LOGMASK;
 #if !(defined(_DEBUG) || defined(PROFILE))
@@ -81,69 +261,144 @@ void CLog::Log(int loglevel, const char *format, ... )
     if (extras != 0 && (m_extraLogLevels & extras) == 0)
       return;
 
-    SYSTEMTIME time;
-    GetLocalTime(&time);
+    LogLine line;
+    line.level = loglevel;
+    line.threadId = (uint64_t)CThread::GetCurrentThreadId();
 
-    std::string strPrefix, strData;
-
-    strData.reserve(16384);
     va_list va;
     va_start(va, format);
-    strData = StringUtils::FormatV(format,va);
+    line.data = StringUtils::FormatV(format,va);
     va_end(va);
 
-    if (m_repeatLogLevel == loglevel && m_repeatLine == strData)
-    {
-      m_repeatCount++;
-      return;
-    }
-    else if (m_repeatCount)
+    // hand the line to the writer thread if there is one. The user count keeps
+    // SetAsynchronous(false) from deleting the writer underneath us, and is only
+    // touched once logging is asynchronous.
+    if (m_writer)
     {
-      strPrefix = StringUtils::Format(prefixFormat,
-                                      time.wHour,
-                                      time.wMinute,
-                                      time.wSecond,
-                                      (uint64_t)CThread::GetCurrentThreadId(),
-                                      levelNames[m_repeatLogLevel]);
-
-      std::string strData2 = StringUtils::Format("Previous line repeats %d times."
-                                                LINE_ENDING,
-                                                m_repeatCount);
-      fputs(strPrefix.c_str(), m_file);
-      fputs(strData2.c_str(), m_file);
-      OutputDebugString(strData2);
-      m_repeatCount = 0;
+      AtomicIncrement(&m_writerUsers);
+      CLogWriter* writer = m_writer;
+      if (writer)
+      {
+        GetLocalTime(&line.time);
+        writer->Push(line);
+        AtomicDecrement(&m_writerUsers);
+        return;
+      }
+      AtomicDecrement(&m_writerUsers);
     }
-    
-    m_repeatLine      = strData;
-    m_repeatLogLevel  = loglevel;
 
-    StringUtils::TrimRight(strData);
-    if (strData.empty())
-      return;
-    
-    OutputDebugString(strData);
+    // timestamped under the lock, so that the lines are written in order
+    CSingleLock waitLock(critSec);
+    GetLocalTime(&line.time);
+    WriteLine(line);
+    if (m_file)
+      fflush(m_file);
+  }
+}
+
+void CLog::WriteLine(LogLine& line)
+{
+  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%" PRIu64" %7s: ";
 
-    /* fixup newline alignment, number of spaces should equal prefix length */
-    StringUtils::Replace(strData, "\n", LINE_ENDING"                                            ");
-    strData += LINE_ENDING;
+  if (!m_file)
+    return;
+
+  std::string strPrefix;
+  std::string& strData = line.data;
 
+  if (m_repeatLogLevel == line.level && m_repeatLine == strData)
+  {
+    m_repeatCount++;
+    return;
+  }
+  else if (m_repeatCount)
+  {
     strPrefix = StringUtils::Format(prefixFormat,
-                                    time.wHour,
-                                    time.wMinute,
-                                    time.wSecond,
-                                    (uint64_t)CThread::GetCurrentThreadId(),
-                                    levelNames[loglevel]);
+                                    line.time.wHour,
+                                    line.time.wMinute,
+                                    line.time.wSecond,
+                                    line.threadId,
+                                    levelNames[m_repeatLogLevel]);
+
+    std::string strData2 = StringUtils::Format("Previous line repeats %d times."
+                                              LINE_ENDING,
+                                              m_repeatCount);
+    fputs(strPrefix.c_str(), m_file);
+    fputs(strData2.c_str(), m_file);
+    OutputDebugString(strData2);
+    m_repeatCount = 0;
+  }
+
+  m_repeatLine      = strData;
+  m_repeatLogLevel  = line.level;
+
+  StringUtils::TrimRight(strData);
+  if (strData.empty())
+    return;
+
+  OutputDebugString(strData);
+
+  /* fixup newline alignment, number of spaces should equal prefix length */
+  StringUtils::Replace(strData, "\n", LINE_ENDING"                                            ");
+  strData += LINE_ENDING;
+
+  strPrefix = StringUtils::Format(prefixFormat,
+                                  line.time.wHour,
+                                  line.time.wMinute,
+                                  line.time.wSecond,
+                                  line.threadId,
+                                  levelNames[line.level]);
 
 //print to adb
 #if defined(TARGET_ANDROID) && defined(_DEBUG)
   CXBMCApp::android_printf("%s%s",strPrefix.c_str(), strData.c_str());
 #endif
 
-    fputs(strPrefix.c_str(), m_file);
-    fputs(strData.c_str(), m_file);
-    fflush(m_file);
+  fputs(strPrefix.c_str(), m_file);
+  fputs(strData.c_str(), m_file);
+}
+
+void CLog::SetAsynchronous(bool async)
+{
+  CLogWriter* writer = NULL;
+  {
+    CSingleLock waitLock(critSec);
+    if (async == (m_writer != NULL))
+      return;
+
+    if (async)
+    {
+      writer = new CLogWriter();
+      writer->Create();
+      m_writer = writer;
+      return;
+    }
+
+    writer = m_writer;
+    m_writer = NULL;
   }
+
+  // wait for producers that already picked up the writer, then let it drain
+  while (AtomicAdd(&m_writerUsers, 0) != 0)
+    Sleep(0);
+  writer->StopThread();
+  delete writer;
+}
+
+bool CLog::IsAsynchronous()
+{
+  return m_writer != NULL;
+}
+
+unsigned int CLog::GetDroppedLines()
+{
+  unsigned int dropped = 0;
+  AtomicIncrement(&m_writerUsers);
+  CLogWriter* writer = m_writer;
+  if (writer)
+    dropped = writer->GetDropped();
+  AtomicDecrement(&m_writerUsers);
+  return dropped;
 }
 
 bool CLog::Init(const char* path)
@@ -37,16 +37,20 @@ class CLog
 {
 public:
 
+  class CLogWriter;
+
   class CLogGlobals
   {
   public:
-    CLogGlobals() : m_file(NULL), m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0) {}
+    CLogGlobals() : m_file(NULL), m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0), m_writer(NULL), m_writerUsers(0) {}
     FILE*       m_file;
     int         m_repeatCount;
     int         m_repeatLogLevel;
     std::string m_repeatLine;
     int         m_logLevel;
     int         m_extraLogLevels;
+    CLogWriter* volatile m_writer;
+    volatile long m_writerUsers;
     CCriticalSection critSec;
   };
 
@@ -59,7 +63,26 @@ public:
   static void SetLogLevel(int level);
   static int  GetLogLevel();
   static void SetExtraLogLevels(int level);
+
+  /*! \brief Switch between synchronous and asynchronous logging.
+   In asynchronous mode the calling thread only formats the message and hands it to a
+   lock-free queue; a dedicated writer thread does the file output. Lines are dropped
+   (and counted) rather than blocking the caller when the queue is full.
+   Switching back to synchronous mode flushes everything that is still queued.
+   \param async true to enable the background writer, false to disable it.
+   */
+  static void SetAsynchronous(bool async);
+  static bool IsAsynchronous();
+
+  /*! \brief Number of lines dropped because the asynchronous queue was full.
+   Counted since asynchronous logging was last enabled.
+   */
+  static unsigned int GetDroppedLines();
 private:
+  struct LogLine;
+  friend class CLogWriter;
+
+  static void WriteLine(LogLine& line);
   static void OutputDebugString(const std::string& line);
 };
 
@@ -0,0 +1,117 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/JSONStreamWriter.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+class ChunkSink : public IJSONStreamSink
+{
+public:
+  ChunkSink(bool accept = true) : m_accept(accept) { }
+
+  virtual bool Write(const char *data, size_t length)
+  {
+    m_chunks.push_back(std::string(data, length));
+    return m_accept;
+  }
+
+  std::string Joined() const
+  {
+    std::string joined;
+    for (std::vector<std::string>::const_iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+      joined += *it;
+    return joined;
+  }
+
+  bool m_accept;
+  std::vector<std::string> m_chunks;
+};
+
+TEST(TestJSONStreamWriter, Events)
+{
+  CVariant variant(CVariant::VariantTypeObject);
+  variant["limits"]["start"] = 0;
+  variant["limits"]["total"] = 2;
+  variant["movies"].push_back("first");
+  variant["movies"].push_back(2.5);
+
+  std::string str;
+  CJSONStringSink sink(str);
+  CJSONStreamWriter writer(sink, true);
+  EXPECT_TRUE(writer.StartObject());
+  EXPECT_TRUE(writer.Key("limits"));
+  EXPECT_TRUE(writer.Value(variant["limits"]));
+  EXPECT_TRUE(writer.Key("movies"));
+  EXPECT_TRUE(writer.StartArray());
+  EXPECT_TRUE(writer.Value(variant["movies"][0]));
+  EXPECT_TRUE(writer.Value(variant["movies"][1]));
+  EXPECT_TRUE(writer.EndArray());
+  EXPECT_TRUE(writer.EndObject());
+  EXPECT_TRUE(writer.Flush());
+
+  EXPECT_STREQ(CJSONVariantWriter::Write(variant, true).c_str(), str.c_str());
+}
+
+TEST(TestJSONStreamWriter, Chunks)
+{
+  CVariant variant(CVariant::VariantTypeArray);
+  for (int i = 0; i < 1000; i++)
+    variant.push_back(i);
+
+  ChunkSink sink;
+  CJSONStreamWriter writer(sink, true, 64);
+  EXPECT_TRUE(writer.StartArray());
+  for (CVariant::const_iterator_array it = variant.begin_array(); it != variant.end_array(); ++it)
+    EXPECT_TRUE(writer.Value(*it));
+  EXPECT_TRUE(writer.EndArray());
+  EXPECT_TRUE(writer.Flush());
+
+  // output is only handed over once a chunk is full, apart from the final flush
+  ASSERT_LT(1U, sink.m_chunks.size());
+  for (size_t i = 0; i < sink.m_chunks.size() - 1; i++)
+    EXPECT_LE(64U, sink.m_chunks[i].size());
+  EXPECT_STREQ(CJSONVariantWriter::Write(variant, true).c_str(), sink.Joined().c_str());
+}
+
+TEST(TestJSONStreamWriter, SinkFailure)
+{
+  ChunkSink sink(false);
+  CJSONStreamWriter writer(sink, true);
+  EXPECT_TRUE(writer.StartArray());
+  EXPECT_FALSE(writer.Flush());
+  EXPECT_FALSE(writer.IsGood());
+  EXPECT_FALSE(writer.Value(CVariant(1)));
+  EXPECT_EQ(1U, sink.m_chunks.size());
+}
+
+TEST(TestJSONStreamWriter, InvalidStructure)
+{
+  std::string str;
+  CJSONStringSink sink(str);
+  CJSONStreamWriter writer(sink, true);
+  EXPECT_TRUE(writer.StartObject());
+  EXPECT_FALSE(writer.EndArray());
+  EXPECT_FALSE(writer.IsGood());
+}
@@ -21,8 +21,12 @@
 #include "utils/JobManager.h"
 #include "settings/Settings.h"
 #include "utils/SystemInfo.h"
+#include "utils/Variant.h"
+#include "threads/Atomics.h"
+#include "threads/SystemClock.h"
 
 #include "gtest/gtest.h"
+#include <iostream>
 
 /* CSysInfoJob::GetInternetState() will test for network connectivity. */
 class TestJobManager : public testing::Test
@@ -177,3 +181,185 @@ TEST_F(TestJobManager, IsProcessing)
 
   job->FinishAndStopBlocking();
 }
+
+namespace
+{
+class NullJob :
+  public CJob
+{
+public:
+  const char * GetType() const
+  {
+    return "NullJob";
+  }
+
+  bool DoWork()
+  {
+    return true;
+  }
+};
+
+class CountingCallback :
+  public IJobCallback
+{
+public:
+  CountingCallback(long expected) :
+    m_completed(0),
+    m_expected(expected)
+  {
+  }
+
+  void OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    if (AtomicIncrement(&m_completed) == m_expected)
+      m_done.Set();
+  }
+
+  volatile long m_completed;
+  long m_expected;
+  CEvent m_done;
+};
+
+class JobProducer :
+  public CThread
+{
+public:
+  JobProducer(IJobCallback *callback, unsigned int jobs) :
+    CThread("JobProducer"),
+    m_callback(callback),
+    m_jobs(jobs)
+  {
+  }
+
+  void Process()
+  {
+    for (unsigned int i = 0; i < m_jobs; i++)
+      CJobManager::GetInstance().AddJob(new NullJob(), m_callback, CJob::PRIORITY(i % (CJob::PRIORITY_HIGH + 1)));
+  }
+
+private:
+  IJobCallback *m_callback;
+  unsigned int m_jobs;
+};
+
+class CountedJob :
+  public CJob
+{
+public:
+  CountedJob(volatile long &destroyed) : m_destroyed(destroyed) {}
+  ~CountedJob() { AtomicIncrement(&m_destroyed); }
+
+  const char * GetType() const
+  {
+    return "CountedJob";
+  }
+
+  bool DoWork()
+  {
+    return true;
+  }
+
+private:
+  volatile long &m_destroyed;
+};
+
+// adds jobs until told to stop, deleting those the job manager didn't take
+class RejectedJobProducer :
+  public CThread
+{
+public:
+  RejectedJobProducer(volatile long &destroyed) :
+    CThread("RejectedJobProducer"),
+    m_destroyed(destroyed),
+    m_created(0)
+  {
+  }
+
+  void Process()
+  {
+    while (!m_bStop)
+    {
+      CJob *job = new CountedJob(m_destroyed);
+      m_created++;
+      if (CJobManager::GetInstance().AddJob(job, NULL) == 0)
+        delete job;
+    }
+  }
+
+  volatile long &m_destroyed;
+  long m_created;
+};
+}
+
+/* Floods the job manager with tiny jobs from several threads at all priorities,
+ * so the time taken is dominated by the cost of queueing and fetching jobs. */
+TEST_F(TestJobManager, Throughput)
+{
+  static const unsigned int producers = 4;
+  static const unsigned int jobsPerProducer = 25000;
+  CountingCallback callback(producers * jobsPerProducer);
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  JobProducer *threads[producers];
+  for (unsigned int i = 0; i < producers; i++)
+  {
+    threads[i] = new JobProducer(&callback, jobsPerProducer);
+    threads[i]->Create();
+  }
+  for (unsigned int i = 0; i < producers; i++)
+  {
+    threads[i]->StopThread(true);
+    delete threads[i];
+  }
+
+  EXPECT_TRUE(callback.m_done.WaitMSec(60000));
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+  EXPECT_EQ(callback.m_expected, callback.m_completed);
+
+  // don't leave any stragglers calling back into us once we're gone
+  CJobManager::GetInstance().CancelJobs();
+
+  std::cout << producers * jobsPerProducer << " jobs completed in " << elapsed << " ms" << std::endl;
+}
+
+/* Jobs added while the job manager cancels its jobs are either run and freed by it,
+ * or handed back to their caller, but never both. */
+TEST_F(TestJobManager, AddJobWhileCancelling)
+{
+  volatile long destroyed = 0;
+  RejectedJobProducer producer(destroyed);
+  producer.Create();
+  producer.Sleep(100);
+  CJobManager::GetInstance().CancelJobs();
+  producer.Sleep(100);
+  producer.StopThread(true);
+
+  EXPECT_LT(0, producer.m_created);
+  EXPECT_EQ(producer.m_created, destroyed);
+}
+
+TEST_F(TestJobManager, Statistics)
+{
+  CountingCallback callback(10);
+  for (unsigned int i = 0; i < 10; i++)
+    CJobManager::GetInstance().AddJob(new NullJob(), &callback, CJob::PRIORITY_HIGH);
+  EXPECT_TRUE(callback.m_done.WaitMSec(10000));
+  CJobManager::GetInstance().CancelJobs();
+
+  CVariant stats;
+  CJobManager::GetInstance().GetStatistics(stats);
+  ASSERT_TRUE(stats["jobs"].isArray());
+
+  bool found = false;
+  for (CVariant::const_iterator_array it = stats["jobs"].begin_array(); it != stats["jobs"].end_array(); ++it)
+  {
+    if ((*it)["type"].asString() != "NullJob" || (*it)["priority"].asString() != "high")
+      continue;
+    found = true;
+    EXPECT_EQ(0, (*it)["queued"].asInteger());
+    EXPECT_EQ(0, (*it)["processing"].asInteger());
+    EXPECT_LE(10, (*it)["completed"].asInteger());
+    EXPECT_EQ(CJobStatistics::HistogramBuckets, (*it)["run"]["histogram"].size());
+  }
+  EXPECT_TRUE(found);
+}
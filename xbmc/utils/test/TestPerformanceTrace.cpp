@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/PerformanceTrace.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+#include <iostream>
+
+class TracedThread : public CThread
+{
+public:
+  TracedThread() : CThread("TracedThread"), m_id(0) {}
+  virtual void Process()
+  {
+    m_id = (uint64_t)CThread::GetCurrentThreadId();
+    TRACE_SCOPE("TracedThread::Process");
+  }
+  uint64_t m_id;
+};
+
+static void TracedFunction()
+{
+  TRACE_FUNCTION;
+  TRACE_SCOPE("inner");
+}
+
+TEST(TestPerformanceTrace, Disabled)
+{
+  CPerformanceTrace::Start();
+  CPerformanceTrace::Stop();
+
+  TracedFunction();
+  EXPECT_EQ(0U, CPerformanceTrace::GetEventCount());
+}
+
+TEST(TestPerformanceTrace, Serialize)
+{
+  CPerformanceTrace::Start();
+  TracedFunction();
+  int64_t now = CurrentHostCounter();
+  CPerformanceTrace::Complete(CPerformanceTrace::Intern(std::string("dynamic name")), now, now);
+
+  TracedThread thread;
+  thread.Create();
+  thread.StopThread(true);
+  CPerformanceTrace::Stop();
+
+  // 2 begin/end pairs plus one complete event here, 1 pair on the other thread
+  EXPECT_EQ(7U, CPerformanceTrace::GetEventCount());
+  EXPECT_EQ(0U, CPerformanceTrace::GetDroppedEvents());
+
+  CVariant trace;
+  CPerformanceTrace::Serialize(trace);
+  ASSERT_TRUE(trace["traceEvents"].isArray());
+  // each thread gets a thread_name metadata entry on top of its events
+  EXPECT_EQ(9U, trace["traceEvents"].size());
+
+  std::vector<std::string> phases;
+  unsigned int threadNames = 0;
+  bool foundThread = false;
+  unsigned int threadEvents = 0;
+  for (CVariant::const_iterator_array it = trace["traceEvents"].begin_array(); it != trace["traceEvents"].end_array(); ++it)
+  {
+    if ((*it)["ph"].asString() == "M")
+    {
+      threadNames++;
+      if ((*it)["args"]["name"].asString() == "TracedThread")
+      {
+        foundThread = true;
+        EXPECT_EQ(thread.m_id, (*it)["tid"].asUnsignedInteger());
+      }
+      continue;
+    }
+    // events carry the id of the thread they were recorded on
+    if ((*it)["name"].asString() == "TracedThread::Process")
+    {
+      EXPECT_EQ(thread.m_id, (*it)["tid"].asUnsignedInteger());
+      threadEvents++;
+      continue;
+    }
+    EXPECT_EQ((uint64_t)CThread::GetCurrentThreadId(), (*it)["tid"].asUnsignedInteger());
+    phases.push_back((*it)["ph"].asString());
+    EXPECT_GE((*it)["ts"].asDouble(), 0.0);
+  }
+  EXPECT_EQ(2U, threadNames);
+  EXPECT_TRUE(foundThread);
+  // the thread exited, but its events are kept for export
+  EXPECT_EQ(2U, threadEvents);
+
+  ASSERT_EQ(5U, phases.size());
+  EXPECT_STREQ("B", phases[0].c_str());
+  EXPECT_STREQ("B", phases[1].c_str());
+  EXPECT_STREQ("E", phases[2].c_str());
+  EXPECT_STREQ("E", phases[3].c_str());
+  EXPECT_STREQ("X", phases[4].c_str());
+}
+
+TEST(TestPerformanceTrace, MaxEvents)
+{
+  CPerformanceTrace::Start(2);
+  TracedFunction();
+  CPerformanceTrace::Stop();
+
+  EXPECT_EQ(2U, CPerformanceTrace::GetEventCount());
+  EXPECT_EQ(2U, CPerformanceTrace::GetDroppedEvents());
+}
+
+TEST(TestPerformanceTrace, Save)
+{
+  std::string tracefile = CSpecialProtocol::TranslatePath("special://temp/xbmc-trace.json");
+
+  CPerformanceTrace::Start();
+  TracedFunction();
+  CPerformanceTrace::Stop();
+  EXPECT_TRUE(CPerformanceTrace::Save(tracefile));
+
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open(tracefile));
+  std::string json;
+  char buf[1024];
+  unsigned int bytesread;
+  while ((bytesread = file.Read(buf, sizeof(buf))) > 0)
+    json.append(buf, bytesread);
+  file.Close();
+
+  CVariant trace = CJSONVariantParser::Parse((const unsigned char *)json.c_str(), json.size());
+  ASSERT_TRUE(trace["traceEvents"].isArray());
+  EXPECT_EQ(5U, trace["traceEvents"].size());
+  EXPECT_TRUE(XFILE::CFile::Delete(tracefile));
+}
+
+TEST(TestPerformanceTrace, DisabledCost)
+{
+  static const unsigned int iterations = 1000000;
+
+  CPerformanceTrace::Start();
+  CPerformanceTrace::Stop();
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < iterations; i++)
+  {
+    TRACE_SCOPE("disabled");
+  }
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+  EXPECT_EQ(0U, CPerformanceTrace::GetEventCount());
+
+  std::cout << iterations << " disabled trace scopes in " << elapsed << " ms" << std::endl;
+}
@@ -0,0 +1,293 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#ifdef TARGET_POSIX
+#include "FileItem.h"
+#include "filesystem/CurlFile.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/HttpHeader.h"
+#include "utils/ScraperHttpCache.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+  /* A local HTTP server answering
+     /fresh    with a page fresh for an hour
+     /etag     with a page to be revalidated on each use, and a 304 if it's sent its ETag
+     /nostore  with a page that mustn't be stored
+     /big/...  with 1000 bytes fresh for an hour
+   */
+  class CTestHttpServer : public CThread
+  {
+  public:
+    CTestHttpServer() : CThread("TestHttpServer"), m_socket(-1), m_port(0), m_requests(0), m_notModified(0)
+    {
+      m_socket = socket(AF_INET, SOCK_STREAM, 0);
+      struct sockaddr_in address = {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t length = sizeof(address);
+      if (m_socket >= 0 &&
+          bind(m_socket, (struct sockaddr *)&address, sizeof(address)) == 0 &&
+          getsockname(m_socket, (struct sockaddr *)&address, &length) == 0 &&
+          listen(m_socket, 5) == 0)
+        m_port = ntohs(address.sin_port);
+    }
+
+    ~CTestHttpServer()
+    {
+      StopThread();
+      if (m_socket >= 0)
+        close(m_socket);
+    }
+
+    std::string GetURL(const std::string &path) const
+    {
+      return StringUtils::Format("http://127.0.0.1:%i%s", m_port, path.c_str());
+    }
+
+    int GetRequests()
+    {
+      CSingleLock lock(m_section);
+      return m_requests;
+    }
+
+    int GetNotModified()
+    {
+      CSingleLock lock(m_section);
+      return m_notModified;
+    }
+
+    int m_socket;
+    int m_port;
+
+  protected:
+    virtual void Process()
+    {
+      while (!m_bStop)
+      {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(m_socket, &fds);
+        struct timeval timeout = { 0, 100000 };
+        if (select(m_socket + 1, &fds, NULL, NULL, &timeout) <= 0)
+          continue;
+
+        int client = accept(m_socket, NULL, NULL);
+        if (client < 0)
+          continue;
+
+        std::string request;
+        char buffer[1024];
+        ssize_t received;
+        while (request.find("\r\n\r\n") == std::string::npos && (received = recv(client, buffer, sizeof(buffer), 0)) > 0)
+          request.append(buffer, received);
+
+        std::string response = Respond(request);
+        send(client, response.c_str(), response.size(), 0);
+        close(client);
+      }
+    }
+
+  private:
+    std::string Respond(const std::string &request)
+    {
+      CSingleLock lock(m_section);
+      m_requests++;
+
+      std::string path = request.substr(4, request.find(' ', 4) - 4);
+      std::string headers = "Content-Type: text/html; charset=UTF-8\r\n";
+      std::string body;
+      if (path == "/fresh")
+      {
+        headers += "Cache-Control: max-age=3600\r\n";
+        body = StringUtils::Format("<html>fresh %i</html>", m_requests);
+      }
+      else if (path == "/etag")
+      {
+        headers += "Cache-Control: no-cache\r\nETag: \"v1\"\r\n";
+        if (request.find("If-None-Match: \"v1\"\r\n") != std::string::npos)
+        {
+          m_notModified++;
+          return "HTTP/1.1 304 Not Modified\r\n" + headers + "Connection: close\r\n\r\n";
+        }
+        body = StringUtils::Format("<html>etag %i</html>", m_requests);
+      }
+      else if (path == "/nostore")
+      {
+        headers += "Cache-Control: no-store\r\n";
+        body = StringUtils::Format("<html>nostore %i</html>", m_requests);
+      }
+      else if (StringUtils::StartsWith(path, "/big/"))
+      {
+        headers += "Cache-Control: max-age=3600\r\n";
+        body = std::string(1000, 'x');
+      }
+      else
+        return "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+      return StringUtils::Format("HTTP/1.1 200 OK\r\n%sContent-Length: %u\r\nConnection: close\r\n\r\n",
+                                 headers.c_str(), (unsigned int)body.size()) + body;
+    }
+
+    int m_requests;
+    int m_notModified;
+    CCriticalSection m_section;
+  };
+}
+
+class TestScraperHttpCache : public testing::Test
+{
+protected:
+  TestScraperHttpCache()
+  {
+    m_file = XBMC_CREATETEMPFILE("");
+    if (m_file != NULL)
+    {
+      m_file->Close();
+      m_folder = URIUtils::AddFileToFolder(CXBMCTestUtils::Instance().TempFileDirectory(m_file), "TestScraperHttpCache/");
+    }
+    m_server.Create();
+  }
+
+  ~TestScraperHttpCache()
+  {
+    if (!m_folder.empty())
+    {
+      CScraperHttpCache(m_folder, 1).Clear();
+      XFILE::CDirectory::Remove(m_folder);
+    }
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  std::string Fetch(CScraperHttpCache &cache, const std::string &path)
+  {
+    XFILE::CCurlFile http;
+    std::string content;
+    CHttpHeader headers;
+    EXPECT_TRUE(cache.Fetch(http, m_server.GetURL(path), content, headers));
+    EXPECT_STREQ("text/html", headers.GetMimeType().c_str());
+    EXPECT_STREQ("UTF-8", headers.GetCharset().c_str());
+    return content;
+  }
+
+  int64_t GetCachedSize(int &responses)
+  {
+    CFileItemList items;
+    XFILE::CDirectory::GetDirectory(m_folder, items, "", XFILE::DIR_FLAG_BYPASS_CACHE);
+    int64_t size = 0;
+    responses = items.Size();
+    for (int i = 0; i < items.Size(); i++)
+      size += items[i]->m_dwSize;
+    return size;
+  }
+
+  XFILE::CFile *m_file;
+  std::string m_folder;
+  CTestHttpServer m_server;
+};
+
+TEST_F(TestScraperHttpCache, Fresh)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_NE(0, m_server.m_port);
+  CScraperHttpCache cache(m_folder, 1024 * 1024);
+
+  std::string content = Fetch(cache, "/fresh");
+  EXPECT_STREQ("<html>fresh 1</html>", content.c_str());
+  EXPECT_EQ(content, Fetch(cache, "/fresh"));
+  EXPECT_EQ(1, m_server.GetRequests());
+
+  // as it is for another cache in the same folder
+  CScraperHttpCache reopened(m_folder, 1024 * 1024);
+  EXPECT_EQ(content, Fetch(reopened, "/fresh"));
+  EXPECT_EQ(1, m_server.GetRequests());
+}
+
+TEST_F(TestScraperHttpCache, Revalidate)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_NE(0, m_server.m_port);
+  CScraperHttpCache cache(m_folder, 1024 * 1024);
+
+  std::string content = Fetch(cache, "/etag");
+  EXPECT_STREQ("<html>etag 1</html>", content.c_str());
+
+  // each use asks the server, which only says the page is unchanged
+  EXPECT_EQ(content, Fetch(cache, "/etag"));
+  EXPECT_EQ(content, Fetch(cache, "/etag"));
+  EXPECT_EQ(3, m_server.GetRequests());
+  EXPECT_EQ(2, m_server.GetNotModified());
+}
+
+TEST_F(TestScraperHttpCache, NoStore)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_NE(0, m_server.m_port);
+  CScraperHttpCache cache(m_folder, 1024 * 1024);
+
+  EXPECT_STREQ("<html>nostore 1</html>", Fetch(cache, "/nostore").c_str());
+  EXPECT_STREQ("<html>nostore 2</html>", Fetch(cache, "/nostore").c_str());
+  int responses;
+  GetCachedSize(responses);
+  EXPECT_EQ(0, responses);
+
+  // nor is anything cached without a budget
+  CScraperHttpCache disabled(m_folder, 0);
+  EXPECT_STREQ("<html>fresh 3</html>", Fetch(disabled, "/fresh").c_str());
+  EXPECT_STREQ("<html>fresh 4</html>", Fetch(disabled, "/fresh").c_str());
+}
+
+TEST_F(TestScraperHttpCache, Budget)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_NE(0, m_server.m_port);
+  const int64_t budget = 5000;
+  CScraperHttpCache cache(m_folder, budget);
+
+  for (int i = 0; i < 10; i++)
+    Fetch(cache, StringUtils::Format("/big/%i", i));
+  EXPECT_EQ(10, m_server.GetRequests());
+
+  int responses;
+  EXPECT_GE(budget, GetCachedSize(responses));
+  EXPECT_LT(0, responses);
+  EXPECT_GT(10, responses);
+
+  // the last fetched are the ones kept
+  Fetch(cache, "/big/9");
+  EXPECT_EQ(10, m_server.GetRequests());
+}
+#endif
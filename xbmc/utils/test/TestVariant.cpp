@@ -19,8 +19,12 @@
  */
 
 #include "utils/Variant.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "threads/SystemClock.h"
 
 #include "gtest/gtest.h"
+#include <iostream>
 
 TEST(TestVariant, VariantTypeInteger)
 {
@@ -315,6 +319,15 @@ TEST(TestVariant, clear)
   CVariant a(strarray);
 
   EXPECT_FALSE(a.empty());
+  // either side of the inline size
+  CVariant e("1234567"), f("12345678");
+  EXPECT_STREQ("1234567", e.c_str());
+  EXPECT_EQ((unsigned int)7, e.size());
+  EXPECT_STREQ("12345678", f.c_str());
+  EXPECT_EQ((unsigned int)8, f.size());
+  e = f;
+  EXPECT_TRUE(e == f);
+
   a.clear();
   EXPECT_TRUE(a.empty());
 }
@@ -348,3 +361,128 @@ TEST(TestVariant, isMember)
   EXPECT_TRUE(a.isMember("key1"));
   EXPECT_FALSE(a.isMember("key2"));
 }
+
+TEST(TestVariant, smallString)
+{
+  CVariant a("short"), b("a string that does not fit inline");
+  std::string withNul("a\0b", 3);
+  CVariant c(withNul);
+
+  EXPECT_STREQ("short", a.c_str());
+  EXPECT_EQ((unsigned int)5, a.size());
+  EXPECT_STREQ("a string that does not fit inline", b.c_str());
+  EXPECT_EQ(withNul, c.asString());
+  EXPECT_EQ((unsigned int)3, c.size());
+
+  CVariant d = a;
+  EXPECT_TRUE(d == a);
+  d.swap(b);
+  EXPECT_STREQ("short", b.c_str());
+  EXPECT_STREQ("a string that does not fit inline", d.c_str());
+
+  a.clear();
+  EXPECT_TRUE(a.empty());
+  EXPECT_TRUE(CVariant("false") != CVariant("true"));
+  EXPECT_FALSE(CVariant("false").asBoolean());
+  EXPECT_EQ((int64_t)42, CVariant("42").asInteger());
+}
+
+TEST(TestVariant, objectOrder)
+{
+  CVariant a;
+  a["key3"] = 3;
+  a["key1"] = 1;
+  a["key4"] = 4;
+  a["key2"] = 2;
+  a["key1"] = 10;
+
+  EXPECT_EQ((unsigned int)4, a.size());
+  const char *keys[] = { "key1", "key2", "key3", "key4" };
+  unsigned int index = 0;
+  for (CVariant::const_iterator_map it = a.begin_map(); it != a.end_map(); ++it, ++index)
+    EXPECT_STREQ(keys[index], it->first.c_str());
+  EXPECT_EQ((int64_t)10, a["key1"].asInteger());
+
+  CVariant b = a;
+  b["key5"]["nested"] = "value";
+  a.erase("key3");
+  EXPECT_FALSE(a.isMember("key3"));
+  EXPECT_TRUE(b.isMember("key3"));
+  EXPECT_TRUE(a["key2"].isInteger());
+  EXPECT_FALSE(a.isMember("key5"));
+  EXPECT_STREQ("value", b["key5"]["nested"].c_str());
+}
+
+TEST(TestVariant, memberReferences)
+{
+  // callers hold on to members while adding their siblings
+  CVariant a;
+  CVariant &member = a["key5"];
+  member = "value";
+  for (int index = 0; index < 100; index++)
+    a[StringUtils::Format("key%02i", index)] = index;
+  a.erase("key00");
+
+  EXPECT_STREQ("value", member.c_str());
+  EXPECT_EQ(&member, &a["key5"]);
+}
+
+// a movie as VideoLibrary.GetMovies returns it, where most strings are short or empty.
+// Padding the short strings past the inline size takes the heap path all strings used to take.
+static CVariant BuildMovie(unsigned int index, const std::string &padding)
+{
+  CVariant movie(CVariant::VariantTypeObject);
+  movie["movieid"] = index;
+  movie["label"] = "A movie title that is long enough";
+  movie["title"] = "A movie title that is long enough";
+  movie["originaltitle"] = padding;
+  movie["sorttitle"] = padding;
+  movie["tagline"] = padding;
+  movie["plot"] = padding;
+  movie["set"] = padding;
+  movie["trailer"] = padding;
+  movie["lastplayed"] = padding;
+  movie["year"] = 2000 + (int)(index % 14);
+  movie["rating"] = 7.5;
+  movie["runtime"] = 5400;
+  movie["playcount"] = 0;
+  movie["mpaa"] = "PG" + padding;
+  movie["file"] = "smb://server/share/movies/A movie title that is long enough (2013).mkv";
+  movie["thumbnail"] = "image://smb%3a%2f%2fserver%2fshare%2fmovies%2fposter.jpg/";
+  movie["genre"].push_back("Action" + padding);
+  movie["genre"].push_back("Drama" + padding);
+  movie["country"].push_back("USA" + padding);
+  movie["resume"]["position"] = 0;
+  movie["resume"]["total"] = 0;
+  return movie;
+}
+
+// builds, copies and serializes the movies, returns the milliseconds it took
+static unsigned int BuildMovies(unsigned int movies, const std::string &padding)
+{
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CVariant result;
+  for (unsigned int index = 0; index < movies; index++)
+    result["movies"].push_back(BuildMovie(index, padding));
+  result["limits"]["total"] = movies;
+
+  CVariant copy = result;
+  std::string json = CJSONVariantWriter::Write(copy, true);
+  EXPECT_EQ(movies, copy["movies"].size());
+  EXPECT_FALSE(json.empty());
+  return XbmcThreads::SystemClockMillis() - start;
+}
+
+TEST(TestVariant, ConstructionBenchmark)
+{
+  static const unsigned int movies = 20000;
+
+  // the inline strings live in the room of the union
+  EXPECT_GE((size_t)16, sizeof(CVariant));
+
+  unsigned int inlined = BuildMovies(movies, "");
+  unsigned int heap = BuildMovies(movies, std::string(8, ' '));
+
+  std::cout << movies << " movies built, copied and serialized in " << inlined
+            << " ms with inline strings, " << heap << " ms with heap strings" << std::endl;
+}
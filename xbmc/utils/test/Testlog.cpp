@@ -20,12 +20,16 @@
 
 #include "utils/log.h"
 #include "utils/RegExp.h"
+#include "utils/StringUtils.h"
 #include "filesystem/File.h"
 #include "filesystem/SpecialProtocol.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
 
 #include "test/TestUtils.h"
 
 #include "gtest/gtest.h"
+#include <iostream>
 
 class Testlog : public testing::Test
 {
@@ -41,6 +45,38 @@ protected:
   }
 };
 
+class LogProducer : public CThread
+{
+public:
+  LogProducer(unsigned int id, unsigned int lines) : CThread("LogProducer"), m_id(id), m_lines(lines) {}
+  virtual void Process()
+  {
+    for (unsigned int i = 0; i < m_lines; i++)
+      CLog::Log(LOGDEBUG, "producer %u line %u", m_id, i);
+  }
+private:
+  unsigned int m_id;
+  unsigned int m_lines;
+};
+
+static std::string ReadLog(const std::string &logfile)
+{
+  std::string logstring;
+  char buf[4096];
+  unsigned int bytesread;
+  XFILE::CFile file;
+
+  if (!file.Open(logfile))
+    return logstring;
+  while ((bytesread = file.Read(buf, sizeof(buf) - 1)) > 0)
+  {
+    buf[bytesread] = '\0';
+    logstring.append(buf);
+  }
+  file.Close();
+  return logstring;
+}
+
 TEST_F(Testlog, Log)
 {
   std::string logfile, logstring;
@@ -146,3 +182,95 @@ TEST_F(Testlog, SetLogLevel)
   CLog::Close();
   EXPECT_TRUE(XFILE::CFile::Delete(logfile));
 }
+
+TEST_F(Testlog, Asynchronous)
+{
+  static const unsigned int producers = 4;
+  static const unsigned int linesPerProducer = 1000;
+  std::string logfile, logstring;
+  CRegExp regex;
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/").c_str()));
+  EXPECT_TRUE(XFILE::CFile::Exists(logfile));
+
+  CLog::SetAsynchronous(true);
+  EXPECT_TRUE(CLog::IsAsynchronous());
+
+  CLog::Log(LOGNOTICE, "repeated log message");
+  CLog::Log(LOGNOTICE, "repeated log message");
+  CLog::Log(LOGNOTICE, "repeated log message");
+  CLog::Log(LOGNOTICE, "final log message");
+
+  LogProducer *threads[producers];
+  for (unsigned int i = 0; i < producers; i++)
+  {
+    threads[i] = new LogProducer(i, linesPerProducer);
+    threads[i]->Create();
+  }
+  for (unsigned int i = 0; i < producers; i++)
+  {
+    threads[i]->StopThread(true);
+    delete threads[i];
+  }
+  // the queue holds more than we've produced, so nothing may be lost
+  EXPECT_EQ(0U, CLog::GetDroppedLines());
+
+  // closing has to flush everything still queued
+  CLog::Close();
+  EXPECT_FALSE(CLog::IsAsynchronous());
+
+  logstring = ReadLog(logfile);
+  EXPECT_FALSE(logstring.empty());
+  EXPECT_STREQ("\xEF\xBB\xBF", logstring.substr(0, 3).c_str());
+
+  EXPECT_TRUE(regex.RegComp(".*NOTICE: Previous line repeats 2 times.*"));
+  EXPECT_GE(regex.RegFind(logstring), 0);
+  EXPECT_TRUE(regex.RegComp(".*NOTICE: final log message.*"));
+  EXPECT_GE(regex.RegFind(logstring), 0);
+
+  unsigned int found = 0;
+  for (size_t pos = logstring.find("DEBUG: producer "); pos != std::string::npos;
+       pos = logstring.find("DEBUG: producer ", pos + 1))
+    found++;
+  EXPECT_EQ(producers * linesPerProducer, found);
+
+  // each producer's lines must come out in the order they were logged
+  for (unsigned int i = 0; i < producers; i++)
+  {
+    size_t first = logstring.find(StringUtils::Format("producer %u line 0" LINE_ENDING, i));
+    size_t last = logstring.find(StringUtils::Format("producer %u line %u" LINE_ENDING, i, linesPerProducer - 1));
+    EXPECT_NE(std::string::npos, first);
+    EXPECT_NE(std::string::npos, last);
+    EXPECT_LT(first, last);
+  }
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
+
+TEST_F(Testlog, AsynchronousCost)
+{
+  static const unsigned int lines = 5000;
+  std::string logfile;
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/").c_str()));
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < lines; i++)
+    CLog::Log(LOGDEBUG, "synchronous log message %u", i);
+  unsigned int syncElapsed = XbmcThreads::SystemClockMillis() - start;
+
+  CLog::SetAsynchronous(true);
+  start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < lines; i++)
+    CLog::Log(LOGDEBUG, "asynchronous log message %u", i);
+  unsigned int asyncElapsed = XbmcThreads::SystemClockMillis() - start;
+  unsigned int dropped = CLog::GetDroppedLines();
+  CLog::Close();
+
+  std::cout << lines << " lines logged in " << syncElapsed << " ms synchronous, "
+            << asyncElapsed << " ms asynchronous (" << dropped << " dropped)" << std::endl;
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
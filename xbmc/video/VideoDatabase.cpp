@@ -71,6 +71,33 @@ using namespace XFILE;
 using namespace VIDEO;
 using namespace ADDON;
 
+#define VIDEODB_BULK_BATCH_SIZE 100 // items committed at once during a bulk ingest
+
+namespace
+{
+  // the triggers maintaining tvshowcounts are shared with MySQL, which knows
+  // neither WHEN clauses nor GREATEST() with NULL semantics like MAX()
+
+  // 1 if the value is counted by COUNT(), 0 otherwise
+  std::string Counted(const std::string &value)
+  {
+    return "(CASE WHEN " + value + " IS NULL THEN 0 ELSE 1 END)";
+  }
+
+  // the larger of the column and the value, ignoring NULL like MAX() does
+  std::string Greatest(const std::string &column, const std::string &value)
+  {
+    return "(CASE WHEN " + column + " IS NULL OR " + value + " > " + column + " THEN " + value + " ELSE " + column + " END)";
+  }
+
+  // 1 if the season is counted by COUNT(DISTINCT) for the given episode alone, 0 otherwise
+  std::string OnlyInSeason(const std::string &idShow, const std::string &season, const std::string &idEpisode)
+  {
+    return "(CASE WHEN " + season + " IS NULL OR EXISTS (SELECT 1 FROM episode WHERE idShow=" + idShow +
+           StringUtils::Format(" AND c%02d=", VIDEODB_ID_EPISODE_SEASON) + season + " AND idEpisode<>" + idEpisode + ") THEN 0 ELSE 1 END)";
+  }
+}
+
 //********************************************************************************************************************************
 CVideoDatabase::CVideoDatabase(void)
 {
@@ -150,6 +177,9 @@ void CVideoDatabase::CreateTables()
   columns += ")";
   m_pDS->exec(columns.c_str());
 
+  CLog::Log(LOGINFO, "create tvshowcounts table");
+  m_pDS->exec("CREATE TABLE tvshowcounts ( idShow integer primary key, lastPlayed text, totalCount integer, watchedcount integer, totalSeasons integer, dateAdded text)\n");
+
   CLog::Log(LOGINFO, "create directorlinktvshow table");
   m_pDS->exec("CREATE TABLE directorlinktvshow ( idDirector integer, idShow integer)\n");
 
@@ -237,6 +267,8 @@ void CVideoDatabase::CreateTables()
 
   CLog::Log(LOGINFO, "create taglinks table");
   m_pDS->exec("CREATE TABLE taglinks (idTag integer, idMedia integer, media_type TEXT)");
+
+  CreateFingerprintTable();
 }
 
 void CVideoDatabase::CreateAnalytics()
@@ -259,6 +291,7 @@ void CVideoDatabase::CreateAnalytics()
   m_pDS->exec("CREATE INDEX ix_path ON path ( strPath(255) )");
   m_pDS->exec("CREATE INDEX ix_path2 ON path ( idParentPath )");
   m_pDS->exec("CREATE INDEX ix_files ON files ( idPath, strFilename(255) )");
+  m_pDS->exec("CREATE INDEX ix_pathfingerprint ON pathfingerprint ( strPath(255) )");
 
   m_pDS->exec("CREATE UNIQUE INDEX ix_genrelinkmovie_1 ON genrelinkmovie ( idGenre, idMovie)\n");
   m_pDS->exec("CREATE UNIQUE INDEX ix_genrelinkmovie_2 ON genrelinkmovie ( idMovie, idGenre)\n");
@@ -294,6 +327,7 @@ void CVideoDatabase::CreateAnalytics()
   m_pDS->exec(createColIndex.c_str());
   m_pDS->exec("CREATE INDEX ix_episode_show1 on episode(idEpisode,idShow)");
   m_pDS->exec("CREATE INDEX ix_episode_show2 on episode(idShow,idEpisode)");
+  m_pDS->exec(PrepareSQL("CREATE INDEX ix_episode_show_season on episode(idShow,c%02d)", VIDEODB_ID_EPISODE_SEASON));
   m_pDS->exec("CREATE UNIQUE INDEX ix_actorlinkepisode_1 ON actorlinkepisode ( idActor, idEpisode )\n");
   m_pDS->exec("CREATE UNIQUE INDEX ix_actorlinkepisode_2 ON actorlinkepisode ( idEpisode, idActor )\n");
   m_pDS->exec("CREATE UNIQUE INDEX ix_directorlinkepisode_1 ON directorlinkepisode ( idDirector, idEpisode )\n");
@@ -348,6 +382,7 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM seasons WHERE idShow=old.idShow; "
               "DELETE FROM art WHERE media_id=old.idShow AND media_type='tvshow'; "
               "DELETE FROM taglinks WHERE idMedia=old.idShow AND media_type='tvshow'; "
+              "DELETE FROM tvshowcounts WHERE idShow=old.idShow; "
               "END");
   m_pDS->exec("CREATE TRIGGER delete_musicvideo AFTER DELETE ON musicvideo FOR EACH ROW BEGIN "
               "DELETE FROM artistlinkmusicvideo WHERE idMVideo=old.idMVideo; "
@@ -361,7 +396,8 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM actorlinkepisode WHERE idEpisode=old.idEpisode; "
               "DELETE FROM directorlinkepisode WHERE idEpisode=old.idEpisode; "
               "DELETE FROM writerlinkepisode WHERE idEpisode=old.idEpisode; "
-              "DELETE FROM art WHERE media_id=old.idEpisode AND media_type='episode'; "
+              "DELETE FROM art WHERE media_id=old.idEpisode AND media_type='episode'; " +
+              RefreshTvShowCountsSQL("WHERE tvshow.idShow=old.idShow") +
               "END");
   m_pDS->exec("CREATE TRIGGER delete_season AFTER DELETE ON seasons FOR EACH ROW BEGIN "
               "DELETE FROM art WHERE media_id=old.idSeason AND media_type='season'; "
@@ -376,6 +412,57 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM tag WHERE idTag=old.idTag AND idTag NOT IN (SELECT DISTINCT idTag FROM taglinks); "
               "END");
 
+  /* tvshowcounts holds what tvshowview would otherwise aggregate over all episodes on every
+     listing. Adding episodes and marking them watched update the counts of the show in place,
+     anything that may lower a MAX() or move an episode recalculates the whole show. */
+  std::string season = StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_SEASON);
+  m_pDS->exec("CREATE TRIGGER tvshowcounts_insert_tvshow AFTER INSERT ON tvshow FOR EACH ROW BEGIN "
+              "INSERT INTO tvshowcounts (idShow, totalCount, watchedcount, totalSeasons) VALUES (new.idShow, 0, 0, 0); "
+              "END");
+  m_pDS->exec("CREATE TRIGGER tvshowcounts_insert_episode AFTER INSERT ON episode FOR EACH ROW BEGIN "
+              "UPDATE tvshowcounts SET "
+              "totalCount=totalCount+" + Counted("new." + season) + ", "
+              "totalSeasons=totalSeasons+" + OnlyInSeason("new.idShow", "new." + season, "new.idEpisode") + ", "
+              "watchedcount=watchedcount+(SELECT COUNT(playCount) FROM files WHERE idFile=new.idFile), "
+              "lastPlayed=" + Greatest("lastPlayed", "(SELECT lastPlayed FROM files WHERE idFile=new.idFile)") + ", "
+              "dateAdded=" + Greatest("dateAdded", "(SELECT dateAdded FROM files WHERE idFile=new.idFile)") + " "
+              "WHERE idShow=new.idShow; "
+              "END");
+  m_pDS->exec("CREATE TRIGGER tvshowcounts_update_episode AFTER UPDATE ON episode FOR EACH ROW BEGIN "
+              "UPDATE tvshowcounts SET "
+              "totalCount=totalCount+" + Counted("new." + season) + "-" + Counted("old." + season) + ", "
+              "totalSeasons=totalSeasons+" + OnlyInSeason("new.idShow", "new." + season, "new.idEpisode") +
+                                       "-" + OnlyInSeason("new.idShow", "old." + season, "new.idEpisode") + " "
+              "WHERE idShow=new.idShow AND old.idShow=new.idShow AND old.idFile=new.idFile; " +
+              RefreshTvShowCountsSQL("WHERE tvshow.idShow IN (old.idShow, new.idShow) AND (old.idShow<>new.idShow OR old.idFile<>new.idFile)") +
+              "END");
+  m_pDS->exec("CREATE TRIGGER tvshowcounts_update_files AFTER UPDATE ON files FOR EACH ROW BEGIN "
+              "UPDATE tvshowcounts SET "
+              "watchedcount=watchedcount+(" + Counted("new.playCount") + "-" + Counted("old.playCount") + ")*"
+                "(SELECT COUNT(1) FROM episode WHERE idFile=new.idFile AND idShow=tvshowcounts.idShow), "
+              "lastPlayed=" + Greatest("lastPlayed", "new.lastPlayed") + ", "
+              "dateAdded=" + Greatest("dateAdded", "new.dateAdded") + " "
+              "WHERE idShow IN (SELECT idShow FROM episode WHERE idFile=new.idFile); " +
+              RefreshTvShowCountsSQL("WHERE tvshow.idShow IN (SELECT idShow FROM episode WHERE idFile=new.idFile) AND "
+                                     "((old.lastPlayed IS NOT NULL AND (new.lastPlayed IS NULL OR new.lastPlayed < old.lastPlayed)) OR "
+                                     " (old.dateAdded IS NOT NULL AND (new.dateAdded IS NULL OR new.dateAdded < old.dateAdded)))") +
+              "END");
+  m_pDS->exec("CREATE TRIGGER tvshowcounts_delete_files AFTER DELETE ON files FOR EACH ROW BEGIN " +
+              RefreshTvShowCountsSQL("WHERE tvshow.idShow IN (SELECT idShow FROM episode WHERE idFile=old.idFile)") +
+              "END");
+
+  // the triggers aren't in place while the tables are updated
+  CLog::Log(LOGINFO, "%s - updating tvshowcounts", __FUNCTION__);
+  m_pDS->exec("DELETE FROM tvshowcounts");
+  m_pDS->exec(RefreshTvShowCountsSQL(""));
+
+  CLog::Log(LOGINFO, "%s - creating search indices", __FUNCTION__);
+  CreateSearchIndex("movie", "idMovie", PrepareSQL("c%02d", VIDEODB_ID_TITLE));
+  CreateSearchIndex("tvshow", "idShow", PrepareSQL("c%02d", VIDEODB_ID_TV_TITLE));
+  CreateSearchIndex("episode", "idEpisode", PrepareSQL("c%02d", VIDEODB_ID_EPISODE_TITLE));
+  CreateSearchIndex("musicvideo", "idMVideo", PrepareSQL("c%02d", VIDEODB_ID_MUSICVIDEO_TITLE));
+  CreateSearchIndex("actors", "idActor", "strActor");
+
   CreateViews();
 }
 
@@ -411,29 +498,13 @@ void CVideoDatabase::CreateViews()
 
   /* NOTE: The tvshowview needs to have "GROUP BY tvshow.idShow" added to any usage if you wish to
            avoid duplicates due to multiple paths per tvshow (from the join on tvshowlinkpath) */
-  CLog::Log(LOGINFO, "create tvshowcounts");
-  std::string tvshowcounts = PrepareSQL("CREATE VIEW tvshowcounts AS SELECT "
-                                       "      tvshow.idShow AS idShow,"
-                                       "      MAX(files.lastPlayed) AS lastPlayed,"
-                                       "      NULLIF(COUNT(episode.c12), 0) AS totalCount,"
-                                       "      COUNT(files.playCount) AS watchedcount,"
-                                       "      NULLIF(COUNT(DISTINCT(episode.c12)), 0) AS totalSeasons, "
-                                       "      MAX(files.dateAdded) as dateAdded "
-                                       "    FROM tvshow"
-                                       "      LEFT JOIN episode ON"
-                                       "        episode.idShow=tvshow.idShow"
-                                       "      LEFT JOIN files ON"
-                                       "        files.idFile=episode.idFile "
-                                       "    GROUP BY tvshow.idShow");
-  m_pDS->exec(tvshowcounts.c_str());
-
   CLog::Log(LOGINFO, "create tvshowview");
   std::string tvshowview = PrepareSQL("CREATE VIEW tvshowview AS SELECT "
                                      "  tvshow.*,"
                                      "  path.idParentPath AS idParentPath,"
                                      "  path.strPath AS strPath,"
                                      "  tvshowcounts.dateAdded AS dateAdded,"
-                                     "  lastPlayed, totalCount, watchedcount, totalSeasons "
+                                     "  lastPlayed, NULLIF(totalCount, 0) AS totalCount, watchedcount, NULLIF(totalSeasons, 0) AS totalSeasons "
                                      "FROM tvshow"
                                      "  LEFT JOIN tvshowlinkpath ON"
                                      "    tvshowlinkpath.idShow=tvshow.idShow"
@@ -508,6 +579,68 @@ void CVideoDatabase::CreateViews()
               "    bookmark.idFile=movie.idFile AND bookmark.type=1");
 }
 
+std::string CVideoDatabase::GetTvShowCountsSQL(const std::string &where /* = "" */) const
+{
+  return PrepareSQL("SELECT "
+                    "  tvshow.idShow AS idShow,"
+                    "  MAX(files.lastPlayed) AS lastPlayed,"
+                    "  COUNT(episode.c%02d) AS totalCount,"
+                    "  COUNT(files.playCount) AS watchedcount,"
+                    "  COUNT(DISTINCT(episode.c%02d)) AS totalSeasons,"
+                    "  MAX(files.dateAdded) AS dateAdded "
+                    "FROM tvshow"
+                    "  LEFT JOIN episode ON"
+                    "    episode.idShow=tvshow.idShow"
+                    "  LEFT JOIN files ON"
+                    "    files.idFile=episode.idFile ", VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_EPISODE_SEASON) +
+         where + " GROUP BY tvshow.idShow";
+}
+
+std::string CVideoDatabase::RefreshTvShowCountsSQL(const std::string &where) const
+{
+  return "REPLACE INTO tvshowcounts (idShow, lastPlayed, totalCount, watchedcount, totalSeasons, dateAdded) " + GetTvShowCountsSQL(where) + "; ";
+}
+
+int CVideoDatabase::CheckTvShowCounts(bool repair /* = true */)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return -1;
+    if (NULL == m_pDS.get()) return -1;
+
+    // compare with the aggregate tvshowview used before, NULL counts as equal to NULL
+    std::string sql = "SELECT COUNT(1) FROM (" + GetTvShowCountsSQL() + ") counts"
+                      "  LEFT JOIN tvshowcounts ON"
+                      "    tvshowcounts.idShow=counts.idShow "
+                      "WHERE tvshowcounts.idShow IS NULL";
+    const char *columns[] = { "lastPlayed", "totalCount", "watchedcount", "totalSeasons", "dateAdded" };
+    for (unsigned int i = 0; i < sizeof(columns) / sizeof(columns[0]); i++)
+      sql += PrepareSQL(" OR NOT (counts.%s=tvshowcounts.%s OR (counts.%s IS NULL AND tvshowcounts.%s IS NULL))",
+                        columns[i], columns[i], columns[i], columns[i]);
+
+    int wrong = atoi(GetSingleValue(sql).c_str());
+    wrong += atoi(GetSingleValue("SELECT COUNT(1) FROM tvshowcounts WHERE NOT EXISTS (SELECT 1 FROM tvshow WHERE tvshow.idShow=tvshowcounts.idShow)").c_str());
+    if (wrong > 0)
+    {
+      CLog::Log(LOGWARNING, "%s - %i tvshows have wrong counts", __FUNCTION__, wrong);
+      if (repair)
+      {
+        BeginTransaction();
+        m_pDS->exec("DELETE FROM tvshowcounts");
+        m_pDS->exec(RefreshTvShowCountsSQL(""));
+        CommitTransaction();
+      }
+    }
+    return wrong;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    RollbackTransaction();
+  }
+  return -1;
+}
+
 //********************************************************************************************************************************
 int CVideoDatabase::GetPathId(const std::string& strPath)
 {
@@ -524,8 +657,8 @@ int CVideoDatabase::GetPathId(const std::string& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL.c_str());
+    strSQL = "select idPath from path where strPath=?";
+    m_pDS->query(strSQL, Parameters(strPath1));
     if (!m_pDS->eof())
       idPath = m_pDS->fv("path.idPath").get_asInt();
 
@@ -668,6 +801,108 @@ int CVideoDatabase::RunQuery(const std::string &sql)
   return rows;
 }
 
+int CVideoDatabase::RunSortedQuery(const std::string &view, const std::string &idField, const MediaType &mediaType, const Filter &filter,
+                                   const std::string &strSQLExtra, const SortDescription &sorting, DatabaseResults &results)
+{
+  std::string strSQL = "SELECT %s FROM " + view + " ";
+  std::string strSQLLimit;
+  SortDescription order = sorting;
+  int total = -1;
+
+  if (filter.limit.empty() && (sorting.limitStart > 0 || sorting.limitEnd > 0))
+  {
+    // Apply the limiting directly here if there's no special sorting but limiting
+    if (sorting.sortBy == SortByNone || (sorting.sortBy == SortByRandom && filter.order.empty()))
+    {
+      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
+      if (sorting.sortBy == SortByRandom)
+        strSQLLimit = PrepareSQL(" ORDER BY RANDOM()");
+      strSQLLimit += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      order.limitStart = 0;
+      order.limitEnd = -1;
+    }
+    // let the database sort the rows and read the rows of the range only
+    else if (filter.order.empty() && BuildOrderClause(sorting, mediaType, strSQLLimit))
+    {
+      if (filter.group.empty())
+        total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
+      else // count the groups instead of the rows
+        total = (int)strtol(GetSingleValue("SELECT COUNT(1) FROM (" + PrepareSQL(strSQL, (view + "." + idField).c_str()) + strSQLExtra + ") AS grouped", m_pDS).c_str(), NULL, 10);
+      strSQLLimit += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
+      order.sortBy = SortByNone;
+      order.limitStart = 0;
+      order.limitEnd = -1;
+    }
+    else if (filter.fields.empty() && sorting.limitEnd > 0)
+    {
+      // sort the values of the sort fields of all rows and read the rows of the range only
+      FieldList fields;
+      if (DatabaseUtils::GetSelectFields(SortUtils::GetFieldsForSorting(sorting.sortBy), mediaType, fields))
+      {
+        std::string columns = view + "." + idField;
+        for (FieldList::const_iterator it = fields.begin(); it != fields.end(); ++it)
+          columns += ", " + DatabaseUtils::GetField(*it, mediaType, DatabaseQueryPartSelect);
+
+        total = RunQuery(PrepareSQL(strSQL, columns.c_str()) + strSQLExtra);
+        if (total <= 0)
+          return total;
+
+        if (!DatabaseUtils::GetDatabaseResults(mediaType, fields, m_pDS, results, 1))
+          return -1;
+        SortUtils::Sort(sorting, results);
+
+        std::string ids;
+        const query_data &data = m_pDS->get_result_set().records;
+        for (DatabaseResults::iterator it = results.begin(); it != results.end(); ++it)
+        {
+          int id = data.at((unsigned int)it->at(FieldRow).asInteger())->at(0).get_asInt();
+          (*it)[FieldId] = id;
+          ids += StringUtils::Format(ids.empty() ? "%i" : ",%i", id);
+        }
+        m_pDS->close();
+        if (ids.empty())
+          return total;
+
+        if (RunQuery(PrepareSQL(strSQL, "*") + PrepareSQL("WHERE %s.%s IN (%s)", view.c_str(), idField.c_str(), ids.c_str())) < 0)
+          return -1;
+
+        // point the results to the complete rows, skipping rows removed in the meantime
+        std::map<int, int> rows;
+        const query_data &records = m_pDS->get_result_set().records;
+        for (unsigned int row = 0; row < records.size(); row++)
+          rows.insert(std::make_pair(records[row]->at(0).get_asInt(), (int)row));
+
+        DatabaseResults range;
+        range.reserve(results.size());
+        for (DatabaseResults::iterator it = results.begin(); it != results.end(); ++it)
+        {
+          std::map<int, int>::const_iterator row = rows.find((int)it->at(FieldId).asInteger());
+          if (row == rows.end())
+            continue;
+
+          (*it)[FieldRow] = row->second;
+          range.push_back(*it);
+        }
+        results.swap(range);
+        return total;
+      }
+    }
+  }
+
+  int iRowsFound = RunQuery(PrepareSQL(strSQL, !filter.fields.empty() ? filter.fields.c_str() : "*") + strSQLExtra + strSQLLimit);
+  if (iRowsFound <= 0)
+    return iRowsFound < 0 ? -1 : std::max(total, 0);
+
+  if (total < iRowsFound)
+    total = iRowsFound;
+
+  results.reserve(iRowsFound);
+  if (!SortUtils::SortFromDataset(order, mediaType, m_pDS, results))
+    return -1;
+
+  return total;
+}
+
 bool CVideoDatabase::GetSubPaths(const std::string &basepath, vector< pair<int,string> >& subpaths)
 {
   std::string sql;
@@ -1086,9 +1321,7 @@ int CVideoDatabase::GetFileId(const std::string& strFilenameAndPath)
     int idPath = GetPathId(strPath);
     if (idPath >= 0)
     {
-      std::string strSQL;
-      strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-      m_pDS->query(strSQL.c_str());
+      m_pDS->query("select idFile from files where strFileName=? and idPath=?", Parameters(strFileName)(idPath));
       if (m_pDS->num_rows() > 0)
       {
         int idFile = m_pDS->fv("files.idFile").get_asInt();
@@ -1435,6 +1668,21 @@ int CVideoDatabase::AddToTable(const std::string& table, const std::string& firs
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
 
+    if (InBatch())
+    {
+      LookupIds &ids = GetLookupIds(table, firstField, secondField);
+      std::string key = value;
+      StringUtils::ToLower(key);
+      LookupIds::const_iterator it = ids.find(key);
+      if (it != ids.end())
+        return it->second;
+
+      m_pDS->exec(PrepareSQL("insert into %s (%s, %s) values(NULL, '%s')", table.c_str(), firstField.c_str(), secondField.c_str(), value.c_str()));
+      int id = (int)m_pDS->lastinsertid();
+      ids.insert(std::make_pair(key, id));
+      return id;
+    }
+
     std::string strSQL = PrepareSQL("select %s from %s where %s like '%s'", firstField.c_str(), table.c_str(), secondField.c_str(), value.c_str());
     m_pDS->query(strSQL.c_str());
     if (m_pDS->num_rows() == 0)
@@ -1500,6 +1748,30 @@ int CVideoDatabase::AddActor(const std::string& strActor, const std::string& thu
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
     int idActor = -1;
+    if (InBatch())
+    {
+      LookupIds &ids = GetLookupIds("actors", "idActor", "strActor");
+      std::string key = strActor;
+      StringUtils::ToLower(key);
+      LookupIds::const_iterator it = ids.find(key);
+      if (it == ids.end())
+      {
+        m_pDS->exec(PrepareSQL("insert into actors (idActor, strActor, strThumb) values( NULL, '%s','%s')", strActor.c_str(), thumbURLs.c_str()));
+        idActor = (int)m_pDS->lastinsertid();
+        ids.insert(std::make_pair(key, idActor));
+      }
+      else
+      {
+        idActor = it->second;
+        if (!thumbURLs.empty())
+          ExecuteQuery("update actors set strThumb=? where idActor=?", Parameters(thumbURLs)(idActor));
+      }
+
+      if (!thumb.empty())
+        SetArtForItem(idActor, "actor", "thumb", thumb);
+      return idActor;
+    }
+
     std::string strSQL=PrepareSQL("select idActor from actors where strActor like '%s'", strActor.c_str());
     m_pDS->query(strSQL.c_str());
     if (m_pDS->num_rows() == 0)
@@ -1542,13 +1814,13 @@ void CVideoDatabase::AddLinkToActor(const char *table, int actorID, const char *
     if (NULL == m_pDB.get()) return ;
     if (NULL == m_pDS.get()) return ;
 
-    std::string strSQL=PrepareSQL("select * from actorlink%s where idActor=%i and id%s=%i", table, actorID, field, secondID);
-    m_pDS->query(strSQL.c_str());
+    std::string strSQL=PrepareSQL("select * from actorlink%s where idActor=? and id%s=?", table, field);
+    m_pDS->query(strSQL, Parameters(actorID)(secondID));
     if (m_pDS->num_rows() == 0)
     {
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into actorlink%s (idActor, id%s, strRole, iOrder) values(%i,%i,'%s',%i)", table, field, actorID, secondID, role.c_str(), order);
-      m_pDS->exec(strSQL.c_str());
+      strSQL=PrepareSQL("insert into actorlink%s (idActor, id%s, strRole, iOrder) values(?,?,?,?)", table, field);
+      m_pDS->exec(strSQL, Parameters(actorID)(secondID)(role)(order));
     }
     m_pDS->close();
   }
@@ -1565,18 +1837,22 @@ void CVideoDatabase::AddToLinkTable(const char *table, const char *firstField, i
     if (NULL == m_pDB.get()) return ;
     if (NULL == m_pDS.get()) return ;
 
-    std::string strSQL = PrepareSQL("select * from %s where %s=%i and %s=%i", table, firstField, firstID, secondField, secondID);
+    Parameters params = Parameters(firstID)(secondID);
+    std::string strSQL = PrepareSQL("select * from %s where %s=? and %s=?", table, firstField, secondField);
     if (typeField != NULL && type != NULL)
-      strSQL += PrepareSQL(" and %s='%s'", typeField, type);
-    m_pDS->query(strSQL.c_str());
+    {
+      strSQL += PrepareSQL(" and %s=?", typeField);
+      params(std::string(type));
+    }
+    m_pDS->query(strSQL, params);
     if (m_pDS->num_rows() == 0)
     {
       // doesnt exists, add it
       if (typeField == NULL || type == NULL)
-        strSQL = PrepareSQL("insert into %s (%s,%s) values(%i,%i)", table, firstField, secondField, firstID, secondID);
+        strSQL = PrepareSQL("insert into %s (%s,%s) values(?,?)", table, firstField, secondField);
       else
-        strSQL = PrepareSQL("insert into %s (%s,%s,%s) values(%i,%i,'%s')", table, firstField, secondField, typeField, firstID, secondID, type);
-      m_pDS->exec(strSQL.c_str());
+        strSQL = PrepareSQL("insert into %s (%s,%s,%s) values(?,?,?)", table, firstField, secondField, typeField);
+      m_pDS->exec(strSQL, params);
     }
     m_pDS->close();
   }
@@ -3195,14 +3471,14 @@ void CVideoDatabase::DeleteMovie(int idMovie, bool bKeepId /* = false */)
     // the ancilliary tables are still purged
     if (!bKeepId)
     {
-      strSQL=PrepareSQL("delete from movie where idMovie=%i", idMovie);
-      m_pDS->exec(strSQL.c_str());
-
-      // TODO: Why are we invalidating paths here?
+      // invalidate the path before the movie is gone, so that the next scan picks it up again
       int idFile = GetDbId(PrepareSQL("SELECT idFile FROM movie WHERE idMovie=%i", idMovie));
       std::string path = GetSingleValue(PrepareSQL("SELECT strPath FROM path JOIN files ON files.idPath=path.idPath WHERE files.idFile=%i", idFile));
       if (!path.empty())
         InvalidatePathHash(path);
+
+      strSQL=PrepareSQL("delete from movie where idMovie=%i", idMovie);
+      m_pDS->exec(strSQL.c_str());
     }
 
     //TODO: move this below CommitTransaction() once UPnP doesn't rely on this anymore
@@ -3238,6 +3514,11 @@ void CVideoDatabase::DeleteTvShow(int idTvShow, bool bKeepId /* = false */)
 
     BeginTransaction();
 
+    // the paths of the episodes, taken while they're still there
+    set<int> paths;
+    if (!bKeepId)
+      GetPathsForTvShow(idTvShow, paths);
+
     std::string strSQL=PrepareSQL("SELECT episode.idEpisode FROM episode WHERE episode.idShow=%i",idTvShow);
     m_pDS2->query(strSQL.c_str());
     while (!m_pDS2->eof())
@@ -3263,9 +3544,7 @@ void CVideoDatabase::DeleteTvShow(int idTvShow, bool bKeepId /* = false */)
       strSQL=PrepareSQL("delete from movielinktvshow where idShow=%i", idTvShow);
       m_pDS->exec(strSQL.c_str());
 
-      // TODO: why do we invalidate the path hash here??
-      set<int> paths;
-      GetPathsForTvShow(idTvShow, paths);
+      // so that the next scan picks the show up again
       for (set<int>::const_iterator i = paths.begin(); i != paths.end(); ++i)
       {
         std::string path = GetSingleValue(PrepareSQL("SELECT strPath FROM path WHERE idPath=%i", *i));
@@ -3405,14 +3684,14 @@ void CVideoDatabase::DeleteMusicVideo(int idMVideo, bool bKeepId /* = false */)
     // the ancilliary tables are still purged
     if (!bKeepId)
     {
-      strSQL=PrepareSQL("delete from musicvideo where idMVideo=%i", idMVideo);
-      m_pDS->exec(strSQL.c_str());
-
-      // TODO: Why are we invalidating paths here?
+      // invalidate the path before the music video is gone, so that the next scan picks it up again
       int idFile = GetDbId(PrepareSQL("SELECT idFile FROM musicvideo WHERE idMVideo=%i", idMVideo));
       std::string path = GetSingleValue(PrepareSQL("SELECT strPath FROM path JOIN files ON files.idPath=path.idPath WHERE files.idFile=%i", idFile));
       if (!path.empty())
         InvalidatePathHash(path);
+
+      strSQL=PrepareSQL("delete from musicvideo where idMVideo=%i", idMVideo);
+      m_pDS->exec(strSQL.c_str());
     }
 
     //TODO: move this below CommitTransaction() once UPnP doesn't rely on this anymore
@@ -4456,6 +4735,9 @@ void CVideoDatabase::SetScraperForPath(const std::string& filePath, const Scrape
       strSQL=PrepareSQL("update path set strContent='%s', strScraper='%s', scanRecursive=%i, useFolderNames=%i, strSettings='%s', noUpdate=%i, exclude=0 where idPath=%i", content.c_str(), scraper->ID().c_str(),settings.recurse,settings.parent_name,scraper->GetPathSettings().c_str(),settings.noupdate, idPath);
     }
     m_pDS->exec(strSQL.c_str());
+
+    // what's below the path is to be scanned differently, so it can't be skipped on its next scan
+    DeleteFingerprint(filePath);
   }
   catch (...)
   {
@@ -4793,11 +5075,17 @@ void CVideoDatabase::UpdateTables(int iVersion)
     m_pDS->exec("DELETE from art WHERE media_type='tvshow' AND NOT EXISTS (SELECT 1 FROM tvshow WHERE tvshow.idShow = art.media_id)");
     m_pDS->exec("DELETE from art WHERE media_type='season' AND NOT EXISTS (SELECT 1 FROM seasons WHERE seasons.idSeason = art.media_id)");
   }
+  if (iVersion < 90)
+  { // tvshowcounts is a table kept up to date by triggers instead of a view, it's filled by CreateAnalytics()
+    m_pDS->exec("CREATE TABLE tvshowcounts ( idShow integer primary key, lastPlayed text, totalCount integer, watchedcount integer, totalSeasons integer, dateAdded text)\n");
+  }
+  if (iVersion < 92)
+    CreateFingerprintTable();
 }
 
 int CVideoDatabase::GetSchemaVersion() const
 {
-  return 89;
+  return 92;
 }
 
 bool CVideoDatabase::LookupByFolders(const std::string &path, bool shows)
@@ -6262,38 +6550,17 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
     if (!videoUrl.FromString(strBaseDir) || !GetFilter(videoUrl, extFilter, sorting))
       return false;
 
-    int total = -1;
-
-    std::string strSQL = "select %s from movieview ";
     std::string strSQLExtra;
     if (!CDatabase::BuildSQL(strSQLExtra, extFilter, strSQLExtra))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
-    if (extFilter.limit.empty() &&
-        sorting.sortBy == SortByNone &&
-       (sorting.limitStart > 0 || sorting.limitEnd > 0))
-    {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
-    }
-
-    strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
-
-    int iRowsFound = RunQuery(strSQL);
-    if (iRowsFound <= 0)
-      return iRowsFound == 0;
+    DatabaseResults results;
+    int total = RunSortedQuery("movieview", "idMovie", MediaTypeMovie, extFilter, strSQLExtra, sorting, results);
+    if (total <= 0)
+      return total == 0;
 
     // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
     items.SetProperty("total", total);
-    
-    DatabaseResults results;
-    results.reserve(iRowsFound);
-
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
-      return false;
 
     // get data from returned rows
     items.Reserve(results.size());
@@ -6365,9 +6632,6 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    int total = -1;
-    
-    std::string strSQL = "SELECT %s FROM tvshowview ";
     CVideoDbUrl videoUrl;
     std::string strSQLExtra;
     Filter extFilter = filter;
@@ -6376,30 +6640,13 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
     if (!BuildSQL(strBaseDir, strSQLExtra, extFilter, strSQLExtra, videoUrl, sorting))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
-    if (extFilter.limit.empty() &&
-        sorting.sortBy == SortByNone &&
-        (sorting.limitStart > 0 || sorting.limitEnd > 0))
-    {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
-    }
-
-    strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
-
-    int iRowsFound = RunQuery(strSQL);
-    if (iRowsFound <= 0)
-      return iRowsFound == 0;
+    DatabaseResults results;
+    int total = RunSortedQuery("tvshowview", "idShow", MediaTypeTvShow, extFilter, strSQLExtra, sorting, results);
+    if (total <= 0)
+      return total == 0;
 
     // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
     items.SetProperty("total", total);
-    
-    DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeTvShow, m_pDS, results))
-      return false;
 
     // get data from returned rows
     items.Reserve(results.size());
@@ -6493,9 +6740,6 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    int total = -1;
-    
-    std::string strSQL = "select %s from episodeview ";
     CVideoDbUrl videoUrl;
     std::string strSQLExtra;
     Filter extFilter = filter;
@@ -6503,31 +6747,14 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
     if (!BuildSQL(strBaseDir, strSQLExtra, extFilter, strSQLExtra, videoUrl, sorting))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
-    if (extFilter.limit.empty() &&
-      sorting.sortBy == SortByNone &&
-      (sorting.limitStart > 0 || sorting.limitEnd > 0))
-    {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
-    }
-
-    strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
-
-    int iRowsFound = RunQuery(strSQL);
-    if (iRowsFound <= 0)
-      return iRowsFound == 0;
+    DatabaseResults results;
+    int total = RunSortedQuery("episodeview", "idEpisode", MediaTypeEpisode, extFilter, strSQLExtra, sorting, results);
+    if (total <= 0)
+      return total == 0;
 
     // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
     items.SetProperty("total", total);
     
-    DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeEpisode, m_pDS, results))
-      return false;
-    
     // get data from returned rows
     items.Reserve(results.size());
     CLabelFormatter formatter("%H. %T", "");
@@ -7092,9 +7319,9 @@ void CVideoDatabase::GetMovieActorsByName(const std::string& strSearch, CFileIte
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL=PrepareSQL("select actors.idActor,actors.strActor,path.strPath from actorlinkmovie,actors,movie,files,path where actors.idActor=actorlinkmovie.idActor and actorlinkmovie.idMovie=movie.idMovie and files.idFile=movie.idFile and files.idPath=path.idPath and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL=PrepareSQL("select actors.idActor,actors.strActor,path.strPath from actorlinkmovie,actors,movie,files,path where actors.idActor=actorlinkmovie.idActor and actorlinkmovie.idMovie=movie.idMovie and files.idFile=movie.idFile and files.idPath=path.idPath and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     else
-      strSQL=PrepareSQL("select distinct actors.idActor,actors.strActor from actorlinkmovie,actors,movie where actors.idActor=actorlinkmovie.idActor and actorlinkmovie.idMovie=movie.idMovie and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL=PrepareSQL("select distinct actors.idActor,actors.strActor from actorlinkmovie,actors,movie where actors.idActor=actorlinkmovie.idActor and actorlinkmovie.idMovie=movie.idMovie and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7131,9 +7358,9 @@ void CVideoDatabase::GetTvShowsActorsByName(const std::string& strSearch, CFileI
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL=PrepareSQL("select actors.idActor,actors.strActor,path.strPath from actorlinktvshow,actors,tvshow,path,tvshowlinkpath where actors.idActor=actorlinktvshow.idActor and actorlinktvshow.idShow=tvshow.idShow and tvshowlinkpath.idPath=tvshow.idShow and tvshowlinkpath.idPath=path.idPath and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL=PrepareSQL("select actors.idActor,actors.strActor,path.strPath from actorlinktvshow,actors,tvshow,path,tvshowlinkpath where actors.idActor=actorlinktvshow.idActor and actorlinktvshow.idShow=tvshow.idShow and tvshowlinkpath.idPath=tvshow.idShow and tvshowlinkpath.idPath=path.idPath and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     else
-      strSQL=PrepareSQL("select distinct actors.idActor,actors.strActor from actorlinktvshow,actors,tvshow where actors.idActor=actorlinktvshow.idActor and actorlinktvshow.idShow=tvshow.idShow and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL=PrepareSQL("select distinct actors.idActor,actors.strActor from actorlinktvshow,actors,tvshow where actors.idActor=actorlinktvshow.idActor and actorlinktvshow.idShow=tvshow.idShow and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7171,11 +7398,11 @@ void CVideoDatabase::GetMusicVideoArtistsByName(const std::string& strSearch, CF
 
     std::string strLike;
     if (!strSearch.empty())
-      strLike = "and actors.strActor like '%%%s%%'";
+      strLike = "and " + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL=PrepareSQL("select actors.idActor,actors.strActor,path.strPath from artistlinkmusicvideo,actors,musicvideo,files,path where actors.idActor=artistlinkmusicvideo.idArtist and artistlinkmusicvideo.idMVideo=musicvideo.idMVideo and files.idFile=musicvideo.idFile and files.idPath=path.idPath "+strLike,strSearch.c_str());
+      strSQL=PrepareSQL("select actors.idActor,actors.strActor,path.strPath from artistlinkmusicvideo,actors,musicvideo,files,path where actors.idActor=artistlinkmusicvideo.idArtist and artistlinkmusicvideo.idMVideo=musicvideo.idMVideo and files.idFile=musicvideo.idFile and files.idPath=path.idPath ")+strLike;
     else
-      strSQL=PrepareSQL("select distinct actors.idActor,actors.strActor from artistlinkmusicvideo,actors where actors.idActor=artistlinkmusicvideo.idArtist "+strLike,strSearch.c_str());
+      strSQL=PrepareSQL("select distinct actors.idActor,actors.strActor from artistlinkmusicvideo,actors where actors.idActor=artistlinkmusicvideo.idArtist ")+strLike;
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7345,9 +7572,6 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    int total = -1;
-    
-    std::string strSQL = "select %s from musicvideoview ";
     CVideoDbUrl videoUrl;
     std::string strSQLExtra;
     Filter extFilter = filter;
@@ -7355,31 +7579,14 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
     if (!BuildSQL(baseDir, strSQLExtra, extFilter, strSQLExtra, videoUrl, sorting))
       return false;
 
-    // Apply the limiting directly here if there's no special sorting but limiting
-    if (extFilter.limit.empty() &&
-      sorting.sortBy == SortByNone &&
-      (sorting.limitStart > 0 || sorting.limitEnd > 0))
-    {
-      total = (int)strtol(GetSingleValue(PrepareSQL(strSQL, "COUNT(1)") + strSQLExtra, m_pDS).c_str(), NULL, 10);
-      strSQLExtra += DatabaseUtils::BuildLimitClause(sorting.limitEnd, sorting.limitStart);
-    }
-
-    strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
-
-    int iRowsFound = RunQuery(strSQL);
-    if (iRowsFound <= 0)
-      return iRowsFound == 0;
+    DatabaseResults results;
+    int total = RunSortedQuery("musicvideoview", "idMVideo", MediaTypeMusicVideo, extFilter, strSQLExtra, sorting, results);
+    if (total <= 0)
+      return total == 0;
 
     // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
     items.SetProperty("total", total);
     
-    DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeMusicVideo, m_pDS, results))
-      return false;
-    
     // get data from returned rows
     items.Reserve(results.size());
     // get songs from returned subtable
@@ -7539,9 +7746,11 @@ void CVideoDatabase::GetMoviesByName(const std::string& strSearch, CFileItemList
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath, movie.idSet from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath, movie.idSet from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and ",VIDEODB_ID_TITLE) +
+               GetSearchCondition("movie", "idMovie", PrepareSQL("c%02d", VIDEODB_ID_TITLE), "movie.idMovie", strSearch);
     else
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d, movie.idSet from movie where movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d, movie.idSet from movie where ",VIDEODB_ID_TITLE) +
+               GetSearchCondition("movie", "idMovie", PrepareSQL("c%02d", VIDEODB_ID_TITLE), "movie.idMovie", strSearch);
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7584,9 +7793,11 @@ void CVideoDatabase::GetTvShowsByName(const std::string& strSearch, CFileItemLis
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and ",VIDEODB_ID_TV_TITLE) +
+               GetSearchCondition("tvshow", "idShow", PrepareSQL("c%02d", VIDEODB_ID_TV_TITLE), "tvshow.idShow", strSearch);
     else
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where ",VIDEODB_ID_TV_TITLE) +
+               GetSearchCondition("tvshow", "idShow", PrepareSQL("c%02d", VIDEODB_ID_TV_TITLE), "tvshow.idShow", strSearch);
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7625,9 +7836,11 @@ void CVideoDatabase::GetEpisodesByName(const std::string& strSearch, CFileItemLi
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and episode.idShow=tvshow.idShow and files.idPath=path.idPath and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and episode.idShow=tvshow.idShow and files.idPath=path.idPath and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) +
+               GetSearchCondition("episode", "idEpisode", PrepareSQL("c%02d", VIDEODB_ID_EPISODE_TITLE), "episode.idEpisode", strSearch);
     else
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) +
+               GetSearchCondition("episode", "idEpisode", PrepareSQL("c%02d", VIDEODB_ID_EPISODE_TITLE), "episode.idEpisode", strSearch);
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7668,9 +7881,11 @@ void CVideoDatabase::GetMusicVideosByName(const std::string& strSearch, CFileIte
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and ",VIDEODB_ID_MUSICVIDEO_TITLE) +
+               GetSearchCondition("musicvideo", "idMVideo", PrepareSQL("c%02d", VIDEODB_ID_MUSICVIDEO_TITLE), "musicvideo.idMVideo", strSearch);
     else
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where ",VIDEODB_ID_MUSICVIDEO_TITLE) +
+               GetSearchCondition("musicvideo", "idMVideo", PrepareSQL("c%02d", VIDEODB_ID_MUSICVIDEO_TITLE), "musicvideo.idMVideo", strSearch);
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7796,9 +8011,9 @@ void CVideoDatabase::GetMovieDirectorsByName(const std::string& strSearch, CFile
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select distinct directorlinkmovie.idDirector,actors.strActor,path.strPath from movie,files,path,actors,directorlinkmovie where files.idFile=movie.idFile and files.idPath=path.idPath and directorlinkmovie.idMovie=movie.idMovie and directorlinkmovie.idDirector=actors.idActor and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL = PrepareSQL("select distinct directorlinkmovie.idDirector,actors.strActor,path.strPath from movie,files,path,actors,directorlinkmovie where files.idFile=movie.idFile and files.idPath=path.idPath and directorlinkmovie.idMovie=movie.idMovie and directorlinkmovie.idDirector=actors.idActor and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     else
-      strSQL = PrepareSQL("select distinct directorlinkmovie.idDirector,actors.strActor from movie,actors,directorlinkmovie where directorlinkmovie.idMovie=movie.idMovie and directorlinkmovie.idDirector=actors.idActor and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL = PrepareSQL("select distinct directorlinkmovie.idDirector,actors.strActor from movie,actors,directorlinkmovie where directorlinkmovie.idMovie=movie.idMovie and directorlinkmovie.idDirector=actors.idActor and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
 
     m_pDS->query( strSQL.c_str() );
 
@@ -7837,9 +8052,9 @@ void CVideoDatabase::GetTvShowsDirectorsByName(const std::string& strSearch, CFi
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select distinct directorlinktvshow.idDirector,actors.strActor,path.strPath from tvshow,path,actors,directorlinktvshow,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and directorlinktvshow.idShow=tvshow.idShow and directorlinktvshow.idDirector=actors.idActor and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL = PrepareSQL("select distinct directorlinktvshow.idDirector,actors.strActor,path.strPath from tvshow,path,actors,directorlinktvshow,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and directorlinktvshow.idShow=tvshow.idShow and directorlinktvshow.idDirector=actors.idActor and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     else
-      strSQL = PrepareSQL("select distinct directorlinktvshow.idDirector,actors.strActor from tvshow,actors,directorlinktvshow where directorlinktvshow.idShow=tvshow.idShow and directorlinktvshow.idDirector=actors.idActor and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL = PrepareSQL("select distinct directorlinktvshow.idDirector,actors.strActor from tvshow,actors,directorlinktvshow where directorlinktvshow.idShow=tvshow.idShow and directorlinktvshow.idDirector=actors.idActor and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
 
     m_pDS->query( strSQL.c_str() );
 
@@ -7878,9 +8093,9 @@ void CVideoDatabase::GetMusicVideoDirectorsByName(const std::string& strSearch,
     if (NULL == m_pDS.get()) return;
 
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select distinct directorlinkmusicvideo.idDirector,actors.strActor,path.strPath from musicvideo,files,path,actors,directorlinkmusicvideo where files.idFile=musicvideo.idFile and files.idPath=path.idPath and directorlinkmusicvideo.idMVideo=musicvideo.idMVideo and directorlinkmusicvideo.idDirector=actors.idActor and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL = PrepareSQL("select distinct directorlinkmusicvideo.idDirector,actors.strActor,path.strPath from musicvideo,files,path,actors,directorlinkmusicvideo where files.idFile=musicvideo.idFile and files.idPath=path.idPath and directorlinkmusicvideo.idMVideo=musicvideo.idMVideo and directorlinkmusicvideo.idDirector=actors.idActor and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
     else
-      strSQL = PrepareSQL("select distinct directorlinkmusicvideo.idDirector,actors.strActor from musicvideo,actors,directorlinkmusicvideo where directorlinkmusicvideo.idMVideo=musicvideo.idMVideo and directorlinkmusicvideo.idDirector=actors.idActor and actors.strActor like '%%%s%%'",strSearch.c_str());
+      strSQL = PrepareSQL("select distinct directorlinkmusicvideo.idDirector,actors.strActor from musicvideo,actors,directorlinkmusicvideo where directorlinkmusicvideo.idMVideo=musicvideo.idMVideo and directorlinkmusicvideo.idDirector=actors.idActor and ") + GetSearchCondition("actors", "idActor", "strActor", "actors.idActor", strSearch);
 
     m_pDS->query( strSQL.c_str() );
 
@@ -8207,6 +8422,9 @@ void CVideoDatabase::CleanDatabase(CGUIDialogProgressBarHandle* handle, const se
 
     CommitTransaction();
 
+    CLog::Log(LOGDEBUG, "%s: Checking tvshow counts", __FUNCTION__);
+    CheckTvShowCounts();
+
     if (handle)
       handle->SetTitle(g_localizeStrings.Get(331));
 
@@ -9179,6 +9397,9 @@ void CVideoDatabase::InvalidatePathHash(const std::string& strPath)
   bool foundDirectly;
   ScraperPtr info = GetScraperForPath(strPath,settings,foundDirectly);
   SetPathHash(strPath,"");
+
+  // the scan of a tree is skipped as long as its fingerprint is unchanged, removed items included
+  DeleteFingerprintsAbove(strPath);
   if (!info)
     return;
   if (info->Content() == CONTENT_TVSHOWS || (info->Content() == CONTENT_MOVIES && !foundDirectly)) // if we scan by folder name we need to invalidate parent as well
@@ -9195,15 +9416,74 @@ void CVideoDatabase::InvalidatePathHash(const std::string& strPath)
 bool CVideoDatabase::CommitTransaction()
 {
   if (CDatabase::CommitTransaction())
-  { // number of items in the db has likely changed, so recalculate
-    g_infoManager.SetLibraryBool(LIBRARY_HAS_MOVIES, HasContent(VIDEODB_CONTENT_MOVIES));
-    g_infoManager.SetLibraryBool(LIBRARY_HAS_TVSHOWS, HasContent(VIDEODB_CONTENT_TVSHOWS));
-    g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSICVIDEOS, HasContent(VIDEODB_CONTENT_MUSICVIDEOS));
+  { // number of items in the db has likely changed, so recalculate (once the batch is done)
+    if (!InBatch())
+      UpdateHasContent();
     return true;
   }
   return false;
 }
 
+void CVideoDatabase::RollbackTransaction()
+{
+  CDatabase::RollbackTransaction();
+
+  // the values added by the transaction are gone
+  m_lookupIds.clear();
+}
+
+void CVideoDatabase::BeginBulkIngest()
+{
+  BeginBatch(VIDEODB_BULK_BATCH_SIZE);
+}
+
+void CVideoDatabase::EndBulkIngest()
+{
+  if (!InBatch())
+    return;
+
+  if (!CommitBatch())
+    CLog::Log(LOGERROR, "%s failed to commit the added items", __FUNCTION__);
+  m_lookupIds.clear();
+  UpdateHasContent();
+}
+
+void CVideoDatabase::UpdateHasContent()
+{
+  g_infoManager.SetLibraryBool(LIBRARY_HAS_MOVIES, HasContent(VIDEODB_CONTENT_MOVIES));
+  g_infoManager.SetLibraryBool(LIBRARY_HAS_TVSHOWS, HasContent(VIDEODB_CONTENT_TVSHOWS));
+  g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSICVIDEOS, HasContent(VIDEODB_CONTENT_MUSICVIDEOS));
+}
+
+CVideoDatabase::LookupIds &CVideoDatabase::GetLookupIds(const std::string &table, const std::string &idField, const std::string &valueField)
+{
+  std::map<std::string, LookupIds>::iterator it = m_lookupIds.find(table);
+  if (it != m_lookupIds.end())
+    return it->second;
+
+  LookupIds &ids = m_lookupIds[table];
+  try
+  {
+    m_pDS->query(PrepareSQL("select %s, %s from %s", idField.c_str(), valueField.c_str(), table.c_str()).c_str());
+    while (!m_pDS->eof())
+    {
+      std::string key = m_pDS->fv(1).get_asString();
+      StringUtils::ToLower(key);
+      ids.insert(std::make_pair(key, m_pDS->fv(0).get_asInt()));
+      m_pDS->next();
+    }
+    m_pDS->close();
+  }
+  catch (...)
+  {
+    // an incomplete list would lead to duplicate values
+    m_lookupIds.erase(table);
+    throw;
+  }
+
+  return ids;
+}
+
 bool CVideoDatabase::SetSingleValue(VIDEODB_CONTENT_TYPE type, int dbId, int dbField, const std::string &strValue)
 {
   string strSQL;
@@ -9805,5 +10085,8 @@ bool CVideoDatabase::GetFilter(CDbUrl &videoUrl, Filter &filter, SortDescription
       videoUrl.RemoveOption("filter");
   }
 
+  // a page of the items, see CGUIMediaWindow::GetDirectory()
+  videoUrl.TakeSorting(sorting);
+
   return true;
 }
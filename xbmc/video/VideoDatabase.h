@@ -380,6 +380,23 @@ public:
 
   virtual bool Open();
   virtual bool CommitTransaction();
+  virtual void RollbackTransaction();
+
+  /*! \brief Prepare for adding many items, e.g. during a library scan
+   Transactions are committed in batches (see CDatabase::BeginBatch()) and the ids
+   of genres, studios, countries, sets, tags and actors are looked up in memory
+   rather than with a query per name.
+   \sa EndBulkIngest
+   */
+  void BeginBulkIngest();
+
+  /*! \brief Commit the items added since BeginBulkIngest()
+   \sa BeginBulkIngest
+   */
+  void EndBulkIngest();
+
+  /*! \brief Revision of the video database, see CDatabase::GetRevision() */
+  static long GetRevision() { return CDatabase::GetRevision("MyVideos"); }
 
   int AddMovie(const std::string& strFilenameAndPath);
   int AddEpisode(int idShow, const std::string& strFilenameAndPath);
@@ -660,6 +677,12 @@ public:
 
   void CleanDatabase(CGUIDialogProgressBarHandle* handle=NULL, const std::set<int>* paths=NULL, bool showProgress=true);
 
+  /*! \brief Check that the episode counts, watched counts and dates kept in the tvshowcounts table match the library
+   \param repair whether to recalculate the whole table if they don't.
+   \return the number of tvshows with wrong counts, -1 on error.
+   */
+  int CheckTvShowCounts(bool repair = true);
+
   /*! \brief Add a file to the database, if necessary
    If the file is already in the database, we simply return its id.
    \param url - full path of the file to add.
@@ -860,6 +883,18 @@ private:
    */
   virtual void CreateViews();
 
+  /*! \brief Get the query aggregating the counts kept in the tvshowcounts table
+   \param where the condition limiting the tvshows, e.g. "WHERE tvshow.idShow=new.idShow".
+   \return the query selecting the columns of tvshowcounts.
+   */
+  std::string GetTvShowCountsSQL(const std::string &where = "") const;
+
+  /*! \brief Get the statement recalculating rows of the tvshowcounts table
+   \param where the condition limiting the tvshows, all rows are recalculated if empty.
+   \return the statement, terminated for use in a trigger.
+   */
+  std::string RefreshTvShowCountsSQL(const std::string &where) const;
+
   /*! \brief Helper to get a database id given a query.
    Returns an integer, -1 if not found, and greater than 0 if found.
    \param query the SQL that will retrieve a database id.
@@ -874,6 +909,21 @@ private:
    */
   int RunQuery(const std::string &sql);
 
+  /*! \brief Run the query of a library listing on the main dataset and sort its rows
+   If only a range of the sorted rows is requested, only the columns needed for sorting are
+   read for all rows and the complete rows are read for the requested range alone.
+   \param view the view to query, e.g. "movieview"
+   \param idField the id column of the view, e.g. "idMovie"
+   \param mediaType the type of the items in the view
+   \param filter the filter the clauses were built from
+   \param strSQLExtra the clauses of the query built from the filter
+   \param sorting the sort order and range of the rows to get
+   \param results the sorted rows of the range, referring to the rows of the main dataset
+   \return the number of rows matching the filter, -1 for an error.
+   */
+  int RunSortedQuery(const std::string &view, const std::string &idField, const MediaType &mediaType, const Filter &filter,
+                     const std::string &strSQLExtra, const SortDescription &sorting, DatabaseResults &results);
+
   /*! \brief Determine whether the path is using lookup using folders
    \param path the path to check
    \param shows whether this path is from a tvshow (defaults to false)
@@ -901,4 +951,18 @@ private:
 
   static void AnnounceRemove(std::string content, int id, bool scanning = false);
   static void AnnounceUpdate(std::string content, int id);
+
+  void UpdateHasContent();
+
+  typedef std::map<std::string, int> LookupIds;
+
+  /*! \brief Get the ids of all values of a lookup table during a bulk ingest
+   \param table the lookup table, e.g. genre.
+   \param idField the id column of the table.
+   \param valueField the value column of the table, the values are lower case.
+   \return the ids of the values.
+   */
+  LookupIds &GetLookupIds(const std::string &table, const std::string &idField, const std::string &valueField);
+
+  std::map<std::string, LookupIds> m_lookupIds; ///< ids of lookup table values by table during a bulk ingest
 };
@@ -23,6 +23,7 @@
 #include "VideoInfoScanner.h"
 #include "addons/AddonManager.h"
 #include "filesystem/DirectoryCache.h"
+#include "filesystem/DirectoryFingerprint.h"
 #include "Util.h"
 #include "NfoFile.h"
 #include "utils/RegExp.h"
@@ -51,6 +52,10 @@
 #include "GUIUserMessages.h"
 #include "URL.h"
 #include "music/tags/TagLoaderTagLib.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
+
+#include <memory>
 
 using namespace std;
 using namespace XFILE;
@@ -59,6 +64,173 @@ using namespace ADDON;
 namespace VIDEO
 {
 
+  /*! \brief A stage of a CVideoScanPipeline, handing the items it's done with back to the pipeline
+   */
+  class CVideoScanPipeline::CStage : public CJobQueue
+  {
+  public:
+    CStage(CVideoScanPipeline *pipeline, unsigned int stage, unsigned int jobs)
+      : CJobQueue(false, jobs, CJob::PRIORITY_NORMAL), m_pipeline(pipeline), m_stage(stage)
+    {
+    }
+
+    virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
+  private:
+    CVideoScanPipeline *m_pipeline;
+    unsigned int m_stage;
+  };
+
+  /*! \brief Job processing a single item through a stage of a CVideoScanPipeline
+   */
+  class CVideoScanPipeline::CStageJob : public CJob
+  {
+  public:
+    CStageJob(CVideoScanPipeline *pipeline, unsigned int stage, SScanItem *item)
+      : m_pipeline(pipeline), m_stage(stage), m_item(item), m_next(false)
+    {
+    }
+
+    virtual ~CStageJob()
+    {
+      delete m_item;
+    }
+
+    virtual const char *GetType() const { return "videoscanstage"; }
+
+    virtual bool DoWork()
+    {
+      if (m_pipeline->IsStopped())
+        m_item->result = INFO_CANCELLED;
+      else
+        m_next = m_pipeline->m_worker->ProcessStage(m_stage, *m_item);
+      return true;
+    }
+
+    CVideoScanPipeline *m_pipeline;
+    unsigned int m_stage;
+    SScanItem *m_item; ///< owned until handed back to the pipeline
+    bool m_next;
+  };
+
+  void CVideoScanPipeline::CStage::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    CStageJob *stageJob = (CStageJob *)job;
+    SScanItem *item = stageJob->m_item;
+    stageJob->m_item = NULL;
+    bool next = stageJob->m_next;
+
+    // once the item is handed back the pipeline, and this stage with it, may be destroyed
+    CJobQueue::OnJobComplete(jobID, success, job);
+    m_pipeline->OnStageComplete(m_stage, item, next);
+  }
+
+  CVideoScanPipeline::CVideoScanPipeline(IVideoScanWorker *worker, const vector<unsigned int> &jobs)
+  {
+    m_worker = worker;
+    m_pending = 0;
+    m_stopped = false;
+    for (unsigned int i = 0; i < jobs.size(); i++)
+      m_stages.push_back(new CStage(this, i, std::max(jobs[i], 1U)));
+  }
+
+  CVideoScanPipeline::~CVideoScanPipeline()
+  {
+    // the jobs still running refer to us (and the worker), so wait for them
+    Stop();
+    while (GetPending() > 0)
+      delete GetProcessed(1000);
+    for (vector<CStage *>::iterator i = m_stages.begin(); i != m_stages.end(); ++i)
+      delete *i;
+  }
+
+  void CVideoScanPipeline::Add(SScanItem *item)
+  {
+    {
+      CSingleLock lock(m_section);
+      m_pending++;
+    }
+    if (m_stages.empty())
+      OnStageComplete(0, item, false);
+    else
+      m_stages[0]->AddJob(new CStageJob(this, 0, item));
+  }
+
+  void CVideoScanPipeline::OnStageComplete(unsigned int stage, SScanItem *item, bool next)
+  {
+    if (next && stage + 1 < m_stages.size())
+    {
+      if (!m_stopped)
+      {
+        m_stages[stage + 1]->AddJob(new CStageJob(this, stage + 1, item));
+        return;
+      }
+      item->result = INFO_CANCELLED;
+    }
+
+    CSingleLock lock(m_section);
+    m_processed.push_back(item);
+    m_processedEvent.Set();
+  }
+
+  SScanItem *CVideoScanPipeline::GetProcessed(unsigned int timeout)
+  {
+    CSingleLock lock(m_section);
+    if (m_processed.empty())
+    {
+      lock.Leave();
+      m_processedEvent.WaitMSec(timeout);
+      lock.Enter();
+      if (m_processed.empty())
+        return NULL;
+    }
+    SScanItem *item = m_processed.front();
+    m_processed.pop_front();
+    m_pending--;
+    return item;
+  }
+
+  unsigned int CVideoScanPipeline::GetPending() const
+  {
+    CSingleLock lock(m_section);
+    return m_pending;
+  }
+
+  void CVideoScanPipeline::Stop()
+  {
+    m_stopped = true;
+  }
+
+  /*! \brief Whether an item is a video file that movie and music video scrapers look up
+   */
+  static bool IsVideoFile(const CFileItem &item)
+  {
+    return !item.m_bIsFolder && item.IsVideo() && !item.IsNFO() &&
+           (!item.IsPlayList() || URIUtils::HasExtension(item.GetPath(), ".strm"));
+  }
+
+  /*! \brief Account for the outcome of the lookup of an item
+   \param missedInfo set if the item couldn't be looked up.
+   \return false if the scan should stop, true otherwise
+   */
+  static bool OnInfoRetrieved(INFO_RET ret, const CFileItem &item, bool &foundSomeInfo, bool &missedInfo)
+  {
+    if (ret == INFO_CANCELLED || ret == INFO_ERROR)
+    {
+      foundSomeInfo = false;
+      missedInfo = true;
+      return false;
+    }
+    if (ret == INFO_ADDED || ret == INFO_HAVE_ALREADY)
+      foundSomeInfo = true;
+    else if (ret == INFO_NOT_FOUND)
+    {
+      CLog::Log(LOGWARNING, "No information found for item '%s', it won't be added to the library.", CURL::GetRedacted(item.GetPath()).c_str());
+      missedInfo = true;
+    }
+    return true;
+  }
+
   CVideoInfoScanner::CVideoInfoScanner() : CThread("VideoInfoScanner")
   {
     m_bRunning = false;
@@ -69,6 +241,7 @@ namespace VIDEO
     m_itemCount = 0;
     m_bClean = false;
     m_scanAll = false;
+    m_missedInfo = false;
   }
 
   CVideoInfoScanner::~CVideoInfoScanner()
@@ -127,7 +300,7 @@ namespace VIDEO
           CLog::Log(LOGWARNING, "%s directory '%s' does not exist - skipping scan%s.", __FUNCTION__, directory.c_str(), m_bClean ? " and clean" : "");
           m_pathsToScan.erase(m_pathsToScan.begin());
         }
-        else if (!DoScan(directory))
+        else if (!ScanTree(directory))
           bCancelled = true;
       }
 
@@ -220,6 +393,44 @@ namespace VIDEO
     g_windowManager.SendThreadMessage(msg);
   }
 
+  bool CVideoInfoScanner::ScanTree(const std::string& strDirectory)
+  {
+    SScanSettings settings;
+    bool foundDirectly = false;
+    ScraperPtr info = m_database.GetScraperForPath(strDirectory, settings, foundDirectly);
+    CONTENT_TYPE content = info ? info->Content() : CONTENT_NONE;
+    if (content == CONTENT_NONE || (!m_scanAll && settings.noupdate))
+      return DoScan(strDirectory);
+
+    CDirectoryFingerprint fingerprint(strDirectory, content == CONTENT_TVSHOWS ? g_advancedSettings.m_tvshowExcludeFromScanRegExps
+                                                                               : g_advancedSettings.m_moviesExcludeFromScanRegExps);
+    bool stored = m_database.GetFingerprint(fingerprint);
+    if (!fingerprint.Update() && stored && !m_scanAll)
+    {
+      CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping tree '%s' due to no change", CURL::GetRedacted(strDirectory).c_str());
+
+      // nothing below it needs scanning either
+      set<std::string>::iterator it = m_pathsToScan.lower_bound(strDirectory);
+      while (it != m_pathsToScan.end() && StringUtils::StartsWith(*it, strDirectory))
+        m_pathsToScan.erase(it++);
+
+      if (m_handle)
+        OnDirectoryScanned(strDirectory);
+      return true;
+    }
+
+    m_missedInfo = false;
+    if (!DoScan(strDirectory))
+      return false;
+
+    // items that couldn't be looked up are tried again on the next scan
+    if (m_missedInfo)
+      m_database.DeleteFingerprint(strDirectory);
+    else
+      m_database.SetFingerprint(fingerprint);
+    return true;
+  }
+
   bool CVideoInfoScanner::DoScan(const std::string& strDirectory)
   {
     if (m_handle)
@@ -348,6 +559,7 @@ namespace VIDEO
       {
         if (m_bClean)
           m_pathsToClean.insert(m_database.GetPathId(strDirectory));
+        m_missedInfo = true;
         CLog::Log(LOGDEBUG, "VideoInfoScanner: No (new) information was found in dir %s", CURL::GetRedacted(strDirectory).c_str());
       }
     }
@@ -395,10 +607,17 @@ namespace VIDEO
     }
 
     m_database.Open();
+    // the items of a directory are written in batches
+    m_database.BeginBulkIngest();
 
     bool FoundSomeInfo = false;
     vector<int> seenPaths;
-    for (int i = 0; i < (int)items.Size(); ++i)
+    // background scans look up the movies and music videos in parallel
+    bool parallel = !pDlgProgress && !pURL && g_advancedSettings.m_iVideoScannerLookupThreads > 1 &&
+                    (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS);
+    if (parallel)
+      FoundSomeInfo = RetrieveVideoInfoParallel(items, bDirNames, content, useLocal);
+    for (int i = 0; !parallel && i < (int)items.Size(); ++i)
     {
       m_nfoReader.Close();
       CFileItemPtr pItem = items[i];
@@ -422,30 +641,9 @@ namespace VIDEO
       // clear our scraper cache
       info2->ClearCache();
 
-      INFO_RET ret = INFO_CANCELLED;
-      if (info2->Content() == CONTENT_TVSHOWS)
-        ret = RetrieveInfoForTvShow(pItem.get(), bDirNames, info2, useLocal, pURL, fetchEpisodes, pDlgProgress);
-      else if (info2->Content() == CONTENT_MOVIES)
-        ret = RetrieveInfoForMovie(pItem.get(), bDirNames, info2, useLocal, pURL, pDlgProgress);
-      else if (info2->Content() == CONTENT_MUSICVIDEOS)
-        ret = RetrieveInfoForMusicVideo(pItem.get(), bDirNames, info2, useLocal, pURL, pDlgProgress);
-      else
-      {
-        CLog::Log(LOGERROR, "VideoInfoScanner: Unknown content type %d (%s)", info2->Content(), CURL::GetRedacted(pItem->GetPath()).c_str());
-        FoundSomeInfo = false;
+      INFO_RET ret = RetrieveInfoForItem(pItem.get(), bDirNames, info2, useLocal, pURL, fetchEpisodes, pDlgProgress);
+      if (!OnInfoRetrieved(ret, *pItem, FoundSomeInfo, m_missedInfo))
         break;
-      }
-      if (ret == INFO_CANCELLED || ret == INFO_ERROR)
-      {
-        FoundSomeInfo = false;
-        break;
-      }
-      if (ret == INFO_ADDED || ret == INFO_HAVE_ALREADY)
-        FoundSomeInfo = true;
-      else if (ret == INFO_NOT_FOUND)
-      {
-        CLog::Log(LOGWARNING, "No information found for item '%s', it won't be added to the library.", CURL::GetRedacted(pItem->GetPath()).c_str());
-      }
 
       pURL = NULL;
 
@@ -467,11 +665,125 @@ namespace VIDEO
     if(pDlgProgress)
       pDlgProgress->ShowProgressBar(false);
 
+    m_database.EndBulkIngest();
     g_infoManager.ResetLibraryBools();
     m_database.Close();
     return FoundSomeInfo;
   }
 
+  bool CVideoInfoScanner::RetrieveVideoInfoParallel(CFileItemList& items, bool bDirNames, CONTENT_TYPE content, bool useLocal)
+  {
+    vector<unsigned int> jobs(2);
+    jobs[STAGE_LOOKUP] = g_advancedSettings.m_iVideoScannerLookupThreads;
+    jobs[STAGE_ART] = g_advancedSettings.m_iVideoScannerArtThreads;
+    CVideoScanPipeline pipeline(this, jobs);
+
+    bool FoundSomeInfo = false;
+    bool stopped = false;
+    int i = 0;
+    while ((i < items.Size() && !stopped) || pipeline.GetPending() > 0)
+    {
+      if (m_bStop && !stopped)
+      { // cancelled - whatever is still in the pipeline skips the remaining stages
+        FoundSomeInfo = false;
+        pipeline.Stop();
+        stopped = true;
+      }
+
+      if (i < items.Size() && !stopped)
+      { // queue the next item for lookup, unless there is nothing to look up
+        CFileItemPtr pItem = items[i++];
+        INFO_RET ret = INFO_NOT_NEEDED;
+
+        // we do this since we may have a override per dir
+        ScraperPtr info2 = m_database.GetScraperForPath(pItem->m_bIsFolder ? pItem->GetPath() : items.GetPath());
+        if (info2 && !CUtil::ExcludeFileOrFolder(pItem->GetPath(), g_advancedSettings.m_moviesExcludeFromScanRegExps))
+        {
+          // clear our scraper cache
+          info2->ClearCache();
+
+          if (info2->Content() != CONTENT_MOVIES && info2->Content() != CONTENT_MUSICVIDEOS)
+            ret = RetrieveInfoForItem(pItem.get(), bDirNames, info2, useLocal, NULL, true, NULL);
+          else if (IsVideoFile(*pItem))
+          {
+            if (info2->Content() == CONTENT_MOVIES ? m_database.HasMovieInfo(pItem->GetPath())
+                                                   : m_database.HasMusicVideoInfo(pItem->GetPath()))
+              ret = INFO_HAVE_ALREADY;
+            else
+            {
+              SScanItem *item = new SScanItem;
+              item->item = pItem;
+              item->scraper = info2;
+              item->dirNames = bDirNames;
+              item->useLocal = useLocal;
+              pipeline.Add(item);
+              continue;
+            }
+          }
+        }
+        if (!OnInfoRetrieved(ret, *pItem, FoundSomeInfo, m_missedInfo))
+        {
+          pipeline.Stop();
+          stopped = true;
+        }
+      }
+
+      // add the items that made it through the pipeline, waiting for them once all are queued.
+      // The database isn't kept locked while waiting for the lookups.
+      auto_ptr<SScanItem> item(pipeline.GetProcessed(0));
+      if (!item.get() && (i >= items.Size() || stopped))
+      {
+        m_database.FlushBatch();
+        item.reset(pipeline.GetProcessed(100));
+      }
+      if (!item.get() || stopped)
+        continue;
+
+      INFO_RET ret = item->result;
+      if (ret == INFO_ADDED)
+      {
+        if (m_handle)
+          m_handle->SetText(item->item->GetVideoInfoTag()->m_strTitle);
+        if (AddVideoDetails(item->item.get(), item->scraper->Content(), item->dirNames, item->localArt, NULL, false) < 0)
+          ret = INFO_ERROR;
+      }
+      if (m_handle)
+        m_handle->SetPercentage((i - (int)pipeline.GetPending()) * 100.f / items.Size());
+
+      if (!OnInfoRetrieved(ret, *item->item, FoundSomeInfo, m_missedInfo))
+      {
+        pipeline.Stop();
+        stopped = true;
+      }
+    }
+    return FoundSomeInfo;
+  }
+
+  bool CVideoInfoScanner::ProcessStage(unsigned int stage, SScanItem &item)
+  {
+    if (stage == STAGE_LOOKUP)
+    {
+      CNfoFile nfoReader;
+      item.result = LookupVideo(item.item.get(), item.dirNames, item.scraper, item.useLocal, NULL, nfoReader, item.localArt, NULL);
+      return item.result == INFO_ADDED;
+    }
+    GetArtwork(item.item.get(), item.scraper->Content(), item.dirNames, item.localArt);
+    return true;
+  }
+
+  INFO_RET CVideoInfoScanner::RetrieveInfoForItem(CFileItem *pItem, bool bDirNames, ScraperPtr &info2, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress)
+  {
+    if (info2->Content() == CONTENT_TVSHOWS)
+      return RetrieveInfoForTvShow(pItem, bDirNames, info2, useLocal, pURL, fetchEpisodes, pDlgProgress);
+    if (info2->Content() == CONTENT_MOVIES)
+      return RetrieveInfoForMovie(pItem, bDirNames, info2, useLocal, pURL, pDlgProgress);
+    if (info2->Content() == CONTENT_MUSICVIDEOS)
+      return RetrieveInfoForMusicVideo(pItem, bDirNames, info2, useLocal, pURL, pDlgProgress);
+
+    CLog::Log(LOGERROR, "VideoInfoScanner: Unknown content type %d (%s)", info2->Content(), CURL::GetRedacted(pItem->GetPath()).c_str());
+    return INFO_ERROR;
+  }
+
   INFO_RET CVideoInfoScanner::RetrieveInfoForTvShow(CFileItem *pItem, bool bDirNames, ScraperPtr &info2, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress)
   {
     long idTvShow = -1;
@@ -521,6 +833,9 @@ namespace VIDEO
     if (result == CNfoFile::URL_NFO || result == CNfoFile::COMBINED_NFO)
       pURL = &scrUrl;
 
+    // the items written so far mustn't keep the database locked while scraping
+    m_database.FlushBatch();
+
     CScraperUrl url;
     int retVal = 0;
     if (pURL)
@@ -545,8 +860,7 @@ namespace VIDEO
 
   INFO_RET CVideoInfoScanner::RetrieveInfoForMovie(CFileItem *pItem, bool bDirNames, ScraperPtr &info2, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress)
   {
-    if (pItem->m_bIsFolder || !pItem->IsVideo() || pItem->IsNFO() ||
-       (pItem->IsPlayList() && !URIUtils::HasExtension(pItem->GetPath(), ".strm")))
+    if (!IsVideoFile(*pItem))
       return INFO_NOT_NEEDED;
 
     if (ProgressCancelled(pDlgProgress, 198, pItem->GetLabel()))
@@ -558,54 +872,17 @@ namespace VIDEO
     if (m_handle)
       m_handle->SetText(pItem->GetMovieName(bDirNames));
 
-    CNfoFile::NFOResult result=CNfoFile::NO_NFO;
-    CScraperUrl scrUrl;
-    // handle .nfo files
-    if (useLocal)
-      result = CheckForNFOFile(pItem, bDirNames, info2, scrUrl);
-    if (pItem->IsType(".mp4"))
-    {
-      CTagLoaderTagLib loader;
-      loader.Load(pItem->GetPath(), *pItem->GetVideoInfoTag());
-    }
-    if (result == CNfoFile::FULL_NFO ||
-       ( pItem->HasVideoInfoTag() &&
-        !pItem->GetVideoInfoTag()->m_strTitle.empty()))
-    {
-      if (result == CNfoFile::FULL_NFO)
-      {
-        pItem->GetVideoInfoTag()->Reset();
-        m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
-      }
-
-      if (AddVideo(pItem, info2->Content(), bDirNames, true) < 0)
-        return INFO_ERROR;
-      return INFO_ADDED;
-    }
-    if (result == CNfoFile::URL_NFO || result == CNfoFile::COMBINED_NFO)
-      pURL = &scrUrl;
-
-    CScraperUrl url;
-    int retVal = 0;
-    if (pURL)
-      url = *pURL;
-    else if ((retVal = FindVideo(pItem->GetMovieName(bDirNames), info2, url, pDlgProgress)) <= 0)
-      return retVal < 0 ? INFO_CANCELLED : INFO_NOT_FOUND;
-
-    if (GetDetails(pItem, url, info2, result == CNfoFile::COMBINED_NFO ? &m_nfoReader : NULL, pDlgProgress))
-    {
-      if (AddVideo(pItem, info2->Content(), bDirNames, useLocal) < 0)
-        return INFO_ERROR;
-      return INFO_ADDED;
-    }
-    // TODO: This is not strictly correct as we could fail to download information here or error, or be cancelled
-    return INFO_NOT_FOUND;
+    m_database.FlushBatch();
+    bool localArt;
+    INFO_RET ret = LookupVideo(pItem, bDirNames, info2, useLocal, pURL, m_nfoReader, localArt, pDlgProgress);
+    if (ret == INFO_ADDED && AddVideo(pItem, info2->Content(), bDirNames, localArt) < 0)
+      return INFO_ERROR;
+    return ret;
   }
 
   INFO_RET CVideoInfoScanner::RetrieveInfoForMusicVideo(CFileItem *pItem, bool bDirNames, ScraperPtr &info2, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress)
   {
-    if (pItem->m_bIsFolder || !pItem->IsVideo() || pItem->IsNFO() ||
-       (pItem->IsPlayList() && !URIUtils::HasExtension(pItem->GetPath(), ".strm")))
+    if (!IsVideoFile(*pItem))
       return INFO_NOT_NEEDED;
 
     if (ProgressCancelled(pDlgProgress, 20394, pItem->GetLabel()))
@@ -617,18 +894,38 @@ namespace VIDEO
     if (m_handle)
       m_handle->SetText(pItem->GetMovieName(bDirNames));
 
+    m_database.FlushBatch();
+    bool localArt;
+    INFO_RET ret = LookupVideo(pItem, bDirNames, info2, useLocal, pURL, m_nfoReader, localArt, pDlgProgress);
+    if (ret == INFO_ADDED && AddVideo(pItem, info2->Content(), bDirNames, localArt) < 0)
+      return INFO_ERROR;
+    return ret;
+  }
+
+  INFO_RET CVideoInfoScanner::LookupVideo(CFileItem *pItem, bool bDirNames, ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CNfoFile &nfoReader, bool &localArt, CGUIDialogProgress* pDlgProgress)
+  {
+    localArt = true;
+    bool movie = scraper->Content() == CONTENT_MOVIES;
+
     CNfoFile::NFOResult result=CNfoFile::NO_NFO;
     CScraperUrl scrUrl;
     // handle .nfo files
     if (useLocal)
-      result = CheckForNFOFile(pItem, bDirNames, info2, scrUrl);
-    if (result == CNfoFile::FULL_NFO)
+      result = CheckForNFOFile(pItem, bDirNames, scraper, scrUrl, nfoReader);
+    if (movie && pItem->IsType(".mp4"))
     {
-      pItem->GetVideoInfoTag()->Reset();
-      m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
-
-      if (AddVideo(pItem, info2->Content(), bDirNames, true) < 0)
-        return INFO_ERROR;
+      CTagLoaderTagLib loader;
+      loader.Load(pItem->GetPath(), *pItem->GetVideoInfoTag());
+    }
+    if (result == CNfoFile::FULL_NFO ||
+       (movie && pItem->HasVideoInfoTag() &&
+        !pItem->GetVideoInfoTag()->m_strTitle.empty()))
+    {
+      if (result == CNfoFile::FULL_NFO)
+      {
+        pItem->GetVideoInfoTag()->Reset();
+        nfoReader.GetDetails(*pItem->GetVideoInfoTag());
+      }
       return INFO_ADDED;
     }
     if (result == CNfoFile::URL_NFO || result == CNfoFile::COMBINED_NFO)
@@ -638,13 +935,12 @@ namespace VIDEO
     int retVal = 0;
     if (pURL)
       url = *pURL;
-    else if ((retVal = FindVideo(pItem->GetMovieName(bDirNames), info2, url, pDlgProgress)) <= 0)
+    else if ((retVal = FindVideo(pItem->GetMovieName(bDirNames), scraper, url, pDlgProgress)) <= 0)
       return retVal < 0 ? INFO_CANCELLED : INFO_NOT_FOUND;
 
-    if (GetDetails(pItem, url, info2, result == CNfoFile::COMBINED_NFO ? &m_nfoReader : NULL, pDlgProgress))
+    if (GetDetails(pItem, url, scraper, result == CNfoFile::COMBINED_NFO ? &nfoReader : NULL, pDlgProgress))
     {
-      if (AddVideo(pItem, info2->Content(), bDirNames, useLocal) < 0)
-        return INFO_ERROR;
+      localArt = useLocal;
       return INFO_ADDED;
     }
     // TODO: This is not strictly correct as we could fail to download information here or error, or be cancelled
@@ -686,8 +982,14 @@ namespace VIDEO
       if (it != m_pathsToScan.end())
         m_pathsToScan.erase(it);
 
+      // the fingerprint of the show's folders makes for a fast hash, unless it can't be taken
+      CDirectoryFingerprint fingerprint(item->GetPath(), regexps);
+      m_database.GetFingerprint(fingerprint);
+      fingerprint.Update();
+      m_database.SetFingerprint(fingerprint);
+
       std::string hash, dbHash;
-      hash = GetRecursiveFastHash(item->GetPath(), regexps);
+      hash = fingerprint.GetHash();
       if (m_database.GetPathHash(item->GetPath(), dbHash) && !hash.empty() && dbHash == hash)
       {
         // fast hashes match - no need to process anything
@@ -1091,14 +1393,19 @@ namespace VIDEO
   }
 
   long CVideoInfoScanner::AddVideo(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder /* = false */, bool useLocal /* = true */, const CVideoInfoTag *showInfo /* = NULL */, bool libraryImport /* = false */)
+  {
+    if (!libraryImport)
+      GetArtwork(pItem, content, videoFolder, useLocal, showInfo ? showInfo->m_strPath : "");
+
+    return AddVideoDetails(pItem, content, videoFolder, useLocal, showInfo, libraryImport);
+  }
+
+  long CVideoInfoScanner::AddVideoDetails(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder, bool useLocal, const CVideoInfoTag *showInfo, bool libraryImport)
   {
     // ensure our database is open (this can get called via other classes)
     if (!m_database.Open())
       return -1;
 
-    if (!libraryImport)
-      GetArtwork(pItem, content, videoFolder, useLocal, showInfo ? showInfo->m_strPath : "");
-
     // ensure the art map isn't completely empty by specifying an empty thumb
     map<string, string> art = pItem->GetArt();
     if (art.empty())
@@ -1442,6 +1749,7 @@ namespace VIDEO
             pDlgProgress->Progress();
           }
 
+          m_database.FlushBatch();
           CVideoInfoDownloader imdb(scraper);
           if (!imdb.GetEpisodeList(url, episodes))
             return INFO_NOT_FOUND;
@@ -1540,6 +1848,7 @@ namespace VIDEO
 
       if (bFound)
       {
+        m_database.FlushBatch();
         CVideoInfoDownloader imdb(scraper);
         CFileItem item;
         item.SetPath(file->strPath);
@@ -1768,42 +2077,6 @@ namespace VIDEO
     return "";
   }
 
-  std::string CVideoInfoScanner::GetRecursiveFastHash(const std::string &directory, const vector<string> &excludes) const
-  {
-    CFileItemList items;
-    items.Add(CFileItemPtr(new CFileItem(directory, true)));
-    CUtil::GetRecursiveDirsListing(directory, items, DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO);
-
-    XBMC::XBMC_MD5 md5state;
-
-    if (excludes.size())
-      md5state.append(StringUtils::Join(excludes, "|"));
-
-    int64_t time = 0;
-    for (int i=0; i < items.Size(); ++i)
-    {
-      int64_t stat_time = 0;
-      struct __stat64 buffer;
-      if (XFILE::CFile::Stat(items[i]->GetPath(), &buffer) == 0)
-      {
-        // TODO: some filesystems may return the mtime/ctime inline, in which case this is
-        // unnecessarily expensive. Consider supporting Stat() in our directory cache?
-        stat_time = buffer.st_mtime ? buffer.st_mtime : buffer.st_ctime;
-        time += stat_time;
-      }
-
-      if (!stat_time)
-        return "";
-    }
-
-    if (time)
-    {
-      md5state.append((unsigned char *)&time, sizeof(time));
-      return md5state.getDigest();
-    }
-    return "";
-  }
-
   void CVideoInfoScanner::GetSeasonThumbs(const CVideoInfoTag &show, map<int, map<string, string> > &seasonArt, const vector<string> &artTypes, bool useLocal)
   {
     bool lookForThumb = find(artTypes.begin(), artTypes.end(), "thumb") == artTypes.end();
@@ -1918,6 +2191,11 @@ namespace VIDEO
   }
 
   CNfoFile::NFOResult CVideoInfoScanner::CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ScraperPtr& info, CScraperUrl& scrUrl)
+  {
+    return CheckForNFOFile(pItem, bGrabAny, info, scrUrl, m_nfoReader);
+  }
+
+  CNfoFile::NFOResult CVideoInfoScanner::CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ScraperPtr& info, CScraperUrl& scrUrl, CNfoFile &nfoReader)
   {
     std::string strNfoFile;
     if (info->Content() == CONTENT_MOVIES || info->Content() == CONTENT_MUSICVIDEOS
@@ -1930,9 +2208,9 @@ namespace VIDEO
     if (!strNfoFile.empty() && CFile::Exists(strNfoFile))
     {
       if (info->Content() == CONTENT_TVSHOWS && !pItem->m_bIsFolder)
-        result = m_nfoReader.Create(strNfoFile,info,pItem->GetVideoInfoTag()->m_iEpisode);
+        result = nfoReader.Create(strNfoFile,info,pItem->GetVideoInfoTag()->m_iEpisode);
       else
-        result = m_nfoReader.Create(strNfoFile,info);
+        result = nfoReader.Create(strNfoFile,info);
 
       std::string type;
       switch(result)
@@ -1957,18 +2235,18 @@ namespace VIDEO
       if (result == CNfoFile::FULL_NFO)
       {
         if (info->Content() == CONTENT_TVSHOWS)
-          info = m_nfoReader.GetScraperInfo();
+          info = nfoReader.GetScraperInfo();
       }
       else if (result != CNfoFile::NO_NFO && result != CNfoFile::ERROR_NFO)
       {
-        scrUrl = m_nfoReader.ScraperUrl();
-        info = m_nfoReader.GetScraperInfo();
+        scrUrl = nfoReader.ScraperUrl();
+        info = nfoReader.GetScraperInfo();
 
         CLog::Log(LOGDEBUG, "VideoInfoScanner: Fetching url '%s' using %s scraper (content: '%s')",
           scrUrl.m_url[0].m_url.c_str(), info->Name().c_str(), TranslateContent(info->Content()).c_str());
 
         if (result == CNfoFile::COMBINED_NFO)
-          m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
+          nfoReader.GetDetails(*pItem->GetVideoInfoTag());
       }
     }
     else
@@ -2008,7 +2286,13 @@ namespace VIDEO
     MOVIELIST movielist;
     CVideoInfoDownloader imdb(scraper);
     int returncode = imdb.FindMovie(videoName, movielist, progress);
-    if (returncode < 0 || (returncode == 0 && (m_bStop || !DownloadFailed(progress))))
+    if (returncode == 0)
+    { // lookups run in parallel, so ask about one failure at a time
+      CSingleLock lock(m_lookupErrorSection);
+      if (m_bStop || !DownloadFailed(progress))
+        returncode = -1;
+    }
+    if (returncode < 0)
     { // scraper reported an error, or we had an error and user wants to cancel the scan
       m_bStop = true;
       return -1; // cancelled
@@ -18,7 +18,10 @@
  *  <http://www.gnu.org/licenses/>.
  *
  */
+#include <deque>
 #include "threads/Thread.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "VideoDatabase.h"
 #include "addons/Scraper.h"
 #include "NfoFile.h"
@@ -48,7 +51,88 @@ namespace VIDEO
                   INFO_NOT_FOUND,
                   INFO_ADDED };
 
-  class CVideoInfoScanner : CThread
+  /*! \brief An item on its way through the stages of a CVideoScanPipeline
+   */
+  struct SScanItem
+  {
+    SScanItem() : dirNames(false), useLocal(true), localArt(true), result(INFO_CANCELLED) {}
+    boost::shared_ptr<CFileItem> item; ///< the item to scan
+    ADDON::ScraperPtr scraper;         ///< the scraper to look it up with
+    bool dirNames;                     ///< whether the item is looked up by its folder name
+    bool useLocal;                     ///< whether to use local .nfo files and art
+    bool localArt;                     ///< whether to use local art, set by the lookup
+    INFO_RET result;                   ///< the outcome of the last stage it went through
+  };
+
+  /*! \brief Does the work of the stages of a CVideoScanPipeline
+   */
+  class IVideoScanWorker
+  {
+  public:
+    virtual ~IVideoScanWorker() {}
+
+    /*! \brief Process an item through a stage, called on a job worker thread
+     \param stage the index of the stage.
+     \param item the item to process, owned by the pipeline.
+     \return true if the item goes on to the next stage, false if it's done with.
+     */
+    virtual bool ProcessStage(unsigned int stage, SScanItem &item) = 0;
+  };
+
+  /*! \brief Passes items through a sequence of stages running in parallel
+   Each stage is a job queue running at most the given number of jobs at once, so that the
+   network bound lookups of several items overlap rather than happen one after the other.
+   Items leave the pipeline after the last stage, or as soon as a stage is done with them,
+   in whatever order they finish.
+   */
+  class CVideoScanPipeline
+  {
+  public:
+    /*! \brief Create a pipeline
+     \param worker does the work of the stages.
+     \param jobs the number of jobs each stage may run at once, one entry per stage.
+     */
+    CVideoScanPipeline(IVideoScanWorker *worker, const std::vector<unsigned int> &jobs);
+
+    /*! \brief Destroy the pipeline, waiting for the items still in it
+     */
+    ~CVideoScanPipeline();
+
+    /*! \brief Add an item to the first stage, the pipeline takes ownership of it
+     */
+    void Add(SScanItem *item);
+
+    /*! \brief Retrieve the next item that left the pipeline, the caller takes ownership of it
+     \param timeout the milliseconds to wait for one.
+     \return the item, or NULL if none left the pipeline in time.
+     */
+    SScanItem *GetProcessed(unsigned int timeout);
+
+    /*! \brief Number of items added and not retrieved yet
+     */
+    unsigned int GetPending() const;
+
+    /*! \brief Stop processing, the items still in the pipeline skip the remaining stages
+     */
+    void Stop();
+    bool IsStopped() const { return m_stopped; }
+
+  private:
+    class CStage;
+    class CStageJob;
+
+    void OnStageComplete(unsigned int stage, SScanItem *item, bool next);
+
+    IVideoScanWorker *m_worker;
+    std::vector<CStage *> m_stages;
+    std::deque<SScanItem *> m_processed;
+    unsigned int m_pending;
+    volatile bool m_stopped;
+    CCriticalSection m_section;
+    CEvent m_processedEvent;
+  };
+
+  class CVideoInfoScanner : CThread, public IVideoScanWorker
   {
   public:
     CVideoInfoScanner();
@@ -124,6 +208,15 @@ namespace VIDEO
 
   protected:
     virtual void Process();
+
+    /*! \brief Scan a directory tree, skipping it as a whole if its stored fingerprint shows nothing changed.
+     The fingerprint is stored once the tree was scanned completely, so trees with items that
+     couldn't be looked up are looked at again on the next scan.
+     \param strDirectory the root of the tree.
+     \return false if the scan was cancelled, true otherwise.
+     \sa DoScan, XFILE::CDirectoryFingerprint
+     */
+    bool ScanTree(const std::string& strDirectory);
     bool DoScan(const std::string& strDirectory);
 
     INFO_RET RetrieveInfoForTvShow(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress);
@@ -131,6 +224,49 @@ namespace VIDEO
     INFO_RET RetrieveInfoForMusicVideo(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForEpisodes(CFileItem *item, long showID, const ADDON::ScraperPtr &scraper, bool useLocal, CGUIDialogProgress *progress = NULL);
 
+    /*! \brief Retrieve information for a single item and add it to the database, according to the content of the scraper
+     \sa RetrieveVideoInfo
+     */
+    INFO_RET RetrieveInfoForItem(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress);
+
+    /*! \brief Retrieve information for the movies or music videos in a list of items and add them to the database.
+     The lookups and artwork are done through a CVideoScanPipeline, while the items are added to the
+     database on the calling thread as they come out of it.
+     \param items list of items to retrieve info for.
+     \param bDirNames whether we should use folder or file names for lookups.
+     \param content type of content to retrieve.
+     \param useLocal should local data (.nfo and art) be used.
+     \return true if we successfully found information for some items, false otherwise
+     \sa RetrieveVideoInfo, ProcessStage
+     */
+    bool RetrieveVideoInfoParallel(CFileItemList& items, bool bDirNames, CONTENT_TYPE content, bool useLocal);
+
+    /*! \brief Run a stage of the parallel scan for an item: the lookup (STAGE_LOOKUP) or the artwork (STAGE_ART)
+     \sa IVideoScanWorker, RetrieveVideoInfoParallel
+     */
+    virtual bool ProcessStage(unsigned int stage, SScanItem &item);
+    enum { STAGE_LOOKUP = 0, STAGE_ART };
+
+    /*! \brief Look up the details of a movie or music video from its .nfo file or online, without adding it to the database
+     \param pItem item to look up, its video info tag is filled in.
+     \param bDirNames whether we should use the folder or the file name for the lookup.
+     \param scraper the scraper to use, may be replaced by the one of a .nfo file.
+     \param useLocal should local data (.nfo and art) be used.
+     \param pURL an optional URL to use to retrieve online info.
+     \param nfoReader reader for the .nfo file of the item.
+     \param localArt [out] whether local art should be used for the item.
+     \param pDlgProgress progress dialog to update and check for cancellation during processing.
+     \return INFO_ADDED if the details were found, INFO_NOT_FOUND or INFO_CANCELLED otherwise.
+     */
+    INFO_RET LookupVideo(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CNfoFile &nfoReader, bool &localArt, CGUIDialogProgress* pDlgProgress);
+
+    /*! \brief Add an item to the database, its artwork having been retrieved already
+     \sa AddVideo
+     */
+    long AddVideoDetails(CFileItem *pItem, const CONTENT_TYPE &content, bool videoFolder, bool useLocal, const CVideoInfoTag *showInfo, bool libraryImport);
+
+    CNfoFile::NFOResult CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ADDON::ScraperPtr& scraper, CScraperUrl& scrUrl, CNfoFile &nfoReader);
+
     /*! \brief Update the progress bar with the heading and line and check for cancellation
      \param progress CGUIDialogProgress bar
      \param heading string id of heading
@@ -195,18 +331,6 @@ namespace VIDEO
      */
     std::string GetFastHash(const std::string &directory, const std::vector<std::string> &excludes) const;
 
-    /*! \brief Retrieve a "fast" hash of the given directory recursively (if available)
-     Performs a stat() on the directory, and uses modified time to create a "fast"
-     hash of each folder. If no modified time is available, the create time is used,
-     and if neither are available, an empty hash is returned.
-     In case exclude from scan expressions are present, the string array will be appended
-     to the md5 hash to ensure we're doing a re-scan whenever the user modifies those.
-     \param directory folder to hash (recursively)
-     \param excludes string array of exclude expressions
-     \return the md5 hash of the folder
-     */
-    std::string GetRecursiveFastHash(const std::string &directory, const std::vector<std::string> &excludes) const;
-
     /*! \brief Decide whether a folder listing could use the "fast" hash
      Fast hashing can be done whenever the folder contains no scannable subfolders, as the
      fast hash technique uses modified time to determine when folder content changes, which
@@ -249,12 +373,14 @@ namespace VIDEO
     bool m_bCanInterrupt;
     bool m_bClean;
     bool m_scanAll;
+    bool m_missedInfo; ///< some item of the tree being scanned couldn't be looked up
     std::string m_strStartDir;
     CVideoDatabase m_database;
     std::set<std::string> m_pathsToScan;
     std::set<std::string> m_pathsToCount;
     std::set<int> m_pathsToClean;
     CNfoFile m_nfoReader;
+    CCriticalSection m_lookupErrorSection; ///< asks about one failed lookup at a time
   };
 }
 
@@ -0,0 +1,575 @@
+/*
+ *      Copyright (C) 2013 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "video/VideoDatabase.h"
+#include "video/VideoDbUrl.h"
+#include "FileItem.h"
+#include "XBDateTime.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/Directory.h"
+#include "filesystem/DirectoryFingerprint.h"
+#include "filesystem/File.h"
+#include "playlists/SmartPlayList.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+#include <iostream>
+#include <stdlib.h>
+
+namespace
+{
+  const char *GetEnv(const char *name, const char *defaultValue)
+  {
+    const char *value = getenv(name);
+    return value != NULL ? value : defaultValue;
+  }
+
+  // size of the library made of the shows in the Fake Episode Maker's list
+  const int SeasonsPerShow = 4;
+  const int EpisodesPerSeason = 20;
+  const int CastPerShow = 8;
+
+  class CTestVideoDatabase : public CVideoDatabase
+  {
+  public:
+    bool Create(const std::string &folder, const std::string &name)
+    {
+      DatabaseSettings settings;
+      settings.type = "sqlite3";
+      settings.host = folder;
+      settings.name = name;
+      return Update(settings);
+    }
+
+#ifdef HAS_MYSQL
+    // the MySQL/MariaDB server of TestMysqlDataset, returns false if there is none
+    bool CreateMysql(const std::string &name)
+    {
+      DatabaseSettings settings;
+      settings.type = "mysql";
+      settings.host = GetEnv("XBMC_TEST_MYSQL_HOST", "localhost");
+      settings.port = GetEnv("XBMC_TEST_MYSQL_PORT", "3306");
+      settings.user = GetEnv("XBMC_TEST_MYSQL_USER", "xbmc");
+      settings.pass = GetEnv("XBMC_TEST_MYSQL_PASS", "xbmc");
+      settings.name = name;
+      return Update(settings);
+    }
+
+    void Drop()
+    {
+      m_pDB->drop();
+      Close();
+    }
+#endif
+
+    std::string GetFile() const
+    {
+      return URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase());
+    }
+
+    void Exec(const std::string &sql)
+    {
+      m_pDS->exec(sql);
+    }
+
+    // reads all rows of the query, returns the number of milliseconds it took
+    unsigned int List(const std::string &sql, int &rows)
+    {
+      unsigned int start = XbmcThreads::SystemClockMillis();
+      rows = 0;
+      if (m_pDS->query(sql.c_str()))
+      {
+        for (; !m_pDS->eof(); m_pDS->next())
+          rows++;
+        m_pDS->close();
+      }
+      return XbmcThreads::SystemClockMillis() - start;
+    }
+  };
+
+  // tvshowview as it was before the counts were kept in a table
+  const char *AggregateTvShowView =
+    "SELECT tvshow.*, path.idParentPath AS idParentPath, path.strPath AS strPath,"
+    "  tvshowcounts.dateAdded AS dateAdded, lastPlayed, totalCount, watchedcount, totalSeasons "
+    "FROM tvshow"
+    "  LEFT JOIN tvshowlinkpath ON tvshowlinkpath.idShow=tvshow.idShow"
+    "  LEFT JOIN path ON path.idPath=tvshowlinkpath.idPath"
+    "  INNER JOIN (SELECT tvshow.idShow AS idShow, MAX(files.lastPlayed) AS lastPlayed,"
+    "      NULLIF(COUNT(episode.c12), 0) AS totalCount, COUNT(files.playCount) AS watchedcount,"
+    "      NULLIF(COUNT(DISTINCT(episode.c12)), 0) AS totalSeasons, MAX(files.dateAdded) as dateAdded"
+    "    FROM tvshow"
+    "      LEFT JOIN episode ON episode.idShow=tvshow.idShow"
+    "      LEFT JOIN files ON files.idFile=episode.idFile"
+    "    GROUP BY tvshow.idShow) tvshowcounts ON tvshow.idShow = tvshowcounts.idShow";
+}
+
+class TestVideoDatabase : public testing::Test
+{
+protected:
+  TestVideoDatabase()
+  {
+    m_file = XBMC_CREATETEMPFILE(".db");
+    if (m_file != NULL)
+      m_file->Close();
+
+    XFILE::CFile shows;
+    if (shows.Open(XBMC_REF_FILE_PATH("tools/Fake Episode Maker/shows.txt")))
+    {
+      char line[256];
+      while (shows.ReadString(line, sizeof(line)))
+      {
+        std::string show = line;
+        StringUtils::Trim(show);
+        if (!show.empty())
+          m_shows.push_back(show);
+      }
+    }
+  }
+
+  ~TestVideoDatabase()
+  {
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  // adds the episodes the Fake Episode Maker creates for the listed shows the
+  // way the scanner does, returns the number of milliseconds it took
+  unsigned int Scan(CTestVideoDatabase &db, bool bulk)
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (unsigned int show = 0; show < m_shows.size(); show++)
+    {
+      if (bulk)
+        db.BeginBulkIngest();
+
+      std::string name = GetName(show);
+      std::string path = "/media/TV Shows/" + name + "/";
+
+      CVideoInfoTag showInfo;
+      showInfo.m_strTitle = m_shows[show];
+      showInfo.m_genre.push_back(show % 2 ? "Drama" : "Science Fiction");
+      showInfo.m_studio.push_back(StringUtils::Format("Network %u", show % 5));
+      for (int i = 0; i < CastPerShow; i++)
+      {
+        SActorInfo actor;
+        actor.strName = StringUtils::Format("%s Actor %d", name.c_str(), i);
+        actor.strRole = StringUtils::Format("Role %d", i);
+        actor.order = i;
+        showInfo.m_cast.push_back(actor);
+      }
+
+      std::vector< std::pair<std::string, std::string> > paths;
+      paths.push_back(std::make_pair(path, std::string("/media/TV Shows/")));
+      int idShow = db.SetDetailsForTvShow(paths, showInfo, std::map<std::string, std::string>(), std::map<int, std::map<std::string, std::string> >());
+      EXPECT_LT(0, idShow);
+
+      for (int season = 1; season <= SeasonsPerShow; season++)
+      {
+        for (int episode = 1; episode <= EpisodesPerSeason; episode++)
+        {
+          CVideoInfoTag details(showInfo);
+          details.m_strShowTitle = showInfo.m_strTitle;
+          details.m_strTitle = StringUtils::Format("Episode %d", episode);
+          details.m_iSeason = season;
+          details.m_iEpisode = episode;
+          details.m_writingCredits.push_back(StringUtils::Format("%s Writer %d", name.c_str(), episode % 3));
+          details.m_director.push_back(StringUtils::Format("%s Director %d", name.c_str(), season));
+
+          SActorInfo guest;
+          guest.strName = StringUtils::Format("Guest %d", (show * EpisodesPerSeason + episode) % 200);
+          guest.strRole = "Guest";
+          details.m_cast.push_back(guest);
+
+          EXPECT_LT(0, db.SetDetailsForEpisode(GetEpisodeFile(show, season, episode), details, std::map<std::string, std::string>(), idShow));
+        }
+      }
+
+      if (bulk)
+        db.EndBulkIngest();
+    }
+    return XbmcThreads::SystemClockMillis() - start;
+  }
+
+  // every word of the search is the start of a word of the title, no matter whether
+  // MySQL indexes it: "ny" and "5" are too short, "the" and "who" are stopwords
+  void Search(CTestVideoDatabase &db)
+  {
+    const struct { const char *search; int count; } searches[] = {
+      { "star tre",           4 },
+      { "STAR trek next",     1 },
+      { "knight",             3 },
+      { "night",              0 },
+      { "csi: miami",         1 },
+      { "csi: ny",            1 },
+      { "babylon 5",          1 },
+      { "doctor who",         1 },
+      { "the animated",       2 },
+      { "star trek the next", 1 }
+    };
+    for (unsigned int i = 0; i < sizeof(searches) / sizeof(searches[0]); i++)
+    {
+      CFileItemList items;
+      db.GetTvShowsByName(searches[i].search, items);
+      EXPECT_EQ(searches[i].count, items.Size()) << searches[i].search;
+    }
+  }
+
+  std::string GetName(unsigned int show) const
+  {
+    std::string name = m_shows[show];
+    StringUtils::Replace(name, ":", "");
+    return name;
+  }
+
+  std::string GetEpisodeFile(unsigned int show, int season, int episode) const
+  {
+    std::string name = GetName(show);
+    return StringUtils::Format("/media/TV Shows/%s/Season %d/%s S%dE%d.avi", name.c_str(), season, name.c_str(), season, episode);
+  }
+
+  XFILE::CFile *m_file;
+  std::vector<std::string> m_shows;
+};
+
+TEST_F(TestVideoDatabase, BulkIngest)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_FALSE(m_shows.empty());
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestVideoDatabase single;
+  ASSERT_TRUE(single.Create(folder, "TestVideosSingle"));
+  unsigned int singleTime = Scan(single, false);
+
+  CTestVideoDatabase bulk;
+  ASSERT_TRUE(bulk.Create(folder, "TestVideosBulk"));
+  unsigned int bulkTime = Scan(bulk, true);
+
+  // both ways result in the same library
+  const char *tables[] = { "tvshow", "episode", "seasons", "actors", "actorlinkepisode", "writerlinkepisode", "genre", "studio" };
+  for (unsigned int i = 0; i < sizeof(tables) / sizeof(tables[0]); i++)
+    EXPECT_STREQ(single.GetSingleValue(tables[i], "count(1)").c_str(), bulk.GetSingleValue(tables[i], "count(1)").c_str()) << tables[i];
+
+  unsigned int episodes = m_shows.size() * SeasonsPerShow * EpisodesPerSeason;
+  std::cout << episodes << " episodes added in " << singleTime << " ms with a transaction per episode and "
+            << bulkTime << " ms with a bulk ingest" << std::endl;
+
+  std::string files[] = { single.GetFile(), bulk.GetFile() };
+  single.Close();
+  bulk.Close();
+  for (unsigned int i = 0; i < 2; i++)
+    XFILE::CFile::Delete(files[i]);
+}
+
+TEST_F(TestVideoDatabase, FlushBatch)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestVideosFlush"));
+  CTestVideoDatabase other;
+  ASSERT_TRUE(other.Create(folder, "TestVideosFlush"));
+
+  // the movies of the open batch aren't seen by other connections until it's flushed
+  db.BeginBulkIngest();
+  CVideoInfoTag details;
+  details.m_strTitle = "First";
+  EXPECT_LT(0, db.SetDetailsForMovie("/media/Movies/First.avi", details, std::map<std::string, std::string>()));
+  EXPECT_STREQ("0", other.GetSingleValue("movie", "count(1)").c_str());
+
+  EXPECT_TRUE(db.FlushBatch());
+  EXPECT_STREQ("1", other.GetSingleValue("movie", "count(1)").c_str());
+
+  // after which the write lock is free for others while the batch goes on
+  other.Exec("UPDATE movie SET c00='Renamed' WHERE c00='First'");
+  details.m_strTitle = "Second";
+  EXPECT_LT(0, db.SetDetailsForMovie("/media/Movies/Second.avi", details, std::map<std::string, std::string>()));
+  db.EndBulkIngest();
+  EXPECT_STREQ("2", other.GetSingleValue("movie", "count(1)").c_str());
+  EXPECT_STREQ("1", other.GetSingleValue("movie", "count(1)", "c00='Renamed'").c_str());
+
+  std::string file = db.GetFile();
+  other.Close();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestVideoDatabase, TvShowCounts)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_FALSE(m_shows.empty());
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestVideosCounts"));
+  Scan(db, true);
+  EXPECT_EQ(0, db.CheckTvShowCounts(false));
+
+  // watch the first episode of every show, unwatch it again for every other
+  // show and remove the second season of every third show
+  for (unsigned int show = 0; show < m_shows.size(); show++)
+  {
+    CFileItem item(GetEpisodeFile(show, 1, 1), false);
+    db.SetPlayCount(item, 1, CDateTime(2013, 1 + show % 12, 1, 20, 0, 0));
+    if (show % 2)
+      db.SetPlayCount(item, 0);
+    if (show % 3 == 0)
+    {
+      for (int episode = 1; episode <= EpisodesPerSeason; episode++)
+        db.DeleteEpisode(GetEpisodeFile(show, 2, episode));
+    }
+  }
+  EXPECT_EQ(0, db.CheckTvShowCounts(false));
+
+  EXPECT_STREQ("1", db.GetSingleValue("tvshowview", "watchedcount", "idShow=1").c_str());
+  EXPECT_STREQ(StringUtils::Format("%d", SeasonsPerShow - 1).c_str(), db.GetSingleValue("tvshowview", "totalSeasons", "idShow=1").c_str());
+  EXPECT_STREQ(StringUtils::Format("%d", (SeasonsPerShow - 1) * EpisodesPerSeason).c_str(), db.GetSingleValue("tvshowview", "totalCount", "idShow=1").c_str());
+
+  int rows[2];
+  unsigned int aggregateTime = db.List(AggregateTvShowView, rows[0]);
+  unsigned int tableTime = db.List("SELECT * FROM tvshowview", rows[1]);
+  EXPECT_EQ(rows[0], rows[1]);
+  std::cout << rows[1] << " tvshows listed in " << aggregateTime << " ms aggregating their episodes and "
+            << tableTime << " ms with the counts kept in tvshowcounts" << std::endl;
+
+  // counts which went wrong are found and recalculated
+  db.Exec("UPDATE tvshowcounts SET watchedcount=watchedcount+1 WHERE idShow=1");
+  EXPECT_EQ(1, db.CheckTvShowCounts());
+  EXPECT_EQ(0, db.CheckTvShowCounts(false));
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestVideoDatabase, Search)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_FALSE(m_shows.empty());
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestVideosSearch"));
+  Scan(db, true);
+
+  Search(db);
+
+  // renamed titles are found by their new name only, accents don't matter
+  db.Exec("UPDATE tvshow SET c00='Amélie' WHERE c00='Frasier'");
+  CFileItemList renamed;
+  db.GetTvShowsByName("amelie", renamed);
+  EXPECT_EQ(1, renamed.Size());
+  renamed.Clear();
+  db.GetTvShowsByName("frasier", renamed);
+  EXPECT_EQ(0, renamed.Size());
+
+  // smart playlists and filters use the index with the matches operator
+  CSmartPlaylistRule rule;
+  rule.m_field = FieldTitle;
+  rule.m_operator = CDatabaseQueryRule::OPERATOR_MATCHES;
+  rule.m_parameter.push_back("trek voy");
+  rule.m_parameter.push_back("seinf");
+  int rows;
+  db.List("SELECT * FROM tvshowview WHERE " + rule.GetWhereClause(db, "tvshows"), rows);
+  EXPECT_EQ(2, rows);
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+#ifdef HAS_MYSQL
+TEST_F(TestVideoDatabase, MysqlSearch)
+{
+  ASSERT_FALSE(m_shows.empty());
+
+  CTestVideoDatabase db;
+  if (!db.CreateMysql("xbmc_test_videos"))
+  {
+    std::cout << "no MySQL server, skipping test" << std::endl;
+    return;
+  }
+  Scan(db, true);
+  Search(db);
+
+  db.Drop();
+}
+#endif
+
+TEST_F(TestVideoDatabase, Paging)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_FALSE(m_shows.empty());
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestVideosPaging"));
+  Scan(db, true);
+
+  const std::string episodes = "videodb://tvshows/titles/-1/-1/";
+  SortDescription sorting;
+  sorting.sortBy = SortByDateAdded;
+
+  CFileItemList all;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  ASSERT_TRUE(db.GetEpisodesByWhere(episodes, CDatabase::Filter(), all, false, sorting));
+  unsigned int allTime = XbmcThreads::SystemClockMillis() - start;
+  ASSERT_EQ((int)m_shows.size() * SeasonsPerShow * EpisodesPerSeason, all.Size());
+
+  // a page holds the same items as the complete list at its position
+  sorting.limitStart = 100;
+  sorting.limitEnd = 120;
+  CFileItemList page;
+  start = XbmcThreads::SystemClockMillis();
+  ASSERT_TRUE(db.GetEpisodesByWhere(episodes, CDatabase::Filter(), page, false, sorting));
+  unsigned int pageTime = XbmcThreads::SystemClockMillis() - start;
+  ASSERT_EQ(20, page.Size());
+  EXPECT_EQ(all.Size(), page.GetProperty("total").asInteger());
+  for (int i = 0; i < page.Size(); i++)
+    EXPECT_STREQ(all[sorting.limitStart + i]->GetPath().c_str(), page[i]->GetPath().c_str());
+
+  sorting.limitStart = all.Size();
+  sorting.limitEnd = all.Size() + 20;
+  CFileItemList beyond;
+  ASSERT_TRUE(db.GetEpisodesByWhere(episodes, CDatabase::Filter(), beyond, false, sorting));
+  EXPECT_EQ(0, beyond.Size());
+
+  // random items are picked by the database
+  sorting.sortBy = SortByRandom;
+  sorting.limitStart = 0;
+  sorting.limitEnd = 20;
+  CFileItemList random;
+  ASSERT_TRUE(db.GetEpisodesByWhere(episodes, CDatabase::Filter(), random, false, sorting));
+  EXPECT_EQ(20, random.Size());
+  EXPECT_EQ(all.Size(), random.GetProperty("total").asInteger());
+
+  std::cout << all.Size() << " episodes listed in " << allTime << " ms, a page of "
+            << page.Size() << " in " << pageTime << " ms" << std::endl;
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestVideoDatabase, SortedPaging)
+{
+  ASSERT_TRUE(m_file != NULL);
+  ASSERT_FALSE(m_shows.empty());
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestVideosSortedPaging"));
+  Scan(db, true);
+
+  const std::string shows = "videodb://tvshows/titles/";
+  SortDescription sorting;
+  sorting.sortBy = SortByLabel;
+  sorting.sortOrder = SortOrderDescending;
+
+  CFileItemList all;
+  ASSERT_TRUE(db.GetTvShowsByWhere(shows, CDatabase::Filter(), all, sorting));
+  ASSERT_EQ((int)m_shows.size(), all.Size());
+
+  // the pages sorted by the database, requested the way CGUIMediaWindow does,
+  // follow each other like the ranges of the list sorted in memory
+  const int pageSize = 7;
+  for (int start = 0; start < all.Size(); start += pageSize)
+  {
+    CVideoDbUrl url;
+    ASSERT_TRUE(url.FromString(shows));
+    url.AddOption("sortby", (int)SortByLabel);
+    url.AddOption("sortorder", (int)SortOrderDescending);
+    url.AddOption("ignorearticle", false);
+    url.AddOption("start", start);
+    url.AddOption("end", start + pageSize);
+
+    CFileItemList page;
+    ASSERT_TRUE(db.GetTvShowsByWhere(url.ToString(), CDatabase::Filter(), page));
+    EXPECT_EQ(all.Size(), page.GetProperty("total").asInteger());
+    ASSERT_EQ(std::min(pageSize, all.Size() - start), page.Size());
+    for (int i = 0; i < page.Size(); i++)
+    {
+      EXPECT_STREQ(all[start + i]->GetVideoInfoTag()->m_strTitle.c_str(), page[i]->GetVideoInfoTag()->m_strTitle.c_str());
+      // the seasons of a show aren't paged
+      EXPECT_STREQ(all[start + i]->GetPath().c_str(), page[i]->GetPath().c_str());
+    }
+  }
+
+  std::string file = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(file);
+}
+
+TEST_F(TestVideoDatabase, RemoveAndRescan)
+{
+  ASSERT_TRUE(m_file != NULL);
+  std::string folder = CXBMCTestUtils::Instance().TempFileDirectory(m_file);
+  std::string source = URIUtils::AddFileToFolder(folder, "TestVideosRemoveMovies/");
+  std::string movieFolder = URIUtils::AddFileToFolder(source, "Movie 1/");
+  std::string movie = URIUtils::AddFileToFolder(movieFolder, "movie.mkv");
+  std::string otherSource = URIUtils::AddFileToFolder(folder, "TestVideosRemoveOther/");
+  ASSERT_TRUE(XFILE::CDirectory::Create(source));
+  ASSERT_TRUE(XFILE::CDirectory::Create(movieFolder));
+  ASSERT_TRUE(XFILE::CDirectory::Create(otherSource));
+  XFILE::CFile file;
+  ASSERT_TRUE(file.OpenForWrite(movie, true));
+  file.Close();
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Create(folder, "TestVideosRemove"));
+
+  // the scan of both sources, adding the movie
+  std::vector<std::string> excludes;
+  XFILE::CDirectoryFingerprint scanned(source, excludes);
+  ASSERT_TRUE(scanned.Update());
+  ASSERT_TRUE(db.SetFingerprint(scanned));
+  XFILE::CDirectoryFingerprint otherScanned(otherSource, excludes);
+  ASSERT_TRUE(otherScanned.Update());
+  ASSERT_TRUE(db.SetFingerprint(otherScanned));
+  ASSERT_LE(0, db.AddMovie(movie));
+  ASSERT_TRUE(db.HasMovieInfo(movie));
+
+  // nothing changed on disk, so the next scan would skip the source
+  XFILE::CDirectoryFingerprint unchanged(source, excludes);
+  ASSERT_TRUE(db.GetFingerprint(unchanged));
+  EXPECT_FALSE(unchanged.Update());
+
+  // once the movie is removed from the library the source has to be scanned again to bring it back,
+  // while the other source can still be skipped
+  db.DeleteMovie(movie);
+  EXPECT_FALSE(db.HasMovieInfo(movie));
+  XFILE::CDirectoryFingerprint removed(source, excludes);
+  EXPECT_FALSE(db.GetFingerprint(removed));
+  XFILE::CDirectoryFingerprint other(otherSource, excludes);
+  ASSERT_TRUE(db.GetFingerprint(other));
+  EXPECT_FALSE(other.Update());
+
+  std::string dbFile = db.GetFile();
+  db.Close();
+  XFILE::CFile::Delete(dbFile);
+  XFILE::CFile::Delete(movie);
+  XFILE::CDirectory::Remove(movieFolder);
+  XFILE::CDirectory::Remove(source);
+  XFILE::CDirectory::Remove(otherSource);
+}
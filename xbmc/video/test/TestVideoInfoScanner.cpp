@@ -20,7 +20,14 @@
 
 #include "video/VideoInfoScanner.h"
 #include "FileItem.h"
+#include "threads/Atomics.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include "utils/StringUtils.h"
+
 #include "gtest/gtest.h"
+#include <iostream>
+#include <memory>
 
 using namespace VIDEO;
 using ::testing::Test;
@@ -73,3 +80,126 @@ TEST_P(TestVideoInfoScanner, EnumerateEpisodeItem)
 }
 
 INSTANTIATE_TEST_CASE_P(VideoInfoScanner, TestVideoInfoScanner, ValuesIn(TestData));
+
+namespace
+{
+  const unsigned int LookupDuration = 50;
+  const int ScanItems = 24;
+
+  // stands in for the scraper, whose lookups mostly wait on the network
+  class CTestScanWorker : public IVideoScanWorker
+  {
+  public:
+    CTestScanWorker(unsigned int lookupDuration = LookupDuration) : m_lookupDuration(lookupDuration)
+    {
+      for (unsigned int i = 0; i < 2; i++)
+        m_running[i] = m_maxRunning[i] = 0;
+    }
+
+    virtual bool ProcessStage(unsigned int stage, SScanItem &item)
+    {
+      long running = AtomicIncrement(&m_running[stage]);
+      if (running > m_maxRunning[stage])
+        m_maxRunning[stage] = running;
+      if (stage == 0)
+        XbmcThreads::ThreadSleep(m_lookupDuration);
+      else
+        item.item->SetLabel("done");
+      AtomicDecrement(&m_running[stage]);
+
+      // movies 01, 11 and 21 aren't found, so skip the second stage
+      item.result = StringUtils::EndsWith(item.item->GetPath(), "1.mkv") ? INFO_NOT_FOUND : INFO_ADDED;
+      return item.result == INFO_ADDED;
+    }
+
+    unsigned int m_lookupDuration;
+    volatile long m_running[2];
+    volatile long m_maxRunning[2];
+  };
+
+  SScanItem *MakeScanItem(int i)
+  {
+    SScanItem *item = new SScanItem;
+    item->item.reset(new CFileItem(StringUtils::Format("/movies/movie %02d.mkv", i), false));
+    return item;
+  }
+}
+
+TEST(TestVideoScanPipeline, Stages)
+{
+  CTestScanWorker worker;
+  std::vector<unsigned int> jobs;
+  jobs.push_back(3);
+  jobs.push_back(1);
+  CVideoScanPipeline pipeline(&worker, jobs);
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < ScanItems; i++)
+    pipeline.Add(MakeScanItem(i));
+
+  int found = 0, processed = 0;
+  while (pipeline.GetPending() > 0)
+  {
+    std::auto_ptr<SScanItem> item(pipeline.GetProcessed(1000));
+    ASSERT_TRUE(item.get() != NULL);
+    processed++;
+    if (item->result == INFO_ADDED)
+    {
+      found++;
+      EXPECT_STREQ("done", item->item->GetLabel().c_str());
+    }
+    else
+      EXPECT_TRUE(item->item->GetLabel().empty());
+  }
+  unsigned int parallel = XbmcThreads::SystemClockMillis() - start;
+
+  EXPECT_EQ(ScanItems, processed);
+  EXPECT_EQ(ScanItems - 3, found);
+  // the stages stay within their bounds, the lookups overlapping
+  EXPECT_LE(worker.m_maxRunning[0], 3);
+  EXPECT_GT(worker.m_maxRunning[0], 1);
+  EXPECT_EQ(1, worker.m_maxRunning[1]);
+
+  std::cout << ScanItems << " lookups of " << LookupDuration << " ms took " << parallel << " ms in parallel, "
+            << ScanItems * LookupDuration << " ms one after the other" << std::endl;
+  EXPECT_LT(parallel, ScanItems * LookupDuration * 2 / 3);
+}
+
+TEST(TestVideoScanPipeline, Stop)
+{
+  CTestScanWorker worker;
+  std::vector<unsigned int> jobs(2, 1);
+  CVideoScanPipeline pipeline(&worker, jobs);
+
+  for (int i = 0; i < ScanItems; i++)
+    pipeline.Add(MakeScanItem(i));
+  pipeline.Stop();
+
+  // the items still come out, most of them without having been looked up
+  int cancelled = 0;
+  while (pipeline.GetPending() > 0)
+  {
+    std::auto_ptr<SScanItem> item(pipeline.GetProcessed(1000));
+    ASSERT_TRUE(item.get() != NULL);
+    if (item->result == INFO_CANCELLED)
+      cancelled++;
+  }
+  EXPECT_GT(cancelled, ScanItems / 2);
+}
+
+TEST(TestVideoScanPipeline, Destroy)
+{
+  // the pipeline is destroyed as soon as the last item came out, while the stage
+  // which handed it back may still be finishing its job (run with a memory checker)
+  CTestScanWorker worker(0);
+  std::vector<unsigned int> jobs(2, 1);
+  for (int i = 0; i < 100; i++)
+  {
+    CVideoScanPipeline *pipeline = new CVideoScanPipeline(&worker, jobs);
+    pipeline->Add(MakeScanItem(i));
+    std::auto_ptr<SScanItem> item(pipeline->GetProcessed(1000));
+    ASSERT_TRUE(item.get() != NULL);
+    EXPECT_EQ(0U, pipeline->GetPending());
+    delete pipeline;
+  }
+}
@@ -270,6 +270,21 @@ std::string CGUIWindowVideoNav::GetQuickpathName(const std::string& strPath) con
   }
 }
 
+int CGUIWindowVideoNav::GetPageSize(const std::string &strDirectory) const
+{
+  if (g_advancedSettings.m_iVideoLibraryPageSize <= 0 || !URIUtils::IsVideoDb(strDirectory))
+    return 0;
+
+  NODE_TYPE node = CVideoDatabaseDirectory::GetDirectoryChildType(strDirectory);
+  // movies are grouped into sets after they are read, which has to see all of them
+  if (node == NODE_TYPE_TITLE_MOVIES && !CSettings::Get().GetBool("videolibrary.groupmoviesets"))
+    return g_advancedSettings.m_iVideoLibraryPageSize;
+  if (node == NODE_TYPE_TITLE_TVSHOWS || node == NODE_TYPE_TITLE_MUSICVIDEOS)
+    return g_advancedSettings.m_iVideoLibraryPageSize;
+
+  return 0;
+}
+
 bool CGUIWindowVideoNav::GetDirectory(const std::string &strDirectory, CFileItemList &items)
 {
   if (m_thumbLoader.IsLoading())
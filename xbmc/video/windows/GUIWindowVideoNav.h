@@ -57,6 +57,7 @@ protected:
   virtual void OnItemLoaded(CFileItem* pItem) {};
   // override base class methods
   virtual bool GetDirectory(const std::string &strDirectory, CFileItemList &items);
+  virtual int GetPageSize(const std::string &strDirectory) const;
   virtual void UpdateButtons();
   virtual void DoSearch(const std::string& strSearch, CFileItemList& items);
   virtual void PlayItem(int iItem);
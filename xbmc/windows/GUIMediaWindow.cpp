@@ -281,14 +281,14 @@ bool CGUIMediaWindow::OnMessage(CGUIMessage& message)
       {
         if (m_guiState.get())
           m_guiState->SetNextSortOrder();
-        UpdateFileList();
+        OnSortChanged();
         return true;
       }
       else if (iControl == CONTROL_BTNSORTBY) // sort by
       {
         if (m_guiState.get())
           m_guiState->SetNextSortMethod();
-        UpdateFileList();
+        OnSortChanged();
         return true;
       }
       else if (iControl == CONTROL_BTN_FILTER)
@@ -469,7 +469,7 @@ bool CGUIMediaWindow::OnMessage(CGUIMessage& message)
         else if (message.GetParam2())
           m_guiState->SetNextSortMethod((int)message.GetParam2());
       }
-      UpdateFileList();
+      OnSortChanged();
       return true;
     }
     break;
@@ -477,7 +477,7 @@ bool CGUIMediaWindow::OnMessage(CGUIMessage& message)
     {
       if (m_guiState.get())
         m_guiState->SetNextSortOrder();
-      UpdateFileList();
+      OnSortChanged();
       return true;
     }
     break;
@@ -641,7 +641,18 @@ void CGUIMediaWindow::FormatAndSort(CFileItemList &items)
   */
 bool CGUIMediaWindow::GetDirectory(const std::string &strDirectory, CFileItemList &items)
 {
-  const CURL pathToUrl(strDirectory);
+  // listings too large to read at once are read a page at a time
+  std::string directory = strDirectory;
+  int pageSize = GetPageSize(strDirectory);
+  int pageStart = 0;
+  if (pageSize > 0)
+  {
+    map<string, int>::const_iterator page = m_pageStarts.find(strDirectory);
+    if (page != m_pageStarts.end())
+      pageStart = page->second;
+    directory = GetPagePath(strDirectory, pageStart, pageSize);
+  }
+  const CURL pathToUrl(directory);
 
   // cleanup items
   if (items.Size())
@@ -655,7 +666,7 @@ bool CGUIMediaWindow::GetDirectory(const std::string &strDirectory, CFileItemLis
 
   // see if we can load a previously cached folder
   CFileItemList cachedItems(strDirectory);
-  if (!strDirectory.empty() && cachedItems.Load(GetID()))
+  if (!strDirectory.empty() && pageSize == 0 && cachedItems.Load(GetID()))
   {
     items.Assign(cachedItems);
   }
@@ -670,7 +681,7 @@ bool CGUIMediaWindow::GetDirectory(const std::string &strDirectory, CFileItemLis
       return false;
 
     // took over a second, and not normally cached, so cache it
-    if ((XbmcThreads::SystemClockMillis() - time) > 1000  && items.CacheToDiscIfSlow())
+    if ((XbmcThreads::SystemClockMillis() - time) > 1000  && items.CacheToDiscIfSlow() && pageSize == 0)
       items.Save(GetID());
 
     // if these items should replace the current listing, then pop it off the top
@@ -678,6 +689,33 @@ bool CGUIMediaWindow::GetDirectory(const std::string &strDirectory, CFileItemLis
       m_history.RemoveParentPath();
   }
 
+  if (pageSize > 0)
+  {
+    // the listing keeps its path, under which a single page mustn't be cached
+    items.SetPath(strDirectory);
+    items.SetCacheToDisc(CFileItemList::CACHE_NEVER);
+
+    int total = (int)items.GetProperty("total").asInteger();
+    if (pageStart > 0)
+    {
+      CFileItemPtr pItem(new CFileItem(g_localizeStrings.Get(210))); // Previous
+      pItem->SetPath(GetPagePath(strDirectory, std::max(pageStart - pageSize, 0), pageSize));
+      pItem->SetProperty("pagestart", std::max(pageStart - pageSize, 0));
+      pItem->m_bIsFolder = true;
+      pItem->SetSpecialSort(SortSpecialOnTop);
+      items.AddFront(pItem, 0);
+    }
+    if (pageStart + pageSize < total)
+    {
+      CFileItemPtr pItem(new CFileItem(g_localizeStrings.Get(33078))); // Next page
+      pItem->SetPath(GetPagePath(strDirectory, pageStart + pageSize, pageSize));
+      pItem->SetProperty("pagestart", pageStart + pageSize);
+      pItem->m_bIsFolder = true;
+      pItem->SetSpecialSort(SortSpecialOnBottom);
+      items.Add(pItem);
+    }
+  }
+
   if (m_guiState.get() && !m_guiState->HideParentDirItems() && !items.GetPath().empty())
   {
     CFileItemPtr pItem(new CFileItem(".."));
@@ -926,6 +964,12 @@ bool CGUIMediaWindow::OnClick(int iItem)
     GoParentFolder();
     return true;
   }
+  if (pItem->HasProperty("pagestart")) // previous or next page of the listing
+  {
+    m_pageStarts[m_vecItems->GetPath()] = (int)pItem->GetProperty("pagestart").asInteger();
+    Refresh();
+    return true;
+  }
   if (pItem->GetPath() == "add" || pItem->GetPath() == "sources://add/") // 'add source button' in empty root
   {
     OnContextButton(iItem, CONTEXT_BUTTON_ADD_SOURCE);
@@ -1428,6 +1472,33 @@ void CGUIMediaWindow::UpdateFileList()
   }
 }
 
+void CGUIMediaWindow::OnSortChanged()
+{
+  // the items of the page are different in the new order
+  if (GetPageSize(m_vecItems->GetPath()) > 0)
+  {
+    m_pageStarts.erase(m_vecItems->GetPath());
+    Refresh();
+  }
+  else
+    UpdateFileList();
+}
+
+std::string CGUIMediaWindow::GetPagePath(const std::string &strDirectory, int start, int pageSize) const
+{
+  CFileItemList items(strDirectory);
+  auto_ptr<CGUIViewState> viewState(CGUIViewState::GetViewState(GetID(), items));
+  SortDescription sorting = viewState->GetSortMethod();
+
+  CURL url(strDirectory);
+  url.SetOption("sortby", StringUtils::Format("%i", (int)sorting.sortBy));
+  url.SetOption("sortorder", StringUtils::Format("%i", (int)sorting.sortOrder));
+  url.SetOption("ignorearticle", (sorting.sortAttributes & SortAttributeIgnoreArticle) ? "1" : "0");
+  url.SetOption("start", StringUtils::Format("%i", start));
+  url.SetOption("end", StringUtils::Format("%i", start + pageSize));
+  return url.Get();
+}
+
 void CGUIMediaWindow::OnDeleteItem(int iItem)
 {
   if ( iItem < 0 || iItem >= m_vecItems->Size()) return;
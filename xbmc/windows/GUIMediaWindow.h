@@ -154,6 +154,31 @@ protected:
   virtual bool OnPlayMedia(int iItem);
   virtual bool OnPlayAndQueueMedia(const CFileItemPtr &item);
   void UpdateFileList();
+
+  /*! \brief Show the items in the sort method or order the view state was changed to.
+   Pages of a listing are read again, starting over with the first page.
+   \sa GetPageSize
+   */
+  void OnSortChanged();
+
+  /*! \brief Get the number of items per page of a listing too large to read at once.
+   The listing has to support the "sortby", "sortorder", "ignorearticle", "start" and "end"
+   options of library paths (see CDbUrl::TakeSorting()) so that the database sorts the items
+   and reads the items of the current page only. Items to move to the previous and the next
+   page are added to the page.
+   \param strDirectory the path of the listing.
+   \return the number of items per page, 0 to read all items of the listing.
+   \sa GetDirectory
+   */
+  virtual int GetPageSize(const std::string &strDirectory) const { return 0; }
+
+  /*! \brief Get the path reading a page of a listing sorted the way its view state sorts it.
+   \param strDirectory the path of the listing.
+   \param start the index of the first item of the page.
+   \param pageSize the number of items per page.
+   \return the path with the options selecting the page.
+   */
+  std::string GetPagePath(const std::string &strDirectory, int start, int pageSize) const;
   virtual void OnDeleteItem(int iItem);
   void OnRenameItem(int iItem);
 
@@ -174,6 +199,8 @@ protected:
   XFILE::CVirtualDirectory m_rootDir;
   CGUIViewControl m_viewControl;
 
+  std::map<std::string, int> m_pageStarts; ///< \brief index of the first item of the current page by path of paged listings
+
   // current path and history
   CFileItemList* m_vecItems;
   CFileItemList* m_unfilteredItems;        ///< \brief items prior to filtering using FilterItems()